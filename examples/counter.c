@@ -25,8 +25,10 @@ static int syntax_error(const char **argv, const int exit_code)
 	const char *v0 = argv[0];
 	fprintf(stderr, "Code counter (libsrt example). Returns: elements "
 		"processed, unique elements\nError [%i] Syntax: %s unit_size "
-		"diff_max_stop\n(1 <= unit_size <= 4; diff_max_stop = 0: no "
-		"max, != 0: max)\n"
+		"diff_max_stop [hll_precision]\n(1 <= unit_size <= 4; "
+		"diff_max_stop = 0: no max, != 0: max;\n%i <= hll_precision "
+		"<= %i: approximate count, HyperLogLog sketch of\n"
+		"2^hll_precision bytes)\n"
 		"Examples (count colors, fast randomness test, etc.):\n"
 		"%s 1 0 <in  (count unique bytes)\n"
 		"%s 1 128 <in (count unique bytes, stop after 128)\n"
@@ -35,8 +37,11 @@ static int syntax_error(const char **argv, const int exit_code)
 		"%s 3 0 <in (count 3-byte unique elements, e.g. RGB888)\n"
 		"%s 3 256  <in (count 3-byte unique elements, stop after 256)\n"
 		"%s 4 0 <in (count 4-byte unique elements, e.g. RGBA888)\n"
-		"%s 4 1000 <in (count 4-byte unique elements, stop after 1000)\n",
-		exit_code, v0, v0, v0, v0, v0, v0, v0, v0, v0);
+		"%s 4 1000 <in (count 4-byte unique elements, stop after 1000)\n"
+		"%s 4 0 14 <in (approximate count of 4-byte unique elements, "
+		"16KB, ~0.8%% error)\n",
+		exit_code, v0, SHLL_P_MIN, SHLL_P_MAX, v0, v0, v0, v0, v0, v0,
+		v0, v0, v0);
 	return exit_code;
 }
 
@@ -44,11 +49,14 @@ int main(int argc, const char **argv)
 {
 	if (argc < 3)
 		return syntax_error(argv, 5);
-	int csize = atoi(argv[1]), climit0 = atoi(argv[2]);
+	int csize = atoi(argv[1]), climit0 = atoi(argv[2]),
+	    hll_p = argc > 3 ? atoi(argv[3]) : 0;
 	if (csize < 1 || csize > 4)
 		return syntax_error(argv, 6);
 	if (climit0 < 0)
 		return syntax_error(argv, 7);
+	if (hll_p && (hll_p < SHLL_P_MIN || hll_p > SHLL_P_MAX))
+		return syntax_error(argv, 8);
 	int exit_code = 0;
 	size_t count = 0,
 	       cmax = csize == 4 ? 0xffffffff :
@@ -57,38 +65,65 @@ int main(int argc, const char **argv)
 #ifdef COUNTER_USE_BITSET
 	#define COUNTER_SET(val) sb_set(&bs, val)
 	#define COUNTER_POPCOUNT sb_popcount(bs)
+	/* 4-byte elements: compressed bitmap (a bitset would take 512MB) */
+	#define COUNTER_SET32(val) srb_set(&rb, (uint32_t)(val))
+	#define COUNTER_POPCOUNT32 srb_popcount(rb)
 	sb_t *bs = sb_alloc(0);
-	sb_eval(&bs, cmax);
+	srb_t *rb = srb_alloc(0);
+	if (csize < 4)
+		sb_eval(&bs, cmax);
 #else
 	#define COUNTER_SET(val) sm_insert_uu32(&m, val, 1)
 	#define COUNTER_POPCOUNT sm_size(m)
+	#define COUNTER_SET32 COUNTER_SET
+	#define COUNTER_POPCOUNT32 COUNTER_POPCOUNT
 	sm_t *m = sm_alloc(SM_UU32, 0);
 #endif
+	/* Approximate count: the stop condition is checked periodically, as
+	 * the estimate takes O(2^hll_precision) time */
+	#define COUNTER_HLL_CHECK 65536
+	shll_t *hl = hll_p ? shll_alloc((unsigned)hll_p) : NULL;
 	unsigned char buf[3 * 4 * 128];
-	size_t i, l;
+	size_t i, j, l;
+	uint64_t v;
 	for (;;) {
 		l = fread(buf, 1, sizeof(buf), stdin);
 		l = (l / (size_t)csize) * (size_t)csize;
 		if (!l)
 			break;
-		#define CNTLOOP(inc, val)			\
+		if (hl) {
+			for (i = 0; i < l; i += (size_t)csize) {
+				for (v = 0, j = 0; j < (size_t)csize; j++)
+					v = v << 8 | buf[i + j];
+				shll_add_u(&hl, v);
+				count++;
+				if (climit0 && !(count % COUNTER_HLL_CHECK) &&
+				    shll_count(hl) >= climit)
+					goto done;
+			}
+			continue;
+		}
+		#define CNTLOOP(inc, val, set, popcount)	\
 			for (i = 0; i < l; i += inc) {		\
-				COUNTER_SET(val);		\
+				set(val);			\
 				count++;			\
-				if (COUNTER_POPCOUNT >= climit)	\
+				if (popcount >= climit)		\
 					goto done;		\
 			}
 		switch (csize) {
-		case 1:	CNTLOOP(1, buf[i]);
+		case 1:	CNTLOOP(1, buf[i], COUNTER_SET, COUNTER_POPCOUNT);
 			break;
-		case 2:	CNTLOOP(2, (size_t)(buf[i] << 8 | buf[i + 1]));
+		case 2:	CNTLOOP(2, (size_t)(buf[i] << 8 | buf[i + 1]),
+				COUNTER_SET, COUNTER_POPCOUNT);
 			break;
-		case 3:	CNTLOOP(3, (size_t)(buf[i] << 16 | buf[i + 1] << 8 | buf[i + 2]));
+		case 3:	CNTLOOP(3, (size_t)(buf[i] << 16 | buf[i + 1] << 8 | buf[i + 2]),
+				COUNTER_SET, COUNTER_POPCOUNT);
 			break;
 		case 4:	CNTLOOP(4, (size_t)buf[i] << 24 |
 				   (size_t)buf[i + 1] << 16 |
 				   (size_t)buf[i + 2] << 8 |
-				   (size_t)buf[i + 3]);
+				   (size_t)buf[i + 3],
+				COUNTER_SET32, COUNTER_POPCOUNT32);
 			break;
 		default:
 			goto done;
@@ -96,9 +131,13 @@ int main(int argc, const char **argv)
 		#undef CNTLOOP
 	}
 done:
-	printf(FMT_ZU ", " FMT_ZU, count, COUNTER_POPCOUNT);
+	printf(FMT_ZU ", " FMT_ZU, count,
+	       hl ? (size_t)shll_count(hl) :
+	       csize == 4 ? COUNTER_POPCOUNT32 : COUNTER_POPCOUNT);
+	shll_free(&hl);
 #ifdef COUNTER_USE_BITSET
 	sb_free(&bs);
+	srb_free(&rb);
 #else
 	sm_free(&m);
 #endif
@@ -19,7 +19,7 @@ static int syntax_error(const char **argv, const int exit_code)
 	const char *v0 = argv[0];
 	fprintf(stderr,
 		"Error [%i] Syntax: %s [-eb|-db|-eh|-eH|-dh|-ex|-dx|-ej|-dj|"
-		"-eu|-du|-er|-dr|-ez|-dz|-crc32]\nExamples:\n"
+		"-eu|-du|-er|-dr|-ez|-dz|-ef|-df|-crc32]\nExamples:\n"
 		"%s -eb <in >out.b64\n%s -db <in.b64 >out\n"
 		"%s -eh <in >out.hex\n%s -eH <in >out.HEX\n"
 		"%s -dh <in.hex >out\n%s -dh <in.HEX >out\n"
@@ -28,9 +28,10 @@ static int syntax_error(const char **argv, const int exit_code)
 		"%s -eu <in >out.url.esc\n%s -du <in.url.esc >out\n"
 		"%s -er <in >in.r\n%s -dr <in.r >out\n"
 		"%s -ez <in >in.z\n%s -dz <in.z >out\n"
+		"%s -ef <in >in.f\n%s -df <in.f >out\n"
 		"%s -crc32 <in\n%s -crc32 <in >out\n",
 		exit_code, v0, v0, v0, v0, v0, v0, v0, v0, v0, v0, v0, v0,
-		v0, v0, v0, v0, v0, v0, v0);
+		v0, v0, v0, v0, v0, v0, v0, v0, v0);
 	return exit_code;
 }
 
@@ -81,6 +82,10 @@ int main(int argc, const char **argv)
 		ss_codec3_f = ss_enc_rle;
 	else if (!strncmp(argv[1], "-dr", 3))
 		ss_codec4_f = ss_dec_rle;
+	else if (!strncmp(argv[1], "-ef", 3))
+		ss_codec3_f = ss_enc_huf;
+	else if (!strncmp(argv[1], "-df", 3))
+		ss_codec4_f = ss_dec_huf;
 	else
 		return syntax_error(argv, 2);
 	int exit_code = 0;
@@ -126,7 +131,7 @@ int main(int argc, const char **argv)
 			else
 				ss_clear(in);
 			break;
-		case 3: /* lzw/rle encoding */
+		case 3: /* lzw/rle/huf encoding */
 			ss_cpy_read(&in, stdin, IBUF_SIZE);
 			l = ss_size(in);
 			if (!l) {
@@ -146,7 +151,7 @@ int main(int argc, const char **argv)
 			lo += 4;
 			ss_clear(in);
 			break;
-		case 4: /* lzw/rle decoding */
+		case 4: /* lzw/rle/huf decoding */
 			l = fread(&l32, 1, 4, stdin);
 			if (!l || ferror(stdin)) {
 				done = S_TRUE;
@@ -10,7 +10,9 @@
 #include "../src/libsrt.h"
 #include "../src/saux/sbitio.h"
 #include "../src/saux/schar.h"
+#include "../src/saux/shash.h"
 #include "../src/saux/sdbg.h"
+#include "../src/saux/sthread.h"
 #include "utf8_examples.h"
 #include <locale.h>
 
@@ -140,6 +142,9 @@ MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_hex)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_HEX)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_lzw)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_rle)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_huf)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_rle_huf)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_lzw_huf)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_esc_xml)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_esc_json)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(enc_esc_url)
@@ -149,6 +154,9 @@ MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_b64)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_hex)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_lzw)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_rle)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_huf)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_rle_huf)
+MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_lzw_huf)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_esc_xml)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_esc_json)
 MK_TEST_SS_DUP_CPY_CAT_CODEC(dec_esc_url)
@@ -199,6 +207,813 @@ static int test_sb(size_t nelems)
 	return res;
 }
 
+static int test_sb_setops_chk(const sb_t *o, const sb_t *a, const sb_t *b,
+			      const int op, const size_t nbits)
+{
+	int res = 0, x, y, r;
+	size_t i, cnt = 0,
+	       n = S_MAX(nbits, 8 * S_MAX(sv_size(a), sv_size(b))) + 64;
+	for (i = 0; i < n; i++) {
+		x = sb_test(a, i);
+		y = sb_test(b, i);
+		r = op == 0 ? x & y : op == 1 ? x | y : op == 2 ? x ^ y :
+		    op == 3 ? x & !y : i < nbits && !x;
+		res |= sb_test(o, i) != r ? 1 : 0;
+		cnt += (size_t)r;
+	}
+	res |= sb_popcount(o) != cnt || sb_popcount_scan(o) != cnt ? 2 : 0;
+	return res;
+}
+
+static sb_t *test_sb_setops_op(sb_t **o, const sb_t *a, const sb_t *b,
+			       const int op, const size_t nbits)
+{
+	return op == 0 ? sb_and(o, a, b) : op == 1 ? sb_or(o, a, b) :
+	       op == 2 ? sb_xor(o, a, b) : op == 3 ? sb_andnot(o, a, b) :
+	       sb_not(o, a, nbits);
+}
+
+static int test_sb_setops()
+{
+	int res = 0, op;
+	const size_t sizes[] = { 0, 1, 7, 63, 100, 200, 1000 };
+	size_t i, j, k, ns = sizeof(sizes) / sizeof(sizes[0]);
+	uint32_t x = 1;
+	sb_t *a = NULL, *b = NULL, *o = NULL, *t = NULL,
+	     *s = sb_alloca(2000);
+	for (i = 0; i < ns; i++)
+		for (j = 0; j < ns; j++) {
+			sb_free(&a, &b);
+			a = sb_alloc(0);
+			b = sb_alloc(0);
+			for (k = 0; k < sizes[i]; k++) {
+				x = x * 1103515245 + 12345;
+				if ((x >> 16) & 1)
+					sb_set(&a, k);
+			}
+			sb_eval(&a, sizes[i]);
+			for (k = 0; k < sizes[j]; k++) {
+				x = x * 1103515245 + 12345;
+				if ((x >> 16) % 3 == 0)
+					sb_set(&b, k);
+			}
+			for (op = 0; op < 5; op++) {
+				/* new output, existing output, aliasing */
+				sb_free(&o);
+				test_sb_setops_op(&o, a, b, op, sizes[j]);
+				res |= test_sb_setops_chk(o, a, b, op,
+							  sizes[j]) << (op * 4);
+				test_sb_setops_op(&s, a, b, op, sizes[j]);
+				res |= test_sb_setops_chk(s, a, b, op,
+							  sizes[j]) ? 1 << 20 : 0;
+				sb_free(&t);
+				t = sb_dup(a);
+				test_sb_setops_op(&t, t, b, op, sizes[j]);
+				res |= test_sb_setops_chk(t, a, b, op,
+							  sizes[j]) ? 1 << 21 : 0;
+				sb_free(&t);
+				t = sb_dup(b);
+				test_sb_setops_op(&t, a, t, op, sizes[j]);
+				res |= test_sb_setops_chk(t, a, b, op,
+							  sizes[j]) ? 1 << 22 : 0;
+			}
+		}
+	/* NULL inputs are empty bitsets */
+	sb_or(&o, NULL, a);
+	res |= sb_popcount(o) != sb_popcount(a) ? 1 << 23 : 0;
+	sb_and(&o, a, NULL);
+	res |= sb_popcount(o) ? 1 << 24 : 0;
+	sb_free(&a, &b, &o, &t);
+	return res;
+}
+
+static sbool_t test_sb_itr_f(size_t nth, void *context)
+{
+	size_t *c = (size_t *)context;
+	if (c[0] >= c[1] || !c[2])
+		return S_FALSE;
+	c[3 + c[0]++] = nth;
+	c[2]--;
+	return S_TRUE;
+}
+
+static int test_sb_find_range()
+{
+	int res = 0;
+	const size_t sizes[] = { 1, 8, 63, 64, 65, 130, 1000 };
+	size_t i, j, k, f, nb, c[3 + 64],
+	       ns = sizeof(sizes) / sizeof(sizes[0]);
+	uint32_t x = 1;
+	sb_t *b = NULL;
+	sv_t *v = NULL;
+	for (i = 0; i < ns && !res; i++) {
+		nb = sizes[i];
+		sb_free(&b);
+		b = sb_alloc(0);
+		sb_eval(&b, nb - 1);
+		for (k = 0; k < nb; k++) {
+			x = x * 1103515245 + 12345;
+			if ((x >> 16) % (i + 2) == 0)
+				sb_set(&b, k);
+		}
+		/* find next set/clear, against sb_test */
+		for (k = 0; k <= nb + 70; k++) {
+			for (f = k; f < nb + 70 && !sb_test(b, f); f++)
+				;
+			res |= sb_find_next_set(b, k) !=
+			       (f < nb + 70 ? f : S_NPOS) ? 1 : 0;
+			for (f = k; sb_test(b, f); f++)
+				;
+			res |= sb_find_next_clear(b, k) != f ? 2 : 0;
+		}
+		/* enumeration, vector export */
+		sb_to_vector(&v, b);
+		res |= sv_size(v) != sb_popcount(b) ||
+		       sb_itr(b, 0, S_NPOS, NULL, NULL) != sb_popcount(b) ?
+		       4 : 0;
+		for (k = 0; k < sv_size(v); k++)
+			res |= !sb_test(b, sv_at_u(v, k)) ||
+			       (k && sv_at_u(v, k) <= sv_at_u(v, k - 1)) ? 8 : 0;
+		c[0] = 0;
+		c[1] = 64;
+		c[2] = 5;
+		k = sb_itr(b, nb / 3, nb / 3 + 40, test_sb_itr_f, c);
+		for (j = 0, f = sb_find_next_set(b, nb / 3); j < k;
+		     j++, f = sb_find_next_set(b, f + 1))
+			res |= c[3 + j] != f ? 16 : 0;
+		res |= k > 5 || (k < 5 && f < nb / 3 + 40) ? 32 : 0;
+		/* ranges */
+		for (j = 0; j < 20; j++) {
+			x = x * 1103515245 + 12345;
+			k = (x >> 8) % (nb + 20);
+			f = k + (x >> 20) % 80;
+			if (j % 2)
+				sb_set_range(&b, k, f);
+			else
+				sb_reset_range(&b, k, f);
+			for (; k < f; k++)
+				res |= sb_test(b, k) != (int)(j % 2) ? 64 : 0;
+			res |= sb_popcount(b) != sb_popcount_scan(b) ? 128 : 0;
+		}
+	}
+	/* 32-bit output vector, unsupported output type */
+	sv_free(&v);
+	v = sv_alloc_t(SV_I32, 0);
+	sb_to_vector(&v, b);
+	res |= sv_size(v) != sb_popcount(b) ||
+	       sv_at_i(v, 0) != (int64_t)sb_find_next_set(b, 0) ? 256 : 0;
+	sv_free(&v);
+	v = sv_alloc_t(SV_U8, 0);
+	sb_to_vector(&v, b);
+	res |= sv_size(v) ? 512 : 0;
+	sb_free(&b);
+	res |= sb_find_next_set(b, 0) != S_NPOS ||
+	       sb_find_next_clear(b, 5) != 5 ? 1024 : 0;
+	sb_set_range(&b, 3, 5);
+	res |= sb_popcount(b) != 2 || !sb_test(b, 4) || sb_test(b, 5) ?
+	       2048 : 0;
+	sv_free(&v, &b);
+	return res;
+}
+
+static int test_sb_rank_select()
+{
+	int res = 0;
+	const size_t sizes[] = { 0, 1, 64, 511, 512, 513, 5000, 70000 },
+		     dens[] = { 1, 2, 7, 300 },
+		     ns = sizeof(sizes) / sizeof(sizes[0]),
+		     nd = sizeof(dens) / sizeof(dens[0]);
+	size_t i, d, k, r, nb;
+	uint32_t x = 1;
+	sb_t *b = NULL;
+	sb_rs_t *idx = NULL, *idx2 = NULL;
+	sv_t *v = NULL;
+	for (i = 0; i < ns && !res; i++)
+		for (d = 0; d < nd; d++) {
+			nb = sizes[i];
+			sb_free(&b);
+			b = sb_alloc(0);
+			for (k = 0; k < nb; k++) {
+				x = x * 1103515245 + 12345;
+				if ((x >> 16) % dens[d] == 0)
+					sb_set(&b, k);
+			}
+			sb_rs_build(&idx, b);
+			res |= !sb_rs_valid(idx, b) ? 1 : 0;
+			sb_to_vector(&v, b);
+			/* rank, against a running count (index and scan) */
+			for (k = r = 0; k <= nb + 70; k++) {
+				res |= sb_rank(b, idx, k) != r ||
+				       sb_rank(b, NULL, k) != r ? 2 : 0;
+				r += sb_test(b, k);
+			}
+			/* select, against the offsets of the bits set */
+			for (k = 0; k < sv_size(v); k++)
+				res |= sb_select(b, idx, k) != sv_at_u(v, k) ||
+				       sb_select(b, NULL, k) != sv_at_u(v, k) ?
+				       4 : 0;
+			res |= sb_select(b, idx, k) != S_NPOS ||
+			       sb_select(b, NULL, k) != S_NPOS ? 8 : 0;
+			/* modification makes the index stale */
+			sb_set(&b, nb + 5);
+			sb_reset(&b, nb / 3);
+			res |= sb_rs_valid(idx, b) ? 16 : 0;
+			r = sb_rank(b, NULL, nb);
+			res |= sb_rank(b, idx, nb) != r ||
+			       sb_select(b, idx, r - 1) !=
+			       sb_select(b, NULL, r - 1) ? 32 : 0;
+		}
+	sb_rs_build(&idx, b);
+	sb_set_range(&b, 10, 20);
+	res |= sb_rs_valid(idx, b) ? 64 : 0;
+	sb_rs_build(&idx, b);
+	sb_or(&b, b, NULL);
+	res |= sb_rs_valid(idx, b) ? 128 : 0;
+	res |= sb_rs_valid(NULL, b) || sb_rank(NULL, NULL, 5) ||
+	       sb_select(NULL, NULL, 0) != S_NPOS ? 256 : 0;
+	/* older index: same bitset size and bit count, other contents */
+	sb_clear(b);
+	for (i = 2; i < 64; i += 2)
+		sb_set(&b, i);
+	sb_set(&b, 200);
+	sb_rs_build(&idx, b);
+	sb_reset(&b, 2);
+	sb_set(&b, 100);
+	sb_rs_build(&idx2, b);
+	res |= sb_rs_valid(idx, b) || !sb_rs_valid(idx2, b) ? 512 : 0;
+	res |= sb_rank(b, idx, 64) != 30 || sb_rank(b, idx2, 64) != 30 ||
+	       sb_select(b, idx, 31) != 200 ? 1024 : 0;
+	sb_rs_build(&idx, b); /* not modified: both indexes are valid */
+	res |= !sb_rs_valid(idx, b) || !sb_rs_valid(idx2, b) ? 2048 : 0;
+	/* contents changed bypassing the API: select must not hang */
+	sv_get_buffer(b)[200 / 8] = 0;
+	res |= sb_select(b, idx, 31) != S_NPOS ? 4096 : 0;
+	sb_free(&b);
+	sb_rs_free(&idx, &idx2);
+	sv_free(&v);
+	return res;
+}
+
+#define TEST_SRB_BITS	(6 * 65536)
+
+/* Compare compressed bitmap against reference bitset */
+struct SBAtomicTest
+{
+	sb_t *b;
+	size_t nbits, n, reset;
+	size_t changed[4];
+};
+
+/* Overlapping marks from every job */
+static void test_sb_atomic_job(void *context, size_t j)
+{
+	struct SBAtomicTest *t = (struct SBAtomicTest *)context;
+	size_t i, delta = 0, pos;
+	for (i = 0; i < t->n; i++) {
+		pos = (i * 7 + j * 5) % t->nbits;
+		if (t->reset) {
+			if (!(pos % 2) &&
+			    sb_reset_atomic(t->b, pos, &delta) == 1)
+				t->changed[j]++;
+		} else if (!sb_set_atomic(t->b, pos, &delta)) {
+			t->changed[j]++;
+		}
+	}
+	sb_popcount_merge(t->b, delta);
+}
+
+static int test_sb_atomic()
+{
+	int res = 0;
+	size_t i, delta = 0, nset = 0, nreset = 0;
+	sb_t *b = sb_alloc_atomic(100);
+	sb_rs_t *idx = NULL;
+	struct SBAtomicTest t;
+	/* Single thread */
+	res |= sv_size(b) != 16 || sb_popcount(b) || sb_test_atomic(b, 99) ?
+	       1 : 0;
+	res |= sb_set_atomic(b, 3, &delta) ||
+	       sb_set_atomic(b, 3, &delta) != 1 || sb_set_atomic(b, 127, NULL) ||
+	       sb_set_atomic(b, 128, &delta) != -1 || delta != 1 ||
+	       !sb_test_atomic(b, 3) || !sb_test_atomic(b, 127) ||
+	       sb_test_atomic(b, 128) || sv_size(b) != 16 ? 2 : 0;
+	res |= sb_reset_atomic(b, 3, &delta) != 1 ||
+	       sb_reset_atomic(b, 3, &delta) ||
+	       sb_reset_atomic(b, 200, &delta) != -1 || delta ? 4 : 0;
+	sb_set_atomic(b, 50, &delta);
+	sb_popcount_merge(b, delta + 1); /* bit 127 set without delta */
+	res |= sb_popcount(b) != 2 || sb_popcount_scan(b) != 2 ||
+	       !sb_test(b, 50) || sb_find_next_set(b, 51) != 127 ? 8 : 0;
+	/* index built before the marking (same bit count after it) */
+	sb_rs_build(&idx, b);
+	delta = 0;
+	sb_reset_atomic(b, 50, &delta);
+	sb_set_atomic(b, 100, &delta);
+	sb_popcount_merge(b, delta);
+	res |= sb_rs_valid(idx, b) || sb_rank(b, idx, 101) != 1 ||
+	       sb_select(b, idx, 0) != 100 ? 256 : 0;
+	sb_rs_build(&idx, b);
+	res |= !sb_rs_valid(idx, b) || sb_rank(b, idx, 101) != 1 ? 512 : 0;
+	sb_rs_free(&idx);
+	sb_free(&b);
+	b = sb_alloc_atomic(0);
+	res |= sv_size(b) != 8 || sb_set_atomic(NULL, 1, NULL) != -1 ||
+	       sb_test_atomic(NULL, 1) ? 16 : 0;
+	sb_popcount_merge(NULL, 1);
+	sb_free(&b);
+	/* Concurrent marking (serial if there is no thread support) */
+	memset(&t, 0, sizeof(t));
+	t.nbits = 100003;
+	t.n = 50000;
+	t.b = sb_alloc_atomic(t.nbits);
+	s_par_run(sb_lock_free() ? 4 : 1, 4, test_sb_atomic_job, &t);
+	for (i = 0; i < 4; i++)
+		nset += t.changed[i];
+	res |= nset != sb_popcount(t.b) || nset != sb_popcount_scan(t.b) ||
+	       nset < t.n ? 32 : 0;
+	memset(t.changed, 0, sizeof(t.changed));
+	t.reset = 1;
+	s_par_run(sb_lock_free() ? 4 : 1, 4, test_sb_atomic_job, &t);
+	for (i = 0; i < 4; i++)
+		nreset += t.changed[i];
+	res |= nset - nreset != sb_popcount(t.b) ||
+	       sb_popcount(t.b) != sb_popcount_scan(t.b) || !nreset ? 64 : 0;
+	for (i = 0; i < t.nbits; i += 2)
+		res |= sb_test(t.b, i) ? 128 : 0;
+	sb_free(&t.b);
+	return res;
+}
+
+static int test_srb_chk(const srb_t *r, const sb_t *b)
+{
+	int res = 0;
+	sv_t *vr = sv_alloc_t(SV_U64, 0), *vb = NULL;
+	srb_to_vector(&vr, r);
+	sb_to_vector(&vb, b);
+	res |= srb_popcount(r) != sb_popcount(b) ? 1 : 0;
+	res |= sv_size(vr) != sv_size(vb) ||
+	       sv_ncmp(vr, 0, vb, 0, sv_size(vb)) ? 2 : 0;
+	sv_free(&vr, &vb);
+	return res;
+}
+
+static srb_t *test_srb_op(srb_t **o, const srb_t *a, const srb_t *b,
+			  const int op)
+{
+	return op == 0 ? srb_and(o, a, b) : op == 1 ? srb_or(o, a, b) :
+	       op == 2 ? srb_xor(o, a, b) : srb_andnot(o, a, b);
+}
+
+static int test_srb()
+{
+	int res = 0, op;
+	size_t i, j, k, c;
+	uint32_t x = 1, e;
+	srb_t *r[2] = { NULL, NULL }, *o = NULL;
+	sb_t *b[2] = { NULL, NULL }, *bo = NULL;
+	sv_t *s = NULL;
+	/* per chunk densities: array, bitmap, runs, empty, array, bitmap */
+	const size_t den[2][6] = { { 200, 2, 0, 0, 1000, 3 },
+				   { 5, 3, 0, 0, 20000, 2 } };
+	for (i = 0; i < 2; i++) {
+		b[i] = sb_alloc(TEST_SRB_BITS);
+		for (c = 0; c < 6; c++)
+			for (k = c * 65536; den[i][c] && k < (c + 1) * 65536;
+			     k++) {
+				x = x * 1103515245 + 12345;
+				if ((x >> 8) % den[i][c] == 0) {
+					srb_set(&r[i], (uint32_t)k);
+					sb_set(&b[i], k);
+				}
+			}
+		for (j = 0; j < 40; j++) { /* runs in chunk 2 */
+			k = 2 * 65536 + j * 1500 + i * 700;
+			for (c = 0; c < 1000; c++) {
+				srb_set(&r[i], (uint32_t)(k + c));
+				sb_set(&b[i], k + c);
+			}
+		}
+		res |= test_srb_chk(r[i], b[i]);
+	}
+	/* random access, reset (with container conversions) */
+	for (k = 0; k < TEST_SRB_BITS; k++)
+		res |= srb_test(r[0], (uint32_t)k) != sb_test(b[0], k) ? 4 : 0;
+	for (k = 65536; k < 2 * 65536 - 1000; k++)
+		if (k % 13) {
+			srb_reset(&r[1], (uint32_t)k);
+			sb_reset(&b[1], k);
+		}
+	srb_reset(&r[1], 3 * 65536); /* empty chunk */
+	res |= test_srb_chk(r[1], b[1]) << 3;
+	/* set operations, including aliasing */
+	for (op = 0; op < 4 && !res; op++) {
+		for (i = 0; i < 2; i++) {
+			test_srb_op(&o, r[i], r[1 - i], op);
+			test_sb_setops_op(&bo, b[i], b[1 - i], op, 0);
+			res |= test_srb_chk(o, bo) << 5;
+		}
+		srb_free(&o);
+		o = srb_dup(r[0]);
+		test_srb_op(&o, o, r[1], op);
+		test_sb_setops_op(&bo, b[0], b[1], op, 0);
+		res |= test_srb_chk(o, bo) << 7;
+		test_srb_op(&o, o, NULL, op);
+		res |= srb_popcount(o) != (op ? sb_popcount(bo) : 0) ?
+		       512 : 0;
+	}
+	/* run containers */
+	i = srb_mem_size(r[0]);
+	srb_optimize(r[0]);
+	res |= srb_mem_size(r[0]) >= i || test_srb_chk(r[0], b[0]) ?
+	       1024 : 0;
+	for (j = 0; j < 3000; j++) {
+		x = x * 1103515245 + 12345;
+		k = 2 * 65536 + (x >> 8) % 65536;
+		if (j % 2) {
+			srb_set(&r[0], (uint32_t)k);
+			sb_set(&b[0], k);
+		} else {
+			srb_reset(&r[0], (uint32_t)k);
+			sb_reset(&b[0], k);
+		}
+		if (j % 1000 == 0)
+			srb_optimize(r[0]);
+	}
+	res |= test_srb_chk(r[0], b[0]) << 11;
+	/* serialization, including run containers and corrupted input */
+	srb_optimize(r[0]);
+	srb_serialize(&s, r[0]);
+	srb_deserialize(&o, s);
+	res |= test_srb_chk(o, b[0]) << 13;
+	sv_set_size(s, sv_size(s) - 1);
+	srb_deserialize(&o, s);
+	res |= srb_popcount(o) || srb_test(o, 0) ? 32768 : 0;
+	srb_serialize(&s, r[1]);
+	sv_set_u(&s, 8 + 8 + 2, 7); /* bad container type */
+	srb_deserialize(&o, s);
+	res |= srb_popcount(o) ? 65536 : 0;
+	srb_deserialize(&o, NULL);
+	res |= srb_popcount(o) ? 0x20000 : 0;
+	/* sparse high ids: memory proportional to the content */
+	srb_clear(o);
+	srb_set(&o, 0xffffffff);
+	srb_set(&o, 7);
+	srb_set(&o, 7);
+	sv_free(&s);
+	s = sv_alloc_t(SV_I32, 0);
+	srb_to_vector(&s, o);
+	e = (uint32_t)sv_at_i(s, 0);
+	res |= srb_popcount(o) != 2 || !srb_test(o, 0xffffffff) ||
+	       srb_test(o, 0xfffffffe) || srb_mem_size(o) > 1024 ||
+	       sv_size(s) != 1 || e != 7 ? 0x40000 : 0;
+	srb_reset(&o, 0xffffffff);
+	srb_reset(&o, 7);
+	res |= srb_popcount(o) || srb_mem_size(o) > 1024 ? 0x80000 : 0;
+	/* short input with a huge chunk count: no allocation for it */
+	sv_free(&s);
+	s = sv_alloc_t(SV_U8, 8);
+	for (j = 0; j < 8; j++)
+		sv_push_u(&s, j == 0 ? 1 : j < 4 ? 0 : 0xff);
+	srb_set(&o, 7);
+	srb_deserialize(&o, s);
+	res |= srb_popcount(o) || srb_test(o, 7) || srb_mem_size(o) > 1024 ?
+	       0x100000 : 0;
+	srb_free(&r[0], &r[1], &o);
+	sb_free(&b[0], &b[1], &bo);
+	sv_free(&s);
+	return res;
+}
+
+/* Bloom filter blocks starting at a cache line boundary */
+static sbool_t test_sbf_aligned(const sbf_t *f)
+{
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(f);
+	return (uintptr_t)(p + 64 + p[2]) % 64 ? S_FALSE : S_TRUE;
+}
+
+static int test_sbf()
+{
+	int res = 0;
+	const size_t n = 20000;
+	size_t i, fp = 0, batch_cnt, nbb;
+	unsigned np;
+	char key[32];
+	unsigned char *p;
+	ss_t *s = NULL;
+	sbf_t *f = sbf_alloc(n, 0.01), *g = NULL, *h = NULL, *d = NULL,
+	      *e = NULL;
+	sb_t *out = NULL;
+	sv_t *v = sv_alloc_t(SV_U32, 0), *vi = sv_alloc_t(SV_I16, 0);
+	/* hash and sizing helpers */
+	res |= sh_hash64("abc", 3, 0) != sh_hash64("abc", 3, 0) ||
+	       sh_hash64("abc", 3, 0) == sh_hash64("abc", 3, 1) ||
+	       sh_hash64("abcdefgh", 8, 0) == sh_hash64("abcdefgh", 7, 0) ||
+	       slog(1) != 0 || slog(2.718281828459045) < 0.999999999 ||
+	       slog(2.718281828459045) > 1.000000001 ? 1 : 0;
+	res |= sbf_bits(f) < sbf_size_bits(n, 0.01) ||
+	       sbf_bits(f) > sbf_size_bits(n, 0.01) + 512 || sbf_k(f) != 7 ||
+	       sbf_size_k(1000, 1000) != 1 || sbf_size_k(100, 100000) != 16 ?
+	       2 : 0;
+	/* no false negatives; false positive rate near the target */
+	for (i = 0; i < n; i++) {
+		if (i % 2) {
+			sbf_add_u(f, i * 3);
+		} else {
+			sprintf(key, "key%u", (unsigned)i);
+			ss_cpy_c(&s, key);
+			sbf_add_s(f, s);
+		}
+	}
+	for (i = 0; i < n; i++) {
+		sprintf(key, "key%u", (unsigned)i);
+		ss_cpy_c(&s, key);
+		res |= (i % 2 && !sbf_test_u(f, i * 3)) ||
+		       (!(i % 2) && !sbf_test_s(f, s)) ? 4 : 0;
+		fp += sbf_test_u(f, i * 3 + 1) + sbf_test_raw(f, key, 2);
+	}
+	res |= fp > 2 * n * 2 / 100 || sb_popcount(f) != sb_popcount_scan(f) ?
+	       8 : 0;
+	/* batch test, against single key test */
+	for (i = 0; i < 1000; i++) {
+		sv_push_u(&v, i % 3 ? i * 3 : i * 3 + 2);
+		sv_push_i(&vi, (int64_t)i - 500);
+		sbf_add_i(f, (int64_t)i - 500 - (int64_t)(i % 2) * 2000);
+	}
+	batch_cnt = sbf_test_batch(&out, f, v);
+	for (i = 0; i < 1000; i++)
+		res |= sb_test(out, i) != sbf_test_u(f, sv_at_u(v, i)) ? 16 : 0;
+	res |= batch_cnt != sb_popcount(out) || batch_cnt < 333 ? 32 : 0;
+	batch_cnt = sbf_test_batch(&out, f, vi);
+	for (i = 0; i < 1000; i++)
+		res |= sb_test(out, i) != sbf_test_i(f, sv_at_i(vi, i)) ||
+		       (!(i % 2) && !sb_test(out, i)) ? 64 : 0;
+	/* union, clear */
+	g = sbf_alloc(n, 0.01);
+	h = sbf_alloc(n, 0.001);
+	sbf_add_u(g, 123456789);
+	res |= sbf_test_u(f, 123456789) || !sbf_union(&f, g) ||
+	       !sbf_test_u(f, 123456789) || sbf_union(&f, h) ||
+	       sb_popcount(f) != sb_popcount_scan(f) ? 128 : 0;
+	/* block alignment: allocation, duplication, moved blocks */
+	d = sbf_dup(f);
+	batch_cnt = sbf_test_batch(&out, f, v);
+	res |= !test_sbf_aligned(f) || !test_sbf_aligned(d) ||
+	       !sbf_test_u(d, 123456789) ||
+	       sb_popcount(d) != sb_popcount_scan(d) ? 1024 : 0;
+	p = (unsigned char *)sv_get_buffer(d); /* e.g. copy at other address */
+	nbb = sbf_bits(d) / 8;
+	np = (p[2] + 32) % 64;
+	memmove(p + 64 + np, p + 64 + p[2], nbb);
+	memset(p + 64, 0, np);
+	memset(p + 64 + np + nbb, 0, 64 - np);
+	p[2] = (unsigned char)np;
+	d->vx.cnt = sb_popcount_scan(d);
+	res |= test_sbf_aligned(d) || !sbf_test_u(d, 123456789) ||
+	       sbf_test_batch(&out, d, v) != batch_cnt ? 2048 : 0;
+	e = sbf_alloc(n, 0.01);
+	res |= !sbf_union(&e, d) || !sbf_test_u(e, 123456789) ||
+	       sbf_test_batch(&out, e, v) != batch_cnt ||
+	       sb_popcount(e) != sb_popcount_scan(e) ? 4096 : 0;
+	sbf_add_u(d, 1);
+	res |= !test_sbf_aligned(d) || !sbf_test_u(d, 123456789) ||
+	       !sbf_test_u(d, 1) || sbf_test_batch(&out, d, v) < batch_cnt ||
+	       sb_popcount(d) != sb_popcount_scan(d) ? 8192 : 0;
+	sbf_clear(f);
+	res |= sbf_test_u(f, 3) || sbf_test_s(f, s) ||
+	       sb_popcount(f) != sb_popcount_scan(f) || sbf_k(f) != 7 ? 256 : 0;
+	/* invalid filters */
+	sbf_add_u(NULL, 1);
+	sbf_add_u(out, 1);
+	res |= sbf_test_u(NULL, 1) || sbf_bits(NULL) || sbf_k(out) ||
+	       sbf_test_batch(&out, NULL, v) || sbf_union(&out, f) ? 512 : 0;
+	sbf_free(&f, &g, &h, &d, &e);
+	sb_free(&out);
+	sv_free(&v, &vi);
+	ss_free(&s);
+	return res;
+}
+
+static int test_shll_near(const shll_t *h, const uint64_t n, const uint64_t pct)
+{
+	const uint64_t c = shll_count(h);
+	return c * 100 < n * (100 - pct) || c * 100 > n * (100 + pct);
+}
+
+static int test_shll()
+{
+	int res = 0;
+	size_t i;
+	ss_t *s = NULL;
+	sv_t *v = NULL, *w = sv_alloc_t(SV_U16, 0);
+	shll_t *h = shll_alloc(14), *g = shll_alloc(14), *d = NULL, *e = NULL,
+	       *f = shll_alloc(0);
+	res |= shll_precision(h) != 14 || !shll_sparse(h) || shll_count(h) ||
+	       shll_precision(f) != SHLL_P_MIN ? 1 : 0;
+	/* sparse: near-exact count, duplicates and key types */
+	for (i = 0; i < 2000; i++)
+		shll_add_u(&h, i % 1000);
+	ss_cpy_c(&s, "hello");
+	shll_add_s(&h, s);
+	shll_add_raw(&h, "hello", 5);
+	shll_add_i(&h, -1);
+	shll_add_i(&h, -1);
+	res |= !shll_sparse(h) || shll_count(h) < 1000 ||
+	       shll_count(h) > 1004 ? 2 : 0;
+	/* dense */
+	for (i = 0; i < 200000; i++)
+		shll_add_u(&h, i);
+	res |= shll_sparse(h) || test_shll_near(h, 200000, 3) ? 4 : 0;
+	/* merge: sparse + sparse, sparse + dense, dense + dense */
+	for (i = 100000; i < 100500; i++)
+		shll_add_u(&g, i);
+	d = shll_dup(g);
+	for (i = 100250; i < 100750; i++)
+		shll_add_u(&d, i);
+	res |= !shll_merge(&d, g) || !shll_sparse(d) ||
+	       test_shll_near(d, 750, 1) || !shll_merge(&d, d) ? 8 : 0;
+	res |= !shll_merge(&g, h) || shll_sparse(g) ||
+	       test_shll_near(g, 200000, 3) ? 16 : 0;
+	e = shll_alloc(14);
+	for (i = 150000; i < 300000; i++)
+		shll_add_u(&e, i);
+	res |= !shll_merge(&e, h) || test_shll_near(e, 300000, 3) ||
+	       shll_merge(&e, f) || shll_merge(&e, NULL) ? 32 : 0;
+	/* sparse entries merged into a dense sketch: same registers */
+	shll_free(&g);
+	g = shll_dup(h);
+	shll_clear(d);
+	for (i = 0; i < 3000; i++) {
+		shll_add_u(&d, i * 1000003);
+		shll_add_u(&h, i * 1000003);
+	}
+	res |= !shll_sparse(d) || !shll_merge(&g, d) ||
+	       sv_size(g) != sv_size(h) ||
+	       memcmp(sv_get_buffer_r(g), sv_get_buffer_r(h), sv_size(h)) ?
+	       64 : 0;
+	/* serialization */
+	shll_serialize(&v, d);
+	shll_deserialize(&g, v);
+	res |= !shll_sparse(g) || shll_count(g) != shll_count(d) ? 128 : 0;
+	shll_serialize(&v, h);
+	shll_deserialize(&g, v);
+	res |= shll_sparse(g) || shll_count(g) != shll_count(h) ? 256 : 0;
+	/* many sparse merges, result too large for sparse */
+	shll_clear(g);
+	for (i = 0; i < 3000; i++)
+		shll_add_u(&d, i + 1);
+	shll_clear(e);
+	shll_add_u(&e, 1);
+	res |= !shll_merge(&e, d) || !shll_merge(&e, g) || shll_sparse(e) ||
+	       test_shll_near(e, 6000, 3) ? 512 : 0;
+	/* invalid serialized input */
+	shll_serialize(&v, h);
+	((unsigned char *)sv_get_buffer(v))[100] = 70;
+	shll_deserialize(&g, v);
+	shll_add_u(&f, 1);
+	shll_serialize(&v, f);
+	sv_set_size(v, sv_size(v) - 4);
+	shll_deserialize(&e, v);
+	res |= shll_count(g) || shll_precision(g) != SHLL_P_DEFAULT ||
+	       shll_count(e) ? 1024 : 0;
+	shll_deserialize(&e, w); /* not SV_U8 */
+	shll_serialize(&w, h);
+	res |= !shll_sparse(e) || shll_count(e) || sv_size(w) ? 1024 : 0;
+	shll_clear(h);
+	res |= !shll_sparse(h) || shll_count(h) || shll_precision(h) != 14 ?
+	       2048 : 0;
+	/* NULL sketch: error, no allocation */
+	shll_free(&f);
+	res |= shll_add_u(NULL, 1) || shll_add_u(&f, 1) || f ||
+	       !shll_add_u(&h, 1) || !shll_add_s(&h, s) ? 4096 : 0;
+	shll_free(&h, &g, &d, &e, &f);
+	sv_free(&v, &w);
+	ss_free(&s);
+	return res;
+}
+
+struct SCMSTest
+{
+	uint64_t last;
+	size_t n, err, stop;
+};
+
+static sbool_t test_scms_it_i(int64_t k, uint64_t count, uint64_t error,
+			      void *context)
+{
+	struct SCMSTest *t = (struct SCMSTest *)context;
+	const uint64_t real = k > 0 && k <= 200 ? 10000 / (uint64_t)k :
+			      k > 0 ? 1 : 0;
+	/* descending order; real count in [count - error, count] */
+	t->err |= count > t->last || count < real || count - error > real;
+	t->err |= t->n < 8 && k != (int64_t)t->n + 1 ? 2 : 0;
+	t->last = count;
+	return ++t->n != t->stop;
+}
+
+static sbool_t test_scms_it_s(const ss_t *k, uint64_t count, uint64_t error,
+			      void *context)
+{
+	struct SCMSTest *t = (struct SCMSTest *)context;
+	t->err |= count > t->last || error ||
+		  count != (uint64_t)ss_size(k) * 10 ? 4 : 0;
+	t->last = count;
+	t->n++;
+	return S_TRUE;
+}
+
+static int test_scms()
+{
+	int res = 0;
+	size_t i, j;
+	uint64_t total = 0, over = 0;
+	ss_t *s = NULL;
+	struct SCMSTest t;
+	scms_t *c = scms_alloc(1024, 4, 20), *d = scms_alloc(64, 2, 0),
+	       *e = scms_alloc(1024, 0, 20);
+	res |= !scms_alloc_size(1024, 4, 20) || scms_total(c) ||
+	       scms_top_size(c) || scms_count_i(c, 1) ||
+	       scms_alloc_size(1024, 0, 20) ||
+	       scms_alloc_size(1024, SCMS_DEPTH_MAX + 1, 20) ? 1 : 0;
+	/* failed allocation: no-op calls */
+	res |= !e || scms_inc_i(e, 1, 1) || scms_count_i(e, 1) ||
+	       scms_total(e) || scms_top_i(e, NULL, NULL) ? 1 : 0;
+	scms_clear(e);
+	scms_free(&e);
+	res |= e ? 1 : 0;
+	if (res)
+		return res;
+	/* Zipf-like stream: key j (1 to 200) 10000 / j times, interleaved
+	 * with a long tail of 20000 keys seen once */
+	for (i = 0; i < 10000; i++) {
+		for (j = 1; j <= 200 && i < 10000 / j; j++) {
+			scms_inc_i(c, (int64_t)j, 1);
+			total++;
+		}
+		scms_inc_i(c, (int64_t)(1000 + 2 * i), 1);
+		scms_inc_i(c, (int64_t)(1001 + 2 * i), 1);
+		total += 2;
+	}
+	res |= scms_total(c) != total || scms_top_size(c) != 20 ? 2 : 0;
+	for (j = 1; j <= 200; j++) {
+		res |= scms_count_i(c, (int64_t)j) < 10000 / j ? 4 : 0;
+		over += scms_count_i(c, (int64_t)j) - 10000 / j;
+	}
+	res |= over > 200 * (total / 1024) ? 8 : 0;
+	memset(&t, 0, sizeof(t));
+	t.last = (uint64_t)-1;
+	res |= scms_top_i(c, test_scms_it_i, &t) != 20 || t.err ||
+	       scms_top_s(c, NULL, NULL) ? 16 : 0;
+	memset(&t, 0, sizeof(t));
+	t.last = (uint64_t)-1;
+	t.stop = 3;
+	res |= scms_top_i(c, test_scms_it_i, &t) != 3 || t.err ? 32 : 0;
+	/* String and integer keys; exact until the table is full */
+	for (i = 1; i <= 10; i++) {
+		ss_cpy_char(&s, 'a');
+		for (j = 1; j < i; j++)
+			ss_cat_char(&s, 'a');
+		for (j = 0; j < 10; j++)
+			scms_inc_s(c, s, i);
+		scms_inc_i(c, (int64_t)i, 1);
+	}
+	res |= scms_count_s(c, s) < 100 ? 64 : 0;
+	scms_clear(c);
+	res |= scms_total(c) || scms_top_size(c) || scms_count_i(c, 1) ?
+	       128 : 0;
+	for (i = 1; i <= 10; i++) {
+		ss_cpy_char(&s, 'a');
+		for (j = 1; j < i; j++)
+			ss_cat_char(&s, 'a');
+		scms_inc_s(c, s, i * 5);
+		scms_inc_s(c, s, i * 5);
+		scms_inc_i(c, (int64_t)i, 7);
+	}
+	memset(&t, 0, sizeof(t));
+	t.last = (uint64_t)-1;
+	res |= scms_top_s(c, test_scms_it_s, &t) != 10 || t.err ||
+	       scms_top_i(c, NULL, NULL) != 10 || scms_top_size(c) != 20 ?
+	       256 : 0;
+	/* No top-k table, NULL sketch */
+	res |= scms_inc_i(d, 5, 3) != 3 || scms_inc_s(d, s, 2) < 2 ||
+	       scms_top_i(d, NULL, NULL) || scms_inc_i(NULL, 1, 1) ||
+	       scms_count_s(NULL, s) || scms_top_s(NULL, NULL, NULL) ? 512 : 0;
+	scms_free(&c);
+	scms_free(&d);
+	scms_free(&d);
+	/* stack allocation (string key copies released by scms_free()) */
+	e = scms_alloca(256, 4, 4);
+	for (i = 0; i < 100; i++) {
+		ss_printf(&s, 32, "k%u", (unsigned)(i % 7));
+		scms_inc_s(e, s, i % 7 + 1);
+	}
+	res |= scms_total(e) != 395 || scms_top_size(e) != 4 ||
+	       scms_top_s(e, NULL, NULL) != 4 || scms_count_s(e, s) < 30 ?
+	       2048 : 0;
+	scms_free(&e);
+	ss_free(&s);
+	return res | (c || e ? 1024 : 0);
+}
+
 static int test_ss_alloc(const size_t max_size)
 {
 	ss_t *a = ss_alloc(max_size);
@@ -1465,6 +2280,289 @@ static int test_ss_csum32()
 	return res;
 }
 
+static int test_ss_huf()
+{
+	int res = 0;
+	size_t i, n = 100000;
+	uint32_t acc = 1;
+	char *p;
+	ss_t *a = ss_alloc(n), *b = NULL, *c = NULL;
+	/* skewed distribution: compressible, all code lengths in use */
+	for (i = 0; i < n; i++) {
+		acc = acc * 1103515245 + 12345;
+		ss_cat_char(&a, 'a' + (int)slog2((acc >> 8) & 0xfffff));
+	}
+	ss_enc_huf(&b, a);
+	ss_dec_huf(&c, b);
+	res |= ss_size(b) >= ss_size(a) ? 1 : 0;
+	res |= ss_cmp(a, c) ? 2 : 0;
+	ss_enc_rle_huf(&b, a);
+	ss_dec_rle_huf(&c, b);
+	res |= ss_cmp(a, c) ? 4 : 0;
+	ss_enc_lzw_huf(&b, a);
+	ss_dec_lzw_huf(&c, b);
+	res |= ss_cmp(a, c) ? 8 : 0;
+	/* all byte values (incompressible: raw fallback) */
+	ss_clear(a);
+	for (i = 0; i < 256; i++)
+		ss_cat_char(&a, (int)(((i * 7) & 0xff) | 0x100)); /* UTF-8 */
+	ss_enc_huf(&b, a);
+	ss_dec_huf(&c, b);
+	res |= ss_cmp(a, c) ? 16 : 0;
+	/* truncated input must not overflow */
+	ss_enc_huf(&b, ss_crefa("aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				"aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				"aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				"aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				"aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				"aaaaaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbcccc"
+				));
+	ss_resize(&b, ss_size(b) - 10, 0);
+	ss_dec_huf(&c, b);
+	res |= ss_size(c) > 282 ? 32 : 0;
+	/* incompressible input: first stage output larger than the input */
+	for (n = 1697; n < 1697 * 8; n *= 2) {
+		ss_resize(&a, n, 0);
+		p = ss_get_buffer(a);
+		for (i = 0; i < n; i++) {
+			acc = acc * 1103515245 + 12345;
+			p[i] = (char)(0x80 | acc >> 24);
+		}
+		ss_enc_lzw_huf(&b, a);
+		ss_dec_lzw_huf(&c, b);
+		res |= ss_cmp(a, c) ? 64 : 0;
+		ss_enc_rle_huf(&b, a);
+		ss_dec_rle_huf(&c, b);
+		res |= ss_cmp(a, c) ? 128 : 0;
+	}
+	ss_free(&a, &b, &c);
+	return res;
+}
+
+static int test_ss_lzw_dict()
+{
+	int res = 0;
+	size_t i;
+	const char *status[] = { "active", "pending", "closed" };
+	ss_t *smp[64], *a = NULL, *b = NULL, *c = NULL, *d = NULL;
+	for (i = 0; i < 64; i++) {
+		smp[i] = ss_dup_printf(512, "{\"id\":%u,\"user\":\"user%u\","
+				       "\"status\":\"%s\",\"tags\":[\"red\","
+				       "\"green\"],\"score\":%u}",
+				       (unsigned)(i * 7919),
+				       (unsigned)(i % 5),
+				       status[i % 3],
+				       (unsigned)(i * 31 % 100));
+	}
+	ss_build_lzw_dict(&d, (const ss_t **)smp, 64, 1024);
+	res |= !ss_size(d) || ss_size(d) > 1024 ? 1 : 0;
+	ss_cpy_printf(&a, 512, "{\"id\":1234,\"user\":\"user9\",\"status\":"
+		      "\"pending\",\"tags\":[\"red\",\"green\"],"
+		      "\"score\":77}");
+	ss_enc_lzw_dict(&b, a, d);
+	ss_dec_lzw_dict(&c, b, d);
+	res |= ss_cmp(a, c) ? 2 : 0;
+	ss_enc_lzw(&c, a);
+	res |= ss_size(b) >= ss_size(c) ? 4 : 0;
+	/* decoding with a different dictionary must not match */
+	ss_dec_lzw_dict(&c, b, smp[0]);
+	res |= !ss_cmp(a, c) ? 8 : 0;
+	/* empty dictionary: same as plain LZW */
+	ss_enc_lzw_dict(&b, a, NULL);
+	ss_enc_lzw(&c, a);
+	res |= ss_cmp(b, c) ? 16 : 0;
+	/* aliasing */
+	ss_cpy(&b, a);
+	ss_enc_lzw_dict(&b, b, d);
+	ss_dec_lzw_dict(&b, b, d);
+	res |= ss_cmp(a, b) ? 32 : 0;
+	ss_enc_lzw_dict(&b, a, d); /* output as the dictionary */
+	ss_cpy(&c, d);
+	ss_shrink(&c); /* the output reserve moves it */
+	ss_enc_lzw_dict(&c, a, c);
+	res |= ss_cmp(b, c) ? 64 : 0;
+	ss_cpy(&c, b);
+	ss_dec_lzw_dict(&c, c, d);
+	res |= ss_cmp(a, c) ? 128 : 0;
+	ss_enc_lzw_dict(&b, a, a); /* output as the input and dictionary */
+	ss_cpy(&c, a);
+	ss_shrink(&c);
+	ss_enc_lzw_dict(&c, c, c);
+	res |= !ss_size(b) || ss_cmp(b, c) ? 256 : 0;
+	ss_dec_lzw_dict(&c, b, a);
+	res |= ss_cmp(a, c) ? 512 : 0;
+	for (i = 0; i < 64; i++)
+		ss_free(&smp[i]);
+	ss_free(&a, &b, &c, &d);
+	return res;
+}
+
+static int test_ss_rle_runs()
+{
+	int res = 0;
+	size_t i, j, k, lit, run, per, n = 0;
+	uint32_t acc = 1;
+	char buf[24000], *p;
+	ss_t *a = NULL, *b = NULL, *c = NULL;
+	/* literals and runs of period 1, 3 and 4 at every offset mod 16 */
+	for (i = 0; n + 200 < sizeof(buf); i++) {
+		lit = i % 37;
+		run = 8 + (i * 7) % 61;
+		per = i % 3 ? i % 3 + 2 : 1;
+		for (j = 0; j < lit; j++) {
+			acc = acc * 1103515245 + 12345;
+			buf[n++] = (char)(acc >> 16);
+		}
+		for (j = 0; j < run; j++, n++)
+			buf[n] = (char)('a' + (int)(i % 5) + (int)(j % per));
+	}
+	ss_cpy_cn(&a, buf, n);
+	ss_enc_rle(&b, a);
+	ss_dec_rle(&c, b);
+	res |= ss_cmp(a, c) ? 1 : 0;
+	ss_enc_lzw(&b, a);
+	ss_dec_lzw(&c, b);
+	res |= ss_cmp(a, c) ? 2 : 0;
+	/* runs crossing the 16-byte blocks of the run finder */
+	for (k = 0; k < 24; k++) {
+		p = buf;
+		for (j = 0; j < k; j++)
+			*p++ = (char)('A' + (int)j);
+		memset(p, 'x', 40);
+		p += 40;
+		*p++ = 'z';
+		ss_cpy_cn(&a, buf, (size_t)(p - buf));
+		ss_enc_rle(&b, a);
+		ss_dec_rle(&c, b);
+		res |= ss_cmp(a, c) ? 4 : 0;
+		res |= ss_size(b) > k + 20 ? 8 : 0;
+	}
+	/* long periodic fills (bulk decode path) */
+	for (per = 1; per <= 4; per++) {
+		for (j = 0; j < 20000; j++)
+			buf[j] = (char)('0' + (int)(j % per));
+		ss_cpy_cn(&a, buf, 20000 + per % 3);
+		ss_enc_rle(&b, a);
+		ss_dec_rle(&c, b);
+		res |= ss_cmp(a, c) ? 16 : 0;
+		res |= ss_size(b) > 32 ? 32 : 0;
+	}
+	ss_free(&a, &b, &c);
+	return res;
+}
+
+static int test_senc_lzw_bound()
+{
+	int res = 0;
+	size_t i, j, n, bound, out;
+	uint32_t acc = 1;
+	unsigned char *s = (unsigned char *)s_malloc(70000), *o, d[1024];
+	RETURN_IF(!s, 1);
+	for (i = 0; i < sizeof(d); i++) {
+		acc = acc * 1103515245 + 12345;
+		d[i] = (unsigned char)(acc >> 16);
+	}
+	/*
+	 * Incompressible and partially compressible inputs, encoded into
+	 * buffers of exactly the reported maximum size
+	 */
+	for (i = 0; i < 400 && !res; i++) {
+		n = i < 300 ? 1 + i * 7 : 1697 + (i - 300) * 683;
+		for (j = 0; j < n; j++) {
+			acc = acc * 1103515245 + 12345;
+			s[j] = (unsigned char)(i % 3 == 0 ? acc >> 24 :
+					       i % 3 == 1 ? 0x80 | acc >> 24 :
+					       (acc >> 24) & 0x1f);
+		}
+		bound = senc_lzw(s, n, NULL);
+		o = (unsigned char *)s_malloc(bound);
+		if (!o)
+			return 2;
+		out = senc_lzw(s, n, o);
+		res |= !out || out + SBIO64_PAD > bound ? 4 : 0;
+		s_free(o);
+		bound = senc_lzw_dict(s, n, NULL, d, sizeof(d));
+		o = (unsigned char *)s_malloc(bound);
+		if (!o)
+			return 8;
+		out = senc_lzw_dict(s, n, o, d, sizeof(d));
+		res |= !out || out + SBIO64_PAD > bound ? 16 : 0;
+		s_free(o);
+	}
+	s_free(s);
+	return res;
+}
+
+static int test_ss_frame()
+{
+	int res = 0;
+	size_t i, n = 100000, nb;
+	uint32_t acc = 1;
+	char *p;
+	ss_t *a = ss_alloc(n), *b = NULL, *c = NULL, *d = NULL;
+	for (i = 0; i < n; i++) {
+		acc = acc * 1103515245 + 12345;
+		ss_cat_char(&a, 'a' + (int)slog2((acc >> 8) & 0xfffff));
+	}
+	/* same output regardless the number of threads */
+	ss_enc_frame(&b, a, 4096, SFR_LZW_HUF, 1);
+	ss_enc_frame(&c, a, 4096, SFR_LZW_HUF, 4);
+	nb = ss_frame_nblocks(b);
+	res |= ss_cmp(b, c) || nb != (n + 4095) / 4096 ? 1 : 0;
+	res |= ss_size(b) >= ss_size(a) ? 2 : 0;
+	ss_dec_frame(&c, b, 0);
+	res |= ss_cmp(a, c) ? 4 : 0;
+	ss_dec_frame(&c, b, 3);
+	res |= ss_cmp(a, c) ? 8 : 0;
+	/* random access */
+	ss_dec_frame_block(&c, b, nb - 1);
+	ss_cpy_substr(&d, a, (nb - 1) * 4096, S_NPOS);
+	res |= ss_cmp(c, d) ? 16 : 0;
+	ss_dec_frame_block(&c, b, 3);
+	ss_cpy_substr(&d, a, 3 * 4096, 4096);
+	res |= ss_cmp(c, d) ? 32 : 0;
+	ss_dec_frame_block(&c, b, nb);
+	res |= ss_size(c) ? 64 : 0;
+	/* all block codecs, aliasing */
+	for (i = 0; i < SFR_NCODECS; i++) {
+		ss_cpy(&c, a);
+		ss_enc_frame(&c, c, 10000, (enum eSFrameCodec)i, 0);
+		ss_dec_frame(&c, c, 0);
+		res |= ss_cmp(a, c) ? 128 : 0;
+	}
+	/* corrupt block: CRC or decoding error */
+	ss_cpy(&c, b);
+	ss_get_buffer(c)[100] ^= 0x11;
+	ss_dec_frame(&d, c, 0);
+	res |= ss_size(d) ? 256 : 0;
+	ss_dec_frame_block(&d, c, 0);
+	res |= ss_size(d) ? 512 : 0;
+	ss_dec_frame_block(&d, c, 1); /* other blocks are not affected */
+	ss_cpy_substr(&b, a, 4096, 4096);
+	res |= ss_cmp(b, d) ? 1024 : 0;
+	ss_enc_frame(&b, a, 4096, SFR_LZW_HUF, 1);
+	/* truncated frame */
+	ss_cpy_substr(&c, b, 0, ss_size(b) - 1);
+	res |= ss_frame_nblocks(c) ? 2048 : 0;
+	ss_dec_frame(&d, c, 0);
+	res |= ss_size(d) ? 4096 : 0;
+	/* incompressible input, all codecs (blocks encoded in parallel) */
+	ss_resize(&a, 247991, 0);
+	p = ss_get_buffer(a);
+	for (i = 0; i < 247991; i++) {
+		acc = acc * 1103515245 + 12345;
+		p[i] = (char)(0x80 | acc >> 24);
+	}
+	for (i = 0; i < SFR_NCODECS * 2; i++) {
+		ss_enc_frame(&b, a, i % 2 ? 3294 : 2954,
+			     (enum eSFrameCodec)(i / 2), 4);
+		ss_dec_frame(&c, b, 4);
+		res |= ss_cmp(a, c) ? 8192 : 0;
+	}
+	ss_free(&a, &b, &c, &d);
+	return res;
+}
+
 static int test_sc_utf8_to_wc(const char *utf8_char,
 			      const int unicode32_expected)
 {
@@ -2316,6 +3414,177 @@ static int test_sv_sort()
 	sv_free(&v8i, &v8u, &v16i, &v16u, &v32i, &v32u, &v64i, &v64u);
 	free(r8i); free(r8u); free(r16i); free(r16u);
 	free(r32i); free(r32u); free(r64i); free(r64u);
+	/*
+	 * Unordered input with duplicates (small partitions)
+	 */
+	v16i = sv_alloc_t(SV_I16, 0);
+	v32u = sv_alloc_t(SV_U32, 0);
+	v64u = sv_alloc_t(SV_U64, 0);
+	for (i = 0; i < nelems; i++) {
+		sv_push_i(&v16i, (i * 7919) % 301 - 150);
+		sv_push_u(&v32u, (i * 7919) % 1000);
+		sv_push_u(&v64u, ((uint64_t)((i * 7919) % 301) << 40) | i);
+	}
+	sv_sort(v16i); sv_sort(v32u); sv_sort(v64u);
+	for (i = 1; i < nelems; i ++)
+		res |= sv_at_i(v16i, i - 1) <= sv_at_i(v16i, i) &&
+		       sv_at_u(v32u, i - 1) <= sv_at_u(v32u, i) &&
+		       sv_at_u(v64u, i - 1) <= sv_at_u(v64u, i) ? 0 : 1 << 30;
+	sv_free(&v16i, &v32u, &v64u);
+	return res;
+}
+
+struct SortT
+{
+	int32_t k;
+	uint32_t seq, pad;
+};
+
+#define SORTT_LESS(a, b) ((a)->k < (b)->k || \
+			  ((a)->k == (b)->k && (a)->seq < (b)->seq))
+
+SSORT_BUILD_PDQ(test_sort_sortt, struct SortT, SORTT_LESS)
+
+static int cmp_sortt(const void *a, const void *b)
+{
+	const struct SortT *x = (const struct SortT *)a,
+			   *y = (const struct SortT *)b;
+	return SORTT_LESS(x, y) ? -1 : SORTT_LESS(y, x) ? 1 : 0;
+}
+
+static int32_t test_sort_key(int pattern, size_t i, size_t n)
+{
+	switch (pattern) {
+	case 0: return (int32_t)((i * 2654435761u) % 1000003);	/* random */
+	case 1: return (int32_t)i;				/* sorted */
+	case 2: return (int32_t)(n - i);			/* reversed */
+	case 3: return 7;					/* equal */
+	case 4: return (int32_t)((i * 40503u) % 5);		/* few */
+	case 5: return (int32_t)(i < n / 2 ? i : n - i);	/* organ */
+	default: return (int32_t)(i % 64);			/* sawtooth */
+	}
+}
+
+static int test_sv_sort_gen()
+{
+	int res = 0, pattern;
+	const size_t sizes[] = { 0, 1, 2, 23, 24, 25, 129, 1000, 20000 };
+	size_t i, j, n, ns = sizeof(sizes) / sizeof(sizes[0]);
+	struct SortT e, *r, *r2;
+	sv_t *v, *w;
+	for (j = 0; j < ns; j++) {
+		n = sizes[j];
+		for (pattern = 0; pattern < 7; pattern++) {
+			v = sv_alloc(sizeof(struct SortT), n, cmp_sortt);
+			r = (struct SortT *)malloc((n + 1) * sizeof(*r));
+			r2 = (struct SortT *)malloc((n + 1) * sizeof(*r2));
+			for (i = 0; i < n; i++) {
+				e.k = test_sort_key(pattern, i, n);
+				e.seq = (uint32_t)((i * 7919) % (n + 1));
+				e.pad = 0;
+				sv_push(&v, &e);
+				r[i] = r2[i] = e;
+			}
+			w = sv_dup(v);
+			qsort(r, n, sizeof(*r), cmp_sortt);
+			sv_sort(v);
+			res |= sv_sort_with(w, struct SortT, test_sort_sortt) !=
+			       w ? 1 : 0;
+			test_sort_sortt_ctx_heap(r2, n, NULL);
+			res |= sv_size(v) != n || sv_size(w) != n ? 2 : 0;
+			for (i = 0; i < n && !res; i++) {
+				res |= memcmp(sv_at(v, i), r + i, sizeof(e)) ?
+				       4 : 0;
+				res |= memcmp(sv_at(w, i), r + i, sizeof(e)) ?
+				       8 : 0;
+				res |= memcmp(r2 + i, r + i, sizeof(e)) ? 16 : 0;
+			}
+			sv_free(&v, &w);
+			free(r);
+			free(r2);
+		}
+	}
+	/* Element size not matching the sort function */
+	v = sv_alloc_t(SV_U32, 0);
+	sv_push_u(&v, 2);
+	sv_push_u(&v, 1);
+	sv_sort_with(v, struct SortT, test_sort_sortt);
+	res |= sv_at_u(v, 0) != 2 ? 32 : 0;
+	sv_free(&v);
+	res |= sv_sort_with((sv_t *)NULL, struct SortT, test_sort_sortt) ?
+	       64 : 0;
+	return res;
+}
+
+static int test_sv_argsort()
+{
+	int res = 0, sgn;
+	size_t i, j, n = 1000, p0, p1;
+	enum eSV_Type t;
+	struct AA e;
+	char *seen = (char *)malloc(n);
+	sv_t *v, *w, *perm = NULL;
+	for (t = SV_I8; t <= SV_U64; t = (enum eSV_Type)(t + 1)) {
+		sgn = t == SV_I8 || t == SV_I16 || t == SV_I32 || t == SV_I64;
+		v = sv_alloc_t(t, n);
+		w = sv_alloc(sizeof(struct AA), n, NULL);
+		for (i = 0; i < n; i++) {
+			sv_push_i(&v, (int64_t)((i * 7919) % 301) - 150);
+			e.a = (int)sv_at_i(v, i);
+			e.b = (int)i;
+			sv_push(&w, &e);
+		}
+		if (t == SV_I64)
+			sv_set_i(&v, 3, SINT64_MIN);
+		if (t == SV_U64)
+			sv_set_u(&v, 3, SUINT64_MAX - 1);
+		sv_argsort(&perm, v);
+		res |= sv_size(perm) != n ? 1 : 0;
+		memset(seen, 0, n);
+		for (i = 0; i < n && !res; i++) {
+			p1 = (size_t)sv_at_u(perm, i);
+			if (p1 >= n || seen[p1]) {
+				res |= 2;
+				break;
+			}
+			seen[p1] = 1;
+			if (!i || res)
+				continue;
+			p0 = (size_t)sv_at_u(perm, i - 1);
+			if (sgn)
+				res |= sv_at_i(v, p0) > sv_at_i(v, p1) ||
+				       (sv_at_i(v, p0) == sv_at_i(v, p1) &&
+					p0 > p1) ? 4 : 0;
+			else
+				res |= sv_at_u(v, p0) > sv_at_u(v, p1) ||
+				       (sv_at_u(v, p0) == sv_at_u(v, p1) &&
+					p0 > p1) ? 4 : 0;
+		}
+		/* Pairs: the payload follows its key */
+		res |= sv_sort_pairs(v, w) ? 0 : 8;
+		for (i = 0; i < n && !res; i++) {
+			j = (size_t)((const struct AA *)sv_at(w, i))->b;
+			res |= (size_t)sv_at_u(perm, i) != j ? 16 : 0;
+		}
+		sv_free(&v, &w);
+	}
+	free(seen);
+	/* Generic vector (stable) */
+	v = sv_alloc(sizeof(struct AA), 4, AA_cmp);
+	sv_push(&v, &av1[2], &a2, &av1[0], &a2);
+	sv_argsort(&perm, v);
+	res |= sv_size(perm) != 4 || sv_at_u(perm, 0) != 2 ||
+	       sv_at_u(perm, 1) != 1 || sv_at_u(perm, 2) != 3 ||
+	       sv_at_u(perm, 3) != 0 ? 32 : 0;
+	/* Invalid input */
+	w = sv_alloc_t(SV_U8, 3);
+	sv_push_u(&w, 1);
+	res |= sv_sort_pairs(v, w) || sv_sort_pairs(v, v) ||
+	       sv_sort_pairs(v, NULL) ? 64 : 0;
+	sv_argsort(&perm, NULL);
+	res |= sv_size(perm) != 0 ? 128 : 0;
+	res |= sv_size(sv_argsort(&w, v)) != 1 ? 256 : 0; /* not SV_U64 */
+	sv_free(&v, &w, &perm);
 	return res;
 }
 
@@ -2328,6 +3597,180 @@ static int test_sv_sort()
 		    (sv_size(v) == 10 ? 0 : 4 << (ntest * 3));		 \
 	sv_free(&v);
 
+static int test_sv_select_chk(const sv_t *v, const sv_t *s, const size_t nth)
+{
+	int res = 0;
+	size_t i, n = sv_size(v);
+	res |= sv_size(s) != n ||
+	       v->vx.cmpf(sv_at(v, nth), sv_at(s, nth)) ? 1 : 0;
+	for (i = 0; i < n && !res; i++)
+		res |= (i < nth && sv_cmp(v, i, nth) > 0) ||
+		       (i > nth && sv_cmp(v, i, nth) < 0) ? 2 : 0;
+	return res;
+}
+
+static int test_sv_select()
+{
+	int res = 0, k;
+	size_t i, j, n, nths[4];
+	const size_t sizes[] = { 1, 20, 1000, 7000 }, ks[] = { 0, 1, 10, 600 },
+		     nk = sizeof(ks) / sizeof(ks[0]);
+	uint64_t x = 7;
+	enum eSV_Type t;
+	struct AA e;
+	sv_t *v = NULL, *s = NULL, *w = NULL, *o = NULL;
+	for (t = SV_I8; t <= SV_GEN; t = (enum eSV_Type)(t + 1))
+		for (k = 0; k < 4; k++) {
+			n = sizes[k];
+			sv_free(&v);
+			v = t == SV_GEN ? sv_alloc(sizeof(struct AA), n, AA_cmp) :
+					  sv_alloc_t(t, n);
+			for (i = 0; i < n; i++) {
+				x = x * 6364136223846793005ULL +
+				    1442695040888963407ULL;
+				/* many duplicates on even sizes */
+				e.a = e.b = (int)((x >> 33) % (k % 2 ? 1000 : 7))
+					    - 3;
+				if (t == SV_GEN)
+					sv_push(&v, &e);
+				else if (t >= SV_F32)
+					sv_push_f(&v, e.a / 4.0);
+				else
+					sv_push_i(&v, e.a);
+			}
+			sv_cpy(&s, v);
+			sv_sort(s);
+			nths[0] = 0;
+			nths[1] = n / 2;
+			nths[2] = n / 3;
+			nths[3] = n - 1;
+			for (j = 0; j < 4; j++) {
+				sv_cpy(&w, v);
+				sv_nth_element(w, nths[j]);
+				res |= test_sv_select_chk(w, s, nths[j]);
+			}
+			for (j = 0; j < nk; j++) {
+				sv_cpy(&w, v);
+				sv_partial_sort(w, ks[j]);
+				for (i = 0; i < S_MIN(ks[j], n); i++)
+					res |= v->vx.cmpf(sv_at(w, i),
+							  sv_at(s, i)) ? 4 : 0;
+				sv_top_k(&o, v, ks[j]);
+				res |= sv_size(o) != S_MIN(ks[j], n) ? 8 : 0;
+				for (i = 0; i < sv_size(o); i++)
+					res |= v->vx.cmpf(sv_at(o, i),
+							  sv_at(s, n - 1 - i)) ?
+					       16 : 0;
+			}
+			/* Aliasing */
+			sv_cpy(&w, v);
+			sv_top_k(&w, w, 3);
+			res |= sv_size(w) != S_MIN(3, n) ||
+			       v->vx.cmpf(sv_at(w, 0), sv_at(s, n - 1)) ?
+			       32 : 0;
+		}
+	/* Invalid input */
+	sv_free(&v);
+	v = sv_alloc(sizeof(struct AA), 1, NULL);
+	sv_push(&v, &a1);
+	res |= sv_size(sv_top_k(&o, v, 1)) || sv_nth_element(v, 0) != v ||
+	       sv_partial_sort(v, 5) != v ? 64 : 0;
+	sv_free(&v, &s, &w, &o);
+	return res;
+}
+
+static double test_f64_bits(const uint64_t b)
+{
+	double d;
+	memcpy(&d, &b, sizeof(d));
+	return d;
+}
+
+static uint64_t test_sv_f_bits(const sv_t *v, const size_t i)
+{
+	float f;
+	uint32_t u32;
+	uint64_t u64;
+	if (v->d.sub_type == SV_F32) {
+		f = (float)sv_at_f(v, i);
+		memcpy(&u32, &f, sizeof(u32));
+		return u32;
+	}
+	memcpy(&u64, sv_at(v, i), sizeof(u64));
+	return u64;
+}
+
+static int test_sv_float()
+{
+	int res = 0, k;
+	size_t i, n = 20000, mn, mx;
+	uint64_t x = 1;
+	double s, y;
+	enum eSV_Type t;
+	sv_t *v, *w, *perm = NULL;
+	/* -NaN, -inf, -1, -0, +0, 1, +inf, +NaN */
+	const uint64_t sp[8] = { 0xfff8000000000000ULL, 0xfff0000000000000ULL,
+				 0xbff0000000000000ULL, 0x8000000000000000ULL,
+				 0, 0x3ff0000000000000ULL,
+				 0x7ff0000000000000ULL, 0x7ff8000000000000ULL };
+	const size_t sp_order[8] = { 6, 2, 0, 4, 7, 1, 3, 5 };
+	for (t = SV_F32; t <= SV_F64; t = (enum eSV_Type)(t + 1)) {
+		v = sv_alloc_t(t, n);
+		res |= sv_elem_size(t) != (t == SV_F32 ? 4 : 8) ? 1 : 0;
+		for (i = 0, s = 0; i < n; i++) {
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			y = (double)(int64_t)(x >> 44) / 8 - 65536;
+			res |= sv_push_f(&v, y) ? 0 : 2;
+			s += y;
+		}
+		/* Values are exact in both precisions: exact sum */
+		res |= sv_sum_f(v) != s ? 4 : 0;
+		sv_minmax(v, &mn, &mx);
+		for (i = 0; i < n; i++)
+			res |= sv_at_f(v, i) < sv_at_f(v, mn) ||
+			       sv_at_f(v, i) > sv_at_f(v, mx) ? 8 : 0;
+		res |= sv_find(v, 0, sv_at(v, mx)) > mx ? 16 : 0;
+		w = sv_dup(v);
+		sv_argsort(&perm, v);
+		sv_sort(v);
+		for (i = 1; i < n; i++)
+			res |= sv_at_f(v, i - 1) > sv_at_f(v, i) ||
+			       sv_at_f(w, sv_at_u(perm, i)) != sv_at_f(v, i) ?
+			       32 : 0;
+		/* Total order: signed zeros, infinities, NaNs */
+		sv_clear(v);
+		for (k = 0; k < 8; k++)
+			sv_push_f(&v, test_f64_bits(sp[sp_order[k]]));
+		sv_cpy(&w, v);
+		sv_sort(v);
+		sv_argsort(&perm, w);
+		for (k = 0; k < 8; k++)
+			res |= test_sv_f_bits(v, k) !=
+			       test_sv_f_bits(w, sv_at_u(perm, k)) ? 64 : 0;
+		for (k = 0; k < 8; k++)
+			res |= t == SV_F64 && test_sv_f_bits(v, k) != sp[k] ?
+			       128 : 0;
+		res |= test_sv_f_bits(v, 3) == test_sv_f_bits(v, 4) ? 256 : 0;
+		res |= sv_min(w) != 2 || sv_max(w) != 4 ? 512 : 0;
+		/* Accessors */
+		res |= sv_set_f(&v, 9, 2.5) && sv_size(v) == 10 &&
+		       sv_at_f(v, 9) == 2.5 && sv_pop_f(v) == 2.5 &&
+		       sv_size(v) == 9 && sv_at_f(v, 9) == 0 ? 0 : 1024;
+		res |= sv_push_i(&v, 1) || sv_at_i(v, 0) != 0 ||
+		       sv_sum_i(v, NULL) != 0 ? 2048 : 0;
+		sv_free(&v, &w);
+	}
+	/* Float functions on other vector types */
+	v = sv_alloc_t(SV_I32, 1);
+	res |= sv_push_f(&v, 1) || sv_set_f(&v, 0, 1) || sv_size(v) ||
+	       sv_sum_f(v) != 0 ? 4096 : 0;
+	sv_push_i(&v, 1);
+	res |= sv_at_f(v, 0) != 0 || sv_pop_f(v) != 0 || sv_size(v) != 1 ?
+	       8192 : 0;
+	sv_free(&v, &perm);
+	return res;
+}
+
 static int test_sv_find()
 {
 	int res = 0;
@@ -2357,6 +3800,622 @@ static int test_sv_find()
 	return res;
 }
 
+static int test_sv_find_large()
+{
+	int res = 0;
+	size_t i, j, n = 1000, pos[3] = { 0, 517, 999 };
+	enum eSV_Type t;
+	sv_t *v, *w = NULL;
+	for (t = SV_I8; t <= SV_U64; t = (enum eSV_Type)(t + 1)) {
+		v = sv_alloc_t(t, n);
+		for (i = 0; i < n; i++)
+			sv_push_i(&v, 1);
+		/* every position mod 64 bytes, then the tail */
+		for (j = 0; j < 3; j++) {
+			sv_set_i(&v, pos[j], -2);
+			res |= sv_find_i(v, 0, -2) != pos[0] ? 1 : 0;
+			res |= sv_find_i(v, pos[j], -2) != pos[j] ? 2 : 0;
+			res |= sv_find_u(v, pos[j] + 1, 3) != S_NPOS ? 4 : 0;
+		}
+		res |= sv_find(v, 1, sv_at(v, 517)) != 517 ? 8 : 0;
+		sv_find_all(&w, v, 1, sv_at(v, 0));
+		res |= sv_size(w) != 2 || sv_at_u(w, 0) != 517 ||
+		       sv_at_u(w, 1) != 999 ? 16 : 0;
+		sv_find_all(&w, v, 0, sv_at(v, 1));
+		res |= sv_size(w) != n - 3 || sv_at_u(w, 0) != 1 ? 32 : 0;
+		sv_free(&v);
+	}
+	v = sv_alloc(sizeof(struct AA), 0, NULL);
+	for (i = 0; i < 100; i++)
+		sv_push(&v, i % 10 ? &a1 : &a2);
+	sv_find_all(&w, v, 5, &a2);
+	res |= sv_size(w) != 9 || sv_at_u(w, 8) != 90 ? 64 : 0;
+	res |= sv_find(v, 91, &a2) != S_NPOS ? 128 : 0;
+	/* aliasing: the output is the input */
+	sv_free(&v);
+	v = sv_alloc_t(SV_I32, 0);
+	for (i = 0; i < 100; i++)
+		sv_push_i(&v, i % 10 ? 1 : 7);
+	sv_find_all(&v, v, 5, sv_at(v, 0));
+	res |= v->d.sub_type != SV_U64 || sv_size(v) != 9 ||
+	       sv_at_u(v, 0) != 10 || sv_at_u(v, 8) != 90 ? 256 : 0;
+	/* offsets above 255: 8/16-bit outputs are not written */
+	sv_free(&v, &w);
+	v = sv_alloc_t(SV_U8, 0);
+	for (i = 0; i < 70000; i++)
+		sv_push_u(&v, i % 1000 ? 1 : 2);
+	for (i = 0; i < 4; i++) {
+		w = sv_alloc_t(i == 0 ? SV_U8 : i == 1 ? SV_I16 :
+			       i == 2 ? SV_U32 : SV_I64, 0);
+		sv_push_u(&w, 5);
+		sv_find_all(&w, v, 0, sv_at(v, 0));
+		res |= i < 2 ? (sv_size(w) ? 512 : 0) :
+		       (sv_size(w) != 70 || sv_at_u(w, 1) != 1000 ||
+			sv_at_u(w, 69) != 69000 ? 1024 : 0);
+		sv_free(&w);
+	}
+	sv_free(&v, &w);
+	return res;
+}
+
+static int test_sv_bsearch()
+{
+	int res = 0, sgn;
+	int64_t t;
+	size_t i, n = 300, lb, ub, slot;
+	enum eSV_Type tt;
+	sv_t *v, *w, *idx = NULL;
+	for (tt = SV_I8; tt <= SV_U64; tt = (enum eSV_Type)(tt + 1)) {
+		sgn = tt == SV_I8 || tt == SV_I16 || tt == SV_I32 ||
+		      tt == SV_I64;
+		v = sv_alloc_t(tt, n);
+		w = sv_alloc_t(tt, 1);
+		for (i = 0; i < n; i++)
+			sv_push_i(&v, (int64_t)(i / 3) * 2 - 40);
+		sv_sort(v);
+		sv_build_search_index(&idx, v);
+		res |= sv_size(idx) != n + 1 ? 1 : 0;
+		for (t = -50; t < 220; t++) {
+			sv_set_i(&w, 0, t);
+			for (lb = 0; lb < n; lb++)
+				if (sgn ? sv_at_i(v, lb) >= sv_at_i(w, 0) :
+					  sv_at_u(v, lb) >= sv_at_u(w, 0))
+					break;
+			for (ub = lb; ub < n; ub++)
+				if (sv_at_u(v, ub) != sv_at_u(w, 0))
+					break;
+			res |= sv_lower_bound(v, sv_at(w, 0)) != lb ? 2 : 0;
+			res |= sv_upper_bound(v, sv_at(w, 0)) != ub ? 4 : 0;
+			res |= sv_bsearch(v, sv_at(w, 0)) !=
+			       (lb < ub ? lb : S_NPOS) ? 8 : 0;
+			slot = sv_search_index(idx, sv_at(w, 0));
+			res |= lb == n ? (slot != S_NPOS ? 16 : 0) :
+			       slot == S_NPOS ||
+			       sv_at_u(idx, slot) != sv_at_u(v, lb) ? 32 : 0;
+		}
+		sv_free(&v, &w);
+	}
+	v = sv_alloc(sizeof(struct AA), 3, AA_cmp);
+	sv_push(&v, &av1[0], &av1[1], &av1[2]);
+	res |= sv_lower_bound(v, &a2) != 1 || sv_upper_bound(v, &a2) != 2 ||
+	       sv_bsearch(v, &a1) != 0 || sv_bsearch(v, &av1[2]) != 2 ?
+	       64 : 0;
+	sv_build_search_index(&idx, v);
+	slot = sv_search_index(idx, &a2);
+	res |= slot == S_NPOS ||
+	       ((const struct AA *)sv_at(idx, slot))->a != a2.a ? 128 : 0;
+	res |= sv_lower_bound(NULL, &a1) || sv_bsearch(v, NULL) != S_NPOS ?
+	       256 : 0;
+	sv_free(&v, &idx);
+	return res;
+}
+
+static int test_sv_setops_chk(const sv_t *o, const int *ca, const int *cb,
+			      const int op, const int64_t base)
+{
+	int res = 0, k, c;
+	size_t i = 0;
+	for (k = 0; k < 500; k++) {
+		c = op == 0 ? ca[k] + cb[k] : op == 1 ? ca[k] || cb[k] :
+		    op == 2 ? ca[k] && cb[k] : ca[k] && !cb[k];
+		for (; c > 0; c--, i++)
+			res |= i >= sv_size(o) ||
+			       sv_at_i(o, i) != base + k ? 1 : 0;
+	}
+	return res | (i != sv_size(o) ? 2 : 0);
+}
+
+static int test_sv_setops()
+{
+	int res = 0, ca[500], cb[500], op, sgn, s;
+	const size_t sizes[][2] = { { 0, 0 }, { 0, 100 }, { 100, 0 },
+				    { 1, 1 }, { 300, 280 }, { 2000, 1500 },
+				    { 10, 3000 }, { 3000, 7 } };
+	size_t i, k, ns = sizeof(sizes) / sizeof(sizes[0]);
+	int64_t base, x;
+	enum eSV_Type t;
+	sv_t *a = NULL, *b = NULL, *o = NULL;
+	for (t = SV_I8; t <= SV_U64; t = (enum eSV_Type)(t + 1)) {
+		sgn = t == SV_I8 || t == SV_I16 || t == SV_I32 || t == SV_I64;
+		base = sgn ? -120 : 0;
+		for (k = 0; k < ns; k++) {
+			memset(ca, 0, sizeof(ca));
+			memset(cb, 0, sizeof(cb));
+			sv_free(&a, &b);
+			a = sv_alloc_t(t, sizes[k][0]);
+			b = sv_alloc_t(t, sizes[k][1]);
+			s = t < SV_I16 ? 240 : 500; /* value range */
+			for (i = 0; i < sizes[k][0]; i++) {
+				x = (int64_t)((i * 7919 + k) % (size_t)s);
+				sv_push_i(&a, base + x);
+				ca[x]++;
+			}
+			for (i = 0; i < sizes[k][1]; i++) {
+				x = (int64_t)((i * 104729 + 3) % (size_t)s);
+				sv_push_i(&b, base + x);
+				cb[x]++;
+			}
+			sv_sort(a);
+			sv_sort(b);
+			sv_merge(&o, a, b);
+			res |= test_sv_setops_chk(o, ca, cb, 0, base);
+			sv_union(&o, a, b);
+			res |= test_sv_setops_chk(o, ca, cb, 1, base) << 2;
+			sv_intersect(&o, a, b);
+			res |= test_sv_setops_chk(o, ca, cb, 2, base) << 4;
+			sv_difference(&o, a, b);
+			res |= test_sv_setops_chk(o, ca, cb, 3, base) << 6;
+			for (op = 0; op < 500; op++)
+				cb[op] = 0;
+			sv_unique(a);
+			res |= test_sv_setops_chk(a, ca, cb, 1, base) << 8;
+		}
+	}
+	/* Aliasing, type changes, invalid input */
+	sv_free(&a, &b, &o);
+	a = sv_alloc_t(SV_U32, 3);
+	b = sv_alloc_t(SV_U32, 3);
+	o = sv_alloc_t(SV_I8, 1);
+	sv_push_u(&a, 1); sv_push_u(&a, 3); sv_push_u(&a, 5);
+	sv_push_u(&b, 3); sv_push_u(&b, 4); sv_push_u(&b, 5);
+	sv_intersect(&o, a, b);
+	res |= sv_size(o) != 2 || sv_at_u(o, 0) != 3 || sv_at_u(o, 1) != 5 ||
+	       o->d.sub_type != SV_U32 ? 1 << 10 : 0;
+	sv_union(&a, a, b);
+	res |= sv_size(a) != 4 || sv_at_u(a, 3) != 5 ? 1 << 11 : 0;
+	sv_difference(&b, a, b);
+	res |= sv_size(b) != 1 || sv_at_u(b, 0) != 1 ? 1 << 12 : 0;
+	sv_free(&b);
+	b = sv_alloc_t(SV_U64, 0);
+	sv_merge(&o, a, b);
+	res |= sv_size(o) != 0 || sv_size(sv_merge(&o, a, NULL)) != 0 ?
+	       1 << 13 : 0;
+	sv_free(&a, &b, &o);
+	a = sv_alloc(sizeof(struct AA), 4, AA_cmp);
+	sv_push(&a, &a1, &a1, &a2, &a2);
+	sv_unique(a);
+	res |= sv_size(a) != 2 ? 1 << 14 : 0;
+	sv_free(&a);
+	return res;
+}
+
+static int test_sv_reductions()
+{
+	int res = 0, sgn;
+	size_t i, n = 1000, mn, mx, bins = 7;
+	int64_t x, si, rs, bin_lo = -20;
+	sbool_t ovf;
+	enum eSV_Type t;
+	uint64_t cnt[7];
+	sv_t *v, *h = NULL;
+	for (t = SV_I8; t <= SV_U64; t = (enum eSV_Type)(t + 1)) {
+		sgn = t == SV_I8 || t == SV_I16 || t == SV_I32 || t == SV_I64;
+		v = sv_alloc_t(t, n);
+		for (i = 0; i < n; i++)
+			sv_push_i(&v, (int64_t)((i * 37) % 101) - 50);
+		for (i = 0, rs = 0, mn = mx = 0; i < n; i++) {
+			rs += sgn ? sv_at_i(v, i) : (int64_t)sv_at_u(v, i);
+			if (sgn ? sv_at_i(v, i) < sv_at_i(v, mn) :
+				  sv_at_u(v, i) < sv_at_u(v, mn))
+				mn = i;
+			if (sgn ? sv_at_i(v, i) > sv_at_i(v, mx) :
+				  sv_at_u(v, i) > sv_at_u(v, mx))
+				mx = i;
+		}
+		si = sv_sum_i(v, &ovf);
+		res |= (t != SV_U64 && (si != rs || ovf)) ? 1 : 0;
+		res |= sv_min(v) != mn || sv_max(v) != mx ? 2 : 0;
+		memset(cnt, 0, sizeof(cnt));
+		for (i = 0; i < n; i++) {
+			x = sgn ? sv_at_i(v, i) : (int64_t)sv_at_u(v, i);
+			if ((sgn || x >= 0) && x >= bin_lo && x < bin_lo + 35)
+				cnt[(x - bin_lo) / 5]++;
+		}
+		sv_histogram(&h, v, bin_lo, 5, bins);
+		for (i = 0; i < bins; i++)
+			res |= sv_at_u(h, i) != cnt[i] ? 4 : 0;
+		res |= sv_size(h) != bins ? 8 : 0;
+		sv_free(&v);
+	}
+	/* 128-bit accumulation */
+	v = sv_alloc_t(SV_I64, 3);
+	sv_push_i(&v, SINT64_MAX);
+	sv_push_i(&v, SINT64_MAX);
+	sv_push_i(&v, -SINT64_MAX);
+	res |= sv_sum_i(v, &ovf) != SINT64_MAX || ovf ? 16 : 0;
+	sv_push_i(&v, 1);
+	res |= sv_sum_i(v, &ovf) != SINT64_MAX || !ovf ? 32 : 0;
+	sv_free(&v);
+	v = sv_alloc_t(SV_U64, 3);
+	sv_push_u(&v, SUINT64_MAX);
+	sv_push_u(&v, SUINT64_MAX);
+	res |= sv_sum_u(v, &ovf) != SUINT64_MAX || !ovf ? 64 : 0;
+	sv_histogram(&h, v, -1, SUINT64_MAX / 4, 4);
+	res |= sv_at_u(h, 3) != 0 ? 128 : 0;
+	sv_free(&v);
+	/* generic */
+	v = sv_alloc(sizeof(struct AA), 3, AA_cmp);
+	sv_push(&v, &av1[1], &av1[2], &av1[0]);
+	res |= !sv_minmax(v, &mn, &mx) || mn != 2 || mx != 1 ? 256 : 0;
+	sv_clear(v);
+	res |= sv_minmax(v, &mn, &mx) || mn != S_NPOS ? 512 : 0;
+	sv_free(&v, &h);
+	return res;
+}
+
+static int test_spv_chk(const sv_t *v, const spv_t *p)
+{
+	int res = 0;
+	size_t i, n = sv_size(v);
+	sv_t *u = NULL, *r = NULL;
+	spv_unpack(&u, p);
+	res |= spv_size(p) != n || sv_size(u) != n ||
+	       spv_type(p) != (enum eSV_Type)v->d.sub_type ? 1 : 0;
+	for (i = 0; i < sv_size(u) && !res; i++)
+		res |= sv_at_u(u, i) != sv_at_u(v, i) ||
+		       spv_at_u(p, i) != sv_at_u(v, i) ||
+		       spv_at_i(p, i) != sv_at_i(v, i) ? 2 : 0;
+	spv_unpack_range(&r, p, n / 3, 300);
+	res |= sv_size(r) != S_MIN(n - n / 3, 300) ? 4 : 0;
+	for (i = 0; i < sv_size(r) && !res; i++)
+		res |= sv_at_u(r, i) != sv_at_u(v, n / 3 + i) ? 8 : 0;
+	res |= spv_at_u(p, n) != 0 ? 16 : 0;
+	sv_free(&u, &r);
+	return res;
+}
+
+static int test_spv()
+{
+	int res = 0, mode;
+	const size_t sizes[] = { 0, 1, 127, 128, 129, 1000, 5000 };
+	size_t i, k, ns = sizeof(sizes) / sizeof(sizes[0]), ps;
+	uint64_t x = 1;
+	enum eSV_Type t;
+	sv_t *v = NULL, *u = NULL;
+	spv_t *p = NULL;
+	for (t = SV_I8; t <= SV_U64; t = (enum eSV_Type)(t + 1))
+		for (k = 0; k < ns; k++)
+			for (mode = 0; mode < 4; mode++) {
+				sv_free(&v);
+				v = sv_alloc_t(t, sizes[k]);
+				for (i = 0; i < sizes[k]; i++) {
+					x = x * 6364136223846793005ULL +
+					    1442695040888963407ULL;
+					/* narrow range, full range, mixed */
+					sv_push_u(&v, mode & 1 ? x :
+						  mode & 2 || i % 300 ?
+						  (x >> 40) % 1000 : x);
+				}
+				if (mode >= 2)
+					sv_sort(v);
+				spv_pack(&p, v);
+				res |= test_spv_chk(v, p) << (mode * 5);
+			}
+	/* Compression ratio: sorted ids with small gaps */
+	sv_free(&v);
+	v = sv_alloc_t(SV_U64, 10000);
+	for (i = 0; i < 10000; i++)
+		sv_push_u(&v, 1000000000000ULL + i * 100 + i % 7);
+	spv_pack(&p, v);
+	res |= sv_size(p) > 10000 * 2 || test_spv_chk(v, p) ? 1 << 20 : 0;
+	/* Corrupted/truncated input, invalid output */
+	ps = sv_size(p);
+	sv_set_size(p, ps - 9);
+	spv_unpack(&u, p);
+	res |= sv_size(u) >= 10000 || spv_size(p) != 10000 ? 1 << 21 : 0;
+	sv_set_size(p, ps);
+	((char *)sv_get_buffer(p))[16 + 8] = 65; /* block 0 width */
+	spv_unpack(&u, p);
+	res |= sv_size(u) != 0 || spv_at_u(p, 0) != 0 ? 1 << 22 : 0;
+	((char *)sv_get_buffer(p))[0] = 99; /* version */
+	res |= spv_size(p) || spv_type(p) != SV_GEN ? 1 << 23 : 0;
+	sv_free(&u);
+	u = sv_alloc_t(SV_I8, 1);
+	spv_pack(&p, v);
+	spv_unpack(&u, p);
+	res |= sv_size(u) || spv_pack(&u, v) != u || sv_size(u) ? 1 << 24 : 0;
+	spv_pack(&p, NULL);
+	res |= spv_size(p) || sv_size(p) ? 1 << 25 : 0;
+	sv_free(&v, &u, &p);
+	return res;
+}
+
+static int test_sdq_chk(const sdq_t *q, const uint32_t *ref, size_t ref_h,
+			size_t n)
+{
+	int res = 0;
+	size_t i, n1, n2;
+	const void *s1, *s2;
+	res |= sdq_size(q) != n || sdq_view(q, &s1, &n1, &s2, &n2) != n ||
+	       n1 + n2 != n || (n2 && !s2) ? 1 : 0;
+	for (i = 0; i < n && !res; i++) {
+		uint32_t e = *(const uint32_t *)sdq_at(q, i),
+			 ev = i < n1 ? ((const uint32_t *)s1)[i] :
+				       ((const uint32_t *)s2)[i - n1];
+		res |= e != ref[ref_h + i] || ev != e ? 2 : 0;
+	}
+	res |= sdq_at(q, n) != NULL ? 4 : 0;
+	return res;
+}
+
+static int test_sdq()
+{
+	int res = 0;
+	uint32_t ref[4096], e = 0, x = 1;
+	size_t i, h = 2048, n = 0;
+	sdq_t *q = sdq_alloc_t(SV_U32, 1), *f = sdq_alloca_t(SV_U32, 5),
+	      *d = NULL;
+	/* Random operations, checked against a plain array */
+	for (i = 0; i < 3000 && !res; i++) {
+		x = x * 1103515245 + 12345;
+		e = (uint32_t)i;
+		switch ((x >> 16) % 5) {
+		case 0:
+		case 1:
+			ref[h + n] = (uint32_t)i;
+			n++;
+			res |= sdq_push_back(&q, &e) ? 0 : 8;
+			break;
+		case 2:
+			ref[--h] = (uint32_t)i;
+			n++;
+			res |= sdq_push_front(&q, &e) ? 0 : 16;
+			break;
+		case 3:
+			res |= sdq_pop_front(q, &e) != (n > 0) ||
+			       (n && e != ref[h]) ? 32 : 0;
+			if (n) {
+				h++;
+				n--;
+			}
+			break;
+		default:
+			res |= sdq_pop_back(q, &e) != (n > 0) ||
+			       (n && e != ref[h + n - 1]) ? 64 : 0;
+			if (n)
+				n--;
+			break;
+		}
+		res |= test_sdq_chk(q, ref, h, n);
+	}
+	res |= n && (*(const uint32_t *)sdq_front(q) != ref[h] ||
+		     *(const uint32_t *)sdq_back(q) != ref[h + n - 1]) ?
+	       128 : 0;
+	d = sdq_dup(q);
+	res |= test_sdq_chk(d, ref, h, n) << 8;
+	sdq_clear(q);
+	res |= !sdq_empty(q) || sdq_front(q) || sdq_pop_front(q, NULL) ?
+	       1 << 12 : 0;
+	/* Fixed capacity: FIFO usage wrapping around the buffer */
+	for (e = 0; e < 5; e++)
+		res |= sdq_push_back(&f, &e) ? 0 : 1 << 13;
+	res |= sdq_push_back(&f, &e) || sdq_push_front(&f, &e) ||
+	       sdq_capacity(f) != 5 ? 1 << 14 : 0;
+	for (i = 5; i < 50; i++) {
+		e = (uint32_t)i;
+		res |= !sdq_pop_front(f, NULL) || !sdq_push_back(&f, &e) ?
+		       1 << 15 : 0;
+	}
+	for (i = 0; i < 5; i++)
+		ref[i] = (uint32_t)(45 + i);
+	res |= test_sdq_chk(f, ref, 0, 5) << 17;
+	/* Generic elements */
+	sdq_free(&d);
+	d = sdq_alloc(sizeof(struct AA), 0);
+	res |= !sdq_push_front(&d, &a1) || !sdq_push_front(&d, &a2) ||
+	       !sdq_pop_back(d, NULL) ||
+	       ((const struct AA *)sdq_front(d))->a != a2.a ? 1 << 21 : 0;
+	sdq_free(&q, &d);
+	return res;
+}
+
+static int test_spq_chk(spq_t *h, const sv_t *ref, const sv_t *ids,
+			const sbool_t max)
+{
+	int res = 0;
+	int64_t k = 0;
+	uint64_t p = 0;
+	size_t i, n = sv_size(ref);
+	res |= spq_size(h) != n ? 1 : 0;
+	for (i = 0; i < n && !res; i++) {
+		res |= !spq_top_i(h, &k, NULL) ||
+		       k != sv_at_i(ref, max ? n - 1 - i : i) ? 2 : 0;
+		res |= !spq_pop_i(h, &k, &p) || p >= sv_size(ids) ||
+		       sv_at_i(ids, (size_t)p) != k ? 4 : 0;
+	}
+	res |= spq_pop_i(h, &k, &p) || !spq_empty(h) ? 8 : 0;
+	return res;
+}
+
+static int test_spq()
+{
+	int res = 0, mode;
+	size_t i, n = 1000;
+	uint64_t x = 1, k;
+	sv_t *ref = NULL, *ids = NULL;
+	spq_t *h = NULL, *h2 = NULL, *f;
+	enum eSV_Type t;
+	for (mode = 0; mode < 4 && !res; mode++) {
+		const sbool_t max = (mode & 1) ? S_TRUE : S_FALSE;
+		t = (mode & 2) ? SV_U32 : SV_I64;
+		ref = sv_alloc_t(t, n);
+		for (i = 0; i < n; i++) {
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			sv_push_u(&ref, (mode & 2) ? x >> 32 :
+					i % 3 ? x : (x >> 60));
+		}
+		ids = sv_dup(ref);
+		/* Incremental insertion */
+		h = spq_alloc(t, max ? SPQ_MAX : SPQ_MIN, S_TRUE, 0);
+		for (i = 0; i < n; i++)
+			res |= spq_push_i(&h, sv_at_i(ref, i), i) ? 0 : 1;
+		h2 = spq_dup(h);
+		sv_sort(ref);
+		res |= test_spq_chk(h, ref, ids, max) << 1;
+		res |= test_spq_chk(h2, ref, ids, max) << 5;
+		/* Bulk build, over a non-empty heap */
+		sv_clear(ref);
+		spq_push_i(&h, sv_at_i(ids, 0), 0);
+		sv_push_i(&ref, sv_at_i(ids, 0));
+		sv_free(&h2);
+		h2 = sv_alloc_t(SV_U32, n);
+		for (i = 0; i < n; i++)
+			sv_push_u(&h2, i);
+		res |= spq_heapify(&h, ids, h2) ? 0 : 1 << 9;
+		sv_cat(&ref, ids);
+		sv_sort(ref);
+		res |= test_spq_chk(h, ref, ids, max) << 10;
+		sv_free(&ref, &ids, &h, &h2);
+	}
+	res |= res ? (mode << 16) : 0;
+	/* Fixed capacity, no payload */
+	f = spq_alloca(SV_U64, SPQ_MIN, S_FALSE, 3);
+	res |= !spq_push_u(&f, 5, 1) || !spq_push_u(&f, 3, 1) ||
+	       !spq_push_u(&f, 4, 1) || spq_push_u(&f, 1, 1) ||
+	       spq_capacity(f) != 3 ? 1 << 20 : 0;
+	res |= !spq_pop_u(f, &k, &x) || k != 3 || x != 0 ||
+	       !spq_top_u(f, &k, NULL) || k != 4 ? 1 << 21 : 0;
+	spq_clear(f);
+	res |= spq_top_u(f, &k, NULL) || spq_heapify(&f, NULL, NULL) ?
+	       1 << 22 : 0;
+	return res;
+}
+
+struct SLQTest
+{
+	slq_t *q;
+	size_t np, nc, n;
+	uint64_t sum[4];
+	int err[4];
+};
+
+/* Jobs [0, np): producers, [np, np + nc): consumers */
+static void test_slq_job(void *context, size_t i)
+{
+	struct SLQTest *t = (struct SLQTest *)context;
+	uint64_t v[4], last[4] = { 0, 0, 0, 0 }, p, x;
+	size_t j, k, left;
+	if (i < t->np) { /* values: producer id << 32 | 1 ... n */
+		for (j = 1; j <= t->n; j += k) {
+			for (k = 0; k < 4; k++)
+				v[k] = (uint64_t)i << 32 | (j + k);
+			k = slq_push_n(t->q, v, S_MIN(i + 1, t->n - j + 1));
+			if (!k)
+				s_yield();
+		}
+		return;
+	}
+	i -= t->np;
+	for (left = t->n * t->np / t->nc; left > 0; left -= k) {
+		k = slq_pop_n(t->q, v, S_MIN(i + 1, left));
+		if (!k)
+			s_yield();
+		for (j = 0; j < k; j++) {
+			p = (v[j] >> 32) & 3;
+			x = v[j] & 0xffffffff;
+			t->err[i] |= x <= last[p] ? 1 : 0; /* FIFO order */
+			last[p] = x;
+			t->sum[i] += x;
+		}
+	}
+}
+
+static int test_slq_mode(const enum eSLQ_Mode mode)
+{
+	int res = 0;
+	size_t i, n;
+	uint64_t v[20], w[20];
+	char buf[1024];
+	slq_t *q = slq_alloc(mode, sizeof(uint64_t), 5), *r;
+	res |= !q || slq_capacity(q) != 8 || slq_size(q) ? 1 : 0;
+	if (res)
+		return res;
+	/* Full/empty, wrap around, batches */
+	for (i = 0; i < 20; i++)
+		v[i] = i + 1;
+	res |= slq_push_n(q, v, 20) != 8 || slq_push(q, v) ||
+	       slq_size(q) != 8 ? 2 : 0;
+	res |= slq_pop_n(q, w, 3) != 3 || w[0] != 1 || w[2] != 3 ? 4 : 0;
+	res |= slq_push_n(q, v + 8, 5) != 3 || slq_size(q) != 8 ? 8 : 0;
+	for (n = 0; slq_pop(q, w + n); n++)
+		;
+	res |= n != 8 || slq_size(q) ? 16 : 0;
+	for (i = 0; i < n; i++)
+		res |= w[i] != i + 4 ? 32 : 0;
+	for (i = 0; i < 100; i++) {
+		res |= slq_push_n(q, v, i % 7 + 1) != i % 7 + 1 ? 64 : 0;
+		res |= slq_pop_n(q, w, 20) != i % 7 + 1 ||
+		       w[i % 7] != i % 7 + 1 ? 128 : 0;
+	}
+	slq_free(&q);
+	res |= q ? 256 : 0;
+	/* Caller buffer: not freed */
+	res |= slq_alloc_size(mode, 10, 16) > sizeof(buf) ? 512 : 0;
+	r = slq_alloc_raw(mode, buf, 10, 16);
+	res |= !r || !slq_push(r, "123456789") || !slq_pop(r, w) ||
+	       memcmp(w, "123456789", 10) ? 1024 : 0;
+	slq_free(&r);
+	res |= !r || slq_alloc_raw(mode, buf + 1, 10, 16) ||
+	       slq_alloc(mode, 0, 16) ? 2048 : 0;
+	return res;
+}
+
+static int test_slq_threads(const enum eSLQ_Mode mode, const size_t np,
+			    const size_t nc)
+{
+	int res = 0;
+	size_t i;
+	uint64_t sum = 0;
+	struct SLQTest t;
+	memset(&t, 0, sizeof(t));
+	t.q = slq_alloc(mode, sizeof(uint64_t), 64);
+	t.np = np;
+	t.nc = nc;
+	t.n = 100000;
+	s_par_run(np + nc, np + nc, test_slq_job, &t);
+	for (i = 0; i < nc; i++) {
+		sum += t.sum[i];
+		res |= t.err[i];
+	}
+	res |= sum != (uint64_t)np * t.n * (t.n + 1) / 2 || slq_size(t.q) ?
+	       2 : 0;
+	slq_free(&t.q);
+	return res;
+}
+
+static int test_slq()
+{
+	int res = test_slq_mode(SLQ_SPSC) | test_slq_mode(SLQ_MPMC) << 12;
+#if defined(S_THREADS_POSIX) || defined(S_THREADS_WIN32)
+	if (slq_lock_free()) {
+		res |= test_slq_threads(SLQ_SPSC, 1, 1) << 24;
+		res |= test_slq_threads(SLQ_MPMC, 2, 2) << 26;
+		res |= test_slq_threads(SLQ_MPMC, 3, 1) << 28;
+	}
+#endif
+	return res;
+}
+
 static int test_sv_push_pop_set()
 {
 	size_t as = 10;
@@ -3555,6 +5614,57 @@ static int test_sbitio()
 	size_t r8 = sbio_read(&bio, 8);
 	int res = r32 != 0x7834125A ? 1 : r8 != 0x56 ? 2 :
 		  sbio_off(&bio) != 5 ? 4 : 0;
+	/*
+	 * Short reads
+	 */
+	sbio_read_init(&bio, tmp);
+	size_t r1 = sbio_read(&bio, 1), r3 = sbio_read(&bio, 3),
+	       r4 = sbio_read(&bio, 4), r12 = sbio_read(&bio, 12);
+	res |= r1 != 0 || r3 != 5 || r4 != 5 ? 8 : r12 != 0x412 ? 16 : 0;
+	return res;
+}
+
+static int test_sbitio64()
+{
+	unsigned char t1[600], t2[600 + SBIO64_PAD];
+	size_t i, c, cb, s1, s2, seed = 1;
+	int res = 0;
+	sbio_t b1;
+	sbio64_t b2;
+	/*
+	 * Same stream format as sbio_t
+	 */
+	sbio_write_init(&b1, t1);
+	sbio64_write_init(&b2, t2);
+	for (i = 0; i < 300; i++) {
+		seed = seed * 1103515245 + 12345;
+		cb = 1 + (seed >> 16) % 16;
+		c = (seed >> 4) & S_NBITMASK(cb);
+		sbio_write(&b1, c, cb);
+		sbio64_write(&b2, c, cb);
+	}
+	sbio64_write(&b2, 0x12345678, 32);
+	s1 = sbio_write_close(&b1);
+	s2 = sbio64_write_close(&b2);
+	res |= s2 != s1 + 4 || memcmp(t1, t2, s1) ? 1 : 0;
+	/*
+	 * Read back (with the exact size: tail without padding)
+	 */
+	sbio64_read_init(&b2, t2, s2);
+	for (i = 0, seed = 1; i < 300; i++) {
+		seed = seed * 1103515245 + 12345;
+		cb = 1 + (seed >> 16) % 16;
+		c = (seed >> 4) & S_NBITMASK(cb);
+		if (i % 2)
+			res |= sbio64_peek(&b2, cb) != c ? 2 : 0;
+		res |= sbio64_read(&b2, cb) != c ? 4 : 0;
+	}
+	res |= sbio64_read(&b2, 32) != 0x12345678 ? 8 : 0;
+	res |= sbio64_off(&b2) != s2 ? 16 : 0;
+	/*
+	 * Reading past the end gives zeros
+	 */
+	res |= sbio64_read(&b2, 8) != 0 || sbio64_off(&b2) != s2 + 1 ? 32 : 0;
 	return res;
 }
 
@@ -3646,6 +5756,14 @@ int main()
 	STEST_ASSERT(test_sb(1500));
 	STEST_ASSERT(test_sb(8192));
 	STEST_ASSERT(test_sb(10001));
+	STEST_ASSERT(test_sb_setops());
+	STEST_ASSERT(test_sb_find_range());
+	STEST_ASSERT(test_sb_rank_select());
+	STEST_ASSERT(test_sb_atomic());
+	STEST_ASSERT(test_srb());
+	STEST_ASSERT(test_sbf());
+	STEST_ASSERT(test_shll());
+	STEST_ASSERT(test_scms());
 #ifndef S_MINIMAL
 	STEST_ASSERT(test_sb(128 * 1024));
 	STEST_ASSERT(test_sb(1000 * 1000 + 1));
@@ -3789,7 +5907,18 @@ int main()
 		MK_TEST_SS_DUP_CPY_CAT(enc_lzw, dec_lzw, ci[j], co);
 		ss_enc_rle(&co, ci[j]);
 		MK_TEST_SS_DUP_CPY_CAT(enc_rle, dec_rle, ci[j], co);
+		ss_enc_huf(&co, ci[j]);
+		MK_TEST_SS_DUP_CPY_CAT(enc_huf, dec_huf, ci[j], co);
+		ss_enc_rle_huf(&co, ci[j]);
+		MK_TEST_SS_DUP_CPY_CAT(enc_rle_huf, dec_rle_huf, ci[j], co);
+		ss_enc_lzw_huf(&co, ci[j]);
+		MK_TEST_SS_DUP_CPY_CAT(enc_lzw_huf, dec_lzw_huf, ci[j], co);
 	}
+	STEST_ASSERT(test_ss_huf());
+	STEST_ASSERT(test_ss_lzw_dict());
+	STEST_ASSERT(test_ss_rle_runs());
+	STEST_ASSERT(test_senc_lzw_bound());
+	STEST_ASSERT(test_ss_frame());
 	STEST_ASSERT(test_ss_dup_erase("hello", 2, 2, "heo"));
 	STEST_ASSERT(test_ss_dup_erase_u());
         STEST_ASSERT(test_ss_dup_replace("hello", "ll", "*LL*", "he*LL*o"));
@@ -4008,7 +6137,19 @@ int main()
 	STEST_ASSERT(test_sv_erase());
 	STEST_ASSERT(test_sv_resize());
 	STEST_ASSERT(test_sv_sort());
+	STEST_ASSERT(test_sv_sort_gen());
+	STEST_ASSERT(test_sv_argsort());
+	STEST_ASSERT(test_sv_float());
+	STEST_ASSERT(test_sv_select());
 	STEST_ASSERT(test_sv_find());
+	STEST_ASSERT(test_sv_find_large());
+	STEST_ASSERT(test_sv_bsearch());
+	STEST_ASSERT(test_sv_setops());
+	STEST_ASSERT(test_sv_reductions());
+	STEST_ASSERT(test_spv());
+	STEST_ASSERT(test_sdq());
+	STEST_ASSERT(test_spq());
+	STEST_ASSERT(test_slq());
 	STEST_ASSERT(test_sv_push_pop_set());
 	STEST_ASSERT(test_sv_push_pop_set_i());
 	STEST_ASSERT(test_sv_push_pop_set_u());
@@ -4051,6 +6192,7 @@ int main()
 	STEST_ASSERT(test_endianess());
 	STEST_ASSERT(test_alignment());
 	STEST_ASSERT(test_sbitio());
+	STEST_ASSERT(test_sbitio64());
 	STEST_ASSERT(test_lsb_msb());
 	/*
 	 * Report
@@ -14,8 +14,16 @@ extern "C" {
  */
 
 #include "sbitset.h"
+#include "sbloom.h"
+#include "scms.h"
+#include "sdeque.h"
+#include "shll.h"
+#include "slqueue.h"
 #include "smap.h"
 #include "smset.h"
+#include "spqueue.h"
+#include "spvector.h"
+#include "srbitmap.h"
 #include "sstring.h"
 #include "svector.h"
 
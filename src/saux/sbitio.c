@@ -63,6 +63,12 @@ size_t sbio_read(sbio_t *bio, size_t code_bits)
 {
 	size_t code = 0;
 	const unsigned char *b = bio->br;
+	if (code_bits <= bio->acc) { /* enough bits in the accumulator */
+		code = bio->accbuf & S_NBITMASK(code_bits);
+		bio->accbuf >>= code_bits;
+		bio->acc -= code_bits;
+		return code;
+	}
 	if (bio->acc) {
 		code |= bio->accbuf;
 		code_bits -= bio->acc;
@@ -79,7 +85,7 @@ size_t sbio_read(sbio_t *bio, size_t code_bits)
 		bio->acc = 8 - code_bits;
 	} else {
 		bio->acc = 0;
+		bio->accbuf = 0;
 	}
 	return code;
 }
-
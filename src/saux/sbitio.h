@@ -45,6 +45,109 @@ void sbio_read_init(sbio_t *bio, const unsigned char *b);
 /* #notAPI: |Read code|bit I/O struct; code size (bits)|code read|O(n)|1;2| */
 size_t sbio_read(sbio_t *bio, size_t code_bits);
 
+/*
+ * 64-bit accumulator bit I/O (same LSB-first stream format as sbio_t)
+ *
+ * The writer stores the whole accumulator on every write, so the output
+ * buffer must have SBIO64_PAD extra bytes after the last written byte.
+ * The reader refills with unaligned 8-byte loads while far from the end
+ * of the input, switching to byte loads near the end, and reading past the
+ * end returns zero bits (check sbio64_off() against the input size).
+ * Code size: up to 32 bits for writing, up to 56 bits for reading.
+ */
+
+#define SBIO64_PAD	8
+
+struct SBitIO64
+{
+	unsigned char *bw;
+	const unsigned char *br;
+	size_t off, nbits, size;
+	uint64_t acc;
+};
+
+typedef struct SBitIO64 sbio64_t;
+
+/* #notAPI: |Initialize 64-bit bit I/O for writing|bit I/O struct; write buffer||O(1)|1;2| */
+S_INLINE void sbio64_write_init(sbio64_t *bio, unsigned char *b)
+{
+	bio->bw = b;
+	bio->br = NULL;
+	bio->off = bio->nbits = bio->size = 0;
+	bio->acc = 0;
+}
+
+/* #notAPI: |Write code (branchless)|bit I/O struct; code; code size (bits)||O(1)|1;2| */
+S_INLINE void sbio64_write(sbio64_t *bio, size_t c, size_t cbits)
+{
+	bio->acc |= (uint64_t)c << bio->nbits;
+	bio->nbits += cbits;
+	S_ST_LE_U64(bio->bw + bio->off, bio->acc);
+	bio->off += bio->nbits >> 3;
+	bio->acc >>= bio->nbits & ~(size_t)7;
+	bio->nbits &= 7;
+}
+
+/* #notAPI: |Finish write|bit I/O struct|written bytes|O(1)|1;2| */
+S_INLINE size_t sbio64_write_close(sbio64_t *bio)
+{
+	return bio->off + (bio->nbits ? 1 : 0);
+}
+
+/* #notAPI: |Initialize 64-bit bit I/O for reading|bit I/O struct; read buffer; read buffer size||O(1)|1;2| */
+S_INLINE void sbio64_read_init(sbio64_t *bio, const unsigned char *b,
+			       size_t size)
+{
+	bio->bw = NULL;
+	bio->br = b;
+	bio->size = size;
+	bio->off = bio->nbits = 0;
+	bio->acc = 0;
+}
+
+/* #notAPI: |Bit stream byte offset (consumed bytes, rounding up)|bit I/O struct|offset (bytes)|O(1)|1;2| */
+S_INLINE size_t sbio64_off(const sbio64_t *bio)
+{
+	return (bio->off * 8 - bio->nbits + 7) >> 3;
+}
+
+/* #notAPI: |Fill the accumulator with at least 56 bits|bit I/O struct||O(1)|1;2| */
+S_INLINE void sbio64_refill(sbio64_t *bio)
+{
+	if (bio->off + 8 <= bio->size) {
+		bio->acc |= S_LD_LE_U64(bio->br + bio->off) << bio->nbits;
+		bio->off += (63 - bio->nbits) >> 3;
+		bio->nbits |= 56;
+		return;
+	}
+	for (; bio->nbits <= 56; bio->nbits += 8, bio->off++)
+		if (bio->off < bio->size)
+			bio->acc |= (uint64_t)bio->br[bio->off] << bio->nbits;
+}
+
+/* #notAPI: |Peek code (read without consuming it)|bit I/O struct; code size (bits)|code read|O(1)|1;2| */
+S_INLINE size_t sbio64_peek(sbio64_t *bio, size_t cbits)
+{
+	if (bio->nbits < cbits)
+		sbio64_refill(bio);
+	return (size_t)(bio->acc & (((uint64_t)1 << cbits) - 1));
+}
+
+/* #notAPI: |Consume bits (previously peeked)|bit I/O struct; code size (bits)||O(1)|1;2| */
+S_INLINE void sbio64_consume(sbio64_t *bio, size_t cbits)
+{
+	bio->acc >>= cbits;
+	bio->nbits -= cbits;
+}
+
+/* #notAPI: |Read code|bit I/O struct; code size (bits)|code read|O(1)|1;2| */
+S_INLINE size_t sbio64_read(sbio64_t *bio, size_t cbits)
+{
+	size_t c = sbio64_peek(bio, cbits);
+	sbio64_consume(bio, cbits);
+	return c;
+}
+
 #ifdef __cplusplus
 }      /* extern "C" { */
 #endif
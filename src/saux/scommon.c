@@ -30,14 +30,59 @@ unsigned slog2(uint64_t i)
 	return o;
 }
 
+/*
+ * Natural logarithm (without libm dependency): range reduction to
+ * [sqrt(0.5), sqrt(2)), and atanh series (|y| < 0.18, 1e-17 precision in
+ * 12 terms)
+ */
+
+double slog(double x)
+{
+	double y, y2, t, r = 0;
+	int e = 0, i;
+	RETURN_IF(x <= 0, -1e308);
+	for (; x >= 1.4142135623730950488; e++)
+		x /= 2;
+	for (; x < 0.70710678118654752440; e--)
+		x *= 2;
+	y = (x - 1) / (x + 1);
+	y2 = y * y;
+	for (i = 1, t = y; i < 24; i += 2, t *= y2)
+		r += t / i;
+	return 2 * r + e * 0.69314718055994530942;
+}
+
 /*
  * Custom "memset" functions
  */
 
+/*
+ * Large fills: the pattern already written at the beginning is replicated
+ * with block copies, doubling its size on every step (the block size is
+ * limited to a multiple of 3 and 4, keeping the 24 and 32-bit patterns
+ * aligned)
+ */
+#define S_MEMSET_DUP_THRS	64
+#define S_MEMSET_DUP_MAX	(12 * 1024)
+
+static void s_memset_dup(unsigned char *o, size_t k, const size_t n)
+{
+	size_t c;
+	for (; k < n; k += c) {
+		c = S_MIN3(k, n - k, S_MEMSET_DUP_MAX);
+		memcpy(o + k, o, c);
+	}
+}
+
 void s_memset32(void *o, uint32_t data, size_t n)
 {
 	size_t k = 0, n4 = n / 4;
 	uint32_t *o32;
+	if (n >= S_MEMSET_DUP_THRS) {
+		S_ST_U32(o, data);
+		s_memset_dup((unsigned char *)o, 4, n);
+		return;
+	}
 #if defined(S_UNALIGNED_MEMORY_ACCESS) || S_BPWORD == 4
 	size_t ua_head = (intptr_t)o & 3;
 	if (ua_head && n4) {
@@ -65,6 +110,11 @@ void s_memset32(void *o, uint32_t data, size_t n)
 void s_memset24(unsigned char *o, const unsigned char *data, size_t n)
 {
 	size_t k = 0;
+	if (n >= S_MEMSET_DUP_THRS) {
+		memcpy(o, data, 3);
+		s_memset_dup(o, 3, n);
+		return;
+	}
 	if (n >= 15) {
 		size_t ua_head = (intptr_t)o & 3;
 		if (ua_head) {
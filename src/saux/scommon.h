@@ -131,6 +131,8 @@ extern "C" {
 #define S_MIN3(a, b, c) S_MIN(S_MIN(a, b), (c))
 #define S_ROL32(a, c) ((a) << (c) | (a) >> (32 - (c)))
 #define S_ROR32(a, c) ((a) >> (c) | (a) << (32 - (c)))
+#define S_ROL64(a, c) ((a) << (c) | (a) >> (64 - (c)))
+#define S_ROR64(a, c) ((a) >> (c) | (a) << (64 - (c)))
 #define S_NBIT(n) (1 << n)
 #define S_NBITMASK(n) (S_NBIT(n) - 1)
 #if defined(__GNUC__) && __GNUC__ >= 4 && __GNUC_MINOR__ >= 1
@@ -427,7 +429,8 @@ S_INLINE void s_st_le_u16(void *a, unsigned short v)
 S_INLINE unsigned int s_ld_le_u32(const void *a)
 {
 	const unsigned char *p = (const unsigned char *)a;
-	return (unsigned int)(p[3] << 24 | p[2] << 16 | p[1] << 8 | p[0]);
+	return (unsigned int)p[3] << 24 | (unsigned int)p[2] << 16 |
+	       (unsigned int)p[1] << 8 | p[0];
 }
 
 S_INLINE void s_st_le_u32(void *a, unsigned int v)
@@ -484,6 +487,26 @@ S_INLINE void s_st_le_u32(void *a, unsigned int v)
 	#define S_ST_SZT(a, v) S_UAST_X(a, size_t, v)
 #endif
 
+#if S_IS_LITTLE_ENDIAN
+	#define S_LD_LE_U64(a) S_LD_U64(a)
+	#define S_ST_LE_U64(a, v) S_ST_U64(a, v)
+#else
+	S_INLINE uint64_t s_ld_le_u64(const void *a)
+	{
+		const unsigned char *p = (const unsigned char *)a;
+		return (uint64_t)s_ld_le_u32(p) |
+		       (uint64_t)s_ld_le_u32(p + 4) << 32;
+	}
+	S_INLINE void s_st_le_u64(void *a, uint64_t v)
+	{
+		unsigned char *p = (unsigned char *)a;
+		s_st_le_u32(p, (unsigned int)v);
+		s_st_le_u32(p + 4, (unsigned int)(v >> 32));
+	}
+	#define S_LD_LE_U64(a) s_ld_le_u64(a)
+	#define S_ST_LE_U64(a, v) s_st_le_u64(a, v)
+#endif
+
 #if defined(MSVC) && defined(_M_X86)
 	#include <emmintrin.h>
 	#define S_PREFETCH_R(address) 					\
@@ -492,6 +515,16 @@ S_INLINE void s_st_le_u32(void *a, unsigned int v)
 	#define S_PREFETCH_W(address) S_PREFETCH_R(address)
 #endif
 
+/*
+ * SIMD (SSE2 only, for now; define S_NO_SIMD for disabling it)
+ */
+#if !defined(S_MINIMAL) && !defined(S_NO_SIMD) &&			\
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) ||	\
+     defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define S_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
 #if (defined(_M_X86) || defined(__x86_64__) || defined(__ARM_PCS_VFP) || \
      defined(__PPC__) || defined(__sparc__)) && !defined(__SOFTFP__)
 	#define S_HW_FPU
@@ -591,6 +624,7 @@ S_INLINE size_t s_size_t_mul(size_t a, size_t b, size_t val_if_saturated)
 }
 
 unsigned slog2(uint64_t i);
+double slog(double x);
 
 /*
  * Custom "memset" functions
@@ -655,6 +689,53 @@ BUILD_S_MSB(s_msb16, uint16_t, 16)
 BUILD_S_MSB(s_msb32, uint32_t, 32)
 BUILD_S_MSB(s_msb64, uint64_t, 64)
 
+/*
+ * Count trailing zeros (v != 0)
+ */
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+S_INLINE unsigned s_ctz32(uint32_t v)
+{
+#if defined(__GNUC__) && __GNUC__ >= 4
+	return (unsigned)__builtin_ctz(v);
+#elif defined(_MSC_VER)
+	unsigned long r;
+	_BitScanForward(&r, v);
+	return (unsigned)r;
+#else
+	unsigned r = 0;
+	for (; !(v & 1); v >>= 1)
+		r++;
+	return r;
+#endif
+}
+
+S_INLINE unsigned s_ctz64(uint64_t v)
+{
+#if defined(__GNUC__) && __GNUC__ >= 4
+	return (unsigned)__builtin_ctzll(v);
+#else
+	return (uint32_t)v ? s_ctz32((uint32_t)v) :
+			     32 + s_ctz32((uint32_t)(v >> 32));
+#endif
+}
+
+/*
+ * Population count (SWAR: no popcnt instruction required)
+ */
+
+S_INLINE unsigned s_popcount64(uint64_t x)
+{
+	x = x - ((x >> 1) & (uint64_t)0x5555555555555555);
+	x = (x & (uint64_t)0x3333333333333333) +
+	    ((x >> 2) & (uint64_t)0x3333333333333333);
+	x = (x + (x >> 4)) & (uint64_t)0x0f0f0f0f0f0f0f0f;
+	return (unsigned)((x * (uint64_t)0x0101010101010101) >> 56);
+}
+
 #ifdef __cplusplus
 }      /* extern "C" { */
 #endif
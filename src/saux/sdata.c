@@ -100,6 +100,7 @@ void sd_reset(sd_t *d, const uint8_t header_size, const size_t elem_size,
 			d->header_size = header_size;
 			d->elem_size = elem_size;
 			d->sub_type = 0;
+			d->gen = 0;
 		} else {
 			((struct SDataSmall *)d)->aux = 0;
 		}
@@ -161,6 +162,7 @@ S_INLINE size_t sd_reserve_aux(sd_t **d, size_t max_size,
 			d_next->f.st_mode = SData_DynFull;
 			d_next->header_size = full_header_size;
 			d_next->sub_type = 0;
+			d_next->gen = 0;
 			d_next->elem_size = 1;
 			d_next->size = size;
 		}
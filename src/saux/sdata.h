@@ -206,7 +206,7 @@ struct SDataSmall /* 4-byte structure */
 	uint8_t aux;
 };
 
-struct SDataFull /* 16-byte structure for 32-bit compiler, 32-byte for 64-bit */
+struct SDataFull /* 20-byte structure for 32-bit compiler, 32-byte for 64-bit */
 {
 	struct SDataFlags f;
 
@@ -221,6 +221,11 @@ struct SDataFull /* 16-byte structure for 32-bit compiler, 32-byte for 64-bit */
 	 */
 	uint8_t sub_type;
 
+	/*
+	 * Type-specific counter (e.g. bitset modification generation)
+	 */
+	uint32_t gen;
+
 	/*
 	 * Type element size
 	 */
@@ -241,7 +246,7 @@ typedef struct SDataFull sd_t; /* "Hidden" structure (accessors are provided) */
 
 #define EMPTY_SDataFlags	{ 1, 1, 3, 0, 0, 0, 0 }
 #define EMPTY_SDataSmall	{ EMPTY_SDataFlags, 0, 0, 0 }
-#define EMPTY_SDataFull		{ EMPTY_SDataFlags, 0, 0, 0, 0, 0 }
+#define EMPTY_SDataFull		{ EMPTY_SDataFlags, 0, 0, 0, 0, 0, 0 }
 
 extern sd_t *sd_void;
 
@@ -15,7 +15,7 @@ const char *sv_type_to_label(const enum eSV_Type t)
 		#define CXSV(t) case t: return #t
 		CXSV(SV_I8); CXSV(SV_U8); CXSV(SV_I16); CXSV(SV_U16);
 		CXSV(SV_I32); CXSV(SV_U32); CXSV(SV_I64); CXSV(SV_U64);
-		CXSV(SV_GEN);
+		CXSV(SV_F32); CXSV(SV_F64); CXSV(SV_GEN);
 		#undef CXSV
 	} 
 	return "?";
@@ -9,6 +9,8 @@
 
 #include "senc.h"
 #include "sbitio.h"
+#include "shash.h"
+#include "sthread.h"
 #include <stdlib.h>
 
 #ifndef SLZW_ENABLE_RLE
@@ -77,6 +79,24 @@ static const unsigned char h2n[64] = {
  * to increase it, add elements to the "Duff's device" switch SLZW_SWITCH_DD()
  */
 #define SLZW_EPG		7
+/*
+ * LZW output size bound: one code per input byte, up to SLZW_MAX_TREE_BITS
+ * bits each, plus escape prefixes (8 bits, at most one every SLZW_ESC_RATIO
+ * codes), tree reset codes (at least 112 codes apart: 14 LUTs of 8 nodes),
+ * and the last code. RLE opcodes take less than 6 bits per input byte.
+ * Rounded up to 11 bits per input byte, plus header, tail and bit I/O
+ * padding (SBIO64_PAD). Codes coming after a preset dictionary can use the
+ * escape budget of the dictionary codes: one byte every 128 bytes of
+ * dictionary is added for that case.
+ */
+#define SLZW_MAX_OUT(n)		((n) + (n) / 4 + (n) / 8 + 40 + SBIO64_PAD)
+#define SLZW_DICT_MAX_OUT(n, ds) (SLZW_MAX_OUT(n) + (ds) / 128 + 4)
+/*
+ * Output capacity check margin: bytes written by one encoder loop step
+ * (RLE opcode, pattern code, and tree reset code), plus the last code and
+ * the SBIO64_PAD bytes of the 8-byte stores
+ */
+#define SLZW_STEP_MAX		32
 
 #define SRLE_OP_MASK_SHORT	0xe0
 #define SRLE_RUN_MASK_SHORT	0x1f
@@ -88,6 +108,13 @@ static const unsigned char h2n[64] = {
 #define SRLE_OP_RLE3		0x02
 #define SRLE_OP_RLE1		0x01
 
+#define SHUF_MAX_BITS		11
+#define SHUF_LUT_SIZE		(1 << SHUF_MAX_BITS)
+#define SHUF_LENS_BYTES		128	/* 256 code lengths, 4 bit each */
+#define SHUF_MODE_RAW		0
+#define SHUF_MODE_HUF		1
+#define SHUF_HDR_MAX		(4 + 1 + SBIO64_PAD)
+
 /*
  * Macros
  */
@@ -171,39 +198,39 @@ static sbool_t slzw_short_codes(size_t normal_count, size_t esc_count)
 		S_TRUE : S_FALSE;
 }
 
-static size_t slzw_bio_read(sbio_t *bio, size_t cbits, size_t *normal_count,
+static size_t slzw_bio_read(sbio64_t *bio, size_t cbits, size_t *normal_count,
 			      size_t *esc_count)
 {
 	size_t c;
 	if (slzw_short_codes(*normal_count, *esc_count)) {
-		c = sbio_read(bio, 8);
+		c = sbio64_read(bio, 8);
 		if (c == 255) {
-			c = sbio_read(bio, cbits);
+			c = sbio64_read(bio, cbits);
 			(*esc_count)++;
 		} else {
 			(*normal_count)++;
 		}
 	} else {
-		c = sbio_read(bio, cbits);
+		c = sbio64_read(bio, cbits);
 		(*normal_count)++;
 	}
 	return c;
 }
 
-static void slzw_bio_write(sbio_t *bio, size_t c, size_t cbits,
+static void slzw_bio_write(sbio64_t *bio, size_t c, size_t cbits,
 			     size_t *normal_count, size_t *esc_count)
 {
 	if (slzw_short_codes(*normal_count, *esc_count)) {
 		if (c < 255) {
-	                sbio_write(bio, c, 8);
+	                sbio64_write(bio, c, 8);
 			(*normal_count)++;
 #if SLZW_DEBUG
 			fprintf(stderr, "%u (8 (%u))\n",
 				(unsigned)c, (unsigned)cbits);
 #endif
 		} else {
-	                sbio_write(bio, 255, 8);
-			sbio_write(bio, c, cbits);
+	                sbio64_write(bio, 255, 8);
+			sbio64_write(bio, c, cbits);
 			(*esc_count)++;
 #if SLZW_DEBUG
 			fprintf(stderr, "%u (prefix + %u)\n",
@@ -211,7 +238,7 @@ static void slzw_bio_write(sbio_t *bio, size_t c, size_t cbits,
 #endif
 		}
 	} else {
-		sbio_write(bio, c, cbits);
+		sbio64_write(bio, c, cbits);
 		(*normal_count)++;
 #if SLZW_DEBUG
 		fprintf(stderr, "%u (%u)\n", (unsigned)c, (unsigned)cbits);
@@ -276,6 +303,38 @@ static size_t srle_run(const unsigned char *s, size_t i, size_t ss,
 	return run_length;
 }
 
+/*
+ * Run candidate finder: first offset j >= i where srle_run() could detect a
+ * run (4 bytes equal to the next 4, or to the 4 starting 3 bytes later), or
+ * ss if there is none. With SSE2, 16 positions are checked at once by
+ * comparing against the input shifted by 3 and 4 bytes.
+ */
+static size_t srle_next(const unsigned char *s, size_t i, const size_t ss)
+{
+#ifdef S_SIMD_SSE2
+	for (; i + 20 <= ss; i += 13) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(s + i)),
+			b3 = _mm_loadu_si128((const __m128i *)(s + i + 3)),
+			b4 = _mm_loadu_si128((const __m128i *)(s + i + 4));
+		uint32_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b3)),
+			 m4 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b4));
+		/* bit k: 4 equal bytes from k (only k <= 12 are complete) */
+		m3 &= m3 >> 1;
+		m3 &= m3 >> 2;
+		m4 &= m4 >> 1;
+		m4 &= m4 >> 2;
+		if (m3 | m4)
+			return i + s_ctz32(m3 | m4);
+	}
+#endif
+	for (; i + 8 <= ss; i++) {
+		uint32_t a = S_LD_U32(s + i);
+		if (a == S_LD_U32(s + i + 4) || a == S_LD_U32(s + i + 3))
+			return i;
+	}
+	return ss;
+}
+
 /*
  * Base64 encoding/decoding
  */
@@ -704,11 +763,18 @@ static const unsigned char *dec_header(const unsigned char *s, const size_t ss,
 
 typedef short slzw_ndx_t;
 
-size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
+/*
+ * LZW encoder. The first "ds" bytes of the input are a preset dictionary:
+ * those are encoded, so the tree gets populated, but the codes go to the
+ * "od" buffer, and not to the output (the decoder gets the same codes by
+ * calling this function with ss == ds). The "od" buffer capacity must be
+ * SLZW_MAX_OUT(ds), and the output one "o_max" bytes: if the output would
+ * not fit, 0 is returned.
+ */
+static size_t senc_lzw_aux(const unsigned char *s, const size_t ss,
+			   unsigned char *o, const size_t o_max,
+			   const size_t ds, unsigned char *od)
 {
-	RETURN_IF(ss >= 0x80000000, 0); /* currently limited to 2^31-1 input */
-	RETURN_IF(!o && ss > 0, ss + (ss / 10) + 32); /* max out size */
-	RETURN_IF(!s || !o || !ss, 0);
 	size_t i, j;
 	/*
 	 * Node structure (separated elements and not a "struct", in order to
@@ -736,9 +802,13 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 	 */
 	size_t normal_count = 0, esc_count = 0;
 	size_t next_code, curr_code_len = SLZW_ROOT_NODE_BITS + 1;
-	size_t header_bytes = build_header(ss, o);
-	sbio_t bio;
-	sbio_write_init(&bio, o + header_bytes);
+	size_t header_bytes = ds == ss ? 0 : build_header(ss - ds, o),
+	       ss_lim = ds ? ds : ss, /* dictionary end, then input end */
+	       rle_next = 0,
+	       o_lim = o_max > header_bytes ? o_max - header_bytes : 0,
+	       lim = ds ? SLZW_MAX_OUT(ds) : o_lim; /* current buffer */
+	sbio64_t bio;
+	sbio64_write_init(&bio, ds ? od : o + header_bytes);
 	/*
 	 * Initialize data structures
 	 */
@@ -756,14 +826,20 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 	 */
 	slzw_ndx_t curr_node = 0;
 	for (i = 0; i < ss;) {
+		if (bio.off + SLZW_STEP_MAX > lim)
+			return 0; /* BEHAVIOR: output buffer too small */
 #if SLZW_ENABLE_RLE
 		/*
 		 * Attempt RLE at current offset
 		 */
-		size_t run_length, run_elem_size, max_run, rle_mode;
-		max_run = i + S_NBIT(SLZW_RLE_BITSD2 * 2);
-		run_length = srle_run(s, i, ss, SLZW_RLE_CSIZE, max_run,
-				      &run_elem_size, S_TRUE);
+		size_t run_length = 0, run_elem_size, max_run, rle_mode;
+		if (rle_next < i)
+			rle_next = srle_next(s, i, ss_lim);
+		if (rle_next == i) {
+			max_run = i + S_NBIT(SLZW_RLE_BITSD2 * 2);
+			run_length = srle_run(s, i, ss_lim, SLZW_RLE_CSIZE,
+					      max_run, &run_elem_size, S_TRUE);
+		}
 		rle_mode = !run_length ? 0 : run_elem_size == 1 ? SLZW_RLE1 :
 			   run_elem_size == 3 ? SLZW_RLE3 :
 			   run_elem_size == 4 ? SLZW_RLE4 : 0;
@@ -772,14 +848,14 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 			       cl = run_length & S_NBITMASK(SLZW_RLE_BITSD2);
 			slzw_bio_write(&bio, rle_mode, curr_code_len,
 					 &normal_count, &esc_count);
-			sbio_write(&bio, cl, SLZW_RLE_BITSD2);
-			sbio_write(&bio, ch, SLZW_RLE_BITSD2);
-			sbio_write(&bio, s[i], 8);
+			sbio64_write(&bio, cl, SLZW_RLE_BITSD2);
+			sbio64_write(&bio, ch, SLZW_RLE_BITSD2);
+			sbio64_write(&bio, s[i], 8);
 			if (run_elem_size >= 3) {
-				sbio_write(&bio, s[i + 1], 8);
-				sbio_write(&bio, s[i + 2], 8);
+				sbio64_write(&bio, s[i + 1], 8);
+				sbio64_write(&bio, s[i + 2], 8);
 				if (run_elem_size >= 4)
-					sbio_write(&bio, s[i + 3], 8);
+					sbio64_write(&bio, s[i + 3], 8);
 			}
 			i += run_length * run_elem_size;
 			if (i == ss)
@@ -792,7 +868,7 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 		unsigned char in_byte = s[i++];
 		curr_node = in_byte;
 		slzw_ndx_t r;
-		for (; i < ss; i++) {
+		for (; i < ss_lim; i++) {
 			in_byte = s[i];
 			slzw_ndx_t nlut = node_lutref[curr_node];
 			if (nlut < 0) {
@@ -834,8 +910,11 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 				break;
 			curr_node = r;
 		}
-		if (i == ss)
-			break;
+		if (i == ss_lim) {
+			if (i == ss)
+				break;
+			in_byte = s[i]; /* dictionary end: new pattern */
+		}
 		/*
 		 * Add new code to the tree
 		 */
@@ -898,6 +977,11 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 		node_lutref[new_node] = 0;
 		slzw_bio_write(&bio, (size_t)node_codes[curr_node],
 			         curr_code_len, &normal_count, &esc_count);
+		if (i == ss_lim) { /* dictionary end: switch to the output */
+			ss_lim = ss;
+			lim = o_lim;
+			sbio64_write_init(&bio, o + header_bytes);
+		}
 		if (next_code == (size_t)(1 << curr_code_len))
 
 			curr_code_len++;
@@ -925,18 +1009,34 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
 	slzw_bio_write(&bio, SLZW_STOP, curr_code_len, &normal_count,
 		       &esc_count);
 #endif
-	return sbio_write_close(&bio) + header_bytes;
+	return sbio64_write_close(&bio) + header_bytes;
 }
 
-size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
+static size_t senc_lzw_c(const unsigned char *s, const size_t ss,
+			 unsigned char *o, const size_t o_max)
 {
-	RETURN_IF(!s || !ss0, 0);
-	size_t expected_ss, header_size;
-	s = dec_header(s, ss0, &header_size, &expected_ss);
-	RETURN_IF(!o, expected_ss); /* max out size */
-	RETURN_IF(ss0 <= header_size, 0);
-	size_t ss = ss0 - header_size;
-	sbio_t bio;
+	RETURN_IF(ss >= 0x80000000, 0); /* currently limited to 2^31-1 input */
+	RETURN_IF(!o && ss > 0, SLZW_MAX_OUT(ss)); /* max out size */
+	RETURN_IF(!s || !o || !ss, 0);
+	return senc_lzw_aux(s, ss, o, o_max, 0, NULL);
+}
+
+size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	return senc_lzw_c(s, ss, o, SLZW_MAX_OUT(ss));
+}
+
+/*
+ * LZW decoder. If "s2" is not NULL, decoding continues with a second
+ * stream once the first one is done (used for preset dictionaries, being
+ * the first stream the dictionary codes).
+ */
+static size_t sdec_lzw_aux(const unsigned char *s, size_t ss, unsigned char *o,
+			   size_t expected_ss, const unsigned char *s2,
+			   const size_t ss2, unsigned char *o2,
+			   const size_t expected_ss2)
+{
+	sbio64_t bio;
 	size_t oi = 0, normal_count = 0, esc_count = 0, last_code,
 	       curr_code_len = SLZW_ROOT_NODE_BITS + 1, next_inc_code;
 	slzw_ndx_t parents[SLZW_CODE_LIMIT];
@@ -946,7 +1046,7 @@ size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
 	/*
 	 * Init read buffer
 	 */
-	sbio_read_init(&bio, s);
+	sbio64_read_init(&bio, s, ss);
 	/*
 	 * Initialize root node
 	 */
@@ -956,26 +1056,43 @@ size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
 	 * Code expand loop
 	 */
 	size_t new_code;
-	for (; sbio_off(&bio) < ss;) {
+	for (;;) {
+		if (sbio64_off(&bio) >= ss) {
+			if (!s2)
+				break;
+			/* preset dictionary end: switch to the input */
+			RETURN_IF(oi != expected_ss, 0);
+			s = s2;
+			ss = ss2;
+			o = o2;
+			expected_ss = expected_ss2;
+			s2 = NULL;
+			oi = 0;
+			sbio64_read_init(&bio, s, ss);
+			continue;
+		}
 		new_code = slzw_bio_read(&bio, curr_code_len, &normal_count,
 					 &esc_count);
 		if (new_code < SLZW_OP_START || new_code > SLZW_OP_END) {
 			if (last_code == SLZW_CODE_LIMIT) {
+				RETURN_IF(oi == expected_ss, oi);
 				o[oi++] = lastwc = xbyte.g8[new_code];
 				last_code = new_code;
 				continue;
 			}
 			size_t code, pattern_off = SLZW_MAX_CODE;
+			RETURN_IF(new_code > next_inc_code, oi); /* corrupt */
 			if (new_code == next_inc_code) {
 				pattern[pattern_off--] = lastwc;
 				code = last_code;
 			} else {
 				code = new_code;
 			}
-			for (; code >= SLZW_FIRST;) {
+			for (; code >= SLZW_FIRST && pattern_off > 0;) {
 				pattern[pattern_off--] = xbyte.g8[code];
 				code = (size_t)parents[code];
 			}
+			RETURN_IF(code >= SLZW_FIRST, oi); /* corrupt input */
 			pattern[pattern_off--] = lastwc = xbyte.g8[next_inc_code] =
 								xbyte.g8[code];
 			parents[next_inc_code] = (slzw_ndx_t)last_code;
@@ -990,6 +1107,7 @@ size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
 			 * Write LZW pattern
 			 */
 			size_t write_size = SLZW_CODE_LIMIT - 1 - pattern_off;
+			RETURN_IF(write_size > expected_ss - oi, oi);
 			memcpy(o + oi, pattern + pattern_off + 1, write_size);
 			oi += write_size;
 			continue;
@@ -1001,18 +1119,21 @@ size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
 		if (new_code >= SLZW_RLE1 && new_code <= SLZW_RLE4) {
 			union s_u32 rle;
 			size_t count, cl, ch;
-			cl = sbio_read(&bio, SLZW_RLE_BITSD2);
-			ch = sbio_read(&bio, SLZW_RLE_BITSD2);
+			cl = sbio64_read(&bio, SLZW_RLE_BITSD2);
+			ch = sbio64_read(&bio, SLZW_RLE_BITSD2);
 			count = ch << SLZW_RLE_BITSD2 | cl;
-			rle.b[0] = (unsigned char)sbio_read(&bio, 8);
+			rle.b[0] = (unsigned char)sbio64_read(&bio, 8);
+			RETURN_IF(count > (expected_ss - oi) /
+				  (new_code == SLZW_RLE1 ? 1 :
+				   new_code == SLZW_RLE4 ? 4 : 3), oi);
 			if (new_code == SLZW_RLE1) {
 				memset(o + oi, rle.b[0], count);
 			} else {
-				rle.b[1] = (unsigned char)sbio_read(&bio, 8);
-				rle.b[2] = (unsigned char)sbio_read(&bio, 8);
+				rle.b[1] = (unsigned char)sbio64_read(&bio, 8);
+				rle.b[2] = (unsigned char)sbio64_read(&bio, 8);
 				if (new_code == SLZW_RLE4) {
 					count *= 4;
-					rle.b[3] = (unsigned char)sbio_read(
+					rle.b[3] = (unsigned char)sbio64_read(
 						      &bio, 8);
 					s_memset32(o + oi, rle.a32, count);
 				} else {
@@ -1037,6 +1158,137 @@ size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
 	return oi;
 }
 
+size_t sdec_lzw(const unsigned char *s, const size_t ss0, unsigned char *o)
+{
+	RETURN_IF(!s || !ss0, 0);
+	size_t expected_ss, header_size;
+	s = dec_header(s, ss0, &header_size, &expected_ss);
+	RETURN_IF(!o, expected_ss); /* max out size */
+	RETURN_IF(ss0 <= header_size, 0);
+	return sdec_lzw_aux(s, ss0 - header_size, o, expected_ss, NULL, 0,
+			    NULL, 0);
+}
+
+/*
+ * LZW with preset dictionary
+ */
+
+size_t senc_lzw_dict(const unsigned char *s, const size_t ss, unsigned char *o,
+		     const unsigned char *d, const size_t ds)
+{
+	RETURN_IF(!d || !ds, senc_lzw(s, ss, o));
+	RETURN_IF(ss >= 0x80000000 || ds >= 0x80000000 - ss, 0);
+	RETURN_IF(!o && ss > 0, SLZW_DICT_MAX_OUT(ss, ds)); /* max out size */
+	RETURN_IF(!s || !o || !ss, 0);
+	size_t out_size = 0;
+	unsigned char *buf = (unsigned char *)s_malloc(ds + ss +
+						       SLZW_MAX_OUT(ds));
+	if (buf) {
+		memcpy(buf, d, ds);
+		memcpy(buf + ds, s, ss);
+		out_size = senc_lzw_aux(buf, ds + ss, o,
+					SLZW_DICT_MAX_OUT(ss, ds), ds,
+					buf + ds + ss);
+		s_free(buf);
+	}
+	return out_size;
+}
+
+size_t sdec_lzw_dict(const unsigned char *s, const size_t ss0, unsigned char *o,
+		     const unsigned char *d, const size_t ds)
+{
+	RETURN_IF(!d || !ds, sdec_lzw(s, ss0, o));
+	RETURN_IF(!s || !ss0 || ds >= 0x80000000, 0);
+	size_t expected_ss, header_size, dcs, out_size = 0,
+	       dcs_max = SLZW_MAX_OUT(ds);
+	s = dec_header(s, ss0, &header_size, &expected_ss);
+	RETURN_IF(!o, expected_ss); /* max out size */
+	RETURN_IF(ss0 <= header_size, 0);
+	unsigned char *buf = (unsigned char *)s_malloc(dcs_max + ds);
+	if (buf) {
+		/* dictionary codes, as seen by the encoder */
+		dcs = senc_lzw_aux(d, ds, NULL, 0, ds, buf);
+		out_size = sdec_lzw_aux(buf, dcs, buf + dcs_max, ds, s,
+					ss0 - header_size, o, expected_ss);
+		s_free(buf);
+	}
+	return out_size;
+}
+
+/*
+ * Dictionary builder: picks the sample segments having more repeated
+ * k-grams. Once a segment is picked, its k-grams are not counted again.
+ * Best segments go to the end, as LZW could drop the dictionary start if
+ * its tree gets full.
+ */
+
+#define SDICT_K		6
+#define SDICT_SEG	128
+#define SDICT_HBITS	16
+
+S_INLINE size_t sdict_hash(const unsigned char *p)
+{
+	uint32_t a = (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+		     (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24,
+		 b = (uint32_t)p[4] | (uint32_t)p[5] << 8;
+	return (uint32_t)((a ^ (b * 0x9e3779b1)) * 2654435761u) >>
+	       (32 - SDICT_HBITS);
+}
+
+S_INLINE size_t sdict_w(const uint32_t *cnt, const unsigned char *p)
+{
+	uint32_t c = cnt[sdict_hash(p)];
+	return c > 1 ? c - 1 : 0;
+}
+
+size_t senc_dict_build(const unsigned char **s, const size_t *ss,
+		       const size_t n, unsigned char *o, const size_t max_size)
+{
+	RETURN_IF(!s || !ss || !n || !o || !max_size, 0);
+	size_t i, p, out = max_size;
+	uint32_t *cnt = (uint32_t *)s_malloc(sizeof(uint32_t) << SDICT_HBITS);
+	RETURN_IF(!cnt, 0);
+	memset(cnt, 0, sizeof(uint32_t) << SDICT_HBITS);
+	for (i = 0; i < n; i++)
+		for (p = 0; s[i] && p + SDICT_K <= ss[i]; p++)
+			cnt[sdict_hash(s[i] + p)]++;
+	while (out >= SDICT_K) {
+		size_t best = 0, bi = 0, bp = 0, bl = 0;
+		for (i = 0; i < n; i++) {
+			const unsigned char *si = s[i];
+			size_t score = 0,
+			       sl = S_MIN(S_MIN(SDICT_SEG, ss[i]), out),
+			       nk = sl + 1 - SDICT_K;
+			if (!si || sl < SDICT_K)
+				continue;
+			for (p = 0; p < nk; p++)
+				score += sdict_w(cnt, si + p);
+			for (p = 0;; p++) {
+				if (score > best) {
+					best = score;
+					bi = i;
+					bp = p;
+					bl = sl;
+				}
+				if (p + sl >= ss[i])
+					break;
+				score -= sdict_w(cnt, si + p);
+				score += sdict_w(cnt, si + p + nk);
+			}
+		}
+		if (!best)
+			break;
+		out -= bl;
+		memcpy(o + out, s[bi] + bp, bl);
+		for (p = 0; p + SDICT_K <= bl; p++)
+			cnt[sdict_hash(s[bi] + bp + p)] = 0;
+	}
+	s_free(cnt);
+	if (out > 0)
+		memmove(o, o + out, max_size - out);
+	return max_size - out;
+}
+
 static size_t senc_rle_flush(const unsigned char *s, const size_t i,
 			     const size_t i_done, unsigned char *o, size_t oi)
 {
@@ -1068,6 +1320,9 @@ size_t senc_rle(const unsigned char *s, const size_t ss, unsigned char *o)
 	o += header_bytes;
 	size_t i = 0, oi = 0, i_done = 0, run_length, run_elem_size;
 	for (; i < ss;) {
+		i = srle_next(s, i, ss);
+		if (i == ss)
+			break;
 		run_length = srle_run(s, i, ss, 10, (uint32_t)-1,
 				      &run_elem_size, S_FALSE);
 		if (!run_length) {
@@ -1148,6 +1403,7 @@ size_t sdec_rle(const unsigned char *s, const size_t ss0, unsigned char *o)
 #endif
 			break;
 		default:
+			RETURN_IF(ss - i < 4, oi); /* BEHAVIOR: corrupt input */
 			cnt = S_LD_U32(s + i);
 			cnt = S_NTOH_U32(cnt);
 			op_sz = op == SRLE_OP_ST ? 0 : op == SRLE_OP_RLE1 ? 1 :
@@ -1159,6 +1415,10 @@ size_t sdec_rle(const unsigned char *s, const size_t ss0, unsigned char *o)
 				(unsigned)op_sz, (unsigned)cnt);
 #endif
 		}
+		/* BEHAVIOR: corrupt input (input or output overflow) */
+		RETURN_IF((op_sz ? op_sz : cnt) > ss - i ||
+			  cnt > (expected_ss - oi) / (op_sz > 1 ? op_sz : 1),
+			  oi);
 		if (op_sz == 0) {
 #if SLZW_DEBUG
 			fprintf(stderr, "[%u] ST(%u)\n", (unsigned)(i),
@@ -1191,3 +1451,529 @@ size_t sdec_rle(const unsigned char *s, const size_t ss0, unsigned char *o)
 	return oi;
 }
 
+/*
+ * Canonical Huffman encoding/decoding
+ */
+
+static void shuf_minredundancy(size_t *a, const int n)
+{
+	/*
+	 * In-place code length computation over weights sorted in
+	 * ascending order (A. Moffat, J. Katajainen, 1995)
+	 */
+	int root, leaf, next, avbl, used, dpth;
+	if (n <= 1) {
+		if (n == 1)
+			a[0] = 1;
+		return;
+	}
+	a[0] += a[1];
+	root = 0;
+	leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || a[root] < a[leaf]) {
+			a[next] = a[root];
+			a[root++] = (size_t)next;
+		} else {
+			a[next] = a[leaf++];
+		}
+		if (leaf >= n || (root < next && a[root] < a[leaf])) {
+			a[next] += a[root];
+			a[root++] = (size_t)next;
+		} else {
+			a[next] += a[leaf++];
+		}
+	}
+	a[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--)
+		a[next] = a[a[next]] + 1;
+	avbl = 1;
+	used = dpth = 0;
+	root = n - 2;
+	next = n - 1;
+	while (avbl > 0) {
+		for (; root >= 0 && a[root] == (size_t)dpth; root--)
+			used++;
+		for (; avbl > used; avbl--)
+			a[next--] = (size_t)dpth;
+		avbl = 2 * used;
+		dpth++;
+		used = 0;
+	}
+}
+
+/*
+ * Code lengths for every symbol, limited to SHUF_MAX_BITS. Returns the
+ * number of symbols in use.
+ */
+static int shuf_lengths(const size_t *freq, unsigned char *lens)
+{
+	int i, j, n = 0, cnt[SHUF_MAX_BITS + 1];
+	size_t w[256];
+	unsigned char syms[256];
+	memset(lens, 0, 256);
+	/* symbols in use, sorted by frequency (insertion sort, n <= 256) */
+	for (i = 0; i < 256; i++) {
+		if (!freq[i])
+			continue;
+		for (j = n; j > 0 && freq[syms[j - 1]] > freq[i]; j--)
+			syms[j] = syms[j - 1];
+		syms[j] = (unsigned char)i;
+		n++;
+	}
+	for (i = 0; i < n; i++)
+		w[i] = freq[syms[i]];
+	shuf_minredundancy(w, n);
+	/* length limit enforcement (Kraft sum kept <= 1) */
+	memset(cnt, 0, sizeof(cnt));
+	for (i = 0; i < n; i++)
+		cnt[S_MIN(w[i], SHUF_MAX_BITS)]++;
+	uint32_t total = 0;
+	for (i = 1; i <= SHUF_MAX_BITS; i++)
+		total += (uint32_t)cnt[i] << (SHUF_MAX_BITS - i);
+	for (; total > SHUF_LUT_SIZE; total--) {
+		cnt[SHUF_MAX_BITS]--;
+		for (i = SHUF_MAX_BITS - 1; i > 0; i--)
+			if (cnt[i]) {
+				cnt[i]--;
+				cnt[i + 1] += 2;
+				break;
+			}
+	}
+	/* less frequent symbols get the longer codes */
+	for (i = SHUF_MAX_BITS, j = 0; i > 0; i--)
+		for (; cnt[i] > 0; cnt[i]--)
+			lens[syms[j++]] = (unsigned char)i;
+	return n;
+}
+
+S_INLINE size_t shuf_rev(size_t c, size_t nbits)
+{
+	size_t r = 0;
+	for (; nbits > 0; nbits--, c >>= 1)
+		r = (r << 1) | (c & 1);
+	return r;
+}
+
+/*
+ * Canonical code assignment. Codes are bit-reversed, as the bit stream
+ * is LSB first, so the prefix is in the lower bits.
+ */
+static void shuf_codes(const unsigned char *lens, uint16_t *codes)
+{
+	size_t i, code = 0, cnt[SHUF_MAX_BITS + 1], next[SHUF_MAX_BITS + 1];
+	memset(cnt, 0, sizeof(cnt));
+	for (i = 0; i < 256; i++)
+		cnt[lens[i]]++;
+	cnt[0] = 0;
+	for (i = 1; i <= SHUF_MAX_BITS; i++) {
+		code = (code + cnt[i - 1]) << 1;
+		next[i] = code;
+	}
+	for (i = 0; i < 256; i++)
+		if (lens[i])
+			codes[i] = (uint16_t)shuf_rev(next[lens[i]]++,
+						      lens[i]);
+}
+
+size_t senc_huf(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	RETURN_IF(ss >= 0x80000000, 0); /* currently limited to 2^31-1 input */
+	RETURN_IF(!o && ss > 0, ss + SHUF_HDR_MAX); /* max out size */
+	RETURN_IF(!s || !o || !ss, 0);
+	size_t i, freq[256], bits = 0;
+	unsigned char lens[256];
+	uint16_t codes[256];
+	size_t header_bytes = build_header(ss, o);
+	memset(freq, 0, sizeof(freq));
+	for (i = 0; i < ss; i++)
+		freq[s[i]]++;
+	shuf_lengths(freq, lens);
+	for (i = 0; i < 256; i++)
+		bits += freq[i] * lens[i];
+	if ((bits + 7) / 8 + SHUF_LENS_BYTES >= ss) { /* not worth it: copy */
+		o[header_bytes] = SHUF_MODE_RAW;
+		memcpy(o + header_bytes + 1, s, ss);
+		return header_bytes + 1 + ss;
+	}
+	o[header_bytes++] = SHUF_MODE_HUF;
+	for (i = 0; i < 256; i += 2)
+		o[header_bytes++] = (unsigned char)(lens[i] | lens[i + 1] << 4);
+	shuf_codes(lens, codes);
+	sbio64_t bio;
+	sbio64_write_init(&bio, o + header_bytes);
+	for (i = 0; i < ss; i++)
+		sbio64_write(&bio, codes[s[i]], lens[s[i]]);
+	return sbio64_write_close(&bio) + header_bytes;
+}
+
+/*
+ * Decoding LUT entry: up to two symbols per lookup
+ * bits 0-7: 1st symbol, bits 8-15: 2nd symbol, bits 16-19: 1st symbol
+ * length, bits 20-23: total length (0: invalid code), bit 24: 2 symbols
+ */
+#define SHUF_E_SYM2(e)	(((e) >> 8) & 0xff)
+#define SHUF_E_LEN1(e)	(((e) >> 16) & 0x0f)
+#define SHUF_E_LENT(e)	(((e) >> 20) & 0x0f)
+#define SHUF_E_2SYM(e)	((e) & (1 << 24))
+
+static void shuf_build_lut(const unsigned char *lens, uint32_t *lut)
+{
+	size_t i, j, step;
+	uint16_t codes[256];
+	shuf_codes(lens, codes);
+	memset(lut, 0, SHUF_LUT_SIZE * sizeof(lut[0]));
+	for (i = 0; i < 256; i++) {
+		if (!lens[i])
+			continue;
+		step = (size_t)1 << lens[i];
+		for (j = codes[i]; j < SHUF_LUT_SIZE; j += step)
+			lut[j] = (uint32_t)(i | lens[i] << 16 | lens[i] << 20);
+	}
+	for (i = 0; i < SHUF_LUT_SIZE; i++) {
+		uint32_t e = lut[i], l1 = SHUF_E_LEN1(e), e2;
+		if (!l1)
+			continue;
+		e2 = lut[i >> l1];
+		if (SHUF_E_LEN1(e2) && l1 + SHUF_E_LEN1(e2) <= SHUF_MAX_BITS)
+			lut[i] = (e & 0x000f00ff) | (e2 & 0xff) << 8 |
+				 (l1 + SHUF_E_LEN1(e2)) << 20 | 1 << 24;
+	}
+}
+
+size_t sdec_huf(const unsigned char *s, const size_t ss0, unsigned char *o)
+{
+	RETURN_IF(!s || !ss0, 0);
+	size_t expected_ss, header_size;
+	s = dec_header(s, ss0, &header_size, &expected_ss);
+	RETURN_IF(!o, expected_ss); /* max out size */
+	RETURN_IF(ss0 <= header_size, 0);
+	size_t i, ss = ss0 - header_size - 1, oi = 0;
+	if (s[0] == SHUF_MODE_RAW) {
+		RETURN_IF(ss < expected_ss, 0);
+		memcpy(o, s + 1, expected_ss);
+		return expected_ss;
+	}
+	RETURN_IF(s[0] != SHUF_MODE_HUF || ss < SHUF_LENS_BYTES, 0);
+	s++;
+	unsigned char lens[256];
+	uint32_t lut[SHUF_LUT_SIZE];
+	for (i = 0; i < SHUF_LENS_BYTES; i++) {
+		lens[i * 2] = s[i] & 0x0f;
+		lens[i * 2 + 1] = s[i] >> 4;
+		RETURN_IF(lens[i * 2] > SHUF_MAX_BITS ||
+			  lens[i * 2 + 1] > SHUF_MAX_BITS, 0);
+	}
+	s += SHUF_LENS_BYTES;
+	ss -= SHUF_LENS_BYTES;
+	shuf_build_lut(lens, lut);
+	sbio64_t bio;
+	sbio64_read_init(&bio, s, ss);
+	/*
+	 * One table lookup per one or two symbols. Reading past the input end
+	 * gives zero bits, so the consumed size is checked on every step.
+	 */
+	for (; oi < expected_ss;) {
+		uint32_t e = lut[sbio64_peek(&bio, SHUF_MAX_BITS)];
+		int two = SHUF_E_2SYM(e) && oi + 1 < expected_ss;
+		RETURN_IF(!SHUF_E_LENT(e), oi); /* BEHAVIOR: corrupt input */
+		sbio64_consume(&bio, two ? SHUF_E_LENT(e) : SHUF_E_LEN1(e));
+		RETURN_IF(sbio64_off(&bio) > ss, oi); /* BEHAVIOR: truncated */
+		o[oi++] = (unsigned char)e;
+		if (two)
+			o[oi++] = (unsigned char)SHUF_E_SYM2(e);
+	}
+	return oi;
+}
+
+/*
+ * Two-stage codecs: RLE/LZW followed by Huffman entropy coding. The first
+ * stage gets the intermediate buffer capacity, returning 0 if its output
+ * would not fit.
+ */
+
+typedef size_t (*senc_fc_t)(const unsigned char *s, const size_t ss,
+			    unsigned char *o, const size_t o_max);
+
+/*
+ * Capacity check for codecs whose output is always within their size
+ * bound (e.g. RLE runs take less than their input, and the Huffman coder
+ * copies the input if the coded size is not smaller)
+ */
+#define BUILD_SENC_C(f)							\
+	static size_t f##_c(const unsigned char *s, const size_t ss,	\
+			    unsigned char *o, const size_t o_max)	\
+	{								\
+		RETURN_IF(o && o_max < f(NULL, ss, NULL), 0);		\
+		return f(s, ss, o);					\
+	}
+
+BUILD_SENC_C(senc_rle)
+
+static size_t senc_x_huf(const unsigned char *s, const size_t ss,
+			 unsigned char *o, senc_fc_t f)
+{
+	RETURN_IF(ss >= 0x80000000, 0);
+	RETURN_IF(!o && ss > 0,
+		  senc_huf(NULL, f(NULL, ss, NULL, 0), NULL) + 4);
+	RETURN_IF(!s || !o || !ss, 0);
+	size_t header_bytes = build_header(ss, o), out_size = 0,
+	       tmp_max = f(NULL, ss, NULL, 0), tmp_size;
+	unsigned char *tmp = (unsigned char *)s_malloc(tmp_max);
+	if (tmp) {
+		tmp_size = f(s, ss, tmp, tmp_max);
+		if (tmp_size)
+			out_size = senc_huf(tmp, tmp_size, o + header_bytes);
+		s_free(tmp);
+	}
+	return out_size ? header_bytes + out_size : 0;
+}
+
+static size_t sdec_x_huf(const unsigned char *s, const size_t ss0,
+			 unsigned char *o, senc_f_t f)
+{
+	RETURN_IF(!s || !ss0, 0);
+	size_t expected_ss, header_size, out_size = 0, tmp_size;
+	s = dec_header(s, ss0, &header_size, &expected_ss);
+	RETURN_IF(!o, expected_ss); /* max out size */
+	RETURN_IF(ss0 <= header_size, 0);
+	size_t ss = ss0 - header_size;
+	tmp_size = sdec_huf(s, ss, NULL);
+	unsigned char *tmp = (unsigned char *)s_malloc(tmp_size);
+	if (tmp) {
+		tmp_size = sdec_huf(s, ss, tmp);
+		if (f(tmp, tmp_size, NULL) == expected_ss)
+			out_size = f(tmp, tmp_size, o);
+		s_free(tmp);
+	}
+	return out_size;
+}
+
+size_t senc_rle_huf(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	return senc_x_huf(s, ss, o, senc_rle_c);
+}
+
+size_t sdec_rle_huf(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	return sdec_x_huf(s, ss, o, sdec_rle);
+}
+
+size_t senc_lzw_huf(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	return senc_x_huf(s, ss, o, senc_lzw_c);
+}
+
+size_t sdec_lzw_huf(const unsigned char *s, const size_t ss, unsigned char *o)
+{
+	return sdec_x_huf(s, ss, o, sdec_lzw);
+}
+
+/*
+ * Block framing: independent blocks, encoded/decoded in parallel
+ *
+ * Format (little endian):
+ * - Header: "SFR" + codec id (4 bytes), block size (4 bytes)
+ * - Encoded blocks
+ * - Block index: encoded size, decoded size and decoded data CRC-32 for
+ *   every block (12 bytes per block)
+ * - Trailer: block count (4 bytes), "SFRI" (4 bytes)
+ */
+
+#define SFR_HDR_SIZE	8
+#define SFR_NDX_ELEM	12
+#define SFR_TRL_SIZE	8
+
+BUILD_SENC_C(senc_huf)
+BUILD_SENC_C(senc_lzw_huf)
+BUILD_SENC_C(senc_rle_huf)
+
+/* Block encoders write into fixed size slots: output capacity checked */
+static const senc_fc_t sfr_enc[SFR_NCODECS] = {
+	senc_lzw_c, senc_rle_c, senc_huf_c, senc_lzw_huf_c, senc_rle_huf_c
+	};
+static const senc_f_t sfr_dec[SFR_NCODECS] = {
+	sdec_lzw, sdec_rle, sdec_huf, sdec_lzw_huf, sdec_rle_huf
+	};
+
+struct SFrameBlock
+{
+	size_t in_off, in_size, out_off, out_size;
+	uint32_t crc;
+};
+
+struct SFrameJob
+{
+	const unsigned char *s;
+	unsigned char *o;
+	senc_f_t f;
+	senc_fc_t fc;
+	size_t max_bs;
+	struct SFrameBlock *b;
+};
+
+static void sfr_enc_job(void *context, size_t i)
+{
+	struct SFrameJob *j = (struct SFrameJob *)context;
+	struct SFrameBlock *b = j->b + i;
+	b->crc = sh_crc32(0, j->s + b->in_off, b->in_size);
+	/* BEHAVIOR: 0 if not fitting in the slot (frame encoding error) */
+	b->out_size = j->fc(j->s + b->in_off, b->in_size, j->o + b->out_off,
+			    j->max_bs);
+}
+
+static void sfr_dec_job(void *context, size_t i)
+{
+	struct SFrameJob *j = (struct SFrameJob *)context;
+	struct SFrameBlock *b = j->b + i;
+	const unsigned char *s = j->s + b->in_off;
+	unsigned char *o = j->o + b->out_off;
+	/* size check before decoding, so a block can not write on others */
+	if (j->f(s, b->in_size, NULL) != b->out_size ||
+	    j->f(s, b->in_size, o) != b->out_size ||
+	    sh_crc32(0, o, b->out_size) != b->crc)
+		b->out_size = S_NPOS; /* BEHAVIOR: corrupt block */
+}
+
+size_t senc_frame(const unsigned char *s, const size_t ss, unsigned char *o,
+		  size_t block_size, const int codec, const size_t nthreads)
+{
+	RETURN_IF(codec < 0 || codec >= SFR_NCODECS, 0);
+	if (!block_size)
+		block_size = SFR_DEF_BLOCK_SIZE;
+	RETURN_IF(block_size > SFR_MAX_BLOCK_SIZE, 0);
+	size_t i, nb = (ss + block_size - 1) / block_size,
+	       max_bs = sfr_enc[codec](NULL, block_size, NULL, 0),
+	       out_off = SFR_HDR_SIZE;
+	RETURN_IF((uint64_t)nb > 0xffffffff, 0);
+	RETURN_IF(!o && ss > 0, SFR_HDR_SIZE + nb * (max_bs + SFR_NDX_ELEM) +
+				SFR_TRL_SIZE); /* max out size */
+	RETURN_IF(!s || !o || !ss, 0);
+	struct SFrameJob j;
+	j.b = (struct SFrameBlock *)s_malloc(nb * sizeof(struct SFrameBlock));
+	RETURN_IF(!j.b, 0);
+	j.s = s;
+	j.o = o;
+	j.fc = sfr_enc[codec];
+	j.max_bs = max_bs;
+	for (i = 0; i < nb; i++) {
+		j.b[i].in_off = i * block_size;
+		j.b[i].in_size = S_MIN(block_size, ss - j.b[i].in_off);
+		j.b[i].out_off = SFR_HDR_SIZE + i * max_bs;
+	}
+	s_par_run(nthreads, nb, sfr_enc_job, &j);
+	/* compact the blocks, and append the index */
+	for (i = 0; i < nb; i++) {
+		if (!j.b[i].out_size) {
+			out_off = 0;
+			break;
+		}
+		if (out_off != j.b[i].out_off)
+			memmove(o + out_off, o + j.b[i].out_off,
+				j.b[i].out_size);
+		out_off += j.b[i].out_size;
+	}
+	if (out_off) {
+		o[0] = 'S';
+		o[1] = 'F';
+		o[2] = 'R';
+		o[3] = (unsigned char)codec;
+		S_ST_LE_U32(o + 4, (uint32_t)block_size);
+		for (i = 0; i < nb; i++, out_off += SFR_NDX_ELEM) {
+			S_ST_LE_U32(o + out_off, (uint32_t)j.b[i].out_size);
+			S_ST_LE_U32(o + out_off + 4, (uint32_t)j.b[i].in_size);
+			S_ST_LE_U32(o + out_off + 8, j.b[i].crc);
+		}
+		S_ST_LE_U32(o + out_off, (uint32_t)nb);
+		memcpy(o + out_off + 4, "SFRI", 4);
+		out_off += SFR_TRL_SIZE;
+	}
+	s_free(j.b);
+	return out_off;
+}
+
+/*
+ * Frame index load. Returns the number of blocks (0 on invalid frame).
+ * If "b" is not NULL, it gets the offsets and sizes of every block, or
+ * only the ones of the block "sel" if it is not S_NPOS.
+ */
+static size_t sfr_index(const unsigned char *s, const size_t ss,
+			struct SFrameBlock *b, senc_f_t *f, const size_t sel)
+{
+	RETURN_IF(!s || ss < SFR_HDR_SIZE + SFR_TRL_SIZE, 0);
+	RETURN_IF(s[0] != 'S' || s[1] != 'F' || s[2] != 'R' ||
+		  s[3] >= SFR_NCODECS || memcmp(s + ss - 4, "SFRI", 4), 0);
+	size_t i, block_size = S_LD_LE_U32(s + 4),
+	       nb = S_LD_LE_U32(s + ss - SFR_TRL_SIZE),
+	       in_off = SFR_HDR_SIZE, out_off = 0, in_end,
+	       ndx_max = (ss - SFR_HDR_SIZE - SFR_TRL_SIZE) / SFR_NDX_ELEM;
+	RETURN_IF(!nb || nb > ndx_max, 0);
+	in_end = ss - SFR_TRL_SIZE - nb * SFR_NDX_ELEM;
+	const unsigned char *ndx = s + in_end;
+	if (f)
+		*f = sfr_dec[s[3]];
+	for (i = 0; i < nb; i++, ndx += SFR_NDX_ELEM) {
+		size_t in_size = S_LD_LE_U32(ndx),
+		       out_size = S_LD_LE_U32(ndx + 4);
+		/* BEHAVIOR: all blocks but the last one must be full */
+		RETURN_IF(out_size > block_size ||
+			  (i + 1 < nb && out_size != block_size), 0);
+		RETURN_IF(in_size > in_end - in_off, 0);
+		if (b && (sel == S_NPOS || sel == i)) {
+			b->in_off = in_off;
+			b->in_size = in_size;
+			b->out_off = out_off;
+			b->out_size = out_size;
+			b->crc = S_LD_LE_U32(ndx + 8);
+			b++;
+		}
+		in_off += in_size;
+		out_off += out_size;
+	}
+	return nb;
+}
+
+size_t sdec_frame(const unsigned char *s, const size_t ss, unsigned char *o,
+		  const size_t nthreads)
+{
+	size_t i, nb = sfr_index(s, ss, NULL, NULL, S_NPOS), out_size;
+	RETURN_IF(!nb, 0);
+	struct SFrameJob j;
+	j.b = (struct SFrameBlock *)s_malloc(nb * sizeof(struct SFrameBlock));
+	RETURN_IF(!j.b, 0);
+	sfr_index(s, ss, j.b, &j.f, S_NPOS);
+	out_size = j.b[nb - 1].out_off + j.b[nb - 1].out_size;
+	if (o) {
+		j.s = s;
+		j.o = o;
+		s_par_run(nthreads, nb, sfr_dec_job, &j);
+		for (i = 0; i < nb; i++)
+			if (j.b[i].out_size == S_NPOS) {
+				out_size = 0;
+				break;
+			}
+	}
+	s_free(j.b);
+	return out_size;
+}
+
+size_t sdec_frame_nblocks(const unsigned char *s, const size_t ss)
+{
+	return sfr_index(s, ss, NULL, NULL, S_NPOS);
+}
+
+size_t sdec_frame_block(const unsigned char *s, const size_t ss,
+			const size_t block_index, unsigned char *o)
+{
+	struct SFrameBlock b;
+	struct SFrameJob j;
+	size_t nb = sfr_index(s, ss, &b, &j.f, block_index);
+	RETURN_IF(block_index >= nb, 0);
+	RETURN_IF(!o, b.out_size);
+	b.out_off = 0;
+	j.s = s;
+	j.o = o;
+	j.b = &b;
+	sfr_dec_job(&j, 0);
+	return b.out_size == S_NPOS ? 0 : b.out_size;
+}
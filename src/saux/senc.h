@@ -53,6 +53,28 @@ extern "C" {
  *      Data with lots of repeated bytes:
  *       6 GB/s (i5-3330 @3GHz)
  *       300 MB/s (ARM11 @700MHz)
+ * - Preset dictionary support (senc_lzw_dict/sdec_lzw_dict): the LZW tree
+ *   is populated with the dictionary before encoding, for better
+ *   compression of small inputs. Dictionaries can be built from sample
+ *   data (senc_dict_build).
+ *
+ * Features (canonical Huffman):
+ *
+ * - Byte-oriented static Huffman coding, code lengths limited to 11 bits,
+ *   stored as a 128 byte table after the size header.
+ * - Incompressible input falls back to a plain copy (1 byte overhead).
+ * - Decoding uses a 2048-entry table, returning up to two symbols per
+ *   lookup.
+ * - Can be used as entropy coding stage after RLE or LZW (senc_rle_huf,
+ *   senc_lzw_huf).
+ *
+ * Features (block framing):
+ *
+ * - Input split in independent blocks, encoded with one of the LZW, RLE or
+ *   Huffman codecs, each block with its CRC-32, and a block index at the
+ *   end of the frame.
+ * - Blocks are encoded/decoded in parallel (see sthread.h).
+ * - Random access: any block can be decoded without decoding the others.
  *
  * Observations:
  * - Tables take 288 bytes (could be reduced to 248 bytes -tweaking access
@@ -63,6 +85,19 @@ extern "C" {
 
 #include "scommon.h"
 
+#define SFR_DEF_BLOCK_SIZE	(1024 * 1024)
+#define SFR_MAX_BLOCK_SIZE	0x7fffffff
+
+enum eSFrameCodec
+{
+	SFR_LZW,
+	SFR_RLE,
+	SFR_HUF,
+	SFR_LZW_HUF,
+	SFR_RLE_HUF,
+	SFR_NCODECS
+};
+
 typedef size_t (*senc_f_t)(const unsigned char *s, const size_t ss, unsigned char *o);
 typedef size_t (*senc_f2_t)(const unsigned char *s, const size_t ss, unsigned char *o, const size_t known_sso);
 
@@ -85,6 +120,19 @@ size_t senc_lzw(const unsigned char *s, const size_t ss, unsigned char *o);
 size_t sdec_lzw(const unsigned char *s, const size_t ss, unsigned char *o);
 size_t senc_rle(const unsigned char *s, const size_t ss, unsigned char *o);
 size_t sdec_rle(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t senc_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t sdec_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t senc_rle_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t sdec_rle_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t senc_lzw_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t sdec_lzw_huf(const unsigned char *s, const size_t ss, unsigned char *o);
+size_t senc_lzw_dict(const unsigned char *s, const size_t ss, unsigned char *o, const unsigned char *d, const size_t ds);
+size_t sdec_lzw_dict(const unsigned char *s, const size_t ss, unsigned char *o, const unsigned char *d, const size_t ds);
+size_t senc_dict_build(const unsigned char **s, const size_t *ss, const size_t n, unsigned char *o, const size_t max_size);
+size_t senc_frame(const unsigned char *s, const size_t ss, unsigned char *o, size_t block_size, const int codec, const size_t nthreads);
+size_t sdec_frame(const unsigned char *s, const size_t ss, unsigned char *o, const size_t nthreads);
+size_t sdec_frame_nblocks(const unsigned char *s, const size_t ss);
+size_t sdec_frame_block(const unsigned char *s, const size_t ss, const size_t block_index, unsigned char *o);
 
 #define senc_b16 senc_HEX
 #define sdec_b16 sdec_hex
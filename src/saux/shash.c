@@ -14,6 +14,9 @@
  */
 
 #define S_CRC32_POLY	0xedb88320
+#define SH_M1		0x9e3779b97f4a7c15
+#define SH_M2		0xc2b2ae3d27d4eb4f
+#define SH_M3		0x165667b19e3779f9
 
 /*
  * CRC-32 implementations
@@ -117,6 +120,29 @@ uint32_t sh_crc32(uint32_t crc, const void *buf, size_t buf_size)
 
 #endif /* #ifdef S_MINIMAL */
 
+/*
+ * Fast 64-bit hash (not cryptographic): 8 bytes per loop, multiply and
+ * rotate mixing, and a final avalanche step (sh_mix64())
+ */
+uint64_t sh_hash64(const void *buf, size_t buf_size, uint64_t seed)
+{
+	const uint8_t *p = (const uint8_t *)buf;
+	uint64_t h = seed ^ ((uint64_t)buf_size * SH_M1), k;
+	size_t i;
+	for (; buf_size >= 8; buf_size -= 8, p += 8) {
+		k = S_LD_LE_U64(p) * SH_M2;
+		h ^= S_ROL64(k, 31) * SH_M1;
+		h = S_ROL64(h, 27) * SH_M1 + SH_M3;
+	}
+	if (buf_size) {
+		for (k = 0, i = buf_size; i > 0; i--)
+			k = k << 8 | p[i - 1];
+		k *= SH_M2;
+		h ^= S_ROL64(k, 31) * SH_M1;
+	}
+	return sh_mix64(h);
+}
+
 #else
 
 /*
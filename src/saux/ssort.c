@@ -46,8 +46,8 @@
 #define BUILD_SORT3(FN, T, SWAPF, SORT2F)		\
 	S_INLINE void FN(T *b)				\
 	{						\
-		if (b[0] > b[2])			\
-			SWAPF(b, 0, 2);			\
+		SORT2F(b);				\
+		SORT2F(b + 1);				\
 		SORT2F(b);				\
 	}
 
@@ -58,10 +58,9 @@
 		SORT2F(b + 2);				\
 		if (b[2] < b[0])			\
 			SWAPF(b, 0, 2);			\
+		if (b[3] < b[1])			\
+			SWAPF(b, 1, 3);			\
 		SORT2F(b + 1);				\
-		if (b[2] < b[1])			\
-			SWAPF(b, 1, 2);			\
-		SORT2F(b + 2);				\
 	}
 
 #define BUILD_MSD_RADIX_SORT(FN, T, TC, MSBF, SWPF, S2F, S3F, S4F, OFF)	\
@@ -155,6 +154,33 @@ BUILD_MSD_RADIX_SORT(s_msd_radix_sort_i64, int64_t, uint64_t, s_msb64,
 BUILD_MSD_RADIX_SORT(s_msd_radix_sort_u64, uint64_t, uint64_t, s_msb64,
 		     s_swap_u64, s_sort2_u64, s_sort3_u64, s_sort4_u64, 0)
 
+/*
+ * Generic sort: elements are handled as opaque fixed-size blobs, so moves
+ * and swaps get inlined, while the comparison is still the user callback
+ */
+
+#define BUILD_SORT_BLOB(SZ)						\
+	struct SSortBlob##SZ { char d[SZ]; };				\
+	S_INLINE sbool_t s_blob_lt##SZ(const struct SSortBlob##SZ *x,	\
+				       const struct SSortBlob##SZ *y,	\
+				       ssort_cmp_t cmpf)		\
+	{								\
+		return cmpf(x, y) < 0 ? S_TRUE : S_FALSE;		\
+	}								\
+	SSORT_BUILD_PDQ_CTX(s_pdq_blob##SZ, struct SSortBlob##SZ,	\
+			    ssort_cmp_t, s_blob_lt##SZ)			\
+	SSORT_BUILD_SELECT_CTX(s_pdq_blob##SZ, struct SSortBlob##SZ,	\
+			       ssort_cmp_t, s_blob_lt##SZ)
+
+BUILD_SORT_BLOB(1)
+BUILD_SORT_BLOB(2)
+BUILD_SORT_BLOB(4)
+BUILD_SORT_BLOB(8)
+BUILD_SORT_BLOB(12)
+BUILD_SORT_BLOB(16)
+BUILD_SORT_BLOB(24)
+BUILD_SORT_BLOB(32)
+
 /*
  * Sort functions
  */
@@ -217,5 +243,141 @@ void ssort_u64(uint64_t *b, size_t elems)
 	s_msd_radix_sort_u64(b, elems);
 }
 
+void ssort_f32(float *b, size_t elems)
+{
+	SSORT_CHECK(b, elems);
+	size_t i;
+	uint32_t *k = (uint32_t *)b;
+	for (i = 0; i < elems; i++)
+		k[i] = ssort_f32_key(k[i]);
+	s_msd_radix_sort_u32(k, elems);
+	for (i = 0; i < elems; i++)
+		k[i] = ssort_f32_unkey(k[i]);
+}
+
+void ssort_f64(double *b, size_t elems)
+{
+	SSORT_CHECK(b, elems);
+	size_t i;
+	uint64_t *k = (uint64_t *)b;
+	for (i = 0; i < elems; i++)
+		k[i] = ssort_f64_key(k[i]);
+	s_msd_radix_sort_u64(k, elems);
+	for (i = 0; i < elems; i++)
+		k[i] = ssort_f64_unkey(k[i]);
+}
+
 #endif /* #ifndef S_MINIMAL */
 
+#define SSORT_LSD_BITS		11
+#define SSORT_LSD_SIZE		(1 << SSORT_LSD_BITS)
+#define SSORT_LSD_MASK		(SSORT_LSD_SIZE - 1)
+#define SSORT_LSD_PASSES	6	/* ceil(64 / SSORT_LSD_BITS) */
+
+sbool_t ssort_kv_u64(uint64_t *k, uint64_t *v, size_t elems)
+{
+	RETURN_IF(!k || !v || elems <= 1, S_TRUE);
+	size_t i, p, o, t, *cnt;
+	uint64_t x, diff = 0, *ks = k, *vs = v, *kd, *vd, *aux, *tmp;
+	const size_t cnt_size = SSORT_LSD_PASSES * SSORT_LSD_SIZE;
+	RETURN_IF(elems > (((size_t)-1) - cnt_size * sizeof(size_t)) /
+			  (2 * sizeof(uint64_t)), S_FALSE);
+	aux = (uint64_t *)s_malloc(elems * 2 * sizeof(uint64_t) +
+				   cnt_size * sizeof(size_t));
+	RETURN_IF(!aux, S_FALSE);
+	cnt = (size_t *)(aux + elems * 2);
+	kd = aux;
+	vd = aux + elems;
+	memset(cnt, 0, cnt_size * sizeof(size_t));
+	for (i = 0; i < elems; i++) {	/* all digit histograms at once */
+		x = k[i];
+		diff |= x ^ k[0];
+		for (p = 0; p < SSORT_LSD_PASSES; p++)
+			cnt[p * SSORT_LSD_SIZE +
+			    ((x >> (p * SSORT_LSD_BITS)) & SSORT_LSD_MASK)]++;
+	}
+	for (p = 0; p < SSORT_LSD_PASSES; p++) {
+		const size_t sh = p * SSORT_LSD_BITS;
+		size_t *c = cnt + p * SSORT_LSD_SIZE;
+		if (((diff >> sh) & SSORT_LSD_MASK) == 0)
+			continue;	/* same digit for all keys */
+		for (i = o = 0; i < SSORT_LSD_SIZE; i++) {
+			t = c[i];
+			c[i] = o;
+			o += t;
+		}
+		for (i = 0; i < elems; i++) {
+			o = c[(ks[i] >> sh) & SSORT_LSD_MASK]++;
+			kd[o] = ks[i];
+			vd[o] = vs[i];
+		}
+		tmp = ks;
+		ks = kd;
+		kd = tmp;
+		tmp = vs;
+		vs = vd;
+		vd = tmp;
+	}
+	if (ks != k) {
+		memcpy(k, ks, elems * sizeof(uint64_t));
+		memcpy(v, vs, elems * sizeof(uint64_t));
+	}
+	s_free(aux);
+	return S_TRUE;
+}
+
+#define SSORT_GEN_CASE(SZ)						\
+	case SZ:							\
+		s_pdq_blob##SZ((struct SSortBlob##SZ *)b, elems, cmpf);	\
+		break
+
+void ssort_gen(void *b, size_t elems, size_t elem_size, ssort_cmp_t cmpf)
+{
+	if (!b || !cmpf || !elem_size || elems <= 1)
+		return;
+#ifndef S_MINIMAL
+	switch (elem_size) {
+	SSORT_GEN_CASE(1);
+	SSORT_GEN_CASE(2);
+	SSORT_GEN_CASE(4);
+	SSORT_GEN_CASE(8);
+	SSORT_GEN_CASE(12);
+	SSORT_GEN_CASE(16);
+	SSORT_GEN_CASE(24);
+	SSORT_GEN_CASE(32);
+	default:
+		qsort(b, elems, elem_size, cmpf);
+	}
+#else
+	qsort(b, elems, elem_size, cmpf);
+#endif
+}
+
+#define SSORT_SELECT_CASE(SZ)						\
+	case SZ:							\
+		s_pdq_blob##SZ##_select((struct SSortBlob##SZ *)b, elems, \
+					nth, cmpf);			\
+		break
+
+void ssort_gen_select(void *b, size_t elems, size_t elem_size, size_t nth,
+		      ssort_cmp_t cmpf)
+{
+	if (!b || !cmpf || !elem_size || nth >= elems || elems <= 1)
+		return;
+#ifndef S_MINIMAL
+	switch (elem_size) {
+	SSORT_SELECT_CASE(1);
+	SSORT_SELECT_CASE(2);
+	SSORT_SELECT_CASE(4);
+	SSORT_SELECT_CASE(8);
+	SSORT_SELECT_CASE(12);
+	SSORT_SELECT_CASE(16);
+	SSORT_SELECT_CASE(24);
+	SSORT_SELECT_CASE(32);
+	default:
+		qsort(b, elems, elem_size, cmpf);
+	}
+#else
+	qsort(b, elems, elem_size, cmpf);
+#endif
+}
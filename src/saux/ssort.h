@@ -21,6 +21,23 @@ extern "C" {
  *     case only happens when having duplicated elements (e.g. if you
  *     sort more than 2^16 16-bit elements, it would start being really O(n),
  *     for that specific case).
+ * - Floating point sort (IEEE 754 total order): key transform to unsigned
+ *   integers, then MSD radix sort (as the 32/64-bit integer sort)
+ * - Stable 64-bit key + 64-bit payload sort (ssort_kv_u64)
+ *   - Algorithm: LSD radix sort
+ *   - Space complexity: O(n)
+ *   - Time complexity: O(n)
+ * - Generic sort template (SSORT_BUILD_PDQ), specialized at compile time for
+ *   a given element type and an inlineable comparator
+ *   - Algorithm: pattern-defeating quicksort (introsort variant: median of
+ *     3 or ninther pivot, equal element skipping, already sorted partition
+ *     detection, pattern breaking swaps, and heapsort fallback)
+ *   - Space complexity: O(log n) (stack)
+ *   - Time complexity: O(n log n) worst case, O(n) for sorted or
+ *     reverse-sorted input, and for few distinct values
+ * - Selection templates (SSORT_BUILD_SELECT, SSORT_BUILD_TOPK): nth element
+ *   (introselect, O(n) expected time) and k greatest elements (heap,
+ *   O(n log k))
  *
  * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
  * the BSD 3-Clause License (see the doc/LICENSE file included).
@@ -36,6 +53,401 @@ void ssort_i32(int32_t *b, size_t elems);
 void ssort_u32(uint32_t *b, size_t elems);
 void ssort_i64(int64_t *b, size_t elems);
 void ssort_u64(uint64_t *b, size_t elems);
+void ssort_f32(float *b, size_t elems);
+void ssort_f64(double *b, size_t elems);
+
+/*
+ * IEEE 754 total order as unsigned integer order: the sign bit is flipped
+ * for positive values, and all bits for negative values (-NaN < -inf < ...
+ * < -0 < +0 < ... < +inf < +NaN). Floating point sort is a radix sort of
+ * the transformed keys.
+ */
+S_INLINE uint32_t ssort_f32_key(const uint32_t x)
+{
+	return x ^ (((uint32_t)0 - (x >> 31)) | 0x80000000);
+}
+
+S_INLINE uint32_t ssort_f32_unkey(const uint32_t k)
+{
+	return k ^ (((k >> 31) - 1) | 0x80000000);
+}
+
+S_INLINE uint64_t ssort_f64_key(const uint64_t x)
+{
+	return x ^ (((uint64_t)0 - (x >> 63)) | (uint64_t)1 << 63);
+}
+
+S_INLINE uint64_t ssort_f64_unkey(const uint64_t k)
+{
+	return k ^ (((k >> 63) - 1) | (uint64_t)1 << 63);
+}
+
+/*
+ * Stable sort of 64-bit unsigned keys carrying a 64-bit payload (e.g. the
+ * element index, for argsort). LSD radix sort (11-bit digits, passes where
+ * all keys have the same digit are skipped), O(n) time, O(n) extra space.
+ * Returns S_FALSE on allocation error (input left unchanged).
+ */
+sbool_t ssort_kv_u64(uint64_t *k, uint64_t *v, size_t elems);
+
+/*
+ * Sort for elements of arbitrary size with a compare function (qsort(3)
+ * compatible). Common element sizes are sorted with the SSORT_BUILD_PDQ
+ * template, other sizes fall back to libc qsort.
+ */
+typedef int (*ssort_cmp_t)(const void *a, const void *b);
+
+void ssort_gen(void *b, size_t elems, size_t elem_size, ssort_cmp_t cmpf);
+
+/*
+ * Selection (nth element, see SSORT_BUILD_SELECT) for elements of arbitrary
+ * size with a compare function. Sizes not covered by ssort_gen templates
+ * (or S_MINIMAL builds) get a full sort (libc qsort).
+ */
+void ssort_gen_select(void *b, size_t elems, size_t elem_size, size_t nth,
+		      ssort_cmp_t cmpf);
+
+/*
+ * Sort template
+ *
+ * SSORT_BUILD_PDQ(FN, T, LESS) generates "static void FN(T *b, size_t
+ * elems)", being LESS(a, b) a macro or function returning non-zero when
+ * "*a < *b" (a and b are "const T *"). SSORT_BUILD_PDQ_CTX(FN, T, CTX_T,
+ * LESS) does the same with an extra context parameter passed to the
+ * comparator: "FN(T *b, size_t elems, CTX_T ctx)", "LESS(a, b, ctx)".
+ * Example:
+ *
+ * struct Point { int x, y; };
+ * #define POINT_LESS(a, b) ((a)->x < (b)->x || \
+ *			    ((a)->x == (b)->x && (a)->y < (b)->y))
+ * SSORT_BUILD_PDQ(sort_points, struct Point, POINT_LESS)
+ * ...
+ * sort_points(points, npoints);
+ */
+
+#define SSORT_INS_THRS		24	/* insertion sort below this size */
+#define SSORT_NINTHER_THRS	128	/* ninther pivot above this size */
+#define SSORT_PINS_MAX		8	/* partial insertion sort moves */
+
+#define SSORT_BUILD_PDQ_CTX(FN, T, CTX_T, LESS)				\
+	S_INLINE void FN##_swap(T *x, T *y)				\
+	{								\
+		T tmp = *x;						\
+		*x = *y;						\
+		*y = tmp;						\
+	}								\
+	S_INLINE void FN##_sort3(T *x, T *y, T *z, CTX_T ctx)		\
+	{								\
+		if (LESS(y, x, ctx))					\
+			FN##_swap(x, y);				\
+		if (LESS(z, y, ctx)) {					\
+			FN##_swap(y, z);				\
+			if (LESS(y, x, ctx))				\
+				FN##_swap(x, y);			\
+		}							\
+	}								\
+	static sbool_t FN##_ins(T *b, size_t elems, size_t max_moves,	\
+				CTX_T ctx)				\
+	{								\
+		size_t i, j, moves = 0;					\
+		T tmp;							\
+		for (i = 1; i < elems; i++) {				\
+			if (!LESS(b + i, b + i - 1, ctx))		\
+				continue;				\
+			tmp = b[i];					\
+			for (j = i; j > 0 && LESS(&tmp, b + j - 1, ctx); j--) \
+				b[j] = b[j - 1];			\
+			b[j] = tmp;					\
+			moves += i - j;					\
+			if (moves > max_moves && i + 1 < elems)		\
+				return S_FALSE;				\
+		}							\
+		return S_TRUE;						\
+	}								\
+	static void FN##_sift(T *b, size_t i, size_t elems, CTX_T ctx)	\
+	{								\
+		size_t c;						\
+		T tmp = b[i];						\
+		for (; (c = 2 * i + 1) < elems; i = c) {		\
+			if (c + 1 < elems && LESS(b + c, b + c + 1, ctx)) \
+				c++;					\
+			if (!LESS(&tmp, b + c, ctx))			\
+				break;					\
+			b[i] = b[c];					\
+		}							\
+		b[i] = tmp;						\
+	}								\
+	static void FN##_heap(T *b, size_t elems, CTX_T ctx)		\
+	{								\
+		size_t i;						\
+		if (elems < 2)						\
+			return;						\
+		for (i = elems / 2; i > 0; i--)				\
+			FN##_sift(b, i - 1, elems, ctx);		\
+		for (i = elems - 1; i > 0; i--) {			\
+			FN##_swap(b, b + i);				\
+			FN##_sift(b, 0, i, ctx);			\
+		}							\
+	}								\
+	static size_t FN##_part_r(T *b, size_t elems, sbool_t *parted,	\
+				  CTX_T ctx)				\
+	{								\
+		T pivot = b[0];						\
+		size_t i = 1, j = elems - 1;				\
+		for (; LESS(b + i, &pivot, ctx); i++);			\
+		if (i == 1)						\
+			for (; i < j && !LESS(b + j, &pivot, ctx); j--); \
+		else							\
+			for (; !LESS(b + j, &pivot, ctx); j--);		\
+		*parted = i >= j ? S_TRUE : S_FALSE;			\
+		while (i < j) {						\
+			FN##_swap(b + i, b + j);			\
+			for (i++; LESS(b + i, &pivot, ctx); i++);	\
+			for (j--; !LESS(b + j, &pivot, ctx); j--);	\
+		}							\
+		b[0] = b[i - 1];					\
+		b[i - 1] = pivot;					\
+		return i - 1;						\
+	}								\
+	static size_t FN##_part_l(T *b, size_t elems, CTX_T ctx)	\
+	{								\
+		T pivot = b[0];						\
+		size_t i = 0, j = elems - 1;				\
+		for (; LESS(&pivot, b + j, ctx); j--);			\
+		if (j + 1 == elems)					\
+			for (; i < j && !LESS(&pivot, b + i + 1, ctx); i++); \
+		else							\
+			for (; !LESS(&pivot, b + i + 1, ctx); i++);	\
+		for (i++; i < j;) {					\
+			FN##_swap(b + i, b + j);			\
+			for (j--; LESS(&pivot, b + j, ctx); j--);	\
+			for (i++; !LESS(&pivot, b + i, ctx); i++);	\
+		}							\
+		b[0] = b[j];						\
+		b[j] = pivot;						\
+		return j;						\
+	}								\
+	static void FN##_shuffle(T *b, size_t elems, size_t p)		\
+	{								\
+		size_t nl = p, nr = elems - p - 1, k;			\
+		if (nl >= SSORT_INS_THRS) {				\
+			k = nl / 4;					\
+			FN##_swap(b, b + k);				\
+			FN##_swap(b + p - 1, b + p - k);		\
+			if (nl > SSORT_NINTHER_THRS) {			\
+				FN##_swap(b + 1, b + k + 1);		\
+				FN##_swap(b + 2, b + k + 2);		\
+				FN##_swap(b + p - 2, b + p - k - 1);	\
+				FN##_swap(b + p - 3, b + p - k - 2);	\
+			}						\
+		}							\
+		if (nr >= SSORT_INS_THRS) {				\
+			k = nr / 4;					\
+			FN##_swap(b + p + 1, b + p + 1 + k);		\
+			FN##_swap(b + elems - 1, b + elems - k);	\
+			if (nr > SSORT_NINTHER_THRS) {			\
+				FN##_swap(b + p + 2, b + p + 2 + k);	\
+				FN##_swap(b + p + 3, b + p + 3 + k);	\
+				FN##_swap(b + elems - 2, b + elems - 1 - k); \
+				FN##_swap(b + elems - 3, b + elems - 2 - k); \
+			}						\
+		}							\
+	}								\
+	static void FN##_loop(T *b, size_t elems, size_t bad,		\
+			      sbool_t leftmost, CTX_T ctx)		\
+	{								\
+		size_t s2, p;						\
+		sbool_t parted;						\
+		for (;;) {						\
+			if (elems < SSORT_INS_THRS) {			\
+				FN##_ins(b, elems, (size_t)-1, ctx);	\
+				return;					\
+			}						\
+			s2 = elems / 2;					\
+			if (elems > SSORT_NINTHER_THRS) {		\
+				FN##_sort3(b, b + s2, b + elems - 1, ctx); \
+				FN##_sort3(b + 1, b + s2 - 1, b + elems - 2, \
+					   ctx);			\
+				FN##_sort3(b + 2, b + s2 + 1, b + elems - 3, \
+					   ctx);			\
+				FN##_sort3(b + s2 - 1, b + s2, b + s2 + 1, \
+					   ctx);			\
+				FN##_swap(b, b + s2);			\
+			} else {					\
+				FN##_sort3(b + s2, b, b + elems - 1, ctx); \
+			}						\
+			if (!leftmost && !LESS(b - 1, b, ctx)) {	\
+				p = FN##_part_l(b, elems, ctx) + 1;	\
+				b += p;					\
+				elems -= p;				\
+				continue;				\
+			}						\
+			p = FN##_part_r(b, elems, &parted, ctx);	\
+			if (p < elems / 8 || elems - p - 1 < elems / 8) { \
+				if (--bad == 0) {			\
+					FN##_heap(b, elems, ctx);	\
+					return;				\
+				}					\
+				FN##_shuffle(b, elems, p);		\
+			} else if (parted &&				\
+				   FN##_ins(b, p, SSORT_PINS_MAX, ctx) && \
+				   FN##_ins(b + p + 1, elems - p - 1,	\
+					    SSORT_PINS_MAX, ctx)) {	\
+				return;					\
+			}						\
+			FN##_loop(b, p, bad, leftmost, ctx);		\
+			b += p + 1;					\
+			elems -= p + 1;					\
+			leftmost = S_FALSE;				\
+		}							\
+	}								\
+	static void FN(T *b, size_t elems, CTX_T ctx)			\
+	{								\
+		size_t bad = 1, n = elems;				\
+		if (!b || elems < 2)					\
+			return;						\
+		for (; n > 1; n >>= 1)					\
+			bad++;						\
+		FN##_loop(b, elems, bad, S_TRUE, ctx);			\
+	}
+
+#define SSORT_BUILD_PDQ(FN, T, LESS)					\
+	S_INLINE sbool_t FN##_lt(const T *x, const T *y, const void *ctx) \
+	{								\
+		(void)ctx;						\
+		return LESS(x, y) ? S_TRUE : S_FALSE;			\
+	}								\
+	SSORT_BUILD_PDQ_CTX(FN##_ctx, T, const void *, FN##_lt)		\
+	static void FN(T *b, size_t elems)				\
+	{								\
+		FN##_ctx(b, elems, NULL);				\
+	}
+
+/*
+ * Selection templates, for use after the SSORT_BUILD_PDQ_CTX instance with
+ * the same FN, T, CTX_T and LESS (its partitioning and heap functions are
+ * reused):
+ *
+ * SSORT_BUILD_SELECT_CTX(FN, T, CTX_T, LESS) generates "static void
+ * FN##_select(T *b, size_t elems, size_t nth, CTX_T ctx)", which reorders
+ * the elements so b[nth] is the one that would be there after sorting, with
+ * no greater elements before it, and no smaller elements after it.
+ * Introselect: pdq pivot selection and partitioning, narrowing to the side
+ * containing "nth", with heapsort fallback. O(n) expected time.
+ *
+ * SSORT_BUILD_TOPK_CTX(FN, T, CTX_T, LESS) generates "static void
+ * FN##_largest(T *o, const T *b, size_t elems, size_t k, CTX_T ctx)",
+ * which writes the k greatest elements of b to o, in descending order
+ * (k-element min-heap). O(n log k) time, close to O(n) when k << n.
+ *
+ * SSORT_BUILD_SELECT(FN, T, LESS) and SSORT_BUILD_TOPK(FN, T, LESS) do the
+ * same, without the context parameter (for use after SSORT_BUILD_PDQ).
+ */
+
+#define SSORT_BUILD_SELECT_CTX(FN, T, CTX_T, LESS)			\
+	static void FN##_select(T *b, size_t elems, size_t nth, CTX_T ctx) \
+	{								\
+		size_t s2, p, bad = 1, n = elems;			\
+		sbool_t parted, leftmost = S_TRUE;			\
+		if (!b || nth >= elems)					\
+			return;						\
+		for (; n > 1; n >>= 1)					\
+			bad++;						\
+		while (elems >= SSORT_INS_THRS) {			\
+			s2 = elems / 2;					\
+			if (elems > SSORT_NINTHER_THRS) {		\
+				FN##_sort3(b, b + s2, b + elems - 1, ctx); \
+				FN##_sort3(b + 1, b + s2 - 1, b + elems - 2, \
+					   ctx);			\
+				FN##_sort3(b + 2, b + s2 + 1, b + elems - 3, \
+					   ctx);			\
+				FN##_sort3(b + s2 - 1, b + s2, b + s2 + 1, \
+					   ctx);			\
+				FN##_swap(b, b + s2);			\
+			} else {					\
+				FN##_sort3(b + s2, b, b + elems - 1, ctx); \
+			}						\
+			if (!leftmost && !LESS(b - 1, b, ctx)) {	\
+				p = FN##_part_l(b, elems, ctx);		\
+				if (nth <= p)				\
+					return;	/* all equal */		\
+				b += p + 1;				\
+				elems -= p + 1;				\
+				nth -= p + 1;				\
+				continue;				\
+			}						\
+			p = FN##_part_r(b, elems, &parted, ctx);	\
+			if (p == nth)					\
+				return;					\
+			if (p < elems / 8 || elems - p - 1 < elems / 8) { \
+				if (--bad == 0) {			\
+					FN##_heap(b, elems, ctx);	\
+					return;				\
+				}					\
+				FN##_shuffle(b, elems, p);		\
+			}						\
+			if (nth < p) {					\
+				elems = p;				\
+			} else {					\
+				b += p + 1;				\
+				elems -= p + 1;				\
+				nth -= p + 1;				\
+				leftmost = S_FALSE;			\
+			}						\
+		}							\
+		FN##_ins(b, elems, (size_t)-1, ctx);			\
+	}
+
+#define SSORT_BUILD_TOPK_CTX(FN, T, CTX_T, LESS)			\
+	static void FN##_sift_min(T *b, size_t i, size_t elems, CTX_T ctx) \
+	{								\
+		size_t c;						\
+		T tmp = b[i];						\
+		for (; (c = 2 * i + 1) < elems; i = c) {		\
+			if (c + 1 < elems && LESS(b + c + 1, b + c, ctx)) \
+				c++;					\
+			if (!LESS(b + c, &tmp, ctx))			\
+				break;					\
+			b[i] = b[c];					\
+		}							\
+		b[i] = tmp;						\
+	}								\
+	static void FN##_largest(T *o, const T *b, size_t elems, size_t k, \
+				 CTX_T ctx)				\
+	{								\
+		size_t i;						\
+		if (k > elems)						\
+			k = elems;					\
+		if (!o || !b || !k)					\
+			return;						\
+		for (i = 0; i < k; i++)					\
+			o[i] = b[i];					\
+		for (i = k / 2; i > 0; i--)				\
+			FN##_sift_min(o, i - 1, k, ctx);		\
+		for (i = k; i < elems; i++)				\
+			if (LESS(o, b + i, ctx)) {			\
+				o[0] = b[i];				\
+				FN##_sift_min(o, 0, k, ctx);		\
+			}						\
+		for (i = k - 1; i > 0; i--) {				\
+			FN##_swap(o, o + i);				\
+			FN##_sift_min(o, 0, i, ctx);			\
+		}							\
+	}
+
+#define SSORT_BUILD_SELECT(FN, T, LESS)					\
+	SSORT_BUILD_SELECT_CTX(FN##_ctx, T, const void *, FN##_lt)	\
+	static void FN##_select(T *b, size_t elems, size_t nth)		\
+	{								\
+		FN##_ctx_select(b, elems, nth, NULL);			\
+	}
+
+#define SSORT_BUILD_TOPK(FN, T, LESS)					\
+	SSORT_BUILD_TOPK_CTX(FN##_ctx, T, const void *, FN##_lt)	\
+	static void FN##_largest(T *o, const T *b, size_t elems, size_t k) \
+	{								\
+		FN##_ctx_largest(o, b, elems, k, NULL);			\
+	}
 
 #ifdef __cplusplus
 }	/* extern "C" { */
@@ -0,0 +1,126 @@
+/*
+ * sthread.c
+ *
+ * Minimal worker pool for data-parallel jobs
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "sthread.h"
+
+#if defined(S_THREADS_WIN32)
+	#include <windows.h>
+#elif defined(S_THREADS_POSIX)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+struct SParWorker
+{
+	s_job_f f;
+	void *context;
+	size_t first, step, njobs;
+};
+
+static void s_par_worker(struct SParWorker *w)
+{
+	size_t i = w->first;
+	for (; i < w->njobs; i += w->step)
+		w->f(w->context, i);
+}
+
+#if defined(S_THREADS_WIN32)
+
+static DWORD WINAPI s_par_thread(LPVOID w)
+{
+	s_par_worker((struct SParWorker *)w);
+	return 0;
+}
+
+#elif defined(S_THREADS_POSIX)
+
+static void *s_par_thread(void *w)
+{
+	s_par_worker((struct SParWorker *)w);
+	return NULL;
+}
+
+#endif
+
+size_t s_ncpus(void)
+{
+#if defined(S_THREADS_WIN32)
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors > 0 ? (size_t)si.dwNumberOfProcessors :
+					     1;
+#elif defined(S_THREADS_POSIX) && defined(_SC_NPROCESSORS_ONLN)
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (size_t)n : 1;
+#else
+	return 1;
+#endif
+}
+
+void s_par_run(size_t nthreads, const size_t njobs, s_job_f f, void *context)
+{
+	if (!f || !njobs)
+		return;
+	size_t i;
+	struct SParWorker w[S_MAX_THREADS];
+	if (!nthreads)
+		nthreads = s_ncpus();
+	nthreads = S_MIN(S_MIN(nthreads, njobs), S_MAX_THREADS);
+	for (i = 0; i < nthreads; i++) {
+		w[i].f = f;
+		w[i].context = context;
+		w[i].first = i;
+		w[i].step = nthreads;
+		w[i].njobs = njobs;
+	}
+#if defined(S_THREADS_WIN32) || defined(S_THREADS_POSIX)
+	if (nthreads > 1) {
+	#ifdef S_THREADS_WIN32
+		HANDLE t[S_MAX_THREADS];
+		sbool_t started[S_MAX_THREADS];
+		for (i = 1; i < nthreads; i++) {
+			t[i] = CreateThread(NULL, 0, s_par_thread, w + i, 0,
+					    NULL);
+			started[i] = t[i] != NULL;
+		}
+	#else
+		pthread_t t[S_MAX_THREADS];
+		sbool_t started[S_MAX_THREADS];
+		for (i = 1; i < nthreads; i++)
+			started[i] = !pthread_create(t + i, NULL, s_par_thread,
+						     w + i);
+	#endif
+		s_par_worker(w);
+		for (i = 1; i < nthreads; i++) {
+			if (!started[i]) { /* BEHAVIOR: run it serially */
+				s_par_worker(w + i);
+				continue;
+			}
+	#ifdef S_THREADS_WIN32
+			WaitForSingleObject(t[i], INFINITE);
+			CloseHandle(t[i]);
+	#else
+			pthread_join(t[i], NULL);
+	#endif
+		}
+		return;
+	}
+#endif
+	for (i = 0; i < nthreads; i++)
+		s_par_worker(w + i);
+}
+
+void s_yield(void)
+{
+#if defined(S_THREADS_WIN32)
+	SwitchToThread();
+#elif defined(S_THREADS_POSIX)
+	sched_yield();
+#endif
+}
@@ -0,0 +1,54 @@
+#ifndef STHREAD_H
+#define STHREAD_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * sthread.h
+ *
+ * Minimal worker pool for data-parallel jobs
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ *
+ * - Runs N independent jobs over up to T threads (POSIX threads or Win32
+ *   threads). Jobs are assigned statically (job i goes to worker i % T),
+ *   so no locking is required.
+ * - The calling thread is used as the first worker.
+ * - Serial fallback when built with S_MINIMAL or S_NO_THREADS, when the
+ *   platform has no thread support, or if thread creation fails.
+ */
+
+#include "scommon.h"
+
+#if !defined(S_MINIMAL) && !defined(S_NO_THREADS)
+	#if defined(_WIN32)
+		#define S_THREADS_WIN32
+	#elif defined(__unix__) || defined(__unix) || defined(__APPLE__)
+		#include <unistd.h>
+		#if defined(_POSIX_THREADS) && _POSIX_THREADS > 0
+			#define S_THREADS_POSIX
+		#endif
+	#endif
+#endif
+
+#define S_MAX_THREADS	256
+
+typedef void (*s_job_f)(void *context, size_t job_index);
+
+/* #notAPI: |Number of online CPUs|-|CPU count (1 if unknown or without thread support)|O(1)|1;2| */
+size_t s_ncpus(void);
+
+/* #notAPI: |Run jobs in parallel, returning when all are done|number of threads (0: one per CPU);number of jobs;job function;job context|-|O(n)|1;2| */
+void s_par_run(size_t nthreads, const size_t njobs, s_job_f f, void *context);
+
+/* #notAPI: |Yield the CPU to other threads (e.g. in spin-wait loops)|-|-|O(1)|1;2| */
+void s_yield(void);
+
+#ifdef __cplusplus
+}      /* extern "C" { */
+#endif
+#endif	/* STHREAD_H */
@@ -0,0 +1,735 @@
+/*
+ * sbitset.c
+ *
+ * Bit set (bit array): word-level set operations.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "sbitset.h"
+#include "saux/scommon.h"
+
+#if !defined(S_MINIMAL) && !defined(S_NO_THREADS) && defined(__ATOMIC_RELAXED)
+	#define SB_ATOMIC_GNUC
+#elif !defined(S_MINIMAL) && !defined(S_NO_THREADS) && defined(_MSC_VER)
+	#define SB_ATOMIC_MSVC
+	#include <windows.h>
+	#include <intrin.h>
+#endif
+
+enum eSBOp
+{
+	SB_OP_AND,
+	SB_OP_OR,
+	SB_OP_XOR,
+	SB_OP_ANDNOT,
+	SB_OP_NOT
+};
+
+/*
+ * Population count (s_popcount64(), and SSE2 version)
+ */
+
+#ifdef S_SIMD_SSE2
+
+/* Per 64-bit lane bit count */
+S_INLINE __m128i sb_pop128(__m128i x)
+{
+	const __m128i m1 = _mm_set1_epi8(0x55), m2 = _mm_set1_epi8(0x33),
+		      m4 = _mm_set1_epi8(0x0f);
+	x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi64(x, 1), m1));
+	x = _mm_add_epi8(_mm_and_si128(x, m2),
+			 _mm_and_si128(_mm_srli_epi64(x, 2), m2));
+	x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi64(x, 4)), m4);
+	return _mm_sad_epu8(x, _mm_setzero_si128());
+}
+
+S_INLINE size_t sb_pop128_sum(const __m128i acc)
+{
+	uint64_t l[2];
+	_mm_storeu_si128((__m128i *)l, acc);
+	return (size_t)(l[0] + l[1]);
+}
+
+#define SB_LD128(p) _mm_loadu_si128((const __m128i *)(p))
+
+#define SB_OP_LOOP_V(OPV)						\
+	{								\
+		__m128i acc = _mm_setzero_si128(), x;			\
+		for (; i + 16 <= n; i += 16) {				\
+			x = OPV(SB_LD128(a + i), SB_LD128(b + i));	\
+			_mm_storeu_si128((__m128i *)(o + i), x);	\
+			acc = _mm_add_epi64(acc, sb_pop128(x));		\
+		}							\
+		cnt += sb_pop128_sum(acc);				\
+	}
+
+#define SB_V_AND(x, y)		_mm_and_si128(x, y)
+#define SB_V_OR(x, y)		_mm_or_si128(x, y)
+#define SB_V_XOR(x, y)		_mm_xor_si128(x, y)
+#define SB_V_ANDNOT(x, y)	_mm_andnot_si128(y, x)
+#define SB_V_NOT(x, y)		_mm_xor_si128(x, _mm_set1_epi32(-1))
+
+#else
+
+#define SB_OP_LOOP_V(OPV)
+
+#endif
+
+#define SB_W_AND(x, y)		((x) & (y))
+#define SB_W_OR(x, y)		((x) | (y))
+#define SB_W_XOR(x, y)		((x) ^ (y))
+#define SB_W_ANDNOT(x, y)	((x) & ~(y))
+#define SB_W_NOT(x, y)		(~(x))
+
+/*
+ * Bitwise operation over n bytes (o can be a or b), returning the
+ * number of bits set to 1 in the result
+ */
+#define SB_BUILD_OP(FN, OPW, OPV)					\
+	static size_t FN(unsigned char *o, const unsigned char *a,	\
+			 const unsigned char *b, const size_t n)	\
+	{								\
+		size_t i = 0, cnt = 0;					\
+		uint64_t x, y;						\
+		SB_OP_LOOP_V(OPV)					\
+		for (; i + 8 <= n; i += 8) {				\
+			memcpy(&x, a + i, 8);				\
+			memcpy(&y, b + i, 8);				\
+			x = OPW(x, y);					\
+			memcpy(o + i, &x, 8);				\
+			cnt += s_popcount64(x);				\
+		}							\
+		for (; i < n; i++) {					\
+			o[i] = (unsigned char)OPW(a[i], b[i]);		\
+			cnt += s_popcount64(o[i]);			\
+		}							\
+		return cnt;						\
+	}
+
+SB_BUILD_OP(sb_and_x, SB_W_AND, SB_V_AND)
+SB_BUILD_OP(sb_or_x, SB_W_OR, SB_V_OR)
+SB_BUILD_OP(sb_xor_x, SB_W_XOR, SB_V_XOR)
+SB_BUILD_OP(sb_andnot_x, SB_W_ANDNOT, SB_V_ANDNOT)
+SB_BUILD_OP(sb_not_x, SB_W_NOT, SB_V_NOT)
+
+static size_t sb_op_x(const enum eSBOp op, unsigned char *o,
+		      const unsigned char *a, const unsigned char *b,
+		      const size_t n)
+{
+	switch (op) {
+	case SB_OP_AND:
+		return sb_and_x(o, a, b, n);
+	case SB_OP_OR:
+		return sb_or_x(o, a, b, n);
+	case SB_OP_XOR:
+		return sb_xor_x(o, a, b, n);
+	case SB_OP_ANDNOT:
+		return sb_andnot_x(o, a, b, n);
+	default:
+		return sb_not_x(o, a, a, n);
+	}
+}
+
+static size_t sb_count_x(const unsigned char *a, const size_t n)
+{
+	size_t i = 0, cnt = 0;
+	uint64_t x;
+#ifdef S_SIMD_SSE2
+	__m128i acc = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16)
+		acc = _mm_add_epi64(acc, sb_pop128(SB_LD128(a + i)));
+	cnt += sb_pop128_sum(acc);
+#endif
+	for (; i + 8 <= n; i += 8) {
+		memcpy(&x, a + i, 8);
+		cnt += s_popcount64(x);
+	}
+	for (; i < n; i++)
+		cnt += s_popcount64(a[i]);
+	return cnt;
+}
+
+/*
+ * Output bitset of no bytes (it can be one of the inputs: in that case,
+ * the input reference is updated, as the reserve could move it)
+ */
+static unsigned char *sb_out(sb_t **out, const sb_t **a, const sb_t **b,
+			     const size_t no)
+{
+	const sbool_t aa = *out && *out == *a ? S_TRUE : S_FALSE,
+		      ab = *out && *out == *b ? S_TRUE : S_FALSE;
+	if (!*out)
+		*out = sv_alloc(1, no, NULL);
+	RETURN_IF((sd_t *)*out == sd_void, NULL);
+	if (sv_reserve(out, no) < no) {
+		S_ERROR("not enough memory");
+		sb_clear(*out);
+		return NULL;
+	}
+	if (aa)
+		*a = *out;
+	if (ab)
+		*b = *out;
+	(*out)->d.f.flag1 = 0;
+	return (unsigned char *)sv_get_buffer(*out);
+}
+
+static sb_t *sb_op(sb_t **out, const sb_t *a, const sb_t *b,
+		   const enum eSBOp op)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t na = sv_size(a), nb = sv_size(b), nc = S_MIN(na, nb);
+	const size_t no = op == SB_OP_AND ? nc : op == SB_OP_ANDNOT ? na :
+			  S_MAX(na, nb);
+	unsigned char *o = sb_out(out, &a, &b, no);
+	RETURN_IF(!o, *out);
+	size_t cnt = sb_op_x(op, o, (const unsigned char *)sv_get_buffer_r(a),
+			     (const unsigned char *)sv_get_buffer_r(b), nc);
+	if (no > nc) { /* tail: bits of the longer input (0 on the other) */
+		const unsigned char *t = (const unsigned char *)
+					 sv_get_buffer_r(na > nb ? a : b);
+		if (t != o)
+			memcpy(o + nc, t + nc, no - nc);
+		cnt += sb_count_x(o + nc, no - nc);
+	}
+	sv_set_size(*out, no);
+	(*out)->vx.cnt = cnt;
+	return *out;
+}
+
+/*
+ * Set operations
+ */
+
+sb_t *sb_and(sb_t **out, const sb_t *a, const sb_t *b)
+{
+	return sb_op(out, a, b, SB_OP_AND);
+}
+
+sb_t *sb_or(sb_t **out, const sb_t *a, const sb_t *b)
+{
+	return sb_op(out, a, b, SB_OP_OR);
+}
+
+sb_t *sb_xor(sb_t **out, const sb_t *a, const sb_t *b)
+{
+	return sb_op(out, a, b, SB_OP_XOR);
+}
+
+sb_t *sb_andnot(sb_t **out, const sb_t *a, const sb_t *b)
+{
+	return sb_op(out, a, b, SB_OP_ANDNOT);
+}
+
+sb_t *sb_not(sb_t **out, const sb_t *a, const size_t nbits)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t no = nbits / 8 + (nbits % 8 ? 1 : 0),
+		     nc = S_MIN(sv_size(a), no);
+	unsigned char *o = sb_out(out, &a, &a, no);
+	RETURN_IF(!o, *out);
+	size_t cnt = sb_op_x(SB_OP_NOT, o,
+			     (const unsigned char *)sv_get_buffer_r(a), NULL,
+			     nc);
+	if (no > nc) { /* bits not evaluated in the input are 0 */
+		memset(o + nc, 0xff, no - nc);
+		cnt += 8 * (no - nc);
+	}
+	if (nbits % 8) {
+		const unsigned m = (1U << (nbits % 8)) - 1;
+		cnt -= s_popcount64(o[no - 1] & ~m & 0xff);
+		o[no - 1] &= m;
+	}
+	sv_set_size(*out, no);
+	(*out)->vx.cnt = cnt;
+	return *out;
+}
+
+size_t sb_popcount_scan(const sb_t *b)
+{
+	return sb_count_x((const unsigned char *)sv_get_buffer_r(b),
+			  sv_size(b));
+}
+
+/*
+ * Search, enumeration, and ranges
+ */
+
+/* 64-bit word at byte offset off, little-endian, zero-padded beyond n */
+S_INLINE uint64_t sb_ld_w(const unsigned char *p, const size_t n,
+			  const size_t off)
+{
+	uint64_t w = 0;
+	size_t i;
+	if (off + 8 <= n)
+		return S_LD_LE_U64(p + off);
+	for (i = n; i > off; i--)
+		w = w << 8 | p[i - 1];
+	return w;
+}
+
+/* First bit (from 'from' on) with value 1 in (word ^ inv) */
+static size_t sb_find(const sb_t *b, const size_t from, const uint64_t inv)
+{
+	const size_t n = sv_size(b);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	size_t off = from / 8;
+	if (off >= n)
+		return inv ? from : S_NPOS;
+	uint64_t w = (sb_ld_w(p, n, off) ^ inv) & (~(uint64_t)0 << (from % 8));
+	for (;;) {
+		if (w)
+			return off * 8 + s_ctz64(w);
+		off += 8;
+		if (off >= n)
+			return inv ? off * 8 : S_NPOS;
+		w = sb_ld_w(p, n, off) ^ inv;
+	}
+}
+
+static unsigned sb_range_mask(const size_t from, const size_t to)
+{
+	return (0xffU << (from % 8)) & (to % 8 ? (1U << (to % 8)) - 1 : 0xff);
+}
+
+/* Bits set to 1 in [from, to), within the evaluated area */
+static size_t sb_count_range(const unsigned char *p, const size_t from,
+			     const size_t to)
+{
+	size_t i0 = from / 8, i1 = to / 8, cnt = 0;
+	if (i0 == i1 || (i0 + 1 == i1 && !(to % 8)))
+		return s_popcount64(p[i0] & sb_range_mask(from, to));
+	if (from % 8)
+		cnt += s_popcount64(p[i0++] & sb_range_mask(from, 0));
+	cnt += sb_count_x(p + i0, i1 - i0);
+	if (to % 8)
+		cnt += s_popcount64(p[i1] & sb_range_mask(0, to));
+	return cnt;
+}
+
+static void sb_fill_range(unsigned char *p, const size_t from,
+			  const size_t to, const sbool_t val)
+{
+	size_t i0 = from / 8, i1 = to / 8;
+	unsigned m;
+	if (i0 == i1 || (i0 + 1 == i1 && !(to % 8))) {
+		m = sb_range_mask(from, to);
+		p[i0] = (unsigned char)(val ? p[i0] | m : p[i0] & ~m);
+		return;
+	}
+	if (from % 8) {
+		m = sb_range_mask(from, 0);
+		p[i0] = (unsigned char)(val ? p[i0] | m : p[i0] & ~m);
+		i0++;
+	}
+	memset(p + i0, val ? 0xff : 0, i1 - i0);
+	if (to % 8) {
+		m = sb_range_mask(0, to);
+		p[i1] = (unsigned char)(val ? p[i1] | m : p[i1] & ~m);
+	}
+}
+
+size_t sb_find_next_set(const sb_t *b, const size_t from)
+{
+	return sb_find(b, from, 0);
+}
+
+size_t sb_find_next_clear(const sb_t *b, const size_t from)
+{
+	return sb_find(b, from, ~(uint64_t)0);
+}
+
+size_t sb_itr(const sb_t *b, const size_t from, const size_t to, sb_it_t f,
+	      void *context)
+{
+	const size_t n = sv_size(b);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	size_t off = from / 8, cnt = 0, k;
+	RETURN_IF(off >= n || from >= to, 0);
+	uint64_t w = sb_ld_w(p, n, off) & (~(uint64_t)0 << (from % 8));
+	for (;;) {
+		for (; w; w &= w - 1) {
+			k = off * 8 + s_ctz64(w);
+			if (k >= to || (f && !f(k, context)))
+				return cnt;
+			cnt++;
+		}
+		off += 8;
+		if (off >= n || off * 8 >= to)
+			return cnt;
+		w = sb_ld_w(p, n, off);
+	}
+}
+
+sv_t *sb_to_vector(sv_t **out, const sb_t *b)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t nbits = sb_popcount(b), n = sv_size(b);
+	if (!*out)
+		*out = sv_alloc_t(SV_U64, nbits);
+	else
+		sv_clear(*out);
+	const enum eSV_Type t = (enum eSV_Type)(*out)->d.sub_type;
+	const size_t es = (*out)->d.elem_size;
+	RETURN_IF(t > SV_LAST_INT || (es != 4 && es != 8), *out);
+	RETURN_IF(sv_reserve(out, nbits) < nbits, *out);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	const size_t kmax = es == 8 ? (t == SV_U64 ? S_NPOS :
+						(size_t)SINT64_MAX) :
+				      (t == SV_U32 ? 0xffffffff : 0x7fffffff);
+	char *o = sv_get_buffer(*out);
+	size_t off, k, j = 0;
+	uint64_t w;
+	for (off = 0; off < n && j < nbits && off * 8 <= kmax; off += 8)
+		for (w = sb_ld_w(p, n, off); w && j < nbits; w &= w - 1) {
+			k = off * 8 + s_ctz64(w);
+			if (k > kmax)
+				break;
+			if (es == 8)
+				((uint64_t *)o)[j++] = k;
+			else
+				((uint32_t *)o)[j++] = (uint32_t)k;
+		}
+	sv_set_size(*out, j);
+	return *out;
+}
+
+void sb_set_range(sb_t **b, const size_t from, const size_t to)
+{
+	if (!b || from >= to)
+		return;
+	const size_t nb = to / 8 + (to % 8 ? 1 : 0);
+	size_t ss;
+	if (!*b) { /* BEHAVIOR: if NULL, assume heap allocation */
+		*b = sv_alloc(1, nb, NULL);
+		if ((sd_t *)*b == sd_void)
+			return;
+	}
+	ss = sv_size(*b);
+	if (nb > ss) {
+		if (sv_reserve(b, nb) < nb) {
+			S_ERROR("not enough memory");
+			return;
+		}
+		memset(sv_get_buffer(*b) + ss, 0, nb - ss);
+		sv_set_size(*b, nb);
+	}
+	unsigned char *p = (unsigned char *)sv_get_buffer(*b);
+	(*b)->vx.cnt += (to - from) - sb_count_range(p, from, to);
+	(*b)->d.f.flag1 = 0;
+	sb_fill_range(p, from, to, S_TRUE);
+}
+
+void sb_reset_range(sb_t **b, const size_t from, const size_t to)
+{
+	if (!b || !*b) /* NULL bitset: implicitly 0 */
+		return;
+	const size_t t = S_MIN(to, 8 * sv_size(*b));
+	if (from >= t) /* not evaluated area: implicitly 0 */
+		return;
+	unsigned char *p = (unsigned char *)sv_get_buffer(*b);
+	(*b)->vx.cnt -= sb_count_range(p, from, t);
+	(*b)->d.f.flag1 = 0;
+	sb_fill_range(p, from, t, S_FALSE);
+}
+
+/*
+ * Rank/select index
+ *
+ * Layout (SV_U64 vector): header (bitset size in bytes, bits set to 1,
+ * number of 512-bit blocks, number of select samples, bitset generation
+ * when the index was built), two words per
+ * block (bits set to 1 before the block; bits set to 1 before words 1 to
+ * 7, relative to the block, 9 bits each), and one select sample every
+ * SB_RS_SAMPLE bits set to 1 (block containing it).
+ */
+
+#define SB_RS_HDR	5
+#define SB_RS_SAMPLE	512
+
+/*
+ * Bitset generation: a new one is taken from a process-wide counter when
+ * building an index after a modification, so an index is only valid for
+ * the bitset contents it was built from
+ */
+static uint32_t sb_gen_next(void)
+{
+	static volatile uint32_t gen = 0;
+#if defined(SB_ATOMIC_GNUC)
+	return __atomic_add_fetch(&gen, 1, __ATOMIC_RELAXED);
+#elif defined(SB_ATOMIC_MSVC)
+	return (uint32_t)InterlockedIncrement((volatile LONG *)&gen);
+#else
+	return ++gen;
+#endif
+}
+
+S_INLINE size_t sb_rs_rel(const uint64_t rel, const size_t j)
+{
+	return j ? (size_t)(rel >> (9 * (j - 1))) & 0x1ff : 0;
+}
+
+/* Offset of the nth bit set to 1 in a word (64 if n >= popcount) */
+static size_t sb_select64(uint64_t w, size_t nth)
+{
+	size_t off = 0, c;
+	for (; off < 64; off += 8, w >>= 8) {
+		c = s_popcount64(w & 0xff);
+		if (nth < c)
+			break;
+		nth -= c;
+	}
+	RETURN_IF(off == 64, 64);
+	for (; nth; nth--)
+		w &= w - 1;
+	return off + s_ctz64(w);
+}
+
+sb_rs_t *sb_rs_build(sb_rs_t **idx, sb_t *b)
+{
+	ASSERT_RETURN_IF(!idx, NULL);
+	const size_t n = sv_size(b), nblk = (n + 63) / 64, pc = sb_popcount(b),
+		     ns = pc ? (pc - 1) / SB_RS_SAMPLE + 1 : 0,
+		     total = SB_RS_HDR + 2 * nblk + ns;
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	size_t i, j, k = 0, cnt = 0, rc, next = 0;
+	uint64_t *x, *c, *smp, rel;
+	if (!*idx)
+		*idx = sv_alloc_t(SV_U64, total);
+	/* BEHAVIOR: only SV_U64 output is allowed */
+	RETURN_IF((*idx)->d.sub_type != SV_U64, *idx);
+	sv_clear(*idx);
+	RETURN_IF(sv_reserve(idx, total) < total, *idx);
+	x = (uint64_t *)sv_get_buffer(*idx);
+	c = x + SB_RS_HDR;
+	smp = c + 2 * nblk;
+	for (i = 0; i < nblk; i++) {
+		c[2 * i] = cnt;
+		for (j = rc = 0, rel = 0; j < 8; j++) {
+			if (j)
+				rel |= (uint64_t)rc << (9 * (j - 1));
+			rc += s_popcount64(sb_ld_w(p, n, (i * 8 + j) * 8));
+		}
+		c[2 * i + 1] = rel;
+		for (cnt += rc; next < cnt && k < ns; next += SB_RS_SAMPLE)
+			smp[k++] = i;
+	}
+	if (b && (sd_t *)b != sd_void && !b->d.f.flag1) {
+		b->d.gen = sb_gen_next();
+		b->d.f.flag1 = 1;
+	}
+	x[0] = n;
+	x[1] = cnt;
+	x[2] = nblk;
+	x[3] = ns;
+	x[4] = b ? b->d.gen : 0;
+	sv_set_size(*idx, total);
+	return *idx;
+}
+
+sbool_t sb_rs_valid(const sb_rs_t *idx, const sb_t *b)
+{
+	RETURN_IF(!idx || !b || !b->d.f.flag1 || sv_size(idx) < SB_RS_HDR ||
+		  idx->d.sub_type != SV_U64, S_FALSE);
+	const uint64_t *x = (const uint64_t *)sv_get_buffer_r(idx);
+	return x[4] == b->d.gen && x[0] == sv_size(b) &&
+	       x[1] == sb_popcount(b) &&
+	       sv_size(idx) == SB_RS_HDR + 2 * x[2] + x[3] ? S_TRUE : S_FALSE;
+}
+
+size_t sb_rank(const sb_t *b, const sb_rs_t *idx, const size_t pos)
+{
+	const size_t n = sv_size(b);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	RETURN_IF(pos >= 8 * n, sb_popcount(b));
+	RETURN_IF(!pos, 0);
+	if (!sb_rs_valid(idx, b)) /* BEHAVIOR: no index: scan */
+		return sb_count_range(p, 0, pos);
+	const uint64_t *c = (const uint64_t *)sv_get_buffer_r(idx) + SB_RS_HDR;
+	const size_t blk = pos / 512, j = (pos / 64) % 8,
+		     sh = pos % 64;
+	const uint64_t w = sh ? sb_ld_w(p, n, pos / 64 * 8) &
+			   (((uint64_t)1 << sh) - 1) : 0;
+	return (size_t)c[2 * blk] + sb_rs_rel(c[2 * blk + 1], j) +
+	       s_popcount64(w);
+}
+
+size_t sb_select(const sb_t *b, const sb_rs_t *idx, const size_t nth)
+{
+	const size_t n = sv_size(b);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(b);
+	size_t lo, hi, m, j, r, off, c;
+	uint64_t w;
+	RETURN_IF(nth >= sb_popcount(b), S_NPOS);
+	if (!sb_rs_valid(idx, b)) { /* BEHAVIOR: no index: scan */
+		for (off = 0, r = nth; off < n; off += 8, r -= c) {
+			w = sb_ld_w(p, n, off);
+			c = s_popcount64(w);
+			if (r < c)
+				return off * 8 + sb_select64(w, r);
+		}
+		return S_NPOS;
+	}
+	const uint64_t *x = (const uint64_t *)sv_get_buffer_r(idx),
+		       *cb = x + SB_RS_HDR, *smp = cb + 2 * x[2];
+	const size_t s = nth / SB_RS_SAMPLE;
+	lo = (size_t)smp[s];
+	hi = s + 1 < x[3] ? (size_t)smp[s + 1] + 1 : (size_t)x[2];
+	while (hi - lo > 4) { /* last block with count <= nth */
+		m = lo + (hi - lo) / 2;
+		if (cb[2 * m] <= nth)
+			lo = m;
+		else
+			hi = m;
+	}
+	while (lo + 1 < hi && cb[2 * (lo + 1)] <= nth) /* same cache line */
+		lo++;
+	r = nth - (size_t)cb[2 * lo];
+	for (j = 7; j > 0 && sb_rs_rel(cb[2 * lo + 1], j) > r; j--)
+		;
+	r -= sb_rs_rel(cb[2 * lo + 1], j);
+	off = (lo * 8 + j) * 8;
+	j = sb_select64(sb_ld_w(p, n, off), r);
+	return j < 64 ? off * 8 + j : S_NPOS; /* BEHAVIOR: corrupt index */
+}
+
+/*
+ * Concurrent marking
+ */
+
+/* Byte-level atomics: the sv_t buffer is not 64-bit aligned on all ABIs */
+S_INLINE unsigned char sb_fetch_or8(volatile unsigned char *p,
+				    const unsigned char m)
+{
+#if defined(SB_ATOMIC_GNUC)
+	return __atomic_fetch_or(p, m, __ATOMIC_RELAXED);
+#elif defined(SB_ATOMIC_MSVC)
+	return (unsigned char)_InterlockedOr8((volatile char *)p, (char)m);
+#else
+	unsigned char prev = *p;
+	*p = prev | m;
+	return prev;
+#endif
+}
+
+S_INLINE unsigned char sb_fetch_and8(volatile unsigned char *p,
+				     const unsigned char m)
+{
+#if defined(SB_ATOMIC_GNUC)
+	return __atomic_fetch_and(p, m, __ATOMIC_RELAXED);
+#elif defined(SB_ATOMIC_MSVC)
+	return (unsigned char)_InterlockedAnd8((volatile char *)p, (char)m);
+#else
+	unsigned char prev = *p;
+	*p = prev & m;
+	return prev;
+#endif
+}
+
+S_INLINE unsigned char sb_ld8(volatile unsigned char *p)
+{
+#if defined(SB_ATOMIC_GNUC)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#else
+	return *p;
+#endif
+}
+
+S_INLINE void sb_add_cnt(volatile uintptr_t *p, const uintptr_t v)
+{
+#if defined(SB_ATOMIC_GNUC)
+	__atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#elif defined(SB_ATOMIC_MSVC) && defined(_WIN64)
+	InterlockedExchangeAdd64((volatile LONG64 *)p, (LONG64)v);
+#elif defined(SB_ATOMIC_MSVC)
+	InterlockedExchangeAdd((volatile LONG *)p, (LONG)v);
+#else
+	*p += v;
+#endif
+}
+
+sb_t *sb_alloc_atomic(const size_t nbits)
+{
+	const size_t ss = (nbits / 64 + (nbits % 64 ? 1 : 0)) * 8,
+		     ss1 = ss ? ss : 8;
+	sb_t *b = sv_alloc(1, ss1, NULL);
+	RETURN_IF((sd_t *)b == sd_void, b);
+	if (sv_reserve(&b, ss1) < ss1) {
+		sv_free(&b);
+		return (sb_t *)sd_void;
+	}
+	memset(sv_get_buffer(b), 0, ss1);
+	sv_set_size(b, ss1);
+	b->vx.cnt = 0;
+	return b;
+}
+
+sbool_t sb_lock_free(void)
+{
+#if defined(SB_ATOMIC_GNUC) || defined(SB_ATOMIC_MSVC)
+	return S_TRUE;
+#else
+	return S_FALSE;
+#endif
+}
+
+int sb_test_atomic(const sb_t *b, const size_t nth)
+{
+	const size_t pos = nth / 8;
+	RETURN_IF(pos >= sv_size(b), 0);
+	volatile unsigned char *p = (volatile unsigned char *)sv_get_buffer_r(b);
+	return (sb_ld8(p + pos) >> (nth % 8)) & 1;
+}
+
+int sb_set_atomic(sb_t *b, const size_t nth, size_t *delta)
+{
+	const size_t pos = nth / 8;
+	const unsigned char m = (unsigned char)(1 << (nth % 8));
+	RETURN_IF(pos >= sv_size(b), -1);
+	volatile unsigned char *p = (volatile unsigned char *)sv_get_buffer(b);
+	if (sb_fetch_or8(p + pos, m) & m)
+		return 1;
+	if (delta)
+		(*delta)++;
+	return 0;
+}
+
+int sb_reset_atomic(sb_t *b, const size_t nth, size_t *delta)
+{
+	const size_t pos = nth / 8;
+	const unsigned char m = (unsigned char)(1 << (nth % 8));
+	RETURN_IF(pos >= sv_size(b), -1);
+	volatile unsigned char *p = (volatile unsigned char *)sv_get_buffer(b);
+	if (!(sb_fetch_and8(p + pos, (unsigned char)~m) & m))
+		return 0;
+	if (delta)
+		(*delta)--; /* BEHAVIOR: modular, so the deltas can be added */
+	return 1;
+}
+
+S_INLINE void sb_st32(volatile uint32_t *p, const uint32_t v)
+{
+#if defined(SB_ATOMIC_GNUC)
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+#elif defined(SB_ATOMIC_MSVC)
+	InterlockedExchange((volatile LONG *)p, (LONG)v);
+#else
+	*p = v;
+#endif
+}
+
+void sb_popcount_merge(sb_t *b, const size_t delta)
+{
+	if (b && (sd_t *)b != sd_void) {
+		if (delta)
+			sb_add_cnt(&b->vx.cnt, (uintptr_t)delta);
+		/*
+		 * New generation, so indexes built before the marking become
+		 * stale (even if the delta is 0: bits set and reset). Atomic
+		 * store, as merges can be concurrent (flag1 is not modified)
+		 */
+		sb_st32(&b->d.gen, sb_gen_next());
+	}
+}
@@ -27,6 +27,25 @@ extern "C" {
  *   is done until required, and is applied to the affected area. Also bit
  *   set to 0 on non set areas requires doing nothing, as unitialized area
  *   can be both not initialized or even not allocated (when using heap memory)
+ * - Set operations (AND, OR, XOR, AND NOT, NOT) processing 64/128 bits per
+ *   step, with the bit count recomputed in the same pass
+ * - Set bit search and enumeration skipping zero 64-bit words, so sparse
+ *   bitsets are scanned at memory speed
+ * - Optional rank/select index (sb_rs_t): O(1) rank, and select in O(1)
+ *   plus a binary search bounded by the sample interval, using 25% extra
+ *   space (per 512-bit block: one 64-bit absolute count, and seven 9-bit
+ *   counts relative to the block)
+ * - Concurrent marking (sb_alloc_atomic()): fixed-size bitset where many
+ *   threads set/reset bits without locks (atomic byte OR/AND, returning
+ *   the previous bit value). The bit count is not updated per operation:
+ *   each thread accumulates its own delta and adds it with
+ *   sb_popcount_merge(), so there is no shared counter cache line
+ *
+ * sd_t header fields:
+ *	flag1: no modification since the last rank/select index build (any
+ *	       modification clears it)
+ *	gen: bitset generation (stored in the rank/select indexes, renewed
+ *	     when building an index after a modification)
  */ 
 
 #include "svector.h"
@@ -38,6 +57,10 @@ extern "C" {
 typedef sv_t sb_t;	/* "Hidden" structure (accessors are provided) */
 			/* (bitset is implemented using a vector)  */
 
+typedef sbool_t (*sb_it_t)(size_t nth, void *context);
+
+typedef sv_t sb_rs_t;	/* Rank/select index (see sb_rs_build()) */
+
 /*
  * Allocation
  */
@@ -73,6 +96,7 @@ S_INLINE void sb_clear(sb_t *b)
 	if (b) {
 		sv_set_size(b, 0);
 		b->vx.cnt = 0;
+		b->d.f.flag1 = 0;
 	}
 }
 
@@ -130,6 +154,7 @@ S_INLINE void sb_set(sb_t **b, const size_t nth)
 		if ((buf[pos] & mask) == 0) {
 			buf[pos] |= mask;
 			(*b)->vx.cnt++;
+			(*b)->d.f.flag1 = 0;
 		}
 	}
 }
@@ -147,6 +172,7 @@ S_INLINE void sb_reset(sb_t **b, const size_t nth)
 			if ((buf[pos] & mask) != 0) {
 				buf[pos] &= ~mask;
 				(*b)->vx.cnt--;
+				(*b)->d.f.flag1 = 0;
 			}
 		}
 		/* else: implicitly considered as set to 0 */
@@ -187,6 +213,109 @@ S_INLINE sb_t *sb_shrink(sb_t **b)
 	return sv_shrink(b);
 }
 
+/*
+ * Set operations (word-level, SIMD if available)
+ */
+
+/* #API: |Bitwise AND (intersection)|output bitset (allocated if NULL, otherwise overwritten; it can be one of the inputs); bitset; bitset|output bitset reference|O(n)|1;2| */
+sb_t *sb_and(sb_t **out, const sb_t *a, const sb_t *b);
+
+/* #API: |Bitwise OR (union)|output bitset (allocated if NULL, otherwise overwritten; it can be one of the inputs); bitset; bitset|output bitset reference|O(n)|1;2| */
+sb_t *sb_or(sb_t **out, const sb_t *a, const sb_t *b);
+
+/* #API: |Bitwise XOR (symmetric difference)|output bitset (allocated if NULL, otherwise overwritten; it can be one of the inputs); bitset; bitset|output bitset reference|O(n)|1;2| */
+sb_t *sb_xor(sb_t **out, const sb_t *a, const sb_t *b);
+
+/* #API: |Bitwise AND NOT (difference: bits of a not in b)|output bitset (allocated if NULL, otherwise overwritten; it can be one of the inputs); bitset; bitset|output bitset reference|O(n)|1;2| */
+sb_t *sb_andnot(sb_t **out, const sb_t *a, const sb_t *b);
+
+/* #API: |Bitwise NOT (complement) of the first n bits (bits from n on are 0)|output bitset (allocated if NULL, otherwise overwritten; it can be the input); bitset; number of bits|output bitset reference|O(n)|1;2| */
+sb_t *sb_not(sb_t **out, const sb_t *a, const size_t nbits);
+
+/* #API: |Count bits set to 1, recomputing it from the bitset data (sb_popcount() is O(1))|bitset|number of bits set to 1|O(n)|1;2| */
+size_t sb_popcount_scan(const sb_t *b);
+
+/*
+ * Search, enumeration, and ranges (word-level)
+ */
+
+/* #API: |Find next bit set to 1|bitset; starting bit offset|bit offset (S_NPOS if not found)|O(n)|1;2| */
+size_t sb_find_next_set(const sb_t *b, const size_t from);
+
+/* #API: |Find next bit set to 0|bitset; starting bit offset|bit offset (bits not evaluated are 0, so it is always found)|O(n)|1;2| */
+size_t sb_find_next_clear(const sb_t *b, const size_t from);
+
+/* #API: |Enumerate bits set to 1 in a range, in increasing order (the callback returning S_FALSE stops the enumeration)|bitset; first bit offset; end bit offset (not included); callback function (NULL for just counting); callback function context|Elements processed|O(n)|1;2| */
+size_t sb_itr(const sb_t *b, const size_t from, const size_t to, sb_it_t f,
+	      void *context);
+
+/* #API: |Offsets of the bits set to 1, in increasing order|output vector (allocated as SV_U64 if NULL, otherwise overwritten; it must be of 32 or 64-bit integer type: offsets not fitting are not stored); bitset|output vector reference|O(n)|1;2| */
+sv_t *sb_to_vector(sv_t **out, const sb_t *b);
+
+/* #API: |Set bit range to 1|bitset; first bit offset; end bit offset (not included)|-|O(n)|1;2| */
+void sb_set_range(sb_t **b, const size_t from, const size_t to);
+
+/* #API: |Set bit range to 0|bitset; first bit offset; end bit offset (not included)|-|O(n)|1;2| */
+void sb_reset_range(sb_t **b, const size_t from, const size_t to);
+
+/*
+ * Rank/select index
+ */
+
+#define sb_rs_free	sv_free
+
+/*
+#API: |Free one or more rank/select indexes|index; more indexes (optional)|-|O(1)|1;2|
+void sb_rs_free(sb_rs_t **idx, ...)
+*/
+
+/* #API: |Build rank/select index (it becomes stale if the bitset is modified)|output index (allocated if NULL, otherwise overwritten; it must be a SV_U64 vector); bitset|output index reference|O(n)|1;2| */
+sb_rs_t *sb_rs_build(sb_rs_t **idx, sb_t *b);
+
+/* #API: |Check if the index is up to date with the bitset|index; bitset|S_TRUE: up to date, S_FALSE: stale or not built from the bitset|O(1)|1;2| */
+sbool_t sb_rs_valid(const sb_rs_t *idx, const sb_t *b);
+
+/* #API: |Rank: number of bits set to 1 before a given offset|bitset; index (NULL or stale: scan the bitset); bit offset (not included)|number of bits set to 1 in [0, offset)|O(1) (O(n) without a valid index)|1;2| */
+size_t sb_rank(const sb_t *b, const sb_rs_t *idx, const size_t pos);
+
+/* #API: |Select: offset of the nth bit set to 1|bitset; index (NULL or stale: scan the bitset); n (0 for the first bit set to 1)|bit offset (S_NPOS if n >= sb_popcount())|O(1) for uniform density, O(log n) worst case (O(n) without a valid index)|1;2| */
+size_t sb_select(const sb_t *b, const sb_rs_t *idx, const size_t nth);
+
+/*
+ * Concurrent marking
+ *
+ * Observations:
+ * - Only sb_test_atomic(), sb_set_atomic(), sb_reset_atomic(), and
+ *   sb_popcount_merge() can be called concurrently. Other bitset
+ *   functions can be used once the marking threads are done
+ * - Atomic operations use the compiler built-ins (gcc, clang) or the
+ *   Interlocked API (Visual Studio). Without them (other compilers, or
+ *   building with S_MINIMAL/S_NO_THREADS), these functions work, but they
+ *   are not thread-safe: sb_lock_free() tells which is the case
+ * - A rank/select index must not be used during the marking, as the
+ *   atomic operations do not invalidate it. sb_popcount_merge() does
+ *   (new bitset generation), so the indexes built before the marking are
+ *   stale once the deltas are merged, and a new index has to be built
+ */
+
+/* #API: |Allocate fixed-size bitset for concurrent marking (heap; all bits set to 0, size rounded up to 64-bit words)|number of bits|bitset|O(n)|1;2| */
+sb_t *sb_alloc_atomic(const size_t nbits);
+
+/* #API: |Check if concurrent marking is thread-safe in this build|-|S_TRUE: lock-free atomic operations available; S_FALSE: single-thread only|O(1)|1;2| */
+sbool_t sb_lock_free(void);
+
+/* #API: |Access to nth bit (concurrent-safe)|bitset; bit offset|1 or 0|O(1)|1;2| */
+int sb_test_atomic(const sb_t *b, const size_t nth);
+
+/* #API: |Set nth bit to 1 (atomic test-and-set)|bitset (from sb_alloc_atomic()); bit offset; per-thread bit count delta (incremented if the bit was 0; it can be NULL)|0: bit was 0, 1: bit was already 1, -1: offset out of range (bitset not modified)|O(1)|1;2| */
+int sb_set_atomic(sb_t *b, const size_t nth, size_t *delta);
+
+/* #API: |Set nth bit to 0 (atomic test-and-reset)|bitset (from sb_alloc_atomic()); bit offset; per-thread bit count delta (decremented, modulo SIZE_MAX + 1, if the bit was 1; it can be NULL)|0: bit was already 0, 1: bit was 1, -1: offset out of range|O(1)|1;2| */
+int sb_reset_atomic(sb_t *b, const size_t nth, size_t *delta);
+
+/* #API: |Add a per-thread bit count delta to the bitset count (atomic; rank/select indexes built before become stale)|bitset; delta (from sb_set_atomic()/sb_reset_atomic())|-|O(1)|1;2| */
+void sb_popcount_merge(sb_t *b, const size_t delta);
+
 #ifdef __cplusplus
 } /* extern "C" { */
 #endif
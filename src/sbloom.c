@@ -0,0 +1,357 @@
+/*
+ * sbloom.c
+ *
+ * Bloom filter (cache-line blocked).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "sbloom.h"
+#include "saux/scommon.h"
+#include "saux/shash.h"
+
+/*
+ * Constants
+ */
+
+#define SBF_VERSION	2
+#define SBF_HDR		64	/* header size (bytes) */
+#define SBF_BLK		64	/* block size (bytes): cache line */
+#define SBF_BLK_BITS	(SBF_BLK * 8)
+#define SBF_K_MAX	16
+#define SBF_SEED	0
+#define SBF_BATCH	16	/* batch test: blocks prefetched in advance */
+#define SBF_LN2		0.69314718055994530942
+
+/*
+ * Internal functions
+ */
+
+/*
+ * Number of blocks (0 if not a valid filter). The data area after the
+ * header has one extra block of room, so the blocks can start at a cache
+ * line boundary: the header keeps the padding bytes before them.
+ */
+static size_t sbf_nblk(const sbf_t *f)
+{
+	const size_t ss = sv_size(f);
+	RETURN_IF(ss < SBF_HDR + SBF_BLK, 0);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(f);
+	const uint64_t nb = S_LD_LE_U64(p + 8);
+	RETURN_IF(p[0] != SBF_VERSION || !p[1] || p[1] > SBF_K_MAX ||
+		  p[2] >= SBF_BLK || !nb ||
+		  nb != (ss - SBF_HDR) / SBF_BLK - 1 ||
+		  (ss - SBF_HDR) % SBF_BLK, 0);
+	return (size_t)nb;
+}
+
+/* First block (p: filter buffer) */
+#define SBF_BLOCKS(p)	((p) + SBF_HDR + (p)[2])
+
+/* Padding for the blocks starting at a cache line boundary */
+S_INLINE unsigned sbf_pad(const unsigned char *p)
+{
+	return (unsigned)((SBF_BLK - (uintptr_t)(p + SBF_HDR) % SBF_BLK) %
+			  SBF_BLK);
+}
+
+/*
+ * Move the blocks to a cache line boundary. Required when the filter
+ * buffer was copied or moved (e.g. sb_t/sv_t copy, or deserialization):
+ * the blocks are found through the stored padding in any case, but
+ * misaligned blocks span two cache lines.
+ */
+static void sbf_align(sbf_t *f, const size_t nb)
+{
+	unsigned char *p = (unsigned char *)sv_get_buffer(f);
+	const unsigned pad = p[2], np = sbf_pad(p);
+	if (pad == np)
+		return;
+	memmove(p + SBF_HDR + np, p + SBF_HDR + pad, nb * SBF_BLK);
+	if (np > pad)
+		memset(p + SBF_HDR + pad, 0, np - pad);
+	else
+		memset(p + SBF_HDR + np + nb * SBF_BLK, 0, pad - np);
+	p[2] = (unsigned char)np;
+	/* same bits, other than the header padding byte */
+	f->vx.cnt += s_popcount64(np);
+	f->vx.cnt -= s_popcount64(pad);
+	f->d.f.flag1 = 0;
+}
+
+/* Block selection from the hash high bits (multiply-shift range mapping) */
+S_INLINE size_t sbf_blk(const uint64_t h, const size_t nb)
+{
+	if (nb <= 0xffffffff)
+		return (size_t)(((h >> 32) * (uint64_t)nb) >> 32);
+	return (size_t)((h >> 18) % nb);
+}
+
+/*
+ * Bit positions in the block: double hashing from the hash low bits
+ * (odd step, so the k positions are different)
+ */
+#define SBF_POS(h, a, d)						\
+	a = (unsigned)((h) & (SBF_BLK_BITS - 1));			\
+	d = (unsigned)(((h) >> 9) & (SBF_BLK_BITS - 1)) | 1
+
+static void sbf_add_h(sbf_t *f, const uint64_t h)
+{
+	const size_t nb = sbf_nblk(f);
+	if (!nb)
+		return;
+	sbf_align(f, nb);
+	unsigned char *p = (unsigned char *)sv_get_buffer(f),
+		      *b = SBF_BLOCKS(p) + sbf_blk(h, nb) * SBF_BLK;
+	const unsigned k = p[1];
+	unsigned i, a, d, m;
+	size_t cnt = 0;
+	SBF_POS(h, a, d);
+	for (i = 0; i < k; i++, a = (a + d) & (SBF_BLK_BITS - 1)) {
+		m = 1U << (a % 8);
+		if (!(b[a / 8] & m)) {
+			b[a / 8] |= m;
+			cnt++;
+		}
+	}
+	if (cnt) { /* same accounting as sb_set() */
+		f->vx.cnt += cnt;
+		f->d.f.flag1 = 0;
+	}
+}
+
+S_INLINE sbool_t sbf_test_blk(const unsigned char *b, const unsigned k,
+			      const uint64_t h)
+{
+	unsigned i, a, d;
+	SBF_POS(h, a, d);
+	for (i = 0; i < k; i++, a = (a + d) & (SBF_BLK_BITS - 1))
+		if (!(b[a / 8] & (1U << (a % 8))))
+			return S_FALSE;
+	return S_TRUE;
+}
+
+static sbool_t sbf_test_h(const sbf_t *f, const uint64_t h)
+{
+	const size_t nb = sbf_nblk(f);
+	RETURN_IF(!nb, S_FALSE);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(f);
+	return sbf_test_blk(SBF_BLOCKS(p) + sbf_blk(h, nb) * SBF_BLK, p[1], h);
+}
+
+S_INLINE uint64_t sbf_hash_raw(const void *key, const size_t key_size)
+{
+	return sh_hash64(key, key_size, SBF_SEED);
+}
+
+S_INLINE uint64_t sbf_hash_u(const uint64_t key)
+{
+	return sh_mix64(key ^ SBF_SEED);
+}
+
+/* Header bits: same accounting as a bitset (sb_popcount()) */
+static size_t sbf_hdr_popcount(const unsigned char *p)
+{
+	size_t i, cnt = 0;
+	for (i = 0; i < SBF_HDR; i++)
+		cnt += s_popcount64(p[i]);
+	return cnt;
+}
+
+/*
+ * Allocation
+ */
+
+size_t sbf_size_bits(const size_t n, const double fp_rate)
+{
+	const double fp = fp_rate < 1e-12 ? 1e-12 :
+			  fp_rate > 0.5 ? 0.5 : fp_rate,
+		     /* BEHAVIOR: blocked filters have a higher false
+		      * positive rate than standard ones of the same size:
+		      * 1/8 extra space compensates it (usual k values) */
+		     m = -(double)n * slog(fp) / (SBF_LN2 * SBF_LN2) * 1.125;
+	return m < SBF_BLK_BITS ? SBF_BLK_BITS :
+	       m >= (double)(SIZE_MAX / 2) ? SIZE_MAX / 2 : (size_t)m;
+}
+
+unsigned sbf_size_k(const size_t n, const size_t nbits)
+{
+	RETURN_IF(!n, 1);
+	const double k = (double)nbits / (double)n * SBF_LN2 + 0.5;
+	return k < 1 ? 1 : k > SBF_K_MAX ? SBF_K_MAX : (unsigned)k;
+}
+
+sbf_t *sbf_alloc(const size_t n, const double fp_rate)
+{
+	const size_t nbits = sbf_size_bits(n, fp_rate);
+	return sbf_alloc_raw(nbits, sbf_size_k(n, nbits));
+}
+
+sbf_t *sbf_alloc_raw(const size_t nbits, const unsigned k)
+{
+	const size_t nb = nbits / SBF_BLK_BITS +
+			  (nbits % SBF_BLK_BITS ? 1 : 0),
+		     nb1 = nb ? nb : 1,
+		     ss = s_size_t_mul(nb1 + 1, SBF_BLK, SIZE_MAX - SBF_HDR) +
+			  SBF_HDR;
+	sbf_t *f = sv_alloc(1, ss, NULL);
+	unsigned char *p;
+	RETURN_IF((sd_t *)f == sd_void, f);
+	if (sv_reserve(&f, ss) < ss) {
+		sv_free(&f);
+		return (sbf_t *)sd_void;
+	}
+	p = (unsigned char *)sv_get_buffer(f);
+	memset(p, 0, ss);
+	p[0] = SBF_VERSION;
+	p[1] = (unsigned char)(k < 1 ? 1 : k > SBF_K_MAX ? SBF_K_MAX : k);
+	p[2] = (unsigned char)sbf_pad(p);
+	S_ST_LE_U64(p + 8, (uint64_t)nb1);
+	sv_set_size(f, ss);
+	f->vx.cnt = sbf_hdr_popcount(p);
+	return f;
+}
+
+void sbf_clear(sbf_t *f)
+{
+	const size_t nb = sbf_nblk(f);
+	if (!nb)
+		return;
+	unsigned char *p = (unsigned char *)sv_get_buffer(f);
+	memset(p + SBF_HDR, 0, (nb + 1) * SBF_BLK);
+	p[2] = (unsigned char)sbf_pad(p);
+	f->vx.cnt = sbf_hdr_popcount(p);
+	f->d.f.flag1 = 0;
+}
+
+sbf_t *sbf_dup(const sbf_t *src)
+{
+	sbf_t *f = sb_dup(src);
+	const size_t nb = sbf_nblk(f);
+	if (nb)
+		sbf_align(f, nb);
+	return f;
+}
+
+/*
+ * Accessors
+ */
+
+size_t sbf_bits(const sbf_t *f)
+{
+	return sbf_nblk(f) * SBF_BLK_BITS;
+}
+
+unsigned sbf_k(const sbf_t *f)
+{
+	return sbf_nblk(f) ? ((const unsigned char *)sv_get_buffer_r(f))[1] :
+			     0;
+}
+
+/*
+ * Insert and test
+ */
+
+void sbf_add_raw(sbf_t *f, const void *key, const size_t key_size)
+{
+	sbf_add_h(f, sbf_hash_raw(key, key_size));
+}
+
+void sbf_add_s(sbf_t *f, const ss_t *key)
+{
+	sbf_add_raw(f, ss_get_buffer_r(key), ss_size(key));
+}
+
+void sbf_add_i(sbf_t *f, const int64_t key)
+{
+	sbf_add_h(f, sbf_hash_u((uint64_t)key));
+}
+
+void sbf_add_u(sbf_t *f, const uint64_t key)
+{
+	sbf_add_h(f, sbf_hash_u(key));
+}
+
+sbool_t sbf_test_raw(const sbf_t *f, const void *key, const size_t key_size)
+{
+	return sbf_test_h(f, sbf_hash_raw(key, key_size));
+}
+
+sbool_t sbf_test_s(const sbf_t *f, const ss_t *key)
+{
+	return sbf_test_raw(f, ss_get_buffer_r(key), ss_size(key));
+}
+
+sbool_t sbf_test_i(const sbf_t *f, const int64_t key)
+{
+	return sbf_test_h(f, sbf_hash_u((uint64_t)key));
+}
+
+sbool_t sbf_test_u(const sbf_t *f, const uint64_t key)
+{
+	return sbf_test_h(f, sbf_hash_u(key));
+}
+
+size_t sbf_test_batch(sb_t **out, const sbf_t *f, const sv_t *keys)
+{
+	ASSERT_RETURN_IF(!out, 0);
+	const size_t nb = sbf_nblk(f), n = sv_size(keys);
+	size_t i, j, m, cnt = 0, bo[SBF_BATCH];
+	uint64_t h[SBF_BATCH];
+	if (!*out)
+		*out = sb_alloc(n);
+	else
+		sb_clear(*out);
+	RETURN_IF(!nb || !n || keys->d.sub_type > SV_LAST_INT, 0);
+	sb_eval(out, n - 1);
+	RETURN_IF(sv_size(*out) * 8 < n, 0);
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(f),
+			    *b = SBF_BLOCKS(p);
+	const unsigned k = p[1];
+	const int sgn = !(keys->d.sub_type & 1);
+	for (i = 0; i < n; i += m) {
+		m = S_MIN(SBF_BATCH, n - i);
+		for (j = 0; j < m; j++) {
+			h[j] = sbf_hash_u(sgn ? (uint64_t)sv_at_i(keys, i + j) :
+						sv_at_u(keys, i + j));
+			bo[j] = sbf_blk(h[j], nb) * SBF_BLK;
+			S_PREFETCH_R(b + bo[j]);
+		}
+		for (j = 0; j < m; j++)
+			if (sbf_test_blk(b + bo[j], k, h[j])) {
+				sb_set(out, i + j);
+				cnt++;
+			}
+	}
+	return cnt;
+}
+
+/*
+ * Set operations
+ */
+
+sbool_t sbf_union(sbf_t **f, const sbf_t *src)
+{
+	RETURN_IF(!f || !*f, S_FALSE);
+	const size_t nb = sbf_nblk(*f);
+	RETURN_IF(!nb || nb != sbf_nblk(src) ||
+		  sbf_k(*f) != sbf_k(src), S_FALSE);
+	sbf_align(*f, nb);
+	unsigned char *p = (unsigned char *)sv_get_buffer(*f);
+	const unsigned char *q = (const unsigned char *)sv_get_buffer_r(src);
+	size_t i, cnt = 0;
+	if (p[2] == q[2]) { /* same layout (same header, too) */
+		sb_or(f, *f, src);
+		return S_TRUE;
+	}
+	p = SBF_BLOCKS(p);
+	q = SBF_BLOCKS(q);
+	for (i = 0; i < nb * SBF_BLK; i++) {
+		cnt += s_popcount64(q[i] & ~p[i] & 0xff);
+		p[i] |= q[i];
+	}
+	(*f)->vx.cnt += cnt;
+	(*f)->d.f.flag1 = 0;
+	return S_TRUE;
+}
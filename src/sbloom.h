@@ -0,0 +1,129 @@
+#ifndef SBLOOM_H
+#define SBLOOM_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * sbloom.h
+ *
+ * #SHORTDOC Bloom filter (probabilistic set, cache-line blocked)
+ *
+ * #DOC Probabilistic set membership: a test can return false positives
+ * #DOC ("maybe present") but never false negatives. Useful as a cheap
+ * #DOC negative check before querying a larger structure (e.g. a map).
+ * #DOC Each key sets/tests k bits inside a single 512-bit block (one cache
+ * #DOC line), selected by double hashing from a 64-bit hash, so every
+ * #DOC operation touches one memory block.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Built on sb_t storage: the filter is a bitset, so sb_popcount() and
+ *   the sb_t serialization-friendly byte layout apply
+ * - String (ss_t), integer, and raw buffer keys
+ * - Batch test of integer vectors, prefetching the blocks in advance
+ * - Union of filters with the same geometry (word-level OR)
+ * - Sizing from the expected number of elements and false positive rate
+ *
+ * Format (bytes):
+ * - Header (64 bytes): version, k (bits per key), padding (0 to 63), 5
+ *   zero bytes, number of blocks (64-bit, little-endian), 48 zero bytes
+ * - Padding zero bytes, blocks (64 bytes each), and 64 - padding zero
+ *   bytes: the padding makes the blocks start at a cache line boundary
+ *   (a filter copied to another address keeps working, and it is aligned
+ *   again on sbf_dup(), sbf_clear(), sbf_union(), or the next insert)
+ */
+
+#include "sbitset.h"
+#include "sstring.h"
+
+/*
+ * Structures
+ */
+
+typedef sb_t sbf_t;	/* "Hidden" structure (accessors are provided) */
+			/* (filter is stored in a bitset) */
+
+/*
+ * Allocation
+ */
+
+#define sbf_free	sb_free
+
+/*
+#API: |Free one or more Bloom filters|filter; more filters (optional)|-|O(1)|1;2|
+void sbf_free(sbf_t **f, ...)
+*/
+
+/* #API: |Duplicate Bloom filter|filter|output filter|O(n)|1;2| */
+sbf_t *sbf_dup(const sbf_t *src);
+
+/* #API: |Filter size for a false positive rate|expected number of elements; target false positive rate (e.g. 0.01)|size in bits|O(1)|1;2| */
+size_t sbf_size_bits(const size_t n, const double fp_rate);
+
+/* #API: |Optimal bits per key|expected number of elements; size in bits|bits per key (1 to 16)|O(1)|1;2| */
+unsigned sbf_size_k(const size_t n, const size_t nbits);
+
+/* #API: |Allocate Bloom filter (heap)|expected number of elements; target false positive rate (e.g. 0.01)|filter|O(n)|1;2| */
+sbf_t *sbf_alloc(const size_t n, const double fp_rate);
+
+/* #API: |Allocate Bloom filter (heap), with explicit geometry|size in bits (rounded up to 512-bit blocks); bits per key (1 to 16)|filter|O(n)|1;2| */
+sbf_t *sbf_alloc_raw(const size_t nbits, const unsigned k);
+
+/* #API: |Remove all elements|filter|-|O(n)|1;2| */
+void sbf_clear(sbf_t *f);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Filter size|filter|size in bits (0 if not valid)|O(1)|1;2| */
+size_t sbf_bits(const sbf_t *f);
+
+/* #API: |Bits per key|filter|bits per key (0 if not valid)|O(1)|1;2| */
+unsigned sbf_k(const sbf_t *f);
+
+/*
+ * Insert and test
+ */
+
+/* #API: |Insert raw buffer key|filter; buffer; buffer size|-|O(k)|1;2| */
+void sbf_add_raw(sbf_t *f, const void *key, const size_t key_size);
+
+/* #API: |Insert string key|filter; string|-|O(k)|1;2| */
+void sbf_add_s(sbf_t *f, const ss_t *key);
+
+/* #API: |Insert signed integer key|filter; key|-|O(k)|1;2| */
+void sbf_add_i(sbf_t *f, const int64_t key);
+
+/* #API: |Insert unsigned integer key|filter; key|-|O(k)|1;2| */
+void sbf_add_u(sbf_t *f, const uint64_t key);
+
+/* #API: |Test raw buffer key|filter; buffer; buffer size|S_TRUE: maybe present, S_FALSE: not present|O(k)|1;2| */
+sbool_t sbf_test_raw(const sbf_t *f, const void *key, const size_t key_size);
+
+/* #API: |Test string key|filter; string|S_TRUE: maybe present, S_FALSE: not present|O(k)|1;2| */
+sbool_t sbf_test_s(const sbf_t *f, const ss_t *key);
+
+/* #API: |Test signed integer key|filter; key|S_TRUE: maybe present, S_FALSE: not present|O(k)|1;2| */
+sbool_t sbf_test_i(const sbf_t *f, const int64_t key);
+
+/* #API: |Test unsigned integer key|filter; key|S_TRUE: maybe present, S_FALSE: not present|O(k)|1;2| */
+sbool_t sbf_test_u(const sbf_t *f, const uint64_t key);
+
+/* #API: |Test integer vector keys (signed keys are tested as sbf_test_i())|output bitset (allocated if NULL, otherwise overwritten): bit i set if key i is maybe present; filter; integer vector|number of keys maybe present|O(n k)|1;2| */
+size_t sbf_test_batch(sb_t **out, const sbf_t *f, const sv_t *keys);
+
+/*
+ * Set operations
+ */
+
+/* #API: |Union (add the elements of a filter with the same geometry)|filter; other filter|S_TRUE: OK, S_FALSE: different geometry (filter not modified)|O(n)|1;2| */
+sbool_t sbf_union(sbf_t **f, const sbf_t *src);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SBLOOM_H */
@@ -0,0 +1,458 @@
+/*
+ * scms.c
+ *
+ * Count-min sketch with top-k heavy hitters.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "scms.h"
+#include "saux/scommon.h"
+#include "saux/shash.h"
+
+/*
+ * Structures
+ */
+
+#define scms_void (scms_t *)sd_void
+
+#define SCMS_SEED	0
+#define SCMS_W_MAX	((size_t)1 << 28)
+#define SCMS_CNT_MAX	((uint64_t)-1)
+#define SCMS_HDR	((sizeof(struct SCMSHdr) + 7) & ~(size_t)7)
+
+struct SCMSNode
+{
+	uint64_t cnt, err, h;
+	int64_t ki;
+	ss_t *ks;	/* string key (kept allocated for reuse) */
+	sbool_t str;
+};
+
+/* Header, at the start of the vector buffer (followed by the arrays) */
+struct SCMSHdr
+{
+	size_t wmask, d, k, n, hmask;
+	uint64_t total;
+};
+
+/* Sketch access: header and arrays in the vector buffer */
+struct SCMSView
+{
+	struct SCMSHdr *hd;
+	uint64_t *cm;		/* d rows of wmask + 1 counters */
+	struct SCMSNode *nd;	/* top-k entries (n used) */
+	size_t *heap;		/* node ids, min-heap by count */
+	size_t *pos;		/* node id -> heap position */
+	size_t *ht;		/* hash table: node id + 1 (0: empty) */
+};
+
+/*
+ * Internal functions
+ */
+
+S_INLINE uint64_t scms_hash_i(const int64_t k)
+{
+	return sh_mix64((uint64_t)k ^ SCMS_SEED);
+}
+
+S_INLINE uint64_t scms_hash_s(const ss_t *k)
+{
+	return sh_hash64(ss_get_buffer_r(k), ss_size(k), SCMS_SEED);
+}
+
+/* Row counter index: double hashing from the 64-bit hash */
+S_INLINE size_t scms_idx(const struct SCMSView *c, const uint64_t h,
+			     const size_t r)
+{
+	const uint32_t a = (uint32_t)h, b = (uint32_t)(h >> 32) | 1;
+	const size_t wm = c->hd->wmask;
+	return r * (wm + 1) + ((a + (uint32_t)r * b) & wm);
+}
+
+static uint64_t scms_min(const struct SCMSView *c, const uint64_t h)
+{
+	uint64_t m = c->cm[scms_idx(c, h, 0)], x;
+	size_t r;
+	for (r = 1; r < c->hd->d; r++) {
+		x = c->cm[scms_idx(c, h, r)];
+		if (x < m)
+			m = x;
+	}
+	return m;
+}
+
+/* Conservative update: raise only the counters below the new estimate */
+static uint64_t scms_upd(struct SCMSView *c, const uint64_t h,
+			 const uint64_t v)
+{
+	const uint64_t m = scms_min(c, h),
+		       e = m + v < m ? SCMS_CNT_MAX : m + v;
+	size_t r, i;
+	for (r = 0; r < c->hd->d; r++) {
+		i = scms_idx(c, h, r);
+		if (c->cm[i] < e)
+			c->cm[i] = e;
+	}
+	c->hd->total += v;
+	return e;
+}
+
+S_INLINE sbool_t scms_match(const struct SCMSNode *n, const uint64_t h,
+			    const int64_t ki, const ss_t *ks)
+{
+	return n->h == h && (ks ? n->str && !ss_cmp(n->ks, ks) :
+				  !n->str && n->ki == ki);
+}
+
+/* Hash table slot of the key (or the empty slot where it would go) */
+static size_t scms_ht_find(const struct SCMSView *c, const uint64_t h,
+			   const int64_t ki, const ss_t *ks)
+{
+	size_t s = (size_t)h & c->hd->hmask;
+	for (; c->ht[s]; s = (s + 1) & c->hd->hmask)
+		if (scms_match(c->nd + c->ht[s] - 1, h, ki, ks))
+			break;
+	return s;
+}
+
+/* Linear probing deletion (backward shift, no tombstones) */
+static void scms_ht_del(struct SCMSView *c, size_t i)
+{
+	size_t j = i, home;
+	for (;;) {
+		j = (j + 1) & c->hd->hmask;
+		if (!c->ht[j])
+			break;
+		home = (size_t)c->nd[c->ht[j] - 1].h & c->hd->hmask;
+		if (i <= j ? home <= i || home > j : home <= i && home > j) {
+			c->ht[i] = c->ht[j];
+			i = j;
+		}
+	}
+	c->ht[i] = 0;
+}
+
+/* Min-heap by count (pos: node positions, updated if not NULL) */
+static void scms_up(const struct SCMSNode *nd, size_t *hp, size_t *pos,
+		    size_t i)
+{
+	const size_t x = hp[i];
+	size_t p;
+	for (; i > 0; i = p) {
+		p = (i - 1) / 2;
+		if (nd[hp[p]].cnt <= nd[x].cnt)
+			break;
+		hp[i] = hp[p];
+		if (pos)
+			pos[hp[i]] = i;
+	}
+	hp[i] = x;
+	if (pos)
+		pos[x] = i;
+}
+
+static void scms_down(const struct SCMSNode *nd, size_t *hp, size_t *pos,
+		      const size_t n, size_t i)
+{
+	const size_t x = hp[i];
+	size_t ch;
+	for (; (ch = 2 * i + 1) < n; i = ch) {
+		if (ch + 1 < n && nd[hp[ch + 1]].cnt < nd[hp[ch]].cnt)
+			ch++;
+		if (nd[x].cnt <= nd[hp[ch]].cnt)
+			break;
+		hp[i] = hp[ch];
+		if (pos)
+			pos[hp[i]] = i;
+	}
+	hp[i] = x;
+	if (pos)
+		pos[x] = i;
+}
+
+/* Count update of a monitored key (it can decrease, if capped) */
+static void scms_set_cnt(struct SCMSView *c, const size_t id,
+			 const uint64_t cnt)
+{
+	const uint64_t prev = c->nd[id].cnt;
+	c->nd[id].cnt = cnt;
+	if (cnt < prev)
+		scms_up(c->nd, c->heap, c->pos, c->pos[id]);
+	else
+		scms_down(c->nd, c->heap, c->pos, c->hd->n, c->pos[id]);
+}
+
+/*
+ * Space-saving step, with the sketch estimate (e) as upper bound: the
+ * unmonitored key replaces the least frequent one, only if its estimate
+ * is higher
+ */
+static void scms_top_upd(struct SCMSView *c, const uint64_t h,
+			 const int64_t ki, const ss_t *ks, const uint64_t v,
+			 const uint64_t e)
+{
+	size_t s, id;
+	struct SCMSNode *n;
+	uint64_t cnt;
+	sbool_t evict;
+	if (!c->hd->k)
+		return;
+	s = scms_ht_find(c, h, ki, ks);
+	if (c->ht[s]) {
+		id = c->ht[s] - 1;
+		cnt = c->nd[id].cnt + v;
+		scms_set_cnt(c, id, cnt < c->nd[id].cnt ? e : S_MIN(cnt, e));
+		return;
+	}
+	evict = c->hd->n == c->hd->k;
+	if (!evict) { /* never evicted: first occurrence, exact count */
+		id = c->hd->n++;
+		cnt = v;
+		c->heap[id] = id;
+	} else {
+		id = c->heap[0];
+		n = c->nd + id;
+		if (e <= n->cnt)
+			return;
+		scms_ht_del(c, scms_ht_find(c, n->h, n->ki,
+					    n->str ? n->ks : NULL));
+		s = scms_ht_find(c, h, ki, ks);
+		cnt = n->cnt + v < n->cnt ? e : S_MIN(n->cnt + v, e);
+	}
+	n = c->nd + id;
+	n->h = h;
+	n->str = ks ? S_TRUE : S_FALSE;
+	n->ki = ki;
+	if (ks)
+		ss_cpy(&n->ks, ks);
+	n->cnt = cnt;
+	n->err = cnt - v;
+	c->ht[s] = id + 1;
+	if (evict) /* count above the previous minimum */
+		scms_down(c->nd, c->heap, c->pos, c->hd->n, 0);
+	else
+		scms_up(c->nd, c->heap, c->pos, id);
+}
+
+/* Top-k node ids, from the most frequent (heap sort of a copy) */
+static size_t *scms_sorted(const struct SCMSView *c)
+{
+	size_t m, t, *o;
+	RETURN_IF(!c || !c->hd->n, NULL);
+	o = (size_t *)s_malloc(c->hd->n * sizeof(size_t));
+	RETURN_IF(!o, NULL);
+	memcpy(o, c->heap, c->hd->n * sizeof(size_t));
+	for (m = c->hd->n; m > 1; m--) {
+		t = o[0];
+		o[0] = o[m - 1];
+		o[m - 1] = t;
+		scms_down(c->nd, o, NULL, m - 1, 0);
+	}
+	return o;
+}
+
+/* Buffer size (0 if not valid), table sizes rounded up to powers of two */
+static size_t scms_geom(const size_t width, const size_t depth,
+			const size_t k, size_t *w_out, size_t *hs_out)
+{
+	size_t w = 1, hs = 2, cm_sz, nd_sz, h_sz;
+	RETURN_IF(!depth || depth > SCMS_DEPTH_MAX || width > SCMS_W_MAX ||
+		  k > SIZE_MAX / 64, 0);
+	while (w < width)
+		w *= 2;
+	while (hs < 2 * k)
+		hs *= 2;
+	cm_sz = s_size_t_mul(s_size_t_mul(w, depth, SIZE_MAX),
+			     sizeof(uint64_t), SIZE_MAX);
+	nd_sz = s_size_t_mul(k, sizeof(struct SCMSNode), SIZE_MAX);
+	h_sz = (2 * k + hs) * sizeof(size_t);
+	RETURN_IF(cm_sz > SIZE_MAX / 4 || nd_sz > SIZE_MAX / 4 ||
+		  h_sz > SIZE_MAX / 4, 0);
+	if (w_out)
+		*w_out = w;
+	if (hs_out)
+		*hs_out = hs;
+	return SCMS_HDR + cm_sz + nd_sz + h_sz;
+}
+
+/*
+ * Header and arrays from the vector buffer (S_FALSE if not a valid sketch,
+ * e.g. scms_void). The view is writable: the const API functions only
+ * read through it.
+ */
+static sbool_t scms_view(struct SCMSView *v, const scms_t *c)
+{
+	const size_t ss = sv_size(c);
+	RETURN_IF(ss < SCMS_HDR, S_FALSE);
+	char *b = (char *)sv_get_buffer_r(c);
+	const struct SCMSHdr *h = (const struct SCMSHdr *)b;
+	const size_t cm_n = (h->wmask + 1) * h->d;
+	RETURN_IF(!h->d || h->d > SCMS_DEPTH_MAX || h->k > ss ||
+		  SCMS_HDR + cm_n * sizeof(uint64_t) +
+		  h->k * sizeof(struct SCMSNode) +
+		  (2 * h->k + h->hmask + 1) * sizeof(size_t) != ss, S_FALSE);
+	v->hd = (struct SCMSHdr *)b;
+	v->cm = (uint64_t *)(b + SCMS_HDR);
+	v->nd = (struct SCMSNode *)(v->cm + cm_n);
+	v->heap = (size_t *)(v->nd + h->k);
+	v->pos = v->heap + h->k;
+	v->ht = v->pos + h->k;
+	return S_TRUE;
+}
+
+/*
+ * Allocation
+ */
+
+size_t scms_alloc_size(const size_t width, const size_t depth,
+		       const size_t k)
+{
+	const size_t ss = scms_geom(width, depth, k, NULL, NULL);
+	return ss ? sd_alloc_size_raw(sizeof(sv_t), 1, ss, S_FALSE) : 0;
+}
+
+scms_t *scms_alloc_raw(const size_t width, const size_t depth,
+		       const size_t k, const sbool_t ext_buf, void *buffer)
+{
+	size_t w, hs;
+	const size_t ss = scms_geom(width, depth, k, &w, &hs);
+	RETURN_IF(!buffer || !ss, scms_void);
+	scms_t *c = sv_alloc_raw(SV_U8, ext_buf, buffer, 1, ss, NULL);
+	struct SCMSHdr *h = (struct SCMSHdr *)sv_get_buffer(c);
+	memset(h, 0, ss);
+	h->wmask = w - 1;
+	h->d = depth;
+	h->k = k;
+	h->hmask = hs - 1;
+	sv_set_size(c, ss);
+	return c;
+}
+
+scms_t *scms_alloc(const size_t width, const size_t depth, const size_t k)
+{
+	const size_t as = scms_alloc_size(width, depth, k);
+	return as ? scms_alloc_raw(width, depth, k, S_FALSE, s_malloc(as)) :
+		    scms_void;
+}
+
+void scms_free(scms_t **c)
+{
+	struct SCMSView v;
+	size_t i;
+	if (c && *c) {
+		if (scms_view(&v, *c))
+			for (i = 0; i < v.hd->k; i++)
+				ss_free(&v.nd[i].ks);
+		if ((*c)->d.f.ext_buffer) /* stack/external buffer, void */
+			*c = NULL;
+		else
+			sv_free(c);
+	}
+}
+
+void scms_clear(scms_t *c)
+{
+	struct SCMSView v;
+	if (scms_view(&v, c)) {
+		memset(v.cm, 0, (v.hd->wmask + 1) * v.hd->d * sizeof(uint64_t));
+		memset(v.ht, 0, (v.hd->hmask + 1) * sizeof(size_t));
+		v.hd->n = 0;
+		v.hd->total = 0;
+	}
+}
+
+/*
+ * Accessors
+ */
+
+uint64_t scms_total(const scms_t *c)
+{
+	struct SCMSView v;
+	return scms_view(&v, c) ? v.hd->total : 0;
+}
+
+size_t scms_top_size(const scms_t *c)
+{
+	struct SCMSView v;
+	return scms_view(&v, c) ? v.hd->n : 0;
+}
+
+/*
+ * Update and query
+ */
+
+uint64_t scms_inc_i(scms_t *c, const int64_t k, const uint64_t v)
+{
+	struct SCMSView w;
+	RETURN_IF(!scms_view(&w, c), 0);
+	const uint64_t h = scms_hash_i(k), e = scms_upd(&w, h, v);
+	scms_top_upd(&w, h, k, NULL, v, e);
+	return e;
+}
+
+uint64_t scms_inc_s(scms_t *c, const ss_t *k, const uint64_t v)
+{
+	struct SCMSView w;
+	RETURN_IF(!k || !scms_view(&w, c), 0);
+	const uint64_t h = scms_hash_s(k), e = scms_upd(&w, h, v);
+	scms_top_upd(&w, h, 0, k, v, e);
+	return e;
+}
+
+uint64_t scms_count_i(const scms_t *c, const int64_t k)
+{
+	struct SCMSView v;
+	return scms_view(&v, c) ? scms_min(&v, scms_hash_i(k)) : 0;
+}
+
+uint64_t scms_count_s(const scms_t *c, const ss_t *k)
+{
+	struct SCMSView v;
+	return k && scms_view(&v, c) ? scms_min(&v, scms_hash_s(k)) : 0;
+}
+
+/*
+ * Top-k enumeration
+ */
+
+size_t scms_top_i(const scms_t *c, scms_it_i_t f, void *context)
+{
+	struct SCMSView v;
+	size_t i, cnt = 0, *o;
+	const struct SCMSNode *n;
+	RETURN_IF(!scms_view(&v, c), 0);
+	o = scms_sorted(&v);
+	RETURN_IF(!o, 0);
+	for (i = 0; i < v.hd->n; i++) {
+		n = v.nd + o[i];
+		if (n->str)
+			continue;
+		cnt++;
+		if (f && !f(n->ki, n->cnt, n->err, context))
+			break;
+	}
+	s_free(o);
+	return cnt;
+}
+
+size_t scms_top_s(const scms_t *c, scms_it_s_t f, void *context)
+{
+	struct SCMSView v;
+	size_t i, cnt = 0, *o;
+	const struct SCMSNode *n;
+	RETURN_IF(!scms_view(&v, c), 0);
+	o = scms_sorted(&v);
+	RETURN_IF(!o, 0);
+	for (i = 0; i < v.hd->n; i++) {
+		n = v.nd + o[i];
+		if (!n->str)
+			continue;
+		cnt++;
+		if (f && !f(n->ks, n->cnt, n->err, context))
+			break;
+	}
+	s_free(o);
+	return cnt;
+}
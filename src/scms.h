@@ -0,0 +1,129 @@
+#ifndef SCMS_H
+#define SCMS_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * scms.h
+ *
+ * #SHORTDOC count-min sketch with top-k heavy hitters (frequency estimation)
+ *
+ * #DOC Approximate key frequency counting in fixed memory, as a bounded
+ * #DOC alternative to sm_inc_ii()/sm_inc_si() over streams with many
+ * #DOC distinct keys. The count-min sketch keeps depth rows of width
+ * #DOC counters: the estimate for a key is never below its real count,
+ * #DOC and it exceeds it by at most total * e / width with probability
+ * #DOC 1 - e^-depth (e.g. width 2048, depth 4: 0.13% of the total, with
+ * #DOC 98% probability, in 64KB). A table of the k most frequent keys is
+ * #DOC kept along the sketch ("space-saving" algorithm).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Conservative update: only the row counters below the new estimate are
+ *   increased, reducing the overestimation for infrequent keys
+ * - Top-k table: monitored keys are incremented, and an unmonitored key
+ *   takes the place of the least frequent one (space-saving) when its
+ *   sketch estimate is higher. Each entry has an upper bound (count) and
+ *   the maximum overestimation (error), so count - error is a lower bound.
+ *   Until the table is full, counts are exact
+ * - Integer and string (ss_t) keys (same hash functions as sbf_t and
+ *   shll_t), in the same sketch
+ * - One memory block (stored in a vector): no allocation after creation,
+ *   other than the top-k string key copies. Heap, or stack/external
+ *   buffer allocation
+ *
+ * Observations:
+ * - Update: O(depth) for the sketch, plus O(1) hash table lookup and
+ *   O(log k) worst case for reordering the top-k table (min-heap, as
+ *   increments are weighted)
+ */
+
+#include "svector.h"
+#include "sstring.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t scms_t;	/* "Hidden" structure (accessors are provided) */
+			/* (header, counters, and top-k table in a vector) */
+
+typedef sbool_t (*scms_it_i_t)(int64_t k, uint64_t count, uint64_t error,
+			       void *context);
+typedef sbool_t (*scms_it_s_t)(const ss_t *k, uint64_t count,
+			       uint64_t error, void *context);
+
+#define SCMS_DEPTH_MAX	16
+
+/*
+ * Allocation
+ */
+
+#define scms_alloca(width, depth, k)					\
+	scms_alloc_raw(width, depth, k, S_TRUE,				\
+		       alloca(scms_alloc_size(width, depth, k)))
+
+/*
+#API: |Allocate count-min sketch (stack)|width: counters per row (rounded up to a power of two); depth: number of rows (1 to SCMS_DEPTH_MAX); number of top keys tracked (0 for none)|sketch|O(n)|1;2|
+scms_t *scms_alloca(const size_t width, const size_t depth, const size_t k)
+*/
+
+/* #API: |Buffer size required for a count-min sketch|width; depth; number of top keys (same as scms_alloc())|bytes (0 if the parameters are not valid)|O(1)|1;2| */
+size_t scms_alloc_size(const size_t width, const size_t depth, const size_t k);
+
+/* #API: |Allocate count-min sketch using external buffer|width; depth; number of top keys (same as scms_alloc()); external buffer flag; buffer (at least scms_alloc_size() bytes)|sketch|O(n)|1;2| */
+scms_t *scms_alloc_raw(const size_t width, const size_t depth,
+		       const size_t k, const sbool_t ext_buf, void *buffer);
+
+/* #API: |Allocate count-min sketch (heap)|width: counters per row (rounded up to a power of two); depth: number of rows (1 to SCMS_DEPTH_MAX); number of top keys tracked (0 for none)|sketch|O(n)|1;2| */
+scms_t *scms_alloc(const size_t width, const size_t depth, const size_t k);
+
+/* #API: |Free sketch (stack/external buffer sketches: only the top-k string key copies are freed)|sketch|-|O(k)|1;2| */
+void scms_free(scms_t **c);
+
+/* #API: |Reset all counters and the top-k table|sketch|-|O(n)|1;2| */
+void scms_clear(scms_t *c);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Sum of all increments|sketch|total count|O(1)|1;2| */
+uint64_t scms_total(const scms_t *c);
+
+/* #API: |Number of keys in the top-k table|sketch|number of keys (up to k)|O(1)|1;2| */
+size_t scms_top_size(const scms_t *c);
+
+/*
+ * Update and query
+ */
+
+/* #API: |Increment integer key count|sketch; key; increment|key count estimate, after the increment|O(depth + log k)|1;2| */
+uint64_t scms_inc_i(scms_t *c, const int64_t k, const uint64_t v);
+
+/* #API: |Increment string key count|sketch; key; increment|key count estimate, after the increment|O(depth + log k)|1;2| */
+uint64_t scms_inc_s(scms_t *c, const ss_t *k, const uint64_t v);
+
+/* #API: |Integer key count estimate (upper bound)|sketch; key|count estimate|O(depth)|1;2| */
+uint64_t scms_count_i(const scms_t *c, const int64_t k);
+
+/* #API: |String key count estimate (upper bound)|sketch; key|count estimate|O(depth)|1;2| */
+uint64_t scms_count_s(const scms_t *c, const ss_t *k);
+
+/*
+ * Top-k enumeration
+ */
+
+/* #API: |Enumerate top-k integer keys, from the most frequent (the callback returning S_FALSE stops the enumeration)|sketch; callback function (NULL for just counting); callback function context|Elements processed|O(k log k)|1;2| */
+size_t scms_top_i(const scms_t *c, scms_it_i_t f, void *context);
+
+/* #API: |Enumerate top-k string keys, from the most frequent (the callback returning S_FALSE stops the enumeration)|sketch; callback function (NULL for just counting); callback function context|Elements processed|O(k log k)|1;2| */
+size_t scms_top_s(const scms_t *c, scms_it_s_t f, void *context);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SCMS_H */
@@ -0,0 +1,204 @@
+/*
+ * sdeque.c
+ *
+ * Double-ended queue (circular buffer).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "sdeque.h"
+#include "saux/scommon.h"
+
+#define sdq_void (sdq_t *)sd_void
+
+/*
+ * Internal functions
+ */
+
+S_INLINE size_t sdq_head(const sdq_t *q)
+{
+	return (size_t)q->vx.cnt;
+}
+
+/* Physical slot of the element at logical index i (i <= capacity) */
+S_INLINE size_t sdq_slot(const sdq_t *q, const size_t i)
+{
+	const size_t h = sdq_head(q), cap = sv_capacity(q);
+	return i < cap - h ? h + i : i - (cap - h);
+}
+
+S_INLINE void *sdq_ptr(sdq_t *q, const size_t slot)
+{
+	return sv_get_buffer(q) + slot * q->d.elem_size;
+}
+
+S_INLINE const void *sdq_ptr_r(const sdq_t *q, const size_t slot)
+{
+	return sv_get_buffer_r(q) + slot * q->d.elem_size;
+}
+
+/*
+ * Ensure room for one more element. When the buffer gets reallocated, the
+ * wrapped part [head, old capacity) is moved to the end of the new buffer,
+ * so the logical order is kept without a full copy.
+ */
+static sbool_t sdq_grow(sdq_t **q)
+{
+	const size_t n = sv_size(*q), cap = sv_capacity(*q);
+	RETURN_IF(n < cap, S_TRUE);
+	RETURN_IF(sv_reserve(q, cap + 1) <= cap, S_FALSE);
+	const size_t h = sdq_head(*q), ncap = sv_capacity(*q);
+	if (h > 0) {
+		const size_t n_tail = cap - h, nh = ncap - n_tail;
+		memmove(sdq_ptr(*q, nh), sdq_ptr(*q, h),
+			n_tail * (*q)->d.elem_size);
+		(*q)->vx.cnt = nh;
+	}
+	return S_TRUE;
+}
+
+/*
+ * Allocation
+ */
+
+sdq_t *sdq_alloc_raw(const enum eSV_Type t, const sbool_t ext_buf,
+		     void *buffer, const size_t elem_size,
+		     const size_t max_size)
+{
+	RETURN_IF(!elem_size || !buffer, sdq_void);
+	sdq_t *q = sv_alloc_raw(t, ext_buf, buffer, elem_size, max_size, NULL);
+	q->vx.cnt = 0;
+	return q;
+}
+
+sdq_t *sdq_alloc(const size_t elem_size,
+		 const size_t initial_num_elems_reserve)
+{
+	return sdq_alloc_raw(SV_GEN, S_FALSE,
+			     s_malloc(sdq_alloc_size(elem_size,
+						     initial_num_elems_reserve)),
+			     elem_size, initial_num_elems_reserve);
+}
+
+sdq_t *sdq_alloc_t(const enum eSV_Type t,
+		   const size_t initial_num_elems_reserve)
+{
+	const size_t es = sv_elem_size(t);
+	return sdq_alloc_raw(t, S_FALSE,
+			     s_malloc(sdq_alloc_size(es,
+						     initial_num_elems_reserve)),
+			     es, initial_num_elems_reserve);
+}
+
+sdq_t *sdq_dup(const sdq_t *src)
+{
+	RETURN_IF(!src, sdq_void);
+	const void *s1, *s2;
+	size_t n1, n2;
+	const size_t n = sdq_view(src, &s1, &n1, &s2, &n2),
+		     es = src->d.elem_size;
+	sdq_t *q = sdq_alloc_raw((enum eSV_Type)src->d.sub_type, S_FALSE,
+				 s_malloc(sdq_alloc_size(es, n)), es, n);
+	if (q != sdq_void && n > 0) {
+		memcpy(sdq_ptr(q, 0), s1, n1 * es);
+		if (n2)
+			memcpy(sdq_ptr(q, n1), s2, n2 * es);
+		sv_set_size(q, n);
+	}
+	return q;
+}
+
+/*
+ * Accessors
+ */
+
+const void *sdq_at(const sdq_t *q, const size_t index)
+{
+	RETURN_IF(!q || index >= sv_size(q), NULL);
+	return sdq_ptr_r(q, sdq_slot(q, index));
+}
+
+const void *sdq_front(const sdq_t *q)
+{
+	return sdq_at(q, 0);
+}
+
+const void *sdq_back(const sdq_t *q)
+{
+	RETURN_IF(!q || !sv_size(q), NULL);
+	return sdq_at(q, sv_size(q) - 1);
+}
+
+size_t sdq_view(const sdq_t *q, const void **s1, size_t *n1, const void **s2,
+		size_t *n2)
+{
+	const size_t n = sv_size(q);
+	size_t l1 = 0, l2 = 0;
+	const void *p1 = NULL, *p2 = NULL;
+	if (n > 0) {
+		const size_t h = sdq_head(q), cap = sv_capacity(q);
+		p1 = sdq_ptr_r(q, h);
+		l1 = S_MIN(n, cap - h);
+		l2 = n - l1;
+		if (l2)
+			p2 = sdq_ptr_r(q, 0);
+	}
+	if (s1)
+		*s1 = p1;
+	if (n1)
+		*n1 = l1;
+	if (s2)
+		*s2 = p2;
+	if (n2)
+		*n2 = l2;
+	return n;
+}
+
+/*
+ * Insertion/removal
+ */
+
+sbool_t sdq_push_back(sdq_t **q, const void *e)
+{
+	RETURN_IF(!q || !*q || !e || !sdq_grow(q), S_FALSE);
+	const size_t n = sv_size(*q);
+	memcpy(sdq_ptr(*q, sdq_slot(*q, n)), e, (*q)->d.elem_size);
+	sv_set_size(*q, n + 1);
+	return S_TRUE;
+}
+
+sbool_t sdq_push_front(sdq_t **q, const void *e)
+{
+	RETURN_IF(!q || !*q || !e || !sdq_grow(q), S_FALSE);
+	const size_t h = sdq_head(*q),
+		     nh = (h > 0 ? h : sv_capacity(*q)) - 1;
+	memcpy(sdq_ptr(*q, nh), e, (*q)->d.elem_size);
+	(*q)->vx.cnt = nh;
+	sv_set_size(*q, sv_size(*q) + 1);
+	return S_TRUE;
+}
+
+sbool_t sdq_pop_back(sdq_t *q, void *e)
+{
+	const size_t n = sv_size(q);
+	RETURN_IF(!n, S_FALSE);
+	if (e)
+		memcpy(e, sdq_ptr_r(q, sdq_slot(q, n - 1)), q->d.elem_size);
+	sv_set_size(q, n - 1);
+	if (n == 1)
+		q->vx.cnt = 0;
+	return S_TRUE;
+}
+
+sbool_t sdq_pop_front(sdq_t *q, void *e)
+{
+	const size_t n = sv_size(q);
+	RETURN_IF(!n, S_FALSE);
+	const size_t h = sdq_head(q);
+	if (e)
+		memcpy(e, sdq_ptr_r(q, h), q->d.elem_size);
+	sv_set_size(q, n - 1);
+	q->vx.cnt = n == 1 || h + 1 == sv_capacity(q) ? 0 : h + 1;
+	return S_TRUE;
+}
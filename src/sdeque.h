@@ -0,0 +1,152 @@
+#ifndef SDEQUE_H
+#define SDEQUE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * sdeque.h
+ *
+ * #SHORTDOC double-ended queue (circular buffer)
+ *
+ * #DOC Double-ended queue implemented as a ring buffer over a vector
+ * #DOC allocation (single memory block, same as sv_t). Insertion and removal
+ * #DOC at both ends is O(1), so it can be used as FIFO queue without the
+ * #DOC element shifting of sv_erase(v, 0, 1).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - O(1) push/pop at both ends, O(1) random access
+ * - Elements of any size (generic deque), or of sv_t types (SV_I8 ...
+ *   SV_F64), passed by reference
+ * - Heap allocation, with amortized O(1) growth (the wrapped segment is
+ *   moved to the end of the new allocation, no full copy is done)
+ * - Fixed-capacity mode, using a stack or external buffer: no memory
+ *   allocation after the deque creation (push returns S_FALSE when full),
+ *   suitable for real-time code
+ * - Contiguous view: the content is exposed as two segments (head and
+ *   wrapped part), so it can be processed without copying
+ */
+
+#include "svector.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t sdq_t;	/* "Hidden" structure (accessors are provided) */
+			/* (ring buffer over a vector, head index in vx.cnt) */
+
+/*
+ * Allocation
+ */
+
+#define sdq_alloc_size(elem_size, max_size)				\
+	sd_alloc_size_raw(sizeof(sv_t), elem_size, max_size, S_FALSE)
+#define sdq_alloca(elem_size, max_size)					\
+	sdq_alloc_raw(SV_GEN, S_TRUE,					\
+		      alloca(sdq_alloc_size(elem_size, max_size)),	\
+		      elem_size, max_size)
+#define sdq_alloca_t(type, max_size)					\
+	sdq_alloc_raw(type, S_TRUE,					\
+		      alloca(sdq_alloc_size(sv_elem_size(type),		\
+					    max_size)),			\
+		      sv_elem_size(type), max_size)
+#define sdq_free	sv_free
+
+/*
+#API: |Allocate generic deque (stack, fixed capacity)|element size; maximum number of elements|deque|O(1)|1;2|
+sdq_t *sdq_alloca(const size_t elem_size, const size_t max_size)
+
+#API: |Allocate typed deque (stack, fixed capacity)|Deque type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64/SV_F32/SV_F64; maximum number of elements|deque|O(1)|1;2|
+sdq_t *sdq_alloca_t(const enum eSV_Type t, const size_t max_size)
+
+#API: |Buffer size required for a fixed-capacity deque|element size; maximum number of elements|bytes|O(1)|1;2|
+size_t sdq_alloc_size(const size_t elem_size, const size_t max_size)
+
+#API: |Free one or more deques (heap)|deque; more deques (optional)|-|O(1)|1;2|
+void sdq_free(sdq_t **q, ...)
+*/
+
+/* #API: |Allocate deque using external buffer (fixed capacity if ext_buf is S_TRUE)|Deque type (SV_GEN for generic); external buffer flag; buffer (at least sdq_alloc_size() bytes); element size; maximum number of elements|deque|O(1)|1;2| */
+sdq_t *sdq_alloc_raw(const enum eSV_Type t, const sbool_t ext_buf,
+		     void *buffer, const size_t elem_size,
+		     const size_t max_size);
+
+/* #API: |Allocate generic deque (heap)|element size; space preallocated to store n elements|deque|O(1)|1;2| */
+sdq_t *sdq_alloc(const size_t elem_size,
+		 const size_t initial_num_elems_reserve);
+
+/* #API: |Allocate typed deque (heap)|Deque type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64/SV_F32/SV_F64; space preallocated to store n elements|deque|O(1)|1;2| */
+sdq_t *sdq_alloc_t(const enum eSV_Type t,
+		   const size_t initial_num_elems_reserve);
+
+/* #API: |Duplicate deque (the copy is linear: one segment)|deque|output deque (heap)|O(n)|1;2| */
+sdq_t *sdq_dup(const sdq_t *src);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Number of elements|deque|number of elements|O(1)|1;2| */
+S_INLINE size_t sdq_size(const sdq_t *q)
+{
+	return sv_size(q);
+}
+
+/* #API: |Allocated space|deque|current allocated space (number of elements)|O(1)|1;2| */
+S_INLINE size_t sdq_capacity(const sdq_t *q)
+{
+	return sv_capacity(q);
+}
+
+/* #API: |Check if the deque is empty|deque|S_TRUE: empty; S_FALSE: not empty|O(1)|1;2| */
+S_INLINE sbool_t sdq_empty(const sdq_t *q)
+{
+	return sv_size(q) == 0 ? S_TRUE : S_FALSE;
+}
+
+/* #API: |Reset deque (remove all elements)|deque|-|O(1)|1;2| */
+S_INLINE void sdq_clear(sdq_t *q)
+{
+	if (q) {
+		sv_set_size(q, 0);
+		q->vx.cnt = 0;
+	}
+}
+
+/* #API: |Element access|deque; element index (0: front)|element reference (NULL if out of range)|O(1)|1;2| */
+const void *sdq_at(const sdq_t *q, const size_t index);
+
+/* #API: |Front element access|deque|element reference (NULL if empty)|O(1)|1;2| */
+const void *sdq_front(const sdq_t *q);
+
+/* #API: |Back element access|deque|element reference (NULL if empty)|O(1)|1;2| */
+const void *sdq_back(const sdq_t *q);
+
+/* #API: |Contiguous view of the deque, as two segments (elements [0, n1) are in the first one, [n1, n1 + n2) in the second)|deque; first segment (output); first segment element count (output); second segment (output, NULL if not wrapped); second segment element count (output)|number of elements|O(1)|1;2| */
+size_t sdq_view(const sdq_t *q, const void **s1, size_t *n1, const void **s2,
+		size_t *n2);
+
+/*
+ * Insertion/removal
+ */
+
+/* #API: |Insert element at the back|deque; element reference|S_TRUE: OK, S_FALSE: error (e.g. full fixed-capacity deque)|O(1)|1;2| */
+sbool_t sdq_push_back(sdq_t **q, const void *e);
+
+/* #API: |Insert element at the front|deque; element reference|S_TRUE: OK, S_FALSE: error (e.g. full fixed-capacity deque)|O(1)|1;2| */
+sbool_t sdq_push_front(sdq_t **q, const void *e);
+
+/* #API: |Remove element from the back|deque; element output (NULL for discarding it)|S_TRUE: OK, S_FALSE: empty deque|O(1)|1;2| */
+sbool_t sdq_pop_back(sdq_t *q, void *e);
+
+/* #API: |Remove element from the front|deque; element output (NULL for discarding it)|S_TRUE: OK, S_FALSE: empty deque|O(1)|1;2| */
+sbool_t sdq_pop_front(sdq_t *q, void *e);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SDEQUE_H */
@@ -0,0 +1,424 @@
+/*
+ * shll.c
+ *
+ * HyperLogLog sketch (approximate distinct count).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "shll.h"
+#include "saux/scommon.h"
+#include "saux/shash.h"
+
+/*
+ * Constants
+ */
+
+#define SHLL_VERSION	1
+#define SHLL_HDR	8	/* header size (bytes) */
+#define SHLL_SPARSE	0
+#define SHLL_DENSE	1
+#define SHLL_SP		25	/* sparse representation index precision */
+#define SHLL_SQ		(64 - SHLL_SP)
+#define SHLL_SEED	0
+#define SHLL_ALPHA_INF	0.72134752044448170368	/* 1 / (2 ln(2)) */
+
+/*
+ * Internal functions
+ */
+
+/* Precision (0 if not a valid sketch) */
+static unsigned shll_p(const shll_t *h)
+{
+	const size_t ss = sv_size(h);
+	RETURN_IF(ss < SHLL_HDR, 0);
+	const unsigned char *b = (const unsigned char *)sv_get_buffer_r(h);
+	const unsigned p = b[1];
+	RETURN_IF(b[0] != SHLL_VERSION || p < SHLL_P_MIN || p > SHLL_P_MAX ||
+		  b[3], 0);
+	if (b[2] == SHLL_SPARSE)
+		return (ss - SHLL_HDR) % 4 == 0 &&
+		       (ss - SHLL_HDR) / 4 == S_LD_LE_U32(b + 4) ? p : 0;
+	return b[2] == SHLL_DENSE && !S_LD_LE_U32(b + 4) &&
+	       ss == SHLL_HDR + ((size_t)1 << p) ? p : 0;
+}
+
+/* Empty sketch with ss bytes (header set, sparse mode; rest zeroed) */
+static shll_t *shll_new(const unsigned p, const size_t ss)
+{
+	shll_t *h = sv_alloc_t(SV_U8, ss);
+	unsigned char *b;
+	RETURN_IF((sd_t *)h == sd_void, h);
+	if (sv_reserve(&h, ss) < ss) {
+		sv_free(&h);
+		return (shll_t *)sd_void;
+	}
+	b = (unsigned char *)sv_get_buffer(h);
+	memset(b, 0, ss);
+	b[0] = SHLL_VERSION;
+	b[1] = (unsigned char)p;
+	b[2] = SHLL_SPARSE;
+	sv_set_size(h, ss);
+	return h;
+}
+
+static shll_t *shll_replace(shll_t **out, shll_t *r)
+{
+	if (*out)
+		shll_free(out);
+	*out = r;
+	return r;
+}
+
+/* Sparse entry from the hash: 25-bit index, lowest bit set of the rest */
+S_INLINE uint32_t shll_sp_entry(const uint64_t x)
+{
+	return (uint32_t)(x >> SHLL_SQ) << 6 |
+	       (s_ctz64(x | (uint64_t)1 << SHLL_SQ) + 1);
+}
+
+S_INLINE void shll_reg_max(unsigned char *r, const size_t i, const unsigned v)
+{
+	if (r[i] < v)
+		r[i] = (unsigned char)v;
+}
+
+/*
+ * Sparse entry to dense register: the index bits below the dense
+ * precision are the upper part of the dense register hash bits, so they
+ * count only when the 39 lower bits are all zero
+ */
+S_INLINE void shll_reg_sp(unsigned char *r, const unsigned p, const uint32_t e)
+{
+	const unsigned d = SHLL_SP - p;
+	const uint32_t i = e >> 6;
+	unsigned v = e & 63;
+	if (v > SHLL_SQ)
+		v = SHLL_SQ + 1 + s_ctz32((i & ((1U << d) - 1)) | 1U << d);
+	shll_reg_max(r, i >> d, v);
+}
+
+static sbool_t shll_to_dense(shll_t **h, const unsigned p)
+{
+	const unsigned char *s = (const unsigned char *)sv_get_buffer_r(*h);
+	const size_t n = S_LD_LE_U32(s + 4), m = (size_t)1 << p;
+	size_t i;
+	shll_t *d = shll_new(p, SHLL_HDR + m);
+	RETURN_IF((sd_t *)d == sd_void, S_FALSE);
+	unsigned char *b = (unsigned char *)sv_get_buffer(d);
+	b[2] = SHLL_DENSE;
+	for (i = 0; i < n; i++)
+		shll_reg_sp(b + SHLL_HDR, p, S_LD_LE_U32(s + SHLL_HDR + i * 4));
+	shll_replace(h, d);
+	return S_TRUE;
+}
+
+/* Position of the sparse entry index (or where it would be inserted) */
+static size_t shll_sp_find(const unsigned char *e, const size_t n,
+			   const uint32_t i)
+{
+	size_t lo = 0, hi = n, mid;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if ((S_LD_LE_U32(e + mid * 4) >> 6) < i)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static sbool_t shll_add_h(shll_t **h, const uint64_t x)
+{
+	ASSERT_RETURN_IF(!h || !*h, S_FALSE);
+	const unsigned p = shll_p(*h);
+	RETURN_IF(!p, S_FALSE);
+	unsigned char *b = (unsigned char *)sv_get_buffer(*h);
+	if (b[2] == SHLL_DENSE) {
+		shll_reg_max(b + SHLL_HDR, (size_t)(x >> (64 - p)),
+			     s_ctz64(x | (uint64_t)1 << (64 - p)) + 1);
+		return S_TRUE;
+	}
+	const uint32_t e = shll_sp_entry(x);
+	const size_t n = S_LD_LE_U32(b + 4), ss = sv_size(*h),
+		     pos = shll_sp_find(b + SHLL_HDR, n, e >> 6);
+	uint32_t c;
+	if (pos < n) {
+		c = S_LD_LE_U32(b + SHLL_HDR + pos * 4);
+		if ((c >> 6) == (e >> 6)) {
+			if ((c & 63) < (e & 63))
+				S_ST_LE_U32(b + SHLL_HDR + pos * 4, e);
+			return S_TRUE;
+		}
+	}
+	if ((n + 1) * 4 > (size_t)1 << p) { /* sparse larger than dense */
+		RETURN_IF(!shll_to_dense(h, p), S_FALSE);
+		shll_reg_sp((unsigned char *)sv_get_buffer(*h) + SHLL_HDR, p,
+			    e);
+		return S_TRUE;
+	}
+	RETURN_IF(sv_reserve(h, ss + 4) < ss + 4, S_FALSE);
+	b = (unsigned char *)sv_get_buffer(*h);
+	memmove(b + SHLL_HDR + (pos + 1) * 4, b + SHLL_HDR + pos * 4,
+		(n - pos) * 4);
+	S_ST_LE_U32(b + SHLL_HDR + pos * 4, e);
+	S_ST_LE_U32(b + 4, (uint32_t)(n + 1));
+	sv_set_size(*h, ss + 4);
+	return S_TRUE;
+}
+
+/* Sorted merge of two sparse sketches (S_FALSE if larger than dense) */
+static sbool_t shll_merge_sparse(shll_t **h, const shll_t *src,
+				 const unsigned p)
+{
+	const unsigned char *a = (const unsigned char *)sv_get_buffer_r(*h),
+			    *b = (const unsigned char *)sv_get_buffer_r(src);
+	const size_t na = S_LD_LE_U32(a + 4), nb = S_LD_LE_U32(b + 4);
+	size_t i = 0, j = 0, k = 0;
+	uint32_t ea, eb;
+	shll_t *o = shll_new(p, SHLL_HDR + (na + nb) * 4);
+	RETURN_IF((sd_t *)o == sd_void, S_FALSE);
+	unsigned char *c = (unsigned char *)sv_get_buffer(o) + SHLL_HDR;
+	a += SHLL_HDR;
+	b += SHLL_HDR;
+	for (; i < na || j < nb; k++) {
+		ea = i < na ? S_LD_LE_U32(a + i * 4) : 0xffffffff;
+		eb = j < nb ? S_LD_LE_U32(b + j * 4) : 0xffffffff;
+		if ((ea >> 6) == (eb >> 6)) {
+			i++;
+			j++;
+			S_ST_LE_U32(c + k * 4, S_MAX(ea, eb));
+		} else if (ea < eb) {
+			i++;
+			S_ST_LE_U32(c + k * 4, ea);
+		} else {
+			j++;
+			S_ST_LE_U32(c + k * 4, eb);
+		}
+	}
+	if (k * 4 > (size_t)1 << p) {
+		shll_free(&o);
+		return S_FALSE;
+	}
+	S_ST_LE_U32((unsigned char *)sv_get_buffer(o) + 4, (uint32_t)k);
+	sv_set_size(o, SHLL_HDR + k * 4);
+	shll_replace(h, o);
+	return S_TRUE;
+}
+
+/* Square root (Newton's method, from above: monotonic convergence) */
+static double shll_sqrt(const double x)
+{
+	double r = x > 1 ? x : 1, t;
+	RETURN_IF(x <= 0, 0);
+	for (;;) {
+		t = 0.5 * (r + x / r);
+		if (t >= r)
+			return r;
+		r = t;
+	}
+}
+
+static double shll_sigma(double x)
+{
+	double y = 1, z = x, zp;
+	do {
+		x *= x;
+		zp = z;
+		z += x * y;
+		y += y;
+	} while (z != zp);
+	return z;
+}
+
+static double shll_tau(double x)
+{
+	double y = 1, z, zp;
+	RETURN_IF(x == 0 || x == 1, 0);
+	z = 1 - x;
+	do {
+		x = shll_sqrt(x);
+		zp = z;
+		y *= 0.5;
+		z -= (1 - x) * (1 - x) * y;
+	} while (z != zp);
+	return z / 3;
+}
+
+/*
+ * O. Ertl, "New cardinality estimation algorithms for HyperLogLog
+ * sketches" (2017): improved raw estimator, from the register histogram
+ * (c[k]: registers with value k, k = 0 to q + 1)
+ */
+static uint64_t shll_estimate(const size_t *c, const unsigned q,
+			      const size_t m)
+{
+	const double md = (double)m;
+	double z;
+	unsigned k;
+	RETURN_IF(c[0] == m, 0);
+	z = md * shll_tau(1 - (double)c[q + 1] / md);
+	for (k = q; k > 0; k--)
+		z = 0.5 * (z + (double)c[k]);
+	z += md * shll_sigma((double)c[0] / md);
+	return (uint64_t)(SHLL_ALPHA_INF * md * md / z + 0.5);
+}
+
+/*
+ * Allocation
+ */
+
+shll_t *shll_alloc(const unsigned p)
+{
+	/* BEHAVIOR: precision out of range is clamped */
+	return shll_new(p < SHLL_P_MIN ? SHLL_P_MIN :
+			p > SHLL_P_MAX ? SHLL_P_MAX : p, SHLL_HDR);
+}
+
+void shll_clear(shll_t *h)
+{
+	if (!shll_p(h))
+		return;
+	unsigned char *b = (unsigned char *)sv_get_buffer(h);
+	b[2] = SHLL_SPARSE;
+	S_ST_LE_U32(b + 4, 0);
+	sv_set_size(h, SHLL_HDR);
+}
+
+/*
+ * Accessors
+ */
+
+unsigned shll_precision(const shll_t *h)
+{
+	return shll_p(h);
+}
+
+sbool_t shll_sparse(const shll_t *h)
+{
+	return shll_p(h) && ((const unsigned char *)sv_get_buffer_r(h))[2] ==
+			    SHLL_SPARSE ? S_TRUE : S_FALSE;
+}
+
+uint64_t shll_count(const shll_t *h)
+{
+	const unsigned p = shll_p(h);
+	RETURN_IF(!p, 0);
+	const unsigned char *b = (const unsigned char *)sv_get_buffer_r(h);
+	size_t c[66], i, n;
+	memset(c, 0, sizeof(c));
+	if (b[2] == SHLL_SPARSE) { /* 2^25 registers, mostly zero */
+		n = S_LD_LE_U32(b + 4);
+		for (i = 0; i < n; i++)
+			c[S_LD_LE_U32(b + SHLL_HDR + i * 4) & 63]++;
+		c[0] = ((size_t)1 << SHLL_SP) - n;
+		return shll_estimate(c, SHLL_SQ, (size_t)1 << SHLL_SP);
+	}
+	n = (size_t)1 << p;
+	for (i = 0; i < n; i++)
+		c[b[SHLL_HDR + i]]++;
+	return shll_estimate(c, 64 - p, n);
+}
+
+/*
+ * Insert
+ */
+
+sbool_t shll_add_raw(shll_t **h, const void *key, const size_t key_size)
+{
+	return shll_add_h(h, sh_hash64(key, key_size, SHLL_SEED));
+}
+
+sbool_t shll_add_s(shll_t **h, const ss_t *key)
+{
+	return shll_add_raw(h, ss_get_buffer_r(key), ss_size(key));
+}
+
+sbool_t shll_add_i(shll_t **h, const int64_t key)
+{
+	return shll_add_h(h, sh_mix64((uint64_t)key ^ SHLL_SEED));
+}
+
+sbool_t shll_add_u(shll_t **h, const uint64_t key)
+{
+	return shll_add_h(h, sh_mix64(key ^ SHLL_SEED));
+}
+
+/*
+ * Set operations
+ */
+
+sbool_t shll_merge(shll_t **h, const shll_t *src)
+{
+	RETURN_IF(!h || !*h, S_FALSE);
+	const unsigned p = shll_p(*h);
+	RETURN_IF(!p || p != shll_p(src), S_FALSE);
+	RETURN_IF(*h == src, S_TRUE);
+	const unsigned char *s = (const unsigned char *)sv_get_buffer_r(src);
+	const size_t m = (size_t)1 << p;
+	size_t i, n;
+	unsigned char *r;
+	if (shll_sparse(*h)) {
+		if (s[2] == SHLL_SPARSE && shll_merge_sparse(h, src, p))
+			return S_TRUE;
+		RETURN_IF(!shll_to_dense(h, p), S_FALSE);
+	}
+	r = (unsigned char *)sv_get_buffer(*h) + SHLL_HDR;
+	if (s[2] == SHLL_SPARSE) {
+		n = S_LD_LE_U32(s + 4);
+		for (i = 0; i < n; i++)
+			shll_reg_sp(r, p, S_LD_LE_U32(s + SHLL_HDR + i * 4));
+	} else {
+		for (i = 0; i < m; i++)
+			shll_reg_max(r, i, s[SHLL_HDR + i]);
+	}
+	return S_TRUE;
+}
+
+/*
+ * Serialization
+ */
+
+sv_t *shll_serialize(sv_t **out, const shll_t *h)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	if (!*out)
+		*out = sv_alloc_t(SV_U8, 0);
+	/* BEHAVIOR: only SV_U8 output is allowed */
+	RETURN_IF(!*out || (*out)->d.sub_type != SV_U8 || *out == h, *out);
+	sv_clear(*out);
+	const size_t ss = shll_p(h) ? sv_size(h) : 0;
+	RETURN_IF(!ss || sv_reserve(out, ss) < ss, *out);
+	memcpy(sv_get_buffer(*out), sv_get_buffer_r(h), ss);
+	sv_set_size(*out, ss);
+	return *out;
+}
+
+shll_t *shll_deserialize(shll_t **out, const sv_t *in)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const unsigned p = in && in->d.sub_type == SV_U8 ? shll_p(in) : 0;
+	const unsigned char *b = (const unsigned char *)sv_get_buffer_r(in);
+	size_t i, n = p ? S_LD_LE_U32(b + 4) : 0;
+	uint32_t e, prev = 0;
+	sbool_t ok = p != 0;
+	shll_t *r;
+	if (ok && b[2] == SHLL_SPARSE) { /* sorted, unique, values 1 to 40 */
+		ok = n * 4 <= (size_t)1 << p;
+		for (i = 0; ok && i < n; prev = e, i++) {
+			e = S_LD_LE_U32(b + SHLL_HDR + i * 4);
+			ok = (e & 63) && (e & 63) <= SHLL_SQ + 1 &&
+			     (!i || (e >> 6) > (prev >> 6));
+		}
+	} else if (ok) {
+		n = (size_t)1 << p;
+		for (i = 0; ok && i < n; i++)
+			ok = b[SHLL_HDR + i] <= 65 - p;
+	}
+	/* BEHAVIOR: invalid input: empty sketch */
+	r = ok ? shll_new(p, sv_size(in)) : shll_alloc(SHLL_P_DEFAULT);
+	if (ok && (sd_t *)r != sd_void)
+		memcpy(sv_get_buffer(r), b, sv_size(in));
+	return shll_replace(out, r);
+}
@@ -0,0 +1,126 @@
+#ifndef SHLL_H
+#define SHLL_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * shll.h
+ *
+ * #SHORTDOC HyperLogLog sketch (approximate distinct count)
+ *
+ * #DOC Cardinality estimation in fixed memory: 2^p one-byte registers
+ * #DOC (e.g. p = 14: 16KB, ~0.8% standard error), for any number of
+ * #DOC elements. Each element is hashed (64-bit), the top p bits select a
+ * #DOC register, and the register keeps the maximum position of the lowest
+ * #DOC bit set to 1 of the rest of the hash. Adding the same element again
+ * #DOC has no effect, and sketches can be merged (union).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Sparse representation for small cardinalities: sorted list of 4-byte
+ *   entries at 25-bit index precision, so a sketch with few elements takes
+ *   few bytes and the estimate is near-exact. It switches to the dense
+ *   representation once it would take more space than it
+ * - Estimator without empirical bias tables (O. Ertl's "improved raw
+ *   estimator"), valid over the whole cardinality range
+ * - String (ss_t), integer, and raw buffer keys (same hash functions as
+ *   sbf_t)
+ * - Serializable: the sketch is stored in a portable (little-endian)
+ *   format, validated on load
+ *
+ * Format (bytes):
+ * - Header (8 bytes): version, precision (p), representation (0: sparse,
+ *   1: dense), zero byte, sparse entry count (32-bit, little-endian)
+ * - Sparse: entries (32-bit, little-endian), in increasing order: 25-bit
+ *   register index << 6 | register value (1 to 40)
+ * - Dense: 2^p registers (one byte each, 0 to 65 - p)
+ */
+
+#include "svector.h"
+#include "sstring.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t shll_t;	/* "Hidden" structure (accessors are provided) */
+			/* (registers are stored in a vector) */
+
+#define SHLL_P_MIN	4
+#define SHLL_P_MAX	18
+#define SHLL_P_DEFAULT	14
+
+/*
+ * Allocation
+ */
+
+#define shll_free	sv_free
+#define shll_dup	sv_dup
+
+/*
+#API: |Free one or more HyperLogLog sketches|sketch; more sketches (optional)|-|O(1)|1;2|
+void shll_free(shll_t **h, ...)
+
+#API: |Duplicate HyperLogLog sketch|sketch|output sketch|O(n)|1;2|
+shll_t *shll_dup(const shll_t *src)
+*/
+
+/* #API: |Allocate HyperLogLog sketch (heap)|precision: 2^p registers (SHLL_P_MIN to SHLL_P_MAX; standard error: 1.04 / sqrt(2^p))|sketch|O(1)|1;2| */
+shll_t *shll_alloc(const unsigned p);
+
+/* #API: |Remove all elements (back to sparse representation)|sketch|-|O(1)|1;2| */
+void shll_clear(shll_t *h);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Sketch precision|sketch|p (0 if not valid)|O(1)|1;2| */
+unsigned shll_precision(const shll_t *h);
+
+/* #API: |Check sparse representation|sketch|S_TRUE: sparse, S_FALSE: dense or not valid|O(1)|1;2| */
+sbool_t shll_sparse(const shll_t *h);
+
+/* #API: |Estimated number of distinct elements|sketch|cardinality estimate|O(n)|1;2| */
+uint64_t shll_count(const shll_t *h);
+
+/*
+ * Insert
+ */
+
+/* #API: |Insert raw buffer key|sketch; buffer; buffer size|S_TRUE: OK, S_FALSE: error (NULL or not valid sketch, or not enough memory)|O(1) (dense), O(n) (sparse)|1;2| */
+sbool_t shll_add_raw(shll_t **h, const void *key, const size_t key_size);
+
+/* #API: |Insert string key|sketch; string|S_TRUE: OK, S_FALSE: error (NULL or not valid sketch, or not enough memory)|O(1) (dense), O(n) (sparse)|1;2| */
+sbool_t shll_add_s(shll_t **h, const ss_t *key);
+
+/* #API: |Insert signed integer key|sketch; key|S_TRUE: OK, S_FALSE: error (NULL or not valid sketch, or not enough memory)|O(1) (dense), O(n) (sparse)|1;2| */
+sbool_t shll_add_i(shll_t **h, const int64_t key);
+
+/* #API: |Insert unsigned integer key|sketch; key|S_TRUE: OK, S_FALSE: error (NULL or not valid sketch, or not enough memory)|O(1) (dense), O(n) (sparse)|1;2| */
+sbool_t shll_add_u(shll_t **h, const uint64_t key);
+
+/*
+ * Set operations
+ */
+
+/* #API: |Union (add the elements of a sketch with the same precision)|sketch; other sketch|S_TRUE: OK, S_FALSE: different precision (sketch not modified)|O(n)|1;2| */
+sbool_t shll_merge(shll_t **h, const shll_t *src);
+
+/*
+ * Serialization
+ */
+
+/* #API: |Serialize sketch|output vector (allocated if NULL, otherwise overwritten; it must be a SV_U8 vector); sketch|output vector reference|O(n)|1;2| */
+sv_t *shll_serialize(sv_t **out, const shll_t *h);
+
+/* #API: |Load serialized sketch (empty sketch with SHLL_P_DEFAULT precision if the input is not valid)|output sketch (allocated if NULL, otherwise replaced); serialized input (SV_U8 vector)|output sketch reference|O(n)|1;2| */
+shll_t *shll_deserialize(shll_t **out, const sv_t *in);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SHLL_H */
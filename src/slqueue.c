@@ -0,0 +1,366 @@
+/*
+ * slqueue.c
+ *
+ * Bounded lock-free queues (SPSC and MPMC).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "slqueue.h"
+#include "saux/scommon.h"
+
+/*
+ * Atomic operations
+ */
+
+#if !defined(S_MINIMAL) && !defined(S_NO_THREADS) && defined(__ATOMIC_ACQUIRE)
+	#define SLQ_ATOMIC_GNUC
+#elif !defined(S_MINIMAL) && !defined(S_NO_THREADS) && defined(_MSC_VER)
+	#define SLQ_ATOMIC_MSVC
+	#include <windows.h>
+	#include <intrin.h>
+	#if defined(_M_IX86) || defined(_M_X64)
+		#define SLQ_FENCE _ReadWriteBarrier()	/* TSO: compiler only */
+	#else
+		#define SLQ_FENCE MemoryBarrier()
+	#endif
+#endif
+
+S_INLINE size_t slq_ld_acq(volatile size_t *p)
+{
+#if defined(SLQ_ATOMIC_GNUC)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#elif defined(SLQ_ATOMIC_MSVC)
+	size_t v = *p;
+	SLQ_FENCE;
+	return v;
+#else
+	return *p;
+#endif
+}
+
+S_INLINE size_t slq_ld_rlx(volatile size_t *p)
+{
+#if defined(SLQ_ATOMIC_GNUC)
+	return __atomic_load_n(p, __ATOMIC_RELAXED);
+#else
+	return *p;
+#endif
+}
+
+S_INLINE void slq_st_rel(volatile size_t *p, const size_t v)
+{
+#if defined(SLQ_ATOMIC_GNUC)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#elif defined(SLQ_ATOMIC_MSVC)
+	SLQ_FENCE;
+	*p = v;
+#else
+	*p = v;
+#endif
+}
+
+/* Compare and swap (on failure, the current value is stored in *e) */
+S_INLINE sbool_t slq_cas(volatile size_t *p, size_t *e, const size_t d)
+{
+#if defined(SLQ_ATOMIC_GNUC)
+	return __atomic_compare_exchange_n(p, e, d, 1, __ATOMIC_RELAXED,
+					   __ATOMIC_RELAXED) ? S_TRUE : S_FALSE;
+#else
+	size_t prev;
+	#if defined(SLQ_ATOMIC_MSVC) && defined(_WIN64)
+	prev = (size_t)InterlockedCompareExchange64((volatile LONG64 *)p,
+						    (LONG64)d, (LONG64)*e);
+	#elif defined(SLQ_ATOMIC_MSVC)
+	prev = (size_t)InterlockedCompareExchange((volatile LONG *)p,
+						  (LONG)d, (LONG)*e);
+	#else
+	prev = *p;
+	if (prev == *e)
+		*p = d;
+	#endif
+	if (prev == *e)
+		return S_TRUE;
+	*e = prev;
+	return S_FALSE;
+#endif
+}
+
+/*
+ * Structures
+ */
+
+#define SLQ_CL	64	/* cache line size */
+
+struct SLQueue
+{
+	size_t mode, elem_size, slot_size, mask, heap;
+	sv_t *slots;
+	char *data;
+	char pad0[SLQ_CL];
+	volatile size_t head;	/* consumer index */
+	size_t tail_cache;	/* consumer copy of the tail (SPSC) */
+	char pad1[SLQ_CL - 2 * sizeof(size_t)];
+	volatile size_t tail;	/* producer index */
+	size_t head_cache;	/* producer copy of the head (SPSC) */
+	char pad2[SLQ_CL - 2 * sizeof(size_t)];
+};
+
+/*
+ * Internal functions
+ */
+
+/* Capacity rounded up to a power of two (0 on overflow) */
+static size_t slq_cap(const size_t capacity)
+{
+	size_t c = 2;
+	for (; c < capacity; c <<= 1)
+		if (c > ((size_t)-1 >> 2))
+			return 0;
+	return c;
+}
+
+/* MPMC slots: sequence number, plus the element (size_t aligned) */
+static size_t slq_slot_size(const enum eSLQ_Mode mode, const size_t es)
+{
+	const size_t a = sizeof(size_t);
+	return mode == SLQ_MPMC ? a + (es + a - 1) / a * a : es;
+}
+
+S_INLINE char *slq_slot(const slq_t *q, const size_t i)
+{
+	return q->data + (i & q->mask) * q->slot_size;
+}
+
+S_INLINE volatile size_t *slq_seq(const slq_t *q, const size_t i)
+{
+	return (volatile size_t *)slq_slot(q, i);
+}
+
+/* Copy n elements from/to the ring, starting at index i (SPSC) */
+static void slq_copy_in(slq_t *q, const size_t i, const char *e,
+			const size_t n)
+{
+	const size_t es = q->elem_size, o = i & q->mask,
+		     n1 = S_MIN(n, q->mask + 1 - o);
+	memcpy(q->data + o * es, e, n1 * es);
+	if (n > n1)
+		memcpy(q->data, e + n1 * es, (n - n1) * es);
+}
+
+static void slq_copy_out(const slq_t *q, const size_t i, char *e,
+			 const size_t n)
+{
+	const size_t es = q->elem_size, o = i & q->mask,
+		     n1 = S_MIN(n, q->mask + 1 - o);
+	memcpy(e, q->data + o * es, n1 * es);
+	if (n > n1)
+		memcpy(e + n1 * es, q->data, (n - n1) * es);
+}
+
+/*
+ * SPSC: only the producer writes the tail, only the consumer the head.
+ * The opposite index is re-read only when the cached copy is not enough.
+ */
+
+static size_t slq_spsc_push_n(slq_t *q, const char *e, const size_t n)
+{
+	const size_t t = slq_ld_rlx(&q->tail), cap = q->mask + 1;
+	size_t room = cap - (t - q->head_cache);
+	if (room < n) {
+		q->head_cache = slq_ld_acq(&q->head);
+		room = cap - (t - q->head_cache);
+	}
+	const size_t k = S_MIN(n, room);
+	if (k > 0) {
+		slq_copy_in(q, t, e, k);
+		slq_st_rel(&q->tail, t + k);
+	}
+	return k;
+}
+
+static size_t slq_spsc_pop_n(slq_t *q, char *e, const size_t n)
+{
+	const size_t h = slq_ld_rlx(&q->head);
+	size_t avail = q->tail_cache - h;
+	if (avail < n) {
+		q->tail_cache = slq_ld_acq(&q->tail);
+		avail = q->tail_cache - h;
+	}
+	const size_t k = S_MIN(n, avail);
+	if (k > 0) {
+		slq_copy_out(q, h, e, k);
+		slq_st_rel(&q->head, h + k);
+	}
+	return k;
+}
+
+/*
+ * MPMC: slot i is free for the producer of position p when its sequence
+ * is p, and ready for the consumer when it is p + 1. A batch claims the
+ * run of consecutive slots in the expected state with a single CAS on the
+ * shared index.
+ */
+
+static size_t slq_mpmc_claim(slq_t *q, volatile size_t *idx, const size_t n,
+			     const size_t off, size_t *pos)
+{
+	const size_t nmax = S_MIN(n, q->mask + 1);
+	size_t k, p = slq_ld_rlx(idx);
+	for (;;) {
+		for (k = 0; k < nmax; k++)
+			if (slq_ld_acq(slq_seq(q, p + k)) != p + k + off)
+				break;
+		if (k == 0) {
+			const size_t s = slq_ld_acq(slq_seq(q, p));
+			if ((ptrdiff_t)(s - (p + off)) < 0)
+				return 0;	/* full (push) or empty (pop) */
+			p = slq_ld_rlx(idx);	/* stale position */
+			continue;
+		}
+		if (slq_cas(idx, &p, p + k))
+			break;
+	}
+	*pos = p;
+	return k;
+}
+
+static size_t slq_mpmc_push_n(slq_t *q, const char *e, const size_t n)
+{
+	size_t i, p = 0, k = slq_mpmc_claim(q, &q->tail, n, 0, &p);
+	for (i = 0; i < k; i++) {
+		memcpy(slq_slot(q, p + i) + sizeof(size_t),
+		       e + i * q->elem_size, q->elem_size);
+		slq_st_rel(slq_seq(q, p + i), p + i + 1);
+	}
+	return k;
+}
+
+static size_t slq_mpmc_pop_n(slq_t *q, char *e, const size_t n)
+{
+	size_t i, p = 0, k = slq_mpmc_claim(q, &q->head, n, 1, &p);
+	for (i = 0; i < k; i++) {
+		memcpy(e + i * q->elem_size,
+		       slq_slot(q, p + i) + sizeof(size_t), q->elem_size);
+		slq_st_rel(slq_seq(q, p + i), p + i + q->mask + 1);
+	}
+	return k;
+}
+
+/*
+ * Allocation
+ */
+
+size_t slq_alloc_size(const enum eSLQ_Mode mode, const size_t elem_size,
+		      const size_t capacity)
+{
+	const size_t cap = slq_cap(capacity),
+		     ss = slq_slot_size(mode, elem_size);
+	RETURN_IF(!elem_size || !cap || ss < elem_size, 0);
+	RETURN_IF(cap > ((size_t)-1 - sizeof(struct SLQueue) -
+			 sizeof(sv_t)) / ss, 0);
+	return sizeof(struct SLQueue) +
+	       sd_alloc_size_raw(sizeof(sv_t), ss, cap, S_FALSE);
+}
+
+slq_t *slq_alloc_raw(const enum eSLQ_Mode mode, void *buffer,
+		     const size_t elem_size, const size_t capacity)
+{
+	RETURN_IF(!buffer || (uintptr_t)buffer % sizeof(size_t), NULL);
+	RETURN_IF(!slq_alloc_size(mode, elem_size, capacity), NULL);
+	RETURN_IF(mode != SLQ_SPSC && mode != SLQ_MPMC, NULL);
+	const size_t cap = slq_cap(capacity),
+		     ss = slq_slot_size(mode, elem_size);
+	slq_t *q = (slq_t *)buffer;
+	size_t i;
+	memset(q, 0, sizeof(struct SLQueue));
+	q->mode = mode;
+	q->elem_size = elem_size;
+	q->slot_size = ss;
+	q->mask = cap - 1;
+	q->slots = sv_alloc_raw(SV_GEN, S_TRUE, (char *)buffer +
+				sizeof(struct SLQueue), ss, cap, NULL);
+	sv_set_size(q->slots, cap);
+	q->data = sv_get_buffer(q->slots);
+	if (mode == SLQ_MPMC)
+		for (i = 0; i < cap; i++)
+			*slq_seq(q, i) = i;
+	return q;
+}
+
+slq_t *slq_alloc(const enum eSLQ_Mode mode, const size_t elem_size,
+		 const size_t capacity)
+{
+	const size_t as = slq_alloc_size(mode, elem_size, capacity);
+	RETURN_IF(!as, NULL);
+	void *buf = s_malloc(as);
+	slq_t *q = slq_alloc_raw(mode, buf, elem_size, capacity);
+	if (q)
+		q->heap = 1;
+	else if (buf)
+		s_free(buf);
+	return q;
+}
+
+void slq_free(slq_t **q)
+{
+	if (q && *q && (*q)->heap) {
+		s_free(*q);
+		*q = NULL;
+	}
+}
+
+/*
+ * Accessors
+ */
+
+size_t slq_capacity(const slq_t *q)
+{
+	return q ? q->mask + 1 : 0;
+}
+
+size_t slq_size(const slq_t *q)
+{
+	RETURN_IF(!q, 0);
+	slq_t *w = (slq_t *)q;
+	const size_t h = slq_ld_acq(&w->head), t = slq_ld_acq(&w->tail);
+	return (ptrdiff_t)(t - h) <= 0 ? 0 : S_MIN(t - h, q->mask + 1);
+}
+
+sbool_t slq_lock_free(void)
+{
+#if defined(SLQ_ATOMIC_GNUC) || defined(SLQ_ATOMIC_MSVC)
+	return S_TRUE;
+#else
+	return S_FALSE;
+#endif
+}
+
+/*
+ * Enqueue/dequeue
+ */
+
+sbool_t slq_push(slq_t *q, const void *e)
+{
+	return slq_push_n(q, e, 1) == 1 ? S_TRUE : S_FALSE;
+}
+
+sbool_t slq_pop(slq_t *q, void *e)
+{
+	return slq_pop_n(q, e, 1) == 1 ? S_TRUE : S_FALSE;
+}
+
+size_t slq_push_n(slq_t *q, const void *e, const size_t n)
+{
+	RETURN_IF(!q || !e || !n, 0);
+	return q->mode == SLQ_SPSC ? slq_spsc_push_n(q, (const char *)e, n) :
+				     slq_mpmc_push_n(q, (const char *)e, n);
+}
+
+size_t slq_pop_n(slq_t *q, void *e, const size_t n)
+{
+	RETURN_IF(!q || !e || !n, 0);
+	return q->mode == SLQ_SPSC ? slq_spsc_pop_n(q, (char *)e, n) :
+				     slq_mpmc_pop_n(q, (char *)e, n);
+}
@@ -0,0 +1,112 @@
+#ifndef SLQUEUE_H
+#define SLQUEUE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * slqueue.h
+ *
+ * #SHORTDOC bounded lock-free queue (SPSC and MPMC)
+ *
+ * #DOC Fixed-capacity FIFO queues for passing elements between threads
+ * #DOC without locks: single-producer/single-consumer (SPSC), and
+ * #DOC multiple-producer/multiple-consumer (MPMC). Elements are copied in
+ * #DOC and out by value (any size), so e.g. container pointers (sv_t *,
+ * #DOC ss_t *, etc.) can be handed over from one thread to another.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Single memory block: queue indexes plus an external-buffer vector
+ *   (sv_alloc_raw) as slot storage. It can be placed in a caller buffer
+ *   (static, stack, shared memory), so no allocation is done after
+ *   creation
+ * - Producer and consumer indexes are in separate cache lines (no false
+ *   sharing between producer and consumer)
+ * - SPSC: wait-free, with cached copies of the opposite index (the shared
+ *   index is read only when the cached one says full/empty)
+ * - MPMC: lock-free, per-slot sequence numbers (D. Vyukov's bounded queue)
+ * - Batch enqueue/dequeue: one index update per batch (SPSC and MPMC)
+ * - Capacity is rounded up to a power of two (minimum 2)
+ *
+ * Observations:
+ * - Atomic operations use the compiler built-ins (gcc >= 4.7, clang) or
+ *   the Interlocked API (Visual Studio). Without them (other compilers,
+ *   or building with S_MINIMAL/S_NO_THREADS), the queues work, but they
+ *   are not thread-safe: slq_lock_free() tells which is the case
+ * - Queue functions, other than the ones allowed by the queue mode, must
+ *   not be called concurrently (e.g. two slq_pop() in SPSC mode)
+ * - Push/pop never block: when spin-waiting on a full/empty queue, call
+ *   s_yield() (saux/sthread.h), so it works also with fewer CPUs than
+ *   threads
+ */
+
+#include "svector.h"
+
+/*
+ * Structures
+ */
+
+struct SLQueue;
+typedef struct SLQueue slq_t;	/* "Hidden" structure */
+
+enum eSLQ_Mode
+{
+	SLQ_SPSC,	/* single producer, single consumer */
+	SLQ_MPMC	/* multiple producers, multiple consumers */
+};
+
+/*
+ * Allocation
+ */
+
+/* #API: |Buffer size required for a queue|queue mode; element size; capacity (number of elements)|bytes (0 if invalid)|O(1)|1;2| */
+size_t slq_alloc_size(const enum eSLQ_Mode mode, const size_t elem_size,
+		      const size_t capacity);
+
+/* #API: |Create queue in a caller-provided buffer (not freed by slq_free)|queue mode; buffer (at least slq_alloc_size() bytes, aligned for size_t); element size; capacity (number of elements)|queue (NULL if invalid)|O(n)|1;2| */
+slq_t *slq_alloc_raw(const enum eSLQ_Mode mode, void *buffer,
+		     const size_t elem_size, const size_t capacity);
+
+/* #API: |Allocate queue (heap)|queue mode; element size; capacity (number of elements)|queue (NULL on error)|O(n)|1;2| */
+slq_t *slq_alloc(const enum eSLQ_Mode mode, const size_t elem_size,
+		 const size_t capacity);
+
+/* #API: |Free queue (no-op for queues created with slq_alloc_raw())|queue|-|O(1)|1;2| */
+void slq_free(slq_t **q);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Queue capacity|queue|maximum number of elements|O(1)|1;2| */
+size_t slq_capacity(const slq_t *q);
+
+/* #API: |Number of elements (approximate if there are concurrent operations)|queue|number of elements|O(1)|1;2| */
+size_t slq_size(const slq_t *q);
+
+/* #API: |Check if queue operations are thread-safe in this build|-|S_TRUE: lock-free atomic operations available; S_FALSE: single-thread only|O(1)|1;2| */
+sbool_t slq_lock_free(void);
+
+/*
+ * Enqueue/dequeue
+ */
+
+/* #API: |Enqueue element|queue; element reference|S_TRUE: OK, S_FALSE: queue full|O(1)|1;2| */
+sbool_t slq_push(slq_t *q, const void *e);
+
+/* #API: |Dequeue element|queue; element output|S_TRUE: OK, S_FALSE: queue empty|O(1)|1;2| */
+sbool_t slq_pop(slq_t *q, void *e);
+
+/* #API: |Enqueue up to n elements (in order, as one batch)|queue; element array; number of elements|number of elements enqueued|O(n)|1;2| */
+size_t slq_push_n(slq_t *q, const void *e, const size_t n);
+
+/* #API: |Dequeue up to n elements (in order, as one batch)|queue; output element array; maximum number of elements|number of elements dequeued|O(n)|1;2| */
+size_t slq_pop_n(slq_t *q, void *e, const size_t n);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SLQUEUE_H */
@@ -0,0 +1,268 @@
+/*
+ * spqueue.c
+ *
+ * Priority queue (d-ary heap).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "spqueue.h"
+#include "saux/scommon.h"
+
+/*
+ * Constants
+ */
+
+#define spq_void (spq_t *)sd_void
+
+#define SPQ_D		4	/* heap arity */
+#define SPQ_F_MAX	1	/* vx.cnt flags (bits 8-15: key type) */
+#define SPQ_F_SIGNED	2
+#define SPQ_F_PAYLOAD	4
+
+#define SPQ_SIGN_BIT	((uint64_t)1 << 63)
+
+/*
+ * Internal functions
+ */
+
+S_INLINE size_t spq_flags(const spq_t *h)
+{
+	return (size_t)h->vx.cnt;
+}
+
+/* Number of 64-bit words per element: key, payload (optional) */
+S_INLINE size_t spq_w(const spq_t *h)
+{
+	return (spq_flags(h) & SPQ_F_PAYLOAD) ? 2 : 1;
+}
+
+/* Key to order key (and vice versa): the heap is always a min-heap */
+S_INLINE uint64_t spq_mask(const spq_t *h)
+{
+	const size_t f = spq_flags(h);
+	return ((f & SPQ_F_SIGNED) ? SPQ_SIGN_BIT : 0) ^
+	       ((f & SPQ_F_MAX) ? ~(uint64_t)0 : 0);
+}
+
+S_INLINE uint64_t *spq_data(spq_t *h)
+{
+	return (uint64_t *)sv_get_buffer(h);
+}
+
+S_INLINE const uint64_t *spq_data_r(const spq_t *h)
+{
+	return (const uint64_t *)sv_get_buffer_r(h);
+}
+
+#define SPQ_BUILD_SIFT(W)						\
+	static void spq_sift_up##W(uint64_t *a, size_t i)		\
+	{								\
+		const uint64_t k = a[i * W], p = a[i * W + W - 1];	\
+		while (i > 0) {						\
+			const size_t j = (i - 1) / SPQ_D;		\
+			if (a[j * W] <= k)				\
+				break;					\
+			a[i * W] = a[j * W];				\
+			a[i * W + W - 1] = a[j * W + W - 1];		\
+			i = j;						\
+		}							\
+		a[i * W] = k;						\
+		a[i * W + W - 1] = p;					\
+	}								\
+	static void spq_sift_down##W(uint64_t *a, size_t i,		\
+				     const size_t n)			\
+	{								\
+		const uint64_t k = a[i * W], p = a[i * W + W - 1];	\
+		size_t c, m, e;						\
+		for (;;) {						\
+			c = i * SPQ_D + 1;				\
+			if (c >= n)					\
+				break;					\
+			e = S_MIN(c + SPQ_D, n);			\
+			for (m = c++; c < e; c++)			\
+				if (a[c * W] < a[m * W])		\
+					m = c;				\
+			if (k <= a[m * W])				\
+				break;					\
+			a[i * W] = a[m * W];				\
+			a[i * W + W - 1] = a[m * W + W - 1];		\
+			i = m;						\
+		}							\
+		a[i * W] = k;						\
+		a[i * W + W - 1] = p;					\
+	}
+
+SPQ_BUILD_SIFT(1)
+SPQ_BUILD_SIFT(2)
+
+static void spq_sift_up(spq_t *h, const size_t i)
+{
+	if (spq_w(h) == 1)
+		spq_sift_up1(spq_data(h), i);
+	else
+		spq_sift_up2(spq_data(h), i);
+}
+
+static void spq_sift_down(spq_t *h, const size_t i, const size_t n)
+{
+	if (spq_w(h) == 1)
+		spq_sift_down1(spq_data(h), i, n);
+	else
+		spq_sift_down2(spq_data(h), i, n);
+}
+
+static sbool_t spq_push(spq_t **h, const uint64_t key, const uint64_t payload)
+{
+	RETURN_IF(!h || !*h || sv_grow(h, 1) < 1, S_FALSE);
+	const size_t n = sv_size(*h), w = spq_w(*h);
+	uint64_t *a = spq_data(*h);
+	a[n * w] = key ^ spq_mask(*h);
+	if (w > 1)
+		a[n * w + 1] = payload;
+	sv_set_size(*h, n + 1);
+	spq_sift_up(*h, n);
+	return S_TRUE;
+}
+
+static sbool_t spq_top(const spq_t *h, uint64_t *key, uint64_t *payload)
+{
+	RETURN_IF(!sv_size(h), S_FALSE);
+	const uint64_t *a = spq_data_r(h);
+	if (key)
+		*key = a[0] ^ spq_mask(h);
+	if (payload)
+		*payload = spq_w(h) > 1 ? a[1] : 0;
+	return S_TRUE;
+}
+
+static sbool_t spq_pop(spq_t *h, uint64_t *key, uint64_t *payload)
+{
+	RETURN_IF(!spq_top(h, key, payload), S_FALSE);
+	const size_t n = sv_size(h) - 1, w = spq_w(h);
+	if (n > 0) {
+		uint64_t *a = spq_data(h);
+		a[0] = a[n * w];
+		a[w - 1] = a[n * w + w - 1];
+		spq_sift_down(h, 0, n);
+	}
+	sv_set_size(h, n);
+	return S_TRUE;
+}
+
+/*
+ * Allocation
+ */
+
+spq_t *spq_alloc_raw(const enum eSV_Type key_type, const enum eSPQ_Order order,
+		     const sbool_t payload, const sbool_t ext_buf,
+		     void *buffer, const size_t max_size)
+{
+	RETURN_IF(!buffer || key_type > SV_LAST_INT, spq_void);
+	spq_t *h = sv_alloc_raw(SV_GEN, ext_buf, buffer,
+				SPQ_ELEM_SIZE(payload), max_size, NULL);
+	h->vx.cnt = (size_t)key_type << 8 |
+		    (order == SPQ_MAX ? SPQ_F_MAX : 0) |
+		    (!(key_type & 1) ? SPQ_F_SIGNED : 0) |
+		    (payload ? SPQ_F_PAYLOAD : 0);
+	return h;
+}
+
+spq_t *spq_alloc(const enum eSV_Type key_type, const enum eSPQ_Order order,
+		 const sbool_t payload,
+		 const size_t initial_num_elems_reserve)
+{
+	return spq_alloc_raw(key_type, order, payload, S_FALSE,
+			     s_malloc(spq_alloc_size(payload,
+						     initial_num_elems_reserve)),
+			     initial_num_elems_reserve);
+}
+
+spq_t *spq_dup(const spq_t *src)
+{
+	RETURN_IF(!src || src == spq_void, spq_void);
+	const size_t f = spq_flags(src), n = sv_size(src);
+	spq_t *h = spq_alloc((enum eSV_Type)(f >> 8),
+			     (f & SPQ_F_MAX) ? SPQ_MAX : SPQ_MIN,
+			     (f & SPQ_F_PAYLOAD) ? S_TRUE : S_FALSE, n);
+	if (h != spq_void) {
+		memcpy(spq_data(h), spq_data_r(src), n * src->d.elem_size);
+		sv_set_size(h, n);
+	}
+	return h;
+}
+
+/*
+ * Accessors
+ */
+
+sbool_t spq_top_i(const spq_t *h, int64_t *key, uint64_t *payload)
+{
+	uint64_t k = 0;
+	sbool_t r = spq_top(h, &k, payload);
+	if (key)
+		*key = (int64_t)k;
+	return r;
+}
+
+sbool_t spq_top_u(const spq_t *h, uint64_t *key, uint64_t *payload)
+{
+	return spq_top(h, key, payload);
+}
+
+/*
+ * Insertion/removal
+ */
+
+sbool_t spq_push_i(spq_t **h, const int64_t key, const uint64_t payload)
+{
+	return spq_push(h, (uint64_t)key, payload);
+}
+
+sbool_t spq_push_u(spq_t **h, const uint64_t key, const uint64_t payload)
+{
+	return spq_push(h, key, payload);
+}
+
+sbool_t spq_pop_i(spq_t *h, int64_t *key, uint64_t *payload)
+{
+	uint64_t k = 0;
+	sbool_t r = spq_pop(h, &k, payload);
+	if (key)
+		*key = (int64_t)k;
+	return r;
+}
+
+sbool_t spq_pop_u(spq_t *h, uint64_t *key, uint64_t *payload)
+{
+	return spq_pop(h, key, payload);
+}
+
+sbool_t spq_heapify(spq_t **h, const sv_t *keys, const sv_t *payloads)
+{
+	RETURN_IF(!h || !*h || !keys || keys->d.sub_type > SV_LAST_INT,
+		  S_FALSE);
+	RETURN_IF(payloads && payloads->d.sub_type > SV_LAST_INT, S_FALSE);
+	const size_t n0 = sv_size(*h), nk = sv_size(keys),
+		     np = sv_size(payloads);
+	RETURN_IF(sv_grow(h, nk) < nk, S_FALSE);
+	const size_t w = spq_w(*h), n = n0 + nk;
+	const sbool_t ks = !(keys->d.sub_type & 1);
+	const uint64_t mask = spq_mask(*h);
+	uint64_t *a = spq_data(*h);
+	size_t i;
+	for (i = 0; i < nk; i++) {
+		a[(n0 + i) * w] = (ks ? (uint64_t)sv_at_i(keys, i) :
+				   sv_at_u(keys, i)) ^ mask;
+		if (w > 1)
+			a[(n0 + i) * w + 1] = i < np ? sv_at_u(payloads, i) :
+						       0;
+	}
+	sv_set_size(*h, n);
+	/* Floyd's heap construction: sift down from the last parent */
+	if (n > 1)
+		for (i = (n - 2) / SPQ_D + 1; i-- > 0;)
+			spq_sift_down(*h, i, n);
+	return S_TRUE;
+}
@@ -0,0 +1,145 @@
+#ifndef SPQUEUE_H
+#define SPQUEUE_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * spqueue.h
+ *
+ * #SHORTDOC priority queue (d-ary heap)
+ *
+ * #DOC Priority queue with integer keys and optional 64-bit payload,
+ * #DOC implemented as an implicit 4-ary heap stored in a vector (single
+ * #DOC memory block). Both min-heap (smallest key first) and max-heap
+ * #DOC (largest key first) are supported.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - O(log n) insertion and removal, O(1) access to the top element
+ * - 4-ary layout: half the tree height of a binary heap, and the four
+ *   children of a node are contiguous in memory (fewer cache misses on
+ *   removal)
+ * - O(n) bulk build from existing vectors (Floyd's heapify)
+ * - Signed or unsigned keys (key type from the sv_t integer types); the
+ *   payload can be used for storing ids, indexes, or pointers
+ * - Heap allocation (dynamic size), or fixed-capacity stack/external
+ *   buffer allocation (no memory allocation after creation, for real-time
+ *   usage)
+ *
+ * Internals: keys are stored as 64-bit "order keys" (sign bit flipped for
+ * signed keys, all bits flipped for max-heap), so the heap is always an
+ * unsigned min-heap, without branches on the heap mode.
+ */
+
+#include "svector.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t spq_t;	/* "Hidden" structure (accessors are provided) */
+			/* (heap stored in a vector, heap mode in vx.cnt) */
+
+enum eSPQ_Order
+{
+	SPQ_MIN,	/* smallest key at the top */
+	SPQ_MAX		/* largest key at the top */
+};
+
+/*
+ * Allocation
+ */
+
+#define SPQ_ELEM_SIZE(payload)	((payload) ? 16 : 8)
+#define spq_alloc_size(payload, max_size)				\
+	sd_alloc_size_raw(sizeof(sv_t), SPQ_ELEM_SIZE(payload),		\
+			  max_size, S_FALSE)
+#define spq_alloca(key_type, order, payload, max_size)			\
+	spq_alloc_raw(key_type, order, payload, S_TRUE,			\
+		      alloca(spq_alloc_size(payload, max_size)), max_size)
+#define spq_free	sv_free
+
+/*
+#API: |Allocate priority queue (stack, fixed capacity)|key type (SV_I8 ... SV_U64); SPQ_MIN/SPQ_MAX; S_TRUE: store payload; maximum number of elements|priority queue|O(1)|1;2|
+spq_t *spq_alloca(const enum eSV_Type key_type, const enum eSPQ_Order order, const sbool_t payload, const size_t max_size)
+
+#API: |Buffer size required for a fixed-capacity priority queue|S_TRUE: store payload; maximum number of elements|bytes|O(1)|1;2|
+size_t spq_alloc_size(const sbool_t payload, const size_t max_size)
+
+#API: |Free one or more priority queues (heap)|priority queue; more priority queues (optional)|-|O(1)|1;2|
+void spq_free(spq_t **h, ...)
+*/
+
+/* #API: |Allocate priority queue using external buffer (fixed capacity if ext_buf is S_TRUE)|key type (SV_I8 ... SV_U64); SPQ_MIN/SPQ_MAX; S_TRUE: store payload; external buffer flag; buffer (at least spq_alloc_size() bytes); maximum number of elements|priority queue|O(1)|1;2| */
+spq_t *spq_alloc_raw(const enum eSV_Type key_type, const enum eSPQ_Order order,
+		     const sbool_t payload, const sbool_t ext_buf,
+		     void *buffer, const size_t max_size);
+
+/* #API: |Allocate priority queue (heap)|key type (SV_I8 ... SV_U64); SPQ_MIN/SPQ_MAX; S_TRUE: store payload; space preallocated to store n elements|priority queue|O(1)|1;2| */
+spq_t *spq_alloc(const enum eSV_Type key_type, const enum eSPQ_Order order,
+		 const sbool_t payload,
+		 const size_t initial_num_elems_reserve);
+
+/* #API: |Duplicate priority queue|priority queue|output priority queue (heap)|O(n)|1;2| */
+spq_t *spq_dup(const spq_t *src);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Number of elements|priority queue|number of elements|O(1)|1;2| */
+S_INLINE size_t spq_size(const spq_t *h)
+{
+	return sv_size(h);
+}
+
+/* #API: |Allocated space|priority queue|current allocated space (number of elements)|O(1)|1;2| */
+S_INLINE size_t spq_capacity(const spq_t *h)
+{
+	return sv_capacity(h);
+}
+
+/* #API: |Check if the priority queue is empty|priority queue|S_TRUE: empty; S_FALSE: not empty|O(1)|1;2| */
+S_INLINE sbool_t spq_empty(const spq_t *h)
+{
+	return sv_size(h) == 0 ? S_TRUE : S_FALSE;
+}
+
+/* #API: |Reset priority queue (remove all elements)|priority queue|-|O(1)|1;2| */
+S_INLINE void spq_clear(spq_t *h)
+{
+	sv_set_size(h, 0);
+}
+
+/* #API: |Top element (signed key)|priority queue; key output; payload output (optional: NULL)|S_TRUE: OK, S_FALSE: empty priority queue|O(1)|1;2| */
+sbool_t spq_top_i(const spq_t *h, int64_t *key, uint64_t *payload);
+
+/* #API: |Top element (unsigned key)|priority queue; key output; payload output (optional: NULL)|S_TRUE: OK, S_FALSE: empty priority queue|O(1)|1;2| */
+sbool_t spq_top_u(const spq_t *h, uint64_t *key, uint64_t *payload);
+
+/*
+ * Insertion/removal
+ */
+
+/* #API: |Insert element (signed key)|priority queue; key; payload (ignored if the queue has no payload)|S_TRUE: OK, S_FALSE: error (e.g. full fixed-capacity queue)|O(log n)|1;2| */
+sbool_t spq_push_i(spq_t **h, const int64_t key, const uint64_t payload);
+
+/* #API: |Insert element (unsigned key)|priority queue; key; payload (ignored if the queue has no payload)|S_TRUE: OK, S_FALSE: error (e.g. full fixed-capacity queue)|O(log n)|1;2| */
+sbool_t spq_push_u(spq_t **h, const uint64_t key, const uint64_t payload);
+
+/* #API: |Remove top element (signed key)|priority queue; key output (optional: NULL); payload output (optional: NULL)|S_TRUE: OK, S_FALSE: empty priority queue|O(log n)|1;2| */
+sbool_t spq_pop_i(spq_t *h, int64_t *key, uint64_t *payload);
+
+/* #API: |Remove top element (unsigned key)|priority queue; key output (optional: NULL); payload output (optional: NULL)|S_TRUE: OK, S_FALSE: empty priority queue|O(log n)|1;2| */
+sbool_t spq_pop_u(spq_t *h, uint64_t *key, uint64_t *payload);
+
+/* #API: |Insert all elements from vectors, rebuilding the heap|priority queue; key vector (integer type); payload vector (integer type, NULL for zero payload; elements beyond its size get zero payload)|S_TRUE: OK, S_FALSE: error|O(n)|1;2| */
+sbool_t spq_heapify(spq_t **h, const sv_t *keys, const sv_t *payloads);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SPQUEUE_H */
@@ -0,0 +1,452 @@
+/*
+ * spvector.c
+ *
+ * Packed (compressed) integer vector.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "spvector.h"
+#include "saux/scommon.h"
+
+/*
+ * Constants
+ */
+
+#define spv_void (spv_t *)sd_void
+
+#define SPV_VERSION	1
+#define SPV_BLK		128	/* elements per block */
+#define SPV_HDR		16	/* header size */
+#define SPV_DIR		16	/* block directory entry size */
+#define SPV_PAD		8	/* tail padding (unaligned 64-bit loads) */
+#define SPV_FOR		0	/* frame of reference */
+#define SPV_DELTA	1	/* delta coding */
+
+#define SPV_BIAS(t) (!((t) & 1) ? (uint64_t)1 << 63 : 0)
+
+struct SPVInfo
+{
+	size_t n, nblk, data_size;
+	enum eSV_Type t;
+	int mode;
+	const uint8_t *dir, *data;
+};
+
+/*
+ * Header and block directory
+ */
+
+static sbool_t spv_info(const spv_t *p, struct SPVInfo *h)
+{
+	size_t ps;
+	uint64_t n;
+	const uint8_t *b;
+	RETURN_IF(!p || p->d.sub_type != SV_U8, S_FALSE);
+	ps = sv_size(p);
+	b = (const uint8_t *)sv_get_buffer_r(p);
+	RETURN_IF(ps < SPV_HDR + SPV_PAD || b[0] != SPV_VERSION ||
+		  b[1] > SV_U64 || b[2] > SPV_DELTA, S_FALSE);
+	n = S_LD_LE_U64(b + 8);
+	RETURN_IF(n / SPV_BLK > ps / SPV_DIR, S_FALSE);
+	h->n = (size_t)n;
+	h->nblk = h->n / SPV_BLK + (h->n % SPV_BLK ? 1 : 0);
+	RETURN_IF(SPV_HDR + h->nblk * SPV_DIR + SPV_PAD > ps, S_FALSE);
+	h->t = (enum eSV_Type)b[1];
+	h->mode = b[2];
+	h->dir = b + SPV_HDR;
+	h->data = h->dir + h->nblk * SPV_DIR;
+	h->data_size = ps - SPV_HDR - h->nblk * SPV_DIR - SPV_PAD;
+	return S_TRUE;
+}
+
+static const uint8_t *spv_blk(const struct SPVInfo *h, const size_t i,
+			      uint64_t *base, unsigned *bits)
+{
+	const uint8_t *e = h->dir + i * SPV_DIR;
+	const uint64_t ob = S_LD_LE_U64(e + 8), off = ob >> 8;
+	*base = S_LD_LE_U64(e);
+	*bits = (unsigned)(ob & 0xff);
+	RETURN_IF(*bits > 64 || off > h->data_size ||
+		  h->data_size - off < 16 * (size_t)*bits, NULL);
+	return h->data + off;
+}
+
+/*
+ * Element load/store (64-bit, biased, so signed values keep the order)
+ */
+
+#define SPV_LD_CASE(ST, T, CT)						\
+	case ST:							\
+		for (i = 0; i < n; i++)					\
+			u[i] = (uint64_t)(CT)((const T *)src)[off + i]	\
+			       ^ SPV_BIAS(ST);				\
+		break;
+
+#define SPV_ST_CASE(ST, T)						\
+	case ST:							\
+		for (i = 0; i < n; i++)					\
+			((T *)dst)[off + i] = (T)(u[i] ^ SPV_BIAS(ST));	\
+		break;
+
+static void spv_ld(const void *src, const enum eSV_Type t, const size_t off,
+		   const size_t n, uint64_t *u)
+{
+	size_t i;
+	switch (t) {
+	SPV_LD_CASE(SV_I8, int8_t, int64_t)
+	SPV_LD_CASE(SV_U8, uint8_t, uint64_t)
+	SPV_LD_CASE(SV_I16, int16_t, int64_t)
+	SPV_LD_CASE(SV_U16, uint16_t, uint64_t)
+	SPV_LD_CASE(SV_I32, int32_t, int64_t)
+	SPV_LD_CASE(SV_U32, uint32_t, uint64_t)
+	SPV_LD_CASE(SV_I64, int64_t, int64_t)
+	SPV_LD_CASE(SV_U64, uint64_t, uint64_t)
+	default:
+		break;
+	}
+}
+
+static void spv_st(void *dst, const enum eSV_Type t, const size_t off,
+		   const size_t n, const uint64_t *u)
+{
+	size_t i;
+	switch (t) {
+	SPV_ST_CASE(SV_I8, int8_t)
+	SPV_ST_CASE(SV_U8, uint8_t)
+	SPV_ST_CASE(SV_I16, int16_t)
+	SPV_ST_CASE(SV_U16, uint16_t)
+	SPV_ST_CASE(SV_I32, int32_t)
+	SPV_ST_CASE(SV_U32, uint32_t)
+	SPV_ST_CASE(SV_I64, int64_t)
+	SPV_ST_CASE(SV_U64, uint64_t)
+	default:
+		break;
+	}
+}
+
+/*
+ * Bit packing
+ *
+ * Widths up to 32 bits: 4 lanes (element k goes to lane k % 4), each lane
+ * being a stream of 32-bit words, interleaved so word w of all lanes can be
+ * loaded at once (16 * w bytes offset). Wider widths: little-endian bit
+ * stream (element k at bit k * width).
+ */
+
+static unsigned spv_bits(uint64_t x)
+{
+	unsigned b = 0;
+	for (; x; x >>= 1)
+		b++;
+	return b;
+}
+
+static void spv_pack_blk(uint8_t *o, const uint64_t *v, const unsigned b)
+{
+	size_t k, l, q, w, pos, rem, take;
+	uint64_t acc, x;
+	if (b <= 32) {
+		for (l = 0; l < 4; l++)
+			for (q = w = pos = 0, acc = 0; q < SPV_BLK / 4; q++) {
+				acc |= v[q * 4 + l] << pos;
+				pos += b;
+				if (pos >= 32) {
+					S_ST_LE_U32(o + (w++ * 4 + l) * 4,
+						    (unsigned)acc);
+					acc >>= 32;
+					pos -= 32;
+				}
+			}
+		return;
+	}
+	memset(o, 0, 16 * b);
+	for (k = 0; k < SPV_BLK; k++)
+		for (x = v[k], pos = k * b, rem = b; rem > 0; rem -= take) {
+			take = S_MIN(8 - pos % 8, rem);
+			o[pos / 8] |= (uint8_t)((x & ((1u << take) - 1))
+						<< (pos % 8));
+			x >>= take;
+			pos += take;
+		}
+}
+
+static void spv_unpack_v(const uint8_t *p, const unsigned b, uint32_t *o)
+{
+	const uint32_t m = b == 32 ? 0xffffffff : ((uint32_t)1 << b) - 1;
+#ifdef S_SIMD_SSE2
+	const __m128i mm = _mm_set1_epi32((int)m);
+	__m128i w = _mm_loadu_si128((const __m128i *)p), nx = w, v;
+	unsigned sh = 0, q;
+	p += 16;
+	for (q = 0; q < SPV_BLK / 4; q++) {
+		v = _mm_srl_epi32(w, _mm_cvtsi32_si128((int)sh));
+		if (sh + b >= 32) {
+			if (q < SPV_BLK / 4 - 1) {
+				nx = _mm_loadu_si128((const __m128i *)p);
+				p += 16;
+			}
+			if (sh + b > 32)
+				v = _mm_or_si128(v, _mm_sll_epi32(nx,
+					_mm_cvtsi32_si128((int)(32 - sh))));
+			w = nx;
+			sh = sh + b - 32;
+		} else {
+			sh += b;
+		}
+		_mm_storeu_si128((__m128i *)(o + 4 * q), _mm_and_si128(v, mm));
+	}
+#else
+	size_t l, q, w;
+	unsigned avail;
+	uint64_t acc;
+	for (l = 0; l < 4; l++)
+		for (q = w = 0, acc = 0, avail = 0; q < SPV_BLK / 4; q++) {
+			if (avail < b) {
+				acc |= (uint64_t)S_LD_LE_U32(p + (w++ * 4 + l)
+							     * 4) << avail;
+				avail += 32;
+			}
+			o[q * 4 + l] = (uint32_t)acc & m;
+			acc >>= b;
+			avail -= b;
+		}
+#endif
+}
+
+static uint64_t spv_get1(const uint8_t *p, const unsigned b, const size_t k)
+{
+	size_t pos, w, sh;
+	uint64_t x;
+	RETURN_IF(!b, 0);
+	if (b <= 32) {
+		pos = (k / 4) * b;
+		w = pos / 32;
+		sh = pos % 32;
+		x = S_LD_LE_U32(p + (w * 4 + k % 4) * 4);
+		if (sh + b > 32)
+			x |= (uint64_t)S_LD_LE_U32(p + ((w + 1) * 4 + k % 4)
+						   * 4) << 32;
+		return (x >> sh) & (((uint64_t)1 << b) - 1);
+	}
+	pos = k * b;
+	sh = pos % 8;
+	x = S_LD_LE_U64(p + pos / 8) >> sh;
+	if (sh + b > 64)
+		x |= (uint64_t)p[pos / 8 + 8] << (64 - sh);
+	return b == 64 ? x : x & (((uint64_t)1 << b) - 1);
+}
+
+static void spv_dec_blk(const uint8_t *p, const unsigned b,
+			const uint64_t base, const int mode, uint64_t *v)
+{
+	size_t k;
+	uint64_t acc = base;
+	uint32_t v32[SPV_BLK];
+	if (b > 32) {
+		for (k = 0; k < SPV_BLK; k++)
+			v[k] = spv_get1(p, b, k);
+		if (mode == SPV_DELTA)
+			for (k = 0; k < SPV_BLK; k++)
+				v[k] = acc += v[k];
+		else
+			for (k = 0; k < SPV_BLK; k++)
+				v[k] += base;
+		return;
+	}
+	if (b)
+		spv_unpack_v(p, b, v32);
+	else
+		memset(v32, 0, sizeof(v32));
+	if (mode == SPV_DELTA)
+		for (k = 0; k < SPV_BLK; k++)
+			v[k] = acc += v32[k];
+	else
+		for (k = 0; k < SPV_BLK; k++)
+			v[k] = base + v32[k];
+}
+
+/*
+ * Encoding
+ */
+
+static sbool_t spv_sorted(const void *src, const enum eSV_Type t,
+			  const size_t n)
+{
+	size_t i, j, m;
+	uint64_t u[SPV_BLK], prev = 0;
+	for (i = 0; i < n; i += m) {
+		m = S_MIN(n - i, SPV_BLK);
+		spv_ld(src, t, i, m, u);
+		for (j = 0; j < m; prev = u[j++])
+			RETURN_IF(u[j] < prev, S_FALSE);
+	}
+	return S_TRUE;
+}
+
+static unsigned spv_blk_prep(const void *src, const enum eSV_Type t,
+			     const size_t n, const size_t blk, const int mode,
+			     uint64_t *u, uint64_t *base)
+{
+	const size_t off = blk * SPV_BLK, m = S_MIN(n - off, SPV_BLK);
+	size_t k;
+	uint64_t orv = 0, prev, x;
+	spv_ld(src, t, off, m, u);
+	if (mode == SPV_DELTA) {
+		for (*base = prev = u[0], k = 0; k < m; k++) {
+			x = u[k];
+			u[k] = x - prev;
+			prev = x;
+			orv |= u[k];
+		}
+	} else {
+		for (*base = u[0], k = 1; k < m; k++)
+			if (u[k] < *base)
+				*base = u[k];
+		for (k = 0; k < m; k++) {
+			u[k] -= *base;
+			orv |= u[k];
+		}
+	}
+	for (k = m; k < SPV_BLK; k++)
+		u[k] = 0;
+	return spv_bits(orv);
+}
+
+spv_t *spv_pack(spv_t **out, const sv_t *v)
+{
+	ASSERT_RETURN_IF(!out, spv_void);
+	size_t n, nblk, i, ob, dir_end, total;
+	enum eSV_Type t;
+	int mode;
+	unsigned b;
+	uint64_t u[SPV_BLK], base;
+	const void *src;
+	uint8_t *o;
+	if (!*out)
+		*out = sv_alloc_t(SV_U8, 0);
+	if (!*out) /* BEHAVIOR: allocation error: void output */
+		*out = spv_void;
+	/* BEHAVIOR: only SV_U8 output is allowed (packed vector format) */
+	RETURN_IF(*out == spv_void || (*out)->d.sub_type != SV_U8 ||
+		  *out == v, *out);
+	sv_clear(*out);
+	RETURN_IF(!v || v->d.sub_type > SV_U64, *out);
+	n = sv_size(v);
+	nblk = n / SPV_BLK + (n % SPV_BLK ? 1 : 0);
+	t = (enum eSV_Type)v->d.sub_type;
+	src = sv_get_buffer_r(v);
+	mode = spv_sorted(src, t, n) ? SPV_DELTA : SPV_FOR;
+	dir_end = SPV_HDR + nblk * SPV_DIR;
+	RETURN_IF(sv_reserve(out, dir_end) < dir_end, *out);
+	o = (uint8_t *)sv_get_buffer(*out);
+	S_ST_LE_U64(o, (uint64_t)SPV_VERSION | (uint64_t)t << 8 |
+			   (uint64_t)mode << 16);
+	S_ST_LE_U64(o + 8, (uint64_t)n);
+	for (i = ob = 0; i < nblk; i++) {
+		b = spv_blk_prep(src, t, n, i, mode, u, &base);
+		S_ST_LE_U64(o + SPV_HDR + i * SPV_DIR, base);
+		S_ST_LE_U64(o + SPV_HDR + i * SPV_DIR + 8,
+			    (uint64_t)ob << 8 | b);
+		ob += 16 * b;
+	}
+	total = dir_end + ob + SPV_PAD;
+	RETURN_IF(sv_reserve(out, total) < total, *out);
+	o = (uint8_t *)sv_get_buffer(*out);
+	for (i = ob = 0; i < nblk; i++) {
+		b = spv_blk_prep(src, t, n, i, mode, u, &base);
+		spv_pack_blk(o + dir_end + ob, u, b);
+		ob += 16 * b;
+	}
+	memset(o + dir_end + ob, 0, SPV_PAD);
+	sv_set_size(*out, total);
+	return *out;
+}
+
+/*
+ * Decoding
+ */
+
+sv_t *spv_unpack(sv_t **out, const spv_t *p)
+{
+	return spv_unpack_range(out, p, 0, spv_size(p));
+}
+
+sv_t *spv_unpack_range(sv_t **out, const spv_t *p, const size_t off,
+		       const size_t n)
+{
+	ASSERT_RETURN_IF(!out, spv_void);
+	struct SPVInfo h;
+	size_t i, m, k0, nr;
+	unsigned b;
+	uint64_t u[SPV_BLK], base;
+	const uint8_t *pl;
+	char *dst;
+	if (!spv_info(p, &h)) {
+		if (*out)
+			sv_clear(*out);
+		return *out ? *out : spv_void;
+	}
+	nr = off >= h.n ? 0 : S_MIN(n, h.n - off);
+	if (!*out)
+		*out = sv_alloc_t(h.t, nr);
+	if (!*out) /* BEHAVIOR: allocation error: void output */
+		*out = spv_void;
+	/* BEHAVIOR: the output vector must be of the packed vector type */
+	RETURN_IF(*out == spv_void || (*out)->d.sub_type != h.t ||
+		  *out == p, *out);
+	sv_clear(*out);
+	RETURN_IF(sv_reserve(out, nr) < nr, *out);
+	dst = sv_get_buffer(*out);
+	for (i = off; i < off + nr; i += m) {
+		k0 = i % SPV_BLK;
+		m = S_MIN(SPV_BLK - k0, off + nr - i);
+		pl = spv_blk(&h, i / SPV_BLK, &base, &b);
+		if (!pl) /* BEHAVIOR: corrupted input, stop decoding */
+			break;
+		spv_dec_blk(pl, b, base, h.mode, u);
+		spv_st(dst, h.t, i - off, m, u + k0);
+	}
+	sv_set_size(*out, i - off);
+	return *out;
+}
+
+/*
+ * Accessors
+ */
+
+size_t spv_size(const spv_t *p)
+{
+	struct SPVInfo h;
+	return spv_info(p, &h) ? h.n : 0;
+}
+
+enum eSV_Type spv_type(const spv_t *p)
+{
+	struct SPVInfo h;
+	return spv_info(p, &h) ? h.t : SV_GEN;
+}
+
+int64_t spv_at_i(const spv_t *p, const size_t index)
+{
+	return (int64_t)spv_at_u(p, index);
+}
+
+uint64_t spv_at_u(const spv_t *p, const size_t index)
+{
+	struct SPVInfo h;
+	unsigned b;
+	uint64_t u[SPV_BLK], base, x;
+	const uint8_t *pl;
+	RETURN_IF(!spv_info(p, &h) || index >= h.n, 0);
+	pl = spv_blk(&h, index / SPV_BLK, &base, &b);
+	RETURN_IF(!pl, 0);
+	if (h.mode == SPV_FOR) {
+		x = base + spv_get1(pl, b, index % SPV_BLK);
+	} else {
+		spv_dec_blk(pl, b, base, h.mode, u);
+		x = u[index % SPV_BLK];
+	}
+	return x ^ SPV_BIAS(h.t);
+}
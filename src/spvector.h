@@ -0,0 +1,95 @@
+#ifndef SPVECTOR_H
+#define SPVECTOR_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * spvector.h
+ *
+ * #SHORTDOC packed (compressed) integer vector
+ *
+ * #DOC Read-optimized compressed representation of integer vectors. Elements
+ * #DOC are stored in blocks of 128, each one with its own base value and bit
+ * #DOC width: frame of reference (value - block minimum) for unsorted input,
+ * #DOC and delta coding (value - previous value) for sorted input. A block
+ * #DOC directory (base, offset and bit width) gives random access without
+ * #DOC decoding the previous blocks.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Supports all sv_t integer types (SV_I8 ... SV_U64)
+ * - Compact: 16 bytes per block (directory), plus 16 bytes per bit of block
+ *   width, e.g. sorted 64-bit ids with deltas below 256 take ~1.1 bytes
+ *   per element
+ * - Fast sequential decode: blocks of up to 32 bits per element use a 4-lane
+ *   interleaved layout (SSE2 unpacking, if available), wider blocks a plain
+ *   little-endian bit stream
+ * - Serializable: the packed vector is a SV_U8 vector, with a portable
+ *   (little-endian) format, which can be stored as is. Accessors are bound
+ *   checked, so corrupted input does not cause out of bounds reads
+ *
+ * Format:
+ * - Header (16 bytes): version, element type, mode (0: frame of
+ *   reference, 1: delta), 5 zero bytes, element count (64-bit)
+ * - Block directory (16 bytes per block): base (64-bit), payload offset
+ *   << 8 | bit width (64-bit)
+ * - Payload (16 * bit width bytes per block), plus 8 zero padding bytes
+ */
+
+#include "svector.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t spv_t;	/* "Hidden" structure (accessors are provided) */
+			/* (packed vector is stored in a SV_U8 vector) */
+
+#define spv_free	sv_free
+#define spv_dup		sv_dup
+
+/*
+#API: |Free one or more packed vectors|packed vector; more packed vectors (optional)||O(1)|1;2|
+void spv_free(spv_t **p, ...)
+
+#API: |Duplicate packed vector|packed vector|output packed vector|O(n)|1;2|
+spv_t *spv_dup(const spv_t *src)
+*/
+
+/*
+ * Conversion
+ */
+
+/* #API: |Pack integer vector (delta coding if sorted, frame of reference otherwise)|output packed vector (allocated if NULL, otherwise overwritten; it must be a SV_U8 vector); integer vector|output packed vector reference|O(n)|1;2| */
+spv_t *spv_pack(spv_t **out, const sv_t *v);
+
+/* #API: |Unpack vector|output vector (allocated if NULL, otherwise overwritten; it must be of the packed vector type); packed vector|output vector reference|O(n)|1;2| */
+sv_t *spv_unpack(sv_t **out, const spv_t *p);
+
+/* #API: |Unpack vector range|output vector (allocated if NULL, otherwise overwritten; it must be of the packed vector type); packed vector; offset; number of elements|output vector reference|O(n)|1;2| */
+sv_t *spv_unpack_range(sv_t **out, const spv_t *p, const size_t off,
+		       const size_t n);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Number of elements|packed vector|number of elements (0 if invalid)|O(1)|1;2| */
+size_t spv_size(const spv_t *p);
+
+/* #API: |Element type|packed vector|SV_I8 ... SV_U64 (SV_GEN if invalid)|O(1)|1;2| */
+enum eSV_Type spv_type(const spv_t *p);
+
+/* #API: |Access to signed integer element|packed vector; element offset|element value (0 if out of range)|O(1) (frame of reference), O(128) (delta)|1;2| */
+int64_t spv_at_i(const spv_t *p, const size_t index);
+
+/* #API: |Access to unsigned integer element|packed vector; element offset|element value (0 if out of range)|O(1) (frame of reference), O(128) (delta)|1;2| */
+uint64_t spv_at_u(const spv_t *p, const size_t index);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SPVECTOR_H */
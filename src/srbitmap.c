@@ -0,0 +1,863 @@
+/*
+ * srbitmap.c
+ *
+ * Compressed bitmap (array/bitmap/run containers per 64K chunk).
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ */
+
+#include "srbitmap.h"
+#include "saux/scommon.h"
+
+/*
+ * Constants
+ */
+
+#define srb_void (srb_t *)sd_void
+
+#define SRB_VERSION	1
+#define SRB_HDR		8	/* serialized header size */
+#define SRB_DIR		8	/* serialized chunk directory entry size */
+#define SRB_ARRAY	0	/* container types */
+#define SRB_BITMAP	1
+#define SRB_RUN		2
+#define SRB_ARRAY_MAX	4096	/* array container maximum size */
+#define SRB_WORDS	1024	/* bitmap container size (64-bit words) */
+#define SRB_CHUNK_BITS	65536
+#define SRB_KEYS	65536	/* chunk keys (16-bit) */
+#define SRB_AND		0	/* set operations */
+#define SRB_OR		1
+#define SRB_XOR		2
+#define SRB_ANDNOT	3
+
+/*
+ * Structures
+ */
+
+struct SRBChunk
+{
+	sv_t *c;	/* container (SV_U16 array or runs, SV_U64 bitmap) */
+	uint32_t card;	/* number of elements (1 to 65536) */
+	uint16_t key;	/* element high 16 bits */
+	uint8_t type;
+};
+
+struct SRBScratch
+{
+	uint64_t wa[SRB_WORDS], wb[SRB_WORDS];
+	uint16_t o[2 * SRB_ARRAY_MAX];
+};
+
+/*
+ * Internal functions
+ */
+
+S_INLINE struct SRBChunk *srb_chunks(srb_t *b)
+{
+	return (struct SRBChunk *)sv_get_buffer(b);
+}
+
+S_INLINE const struct SRBChunk *srb_chunks_r(const srb_t *b)
+{
+	return (const struct SRBChunk *)sv_get_buffer_r(b);
+}
+
+S_INLINE const uint16_t *srb_u16(const struct SRBChunk *c)
+{
+	return (const uint16_t *)sv_get_buffer_r(c->c);
+}
+
+/* Chunk lower bound (first chunk with key >= target key) */
+static size_t srb_find_chunk(const srb_t *b, const uint16_t key)
+{
+	const struct SRBChunk *c = srb_chunks_r(b);
+	size_t lo = 0, hi = sv_size(b), m = (size_t)key * hi >> 16, d = 1;
+	/* interpolation probe and exponential search around it: O(1) for
+	 * uniformly distributed keys, O(log n) in the worst case */
+	if (hi) {
+		if (c[m].key < key) {
+			for (lo = m + 1; lo + d < hi && c[lo + d].key < key;
+			     d *= 2)
+				lo += d + 1;
+			hi = S_MIN(hi, lo + d + 1);
+		} else {
+			for (hi = m; hi > d && c[hi - d - 1].key >= key; d *= 2)
+				hi -= d + 1;
+			lo = hi > d ? hi - d : 0;
+		}
+	}
+	while (lo < hi) {
+		m = lo + (hi - lo) / 2;
+		if (c[m].key < key)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/* Lower bound in a sorted array (stride 2 for run containers) */
+static size_t srb_lb16(const uint16_t *a, const size_t n, const size_t st,
+		       const uint16_t v)
+{
+	size_t lo = 0, hi = n, m;
+	while (lo < hi) {
+		m = lo + (hi - lo) / 2;
+		if (a[m * st] < v)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+static sbool_t srb_chunk_test(const struct SRBChunk *c, const uint16_t lo)
+{
+	const uint16_t *a;
+	size_t n, i;
+	if (c->type == SRB_BITMAP)
+		return (((const uint64_t *)sv_get_buffer_r(c->c))[lo / 64] >>
+			(lo % 64)) & 1 ? S_TRUE : S_FALSE;
+	a = srb_u16(c);
+	n = sv_size(c->c);
+	if (c->type == SRB_ARRAY) {
+		i = srb_lb16(a, n, 1, lo);
+		return i < n && a[i] == lo ? S_TRUE : S_FALSE;
+	}
+	i = srb_lb16(a, n / 2, 2, lo);	/* runs: (start, length - 1) */
+	if (i < n / 2 && a[i * 2] == lo)
+		return S_TRUE;
+	return i > 0 && lo <= (size_t)a[i * 2 - 2] + a[i * 2 - 1] ? S_TRUE :
+								    S_FALSE;
+}
+
+/* Set bit range [from, to) */
+static void srb_fill_words(uint64_t *w, size_t from, const size_t to)
+{
+	for (; from < to && from % 64; from++)
+		w[from / 64] |= (uint64_t)1 << (from % 64);
+	for (; from + 64 <= to; from += 64)
+		w[from / 64] = ~(uint64_t)0;
+	for (; from < to; from++)
+		w[from / 64] |= (uint64_t)1 << (from % 64);
+}
+
+/* Chunk content as bitmap */
+static void srb_words(const struct SRBChunk *c, uint64_t *w)
+{
+	const uint16_t *a;
+	size_t i, n;
+	if (c->type == SRB_BITMAP) {
+		memcpy(w, sv_get_buffer_r(c->c), SRB_WORDS * sizeof(w[0]));
+		return;
+	}
+	memset(w, 0, SRB_WORDS * sizeof(w[0]));
+	a = srb_u16(c);
+	n = sv_size(c->c);
+	if (c->type == SRB_ARRAY)
+		for (i = 0; i < n; i++)
+			w[a[i] / 64] |= (uint64_t)1 << (a[i] % 64);
+	else
+		for (i = 0; i + 1 < n; i += 2)
+			srb_fill_words(w, a[i], (size_t)a[i] + a[i + 1] + 1);
+}
+
+/* Bitmap to sorted array */
+static size_t srb_words_to_array(const uint64_t *w, uint16_t *o)
+{
+	size_t i, n = 0;
+	uint64_t x;
+	for (i = 0; i < SRB_WORDS; i++)
+		for (x = w[i]; x; x &= x - 1)
+			o[n++] = (uint16_t)(i * 64 + s_ctz64(x));
+	return n;
+}
+
+/* Next position >= p having the bit set (set != 0) or clear (set == 0) */
+static size_t srb_next(const uint64_t *w, const size_t p, const int set)
+{
+	size_t i = p / 64;
+	uint64_t x;
+	RETURN_IF(p >= SRB_CHUNK_BITS, SRB_CHUNK_BITS);
+	x = (set ? w[i] : ~w[i]) & (~(uint64_t)0 << (p % 64));
+	while (!x) {
+		if (++i == SRB_WORDS)
+			return SRB_CHUNK_BITS;
+		x = set ? w[i] : ~w[i];
+	}
+	return i * 64 + s_ctz64(x);
+}
+
+/* New container, with n elements copied from src (NULL on error) */
+static sv_t *srb_new(const enum eSV_Type t, const void *src, const size_t n)
+{
+	sv_t *v = sv_alloc_t(t, n);
+	if (!sv_push_raw(&v, src, n)) {
+		sv_free(&v);
+		return NULL;
+	}
+	return v;
+}
+
+/* Set chunk container from bitmap (bitmap or array container) */
+static sbool_t srb_set_words(struct SRBChunk *c, const uint64_t *w,
+			     const size_t card, const sbool_t bitmap,
+			     uint16_t *tmp)
+{
+	sv_t *v;
+	uint8_t type = SRB_BITMAP;
+	if (bitmap) {
+		v = srb_new(SV_U64, w, SRB_WORDS);
+	} else {
+		v = srb_new(SV_U16, tmp, srb_words_to_array(w, tmp));
+		type = SRB_ARRAY;
+	}
+	RETURN_IF(!v, S_FALSE);
+	sv_free(&c->c);
+	c->c = v;
+	c->card = (uint32_t)card;
+	c->type = type;
+	return S_TRUE;
+}
+
+/* Bitmap to runs: (start, length - 1) pairs */
+static size_t srb_words_to_runs(const uint64_t *w, uint16_t *o)
+{
+	size_t p = 0, e, n = 0;
+	while ((p = srb_next(w, p, 1)) < SRB_CHUNK_BITS) {
+		e = srb_next(w, p, 0);
+		o[n++] = (uint16_t)p;
+		o[n++] = (uint16_t)(e - p - 1);
+		p = e;
+	}
+	return n;
+}
+
+static size_t srb_count_runs(const struct SRBChunk *c, const uint64_t *w)
+{
+	const uint16_t *a;
+	size_t i, n, r;
+	uint64_t prev = 0;
+	if (c->type == SRB_RUN)
+		return sv_size(c->c) / 2;
+	if (c->type == SRB_ARRAY) {
+		a = srb_u16(c);
+		n = sv_size(c->c);
+		for (i = r = n ? 1 : 0; i < n; i++)
+			r += a[i] != a[i - 1] + 1;
+		return r;
+	}
+	for (i = r = 0; i < SRB_WORDS; prev = w[i++] >> 63)
+		r += s_popcount64(w[i] & ~(w[i] << 1 | prev));
+	return r;
+}
+
+/* Convert container to bitmap or array */
+static sbool_t srb_expand(struct SRBChunk *c, const sbool_t bitmap)
+{
+	struct SRBScratch *s = (struct SRBScratch *)s_malloc(sizeof(*s));
+	sbool_t ok;
+	RETURN_IF(!s, S_FALSE);
+	srb_words(c, s->wa);
+	ok = srb_set_words(c, s->wa, c->card, bitmap, s->o);
+	s_free(s);
+	return ok;
+}
+
+/* Returns S_TRUE if the element was not set */
+static sbool_t srb_chunk_set(struct SRBChunk *c, const uint16_t lo)
+{
+	uint16_t *a;
+	uint64_t *w, m;
+	size_t n, i;
+	if (c->type == SRB_RUN) {
+		RETURN_IF(srb_chunk_test(c, lo), S_FALSE);
+		RETURN_IF(!srb_expand(c, c->card >= SRB_ARRAY_MAX), S_FALSE);
+	}
+	if (c->type == SRB_ARRAY) {
+		n = sv_size(c->c);
+		a = (uint16_t *)sv_get_buffer(c->c);
+		i = srb_lb16(a, n, 1, lo);
+		RETURN_IF(i < n && a[i] == lo, S_FALSE);
+		if (n < SRB_ARRAY_MAX) {
+			RETURN_IF(sv_grow(&c->c, 1) < 1, S_FALSE);
+			a = (uint16_t *)sv_get_buffer(c->c);
+			memmove(a + i + 1, a + i, (n - i) * sizeof(a[0]));
+			a[i] = lo;
+			sv_set_size(c->c, n + 1);
+			c->card++;
+			return S_TRUE;
+		}
+		RETURN_IF(!srb_expand(c, S_TRUE), S_FALSE);
+	}
+	w = (uint64_t *)sv_get_buffer(c->c);
+	m = (uint64_t)1 << (lo % 64);
+	RETURN_IF(w[lo / 64] & m, S_FALSE);
+	w[lo / 64] |= m;
+	c->card++;
+	return S_TRUE;
+}
+
+/* Returns S_TRUE if the element was set */
+static sbool_t srb_chunk_reset(struct SRBChunk *c, const uint16_t lo)
+{
+	uint16_t *a;
+	uint64_t *w, m;
+	size_t n, i;
+	RETURN_IF(!srb_chunk_test(c, lo), S_FALSE);
+	if (c->type == SRB_RUN && c->card > 1) {
+		RETURN_IF(!srb_expand(c, c->card > SRB_ARRAY_MAX), S_FALSE);
+	}
+	if (c->type == SRB_BITMAP) {
+		w = (uint64_t *)sv_get_buffer(c->c);
+		m = (uint64_t)1 << (lo % 64);
+		w[lo / 64] &= ~m;
+		c->card--;
+		/* BEHAVIOR: back to array at half the array size (so set/reset
+		 * around the limit does not convert the container every time) */
+		if (c->card <= SRB_ARRAY_MAX / 2)
+			srb_expand(c, S_FALSE);
+		return S_TRUE;
+	}
+	if (c->type == SRB_ARRAY) {
+		n = sv_size(c->c);
+		a = (uint16_t *)sv_get_buffer(c->c);
+		i = srb_lb16(a, n, 1, lo);
+		memmove(a + i, a + i + 1, (n - i - 1) * sizeof(a[0]));
+		sv_set_size(c->c, n - 1);
+	}
+	c->card--;	/* single element run: the chunk is removed */
+	return S_TRUE;
+}
+
+/* Append chunk (taking ownership of the container) */
+static sbool_t srb_push(srb_t **b, struct SRBChunk *c)
+{
+	const size_t n = sv_size(*b);
+	if (!c->c)
+		return S_TRUE;
+	if (sv_grow(b, 1) < 1) {
+		sv_free(&c->c);
+		return S_FALSE;
+	}
+	srb_chunks(*b)[n] = *c;
+	sv_set_size(*b, n + 1);
+	(*b)->vx.cnt += c->card;
+	return S_TRUE;
+}
+
+static sbool_t srb_push_dup(srb_t **b, const struct SRBChunk *c)
+{
+	struct SRBChunk t = *c;
+	t.c = sv_dup(c->c);
+	if (sv_size(t.c) != sv_size(c->c)) {
+		sv_free(&t.c);
+		return S_FALSE;
+	}
+	return srb_push(b, &t);
+}
+
+/* Sorted array set operation (output size <= na + nb) */
+static size_t srb_merge16(uint16_t *o, const uint16_t *a, const size_t na,
+			  const uint16_t *b, const size_t nb, const int op)
+{
+	size_t i = 0, j = 0, n = 0;
+	while (i < na && j < nb) {
+		if (a[i] < b[j]) {
+			if (op != SRB_AND)
+				o[n++] = a[i];
+			i++;
+		} else if (b[j] < a[i]) {
+			if (op == SRB_OR || op == SRB_XOR)
+				o[n++] = b[j];
+			j++;
+		} else {
+			if (op == SRB_AND || op == SRB_OR)
+				o[n++] = a[i];
+			i++;
+			j++;
+		}
+	}
+	if (op != SRB_AND)
+		for (; i < na; i++)
+			o[n++] = a[i];
+	if (op == SRB_OR || op == SRB_XOR)
+		for (; j < nb; j++)
+			o[n++] = b[j];
+	return n;
+}
+
+/* Array elements present (keep != 0) or not present in c */
+static size_t srb_filter16(uint16_t *o, const uint16_t *a, const size_t na,
+			   const struct SRBChunk *c, const int keep)
+{
+	size_t i, n = 0;
+	for (i = 0; i < na; i++)
+		if (srb_chunk_test(c, a[i]) == (keep ? S_TRUE : S_FALSE))
+			o[n++] = a[i];
+	return n;
+}
+
+/* Chunk set operation (r->c is NULL if the result is empty) */
+static sbool_t srb_chunk_op(struct SRBChunk *r, const struct SRBChunk *x,
+			    const struct SRBChunk *y, const int op,
+			    struct SRBScratch *s)
+{
+	size_t i, n = 0, card = 0;
+	sbool_t arr = S_TRUE;
+	r->c = NULL;
+	r->key = x->key;
+	if (x->type == SRB_ARRAY && y->type == SRB_ARRAY)
+		n = srb_merge16(s->o, srb_u16(x), x->card, srb_u16(y), y->card,
+				op);
+	else if (x->type == SRB_ARRAY && (op == SRB_AND || op == SRB_ANDNOT))
+		n = srb_filter16(s->o, srb_u16(x), x->card, y, op == SRB_AND);
+	else if (y->type == SRB_ARRAY && op == SRB_AND)
+		n = srb_filter16(s->o, srb_u16(y), y->card, x, 1);
+	else
+		arr = S_FALSE;
+	if (arr && n <= SRB_ARRAY_MAX) {
+		RETURN_IF(!n, S_TRUE);
+		r->c = srb_new(SV_U16, s->o, n);
+		r->card = (uint32_t)n;
+		r->type = SRB_ARRAY;
+		return r->c ? S_TRUE : S_FALSE;
+	}
+	if (arr) {
+		memset(s->wa, 0, sizeof(s->wa));
+		for (i = 0; i < n; i++)
+			s->wa[s->o[i] / 64] |= (uint64_t)1 << (s->o[i] % 64);
+		card = n;
+	} else {
+		srb_words(x, s->wa);
+		srb_words(y, s->wb);
+		switch (op) {
+		case SRB_AND:
+			for (i = 0; i < SRB_WORDS; i++)
+				card += s_popcount64(s->wa[i] &= s->wb[i]);
+			break;
+		case SRB_OR:
+			for (i = 0; i < SRB_WORDS; i++)
+				card += s_popcount64(s->wa[i] |= s->wb[i]);
+			break;
+		case SRB_XOR:
+			for (i = 0; i < SRB_WORDS; i++)
+				card += s_popcount64(s->wa[i] ^= s->wb[i]);
+			break;
+		default:
+			for (i = 0; i < SRB_WORDS; i++)
+				card += s_popcount64(s->wa[i] &= ~s->wb[i]);
+		}
+	}
+	RETURN_IF(!card, S_TRUE);
+	return srb_set_words(r, s->wa, card, card > SRB_ARRAY_MAX, s->o);
+}
+
+/* Replace output, freeing the previous one */
+static srb_t *srb_replace(srb_t **out, srb_t *r)
+{
+	if (*out)
+		srb_free(out);
+	*out = r;
+	return r;
+}
+
+static srb_t *srb_op(srb_t **out, const srb_t *a, const srb_t *b,
+		     const int op)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t na = sv_size(a), nb = sv_size(b);
+	const struct SRBChunk *ca = srb_chunks_r(a), *cb = srb_chunks_r(b);
+	const sbool_t all_b = op == SRB_OR || op == SRB_XOR;
+	struct SRBScratch *s = NULL;
+	struct SRBChunk t;
+	srb_t *r = srb_alloc(op == SRB_AND ? S_MIN(na, nb) : na + nb);
+	size_t i = 0, j = 0;
+	sbool_t ok = r != srb_void;
+	while (ok && (i < na || (all_b && j < nb))) {
+		if (j == nb || (i < na && ca[i].key < cb[j].key)) {
+			if (op != SRB_AND)
+				ok = srb_push_dup(&r, ca + i);
+			i++;
+		} else if (i == na || cb[j].key < ca[i].key) {
+			if (all_b)
+				ok = srb_push_dup(&r, cb + j);
+			j++;
+		} else {
+			if (!s)
+				s = (struct SRBScratch *)s_malloc(sizeof(*s));
+			ok = s && srb_chunk_op(&t, ca + i, cb + j, op, s) &&
+			     srb_push(&r, &t);
+			i++;
+			j++;
+		}
+	}
+	if (s)
+		s_free(s);
+	if (!ok) {
+		srb_free(&r);
+		r = srb_void;
+	}
+	return srb_replace(out, r);
+}
+
+/*
+ * Allocation
+ */
+
+srb_t *srb_alloc(const size_t initial_num_chunks_reserve)
+{
+	return sv_alloc(sizeof(struct SRBChunk), initial_num_chunks_reserve,
+			NULL);
+}
+
+srb_t *srb_dup(const srb_t *src)
+{
+	const size_t n = sv_size(src);
+	const struct SRBChunk *c = srb_chunks_r(src);
+	srb_t *r = srb_alloc(n);
+	size_t i;
+	for (i = 0; i < n && r != srb_void; i++)
+		if (!srb_push_dup(&r, c + i)) {
+			srb_free(&r);
+			r = srb_void;
+		}
+	return r;
+}
+
+void srb_clear(srb_t *b)
+{
+	if (!b || b == srb_void)
+		return;
+	struct SRBChunk *c = srb_chunks(b);
+	size_t i;
+	const size_t n = sv_size(b);
+	for (i = 0; i < n; i++)
+		sv_free(&c[i].c);
+	sv_set_size(b, 0);
+	b->vx.cnt = 0;
+}
+
+void srb_free_aux(srb_t **b, ...)
+{
+	va_list ap;
+	va_start(ap, b);
+	srb_t **next = b;
+	while (!s_varg_tail_ptr_tag(next)) { /* last element tag */
+		if (next) {
+			srb_clear(*next); /* release the containers */
+			sv_free(next);
+		}
+		next = (srb_t **)va_arg(ap, srb_t **);
+	}
+	va_end(ap);
+}
+
+/*
+ * Accessors
+ */
+
+size_t srb_mem_size(const srb_t *b)
+{
+	RETURN_IF(!b || b == srb_void, 0);
+	const struct SRBChunk *c = srb_chunks_r(b);
+	const size_t n = sv_size(b);
+	size_t i, s = sizeof(srb_t) + sv_capacity(b) * sizeof(c[0]);
+	for (i = 0; i < n; i++)
+		s += sizeof(sv_t) + sv_capacity(c[i].c) * c[i].c->d.elem_size;
+	return s;
+}
+
+int srb_test(const srb_t *b, const uint32_t nth)
+{
+	const uint16_t key = (uint16_t)(nth >> 16);
+	const size_t i = srb_find_chunk(b, key);
+	RETURN_IF(i == sv_size(b) || srb_chunks_r(b)[i].key != key, 0);
+	return srb_chunk_test(srb_chunks_r(b) + i, (uint16_t)nth) ? 1 : 0;
+}
+
+/*
+ * Modification
+ */
+
+void srb_set(srb_t **b, const uint32_t nth)
+{
+	if (!b)
+		return;
+	if (!*b) /* BEHAVIOR: if NULL, assume heap allocation */
+		*b = srb_alloc(1);
+	if (*b == srb_void)
+		return;
+	const uint16_t key = (uint16_t)(nth >> 16), lo = (uint16_t)nth;
+	const size_t i = srb_find_chunk(*b, key), n = sv_size(*b);
+	struct SRBChunk *c = srb_chunks(*b);
+	sv_t *v;
+	if (i < n && c[i].key == key) {
+		if (srb_chunk_set(c + i, lo))
+			(*b)->vx.cnt++;
+		return;
+	}
+	v = srb_new(SV_U16, &lo, 1);
+	if (!v)
+		return;
+	if (sv_grow(b, 1) < 1) {
+		sv_free(&v);
+		return;
+	}
+	c = srb_chunks(*b);
+	memmove(c + i + 1, c + i, (n - i) * sizeof(c[0]));
+	c[i].c = v;
+	c[i].card = 1;
+	c[i].key = key;
+	c[i].type = SRB_ARRAY;
+	sv_set_size(*b, n + 1);
+	(*b)->vx.cnt++;
+}
+
+void srb_reset(srb_t **b, const uint32_t nth)
+{
+	if (!b || !*b || *b == srb_void)
+		return;
+	const uint16_t key = (uint16_t)(nth >> 16);
+	const size_t i = srb_find_chunk(*b, key), n = sv_size(*b);
+	struct SRBChunk *c = srb_chunks(*b);
+	if (i == n || c[i].key != key || !srb_chunk_reset(c + i, (uint16_t)nth))
+		return;
+	(*b)->vx.cnt--;
+	if (!c[i].card) {
+		sv_free(&c[i].c);
+		memmove(c + i, c + i + 1, (n - i - 1) * sizeof(c[0]));
+		sv_set_size(*b, n - 1);
+	}
+}
+
+void srb_optimize(srb_t *b)
+{
+	if (!b || b == srb_void)
+		return;
+	struct SRBChunk *c = srb_chunks(b);
+	const size_t n = sv_size(b);
+	size_t i, nr, sa, sr;
+	struct SRBScratch *s = (struct SRBScratch *)s_malloc(sizeof(*s));
+	sv_t *v;
+	if (!s)
+		return;
+	for (i = 0; i < n; i++) {
+		srb_words(c + i, s->wa);
+		nr = srb_count_runs(c + i, s->wa);
+		sa = c[i].card <= SRB_ARRAY_MAX ? c[i].card * 2 :
+						  SRB_WORDS * 8;
+		sr = nr * 4;
+		if (sr < sa && c[i].type != SRB_RUN) {
+			v = srb_new(SV_U16, s->o, srb_words_to_runs(s->wa, s->o));
+			if (v) {
+				sv_free(&c[i].c);
+				c[i].c = v;
+				c[i].type = SRB_RUN;
+			}
+		} else if (sr >= sa && c[i].type == SRB_RUN) {
+			srb_set_words(c + i, s->wa, c[i].card,
+				      c[i].card > SRB_ARRAY_MAX, s->o);
+		}
+	}
+	s_free(s);
+}
+
+/*
+ * Set operations
+ */
+
+srb_t *srb_and(srb_t **out, const srb_t *a, const srb_t *b)
+{
+	return srb_op(out, a, b, SRB_AND);
+}
+
+srb_t *srb_or(srb_t **out, const srb_t *a, const srb_t *b)
+{
+	return srb_op(out, a, b, SRB_OR);
+}
+
+srb_t *srb_xor(srb_t **out, const srb_t *a, const srb_t *b)
+{
+	return srb_op(out, a, b, SRB_XOR);
+}
+
+srb_t *srb_andnot(srb_t **out, const srb_t *a, const srb_t *b)
+{
+	return srb_op(out, a, b, SRB_ANDNOT);
+}
+
+/*
+ * Export and serialization
+ */
+
+S_INLINE void srb_put(char *o, const size_t j, const size_t es,
+		      const uint32_t k)
+{
+	if (es == 8)
+		((uint64_t *)o)[j] = k;
+	else
+		((uint32_t *)o)[j] = k;
+}
+
+sv_t *srb_to_vector(sv_t **out, const srb_t *b)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t nelems = srb_popcount(b), n = sv_size(b);
+	if (!*out)
+		*out = sv_alloc_t(SV_U32, nelems);
+	else
+		sv_clear(*out);
+	const enum eSV_Type t = (enum eSV_Type)(*out)->d.sub_type;
+	const size_t es = (*out)->d.elem_size;
+	RETURN_IF(t > SV_LAST_INT || (es != 4 && es != 8), *out);
+	RETURN_IF(sv_reserve(out, nelems) < nelems, *out);
+	const struct SRBChunk *c = srb_chunks_r(b);
+	const uint32_t kmax = t == SV_I32 ? 0x7fffffff : 0xffffffff;
+	char *o = sv_get_buffer(*out);
+	const uint16_t *a;
+	const uint64_t *w;
+	uint32_t base, k;
+	size_t i, l, m, e, j = 0;
+	uint64_t x;
+	for (i = 0; i < n && j < nelems; i++) {
+		base = (uint32_t)c[i].key << 16;
+		if (base > kmax)
+			break;
+		m = sv_size(c[i].c);
+		if (c[i].type == SRB_BITMAP) {
+			w = (const uint64_t *)sv_get_buffer_r(c[i].c);
+			for (l = 0; l < SRB_WORDS; l++)
+				for (x = w[l]; x; x &= x - 1)
+					if ((k = base + (uint32_t)(l * 64 +
+					     s_ctz64(x))) <= kmax)
+						srb_put(o, j++, es, k);
+			continue;
+		}
+		a = srb_u16(c + i);
+		if (c[i].type == SRB_ARRAY) {
+			for (l = 0; l < m; l++)
+				if ((k = base + a[l]) <= kmax)
+					srb_put(o, j++, es, k);
+			continue;
+		}
+		for (l = 0; l + 1 < m; l += 2)
+			for (e = a[l]; e <= (size_t)a[l] + a[l + 1]; e++)
+				if ((k = base + (uint32_t)e) <= kmax)
+					srb_put(o, j++, es, k);
+	}
+	sv_set_size(*out, j);
+	return *out;
+}
+
+sv_t *srb_serialize(sv_t **out, const srb_t *b)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	if (!*out)
+		*out = sv_alloc_t(SV_U8, 0);
+	/* BEHAVIOR: only SV_U8 output is allowed */
+	RETURN_IF(!*out || (*out)->d.sub_type != SV_U8 || *out == b, *out);
+	sv_clear(*out);
+	const size_t n = sv_size(b);
+	const struct SRBChunk *c = srb_chunks_r(b);
+	size_t i, l, m, total = SRB_HDR + n * SRB_DIR, off;
+	uint8_t *o;
+	const uint16_t *a;
+	const uint64_t *w;
+	for (i = 0; i < n; i++)
+		total += c[i].type == SRB_BITMAP ? SRB_WORDS * 8 :
+						   sv_size(c[i].c) * 2;
+	RETURN_IF(sv_reserve(out, total) < total, *out);
+	o = (uint8_t *)sv_get_buffer(*out);
+	S_ST_LE_U32(o, SRB_VERSION);
+	S_ST_LE_U32(o + 4, (unsigned)n);
+	off = SRB_HDR + n * SRB_DIR;
+	for (i = 0; i < n; i++) {
+		m = sv_size(c[i].c);
+		S_ST_LE_U32(o + SRB_HDR + i * SRB_DIR,
+			    (unsigned)c[i].key | (unsigned)c[i].type << 16);
+		S_ST_LE_U32(o + SRB_HDR + i * SRB_DIR + 4,
+			    (unsigned)(c[i].type == SRB_BITMAP ? c[i].card :
+					c[i].type == SRB_RUN ? m / 2 : m));
+		if (c[i].type == SRB_BITMAP) {
+			w = (const uint64_t *)sv_get_buffer_r(c[i].c);
+			for (l = 0; l < SRB_WORDS; l++, off += 8)
+				S_ST_LE_U64(o + off, w[l]);
+			continue;
+		}
+		a = srb_u16(c + i);
+		for (l = 0; l < m; l++, off += 2)
+			S_ST_LE_U16(o + off, a[l]);
+	}
+	sv_set_size(*out, total);
+	return *out;
+}
+
+/* Load one serialized chunk (S_FALSE if not valid) */
+static sbool_t srb_load_chunk(struct SRBChunk *c, const uint8_t *p,
+			      const size_t n, struct SRBScratch *s)
+{
+	size_t i, e, card = 0;
+	if (c->type == SRB_BITMAP) {
+		for (i = 0; i < SRB_WORDS; i++)
+			card += s_popcount64(s->wa[i] = S_LD_LE_U64(p + i * 8));
+		return card > 0 && card == n &&
+		       srb_set_words(c, s->wa, card, card > SRB_ARRAY_MAX, s->o);
+	}
+	for (i = e = 0; i < (c->type == SRB_RUN ? n * 2 : n); i++) {
+		s->o[i] = S_LD_LE_U16(p + i * 2);
+		if (c->type == SRB_ARRAY) {
+			RETURN_IF(i > 0 && s->o[i] <= s->o[i - 1], S_FALSE);
+			card++;
+		} else if (i % 2) {
+			RETURN_IF(i > 1 && s->o[i - 1] <= e, S_FALSE);
+			e = (size_t)s->o[i - 1] + s->o[i];
+			RETURN_IF(e >= SRB_CHUNK_BITS, S_FALSE);
+			card += s->o[i] + 1;
+		}
+	}
+	c->c = srb_new(SV_U16, s->o, i);
+	c->card = (uint32_t)card;
+	return c->c ? S_TRUE : S_FALSE;
+}
+
+srb_t *srb_deserialize(srb_t **out, const sv_t *in)
+{
+	ASSERT_RETURN_IF(!out, NULL);
+	const size_t ss = in && in->d.sub_type == SV_U8 ? sv_size(in) : 0;
+	const uint8_t *p = (const uint8_t *)sv_get_buffer_r(in);
+	const size_t n = ss >= SRB_HDR ? S_LD_LE_U32(p + 4) : 0;
+	/* header validated before the allocation (n is not trusted) */
+	const sbool_t hdr_ok = ss >= SRB_HDR &&
+			       S_LD_LE_U32(p) == SRB_VERSION &&
+			       n <= SRB_KEYS && (ss - SRB_HDR) / SRB_DIR >= n;
+	srb_t *r = srb_alloc(hdr_ok ? n : 0);
+	struct SRBScratch *s = NULL;
+	struct SRBChunk t;
+	size_t i, m, sz, off = SRB_HDR + (hdr_ok ? n : 0) * SRB_DIR;
+	unsigned d;
+	sbool_t ok = hdr_ok && r != srb_void &&
+		     (s = (struct SRBScratch *)s_malloc(sizeof(*s))) != NULL;
+	for (i = 0; ok && i < n; i++) {
+		d = S_LD_LE_U32(p + SRB_HDR + i * SRB_DIR);
+		m = S_LD_LE_U32(p + SRB_HDR + i * SRB_DIR + 4);
+		t.c = NULL;
+		t.key = (uint16_t)d;
+		t.type = (uint8_t)(d >> 16);
+		sz = t.type == SRB_BITMAP ? SRB_WORDS * 8 :
+		     t.type == SRB_RUN ? m * 4 : m * 2;
+		ok = (d >> 16) <= SRB_RUN && m > 0 && off <= ss &&
+		     sz <= ss - off && (t.type == SRB_BITMAP ||
+		     m <= (t.type == SRB_RUN ? SRB_ARRAY_MAX / 2 :
+					       SRB_ARRAY_MAX)) &&
+		     (i == 0 || t.key > srb_chunks(r)[i - 1].key) &&
+		     srb_load_chunk(&t, p + off, m, s) && srb_push(&r, &t);
+		off += sz;
+	}
+	if (s)
+		s_free(s);
+	if (!ok)
+		srb_clear(r); /* BEHAVIOR: invalid input: empty bitmap */
+	return srb_replace(out, r);
+}
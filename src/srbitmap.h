@@ -0,0 +1,136 @@
+#ifndef SRBITMAP_H
+#define SRBITMAP_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * srbitmap.h
+ *
+ * #SHORTDOC compressed bitmap (32-bit integer set)
+ *
+ * #DOC Compressed bitmap for sets of 32-bit integers, using "Roaring" style
+ * #DOC partitioning: the high 16 bits of each element select a 64K chunk,
+ * #DOC and each non-empty chunk is stored in the container that fits its
+ * #DOC content: sorted 16-bit array (up to 4096 elements), 8KB bitmap, or
+ * #DOC 16-bit run list (start, length - 1). Memory use is proportional to
+ * #DOC the number of elements, not to the highest element, as it happens
+ * #DOC with the sb_t bitset.
+ *
+ * Copyright (c) 2015-2017, F. Aragon. All rights reserved. Released under
+ * the BSD 3-Clause License (see the doc/LICENSE file included).
+ *
+ * Features:
+ * - Compact: ~2 bytes per element for sparse sets, 1 bit per element for
+ *   dense chunks, and 4 bytes per run after srb_optimize()
+ * - O(1) "population count" (total cardinality is kept updated)
+ * - Set operations (AND, OR, XOR, AND NOT) working per chunk: array merge
+ *   for small containers, 64-bit word operations otherwise
+ * - Serializable: portable (little-endian) format, validated on load, so
+ *   corrupted input does not cause out of bounds reads
+ *
+ * Format:
+ * - Header (8 bytes): version, 3 zero bytes, chunk count (32-bit)
+ * - Chunk directory (8 bytes per chunk): key (high 16 bits, 16-bit),
+ *   container type (0: array, 1: bitmap, 2: run), zero byte, container
+ *   element count (32-bit)
+ * - Container payload, in chunk order: arrays 2 bytes per element, bitmaps
+ *   8192 bytes, runs 4 bytes per run
+ */
+
+#include "svector.h"
+
+/*
+ * Structures
+ */
+
+typedef sv_t srb_t;	/* "Hidden" structure (accessors are provided) */
+			/* (chunk directory is stored in a vector) */
+
+/*
+ * Allocation
+ */
+
+/* #API: |Allocate compressed bitmap (heap)|space preallocated to store n chunks|compressed bitmap|O(1)|1;2| */
+srb_t *srb_alloc(const size_t initial_num_chunks_reserve);
+
+/* #API: |Duplicate compressed bitmap|compressed bitmap|output compressed bitmap|O(n)|1;2| */
+srb_t *srb_dup(const srb_t *src);
+
+/* #API: |Reset compressed bitmap|compressed bitmap|-|O(n)|1;2| */
+void srb_clear(srb_t *b);
+
+/*
+#API: |Free one or more compressed bitmaps|compressed bitmap; more compressed bitmaps (optional)|-|O(n)|1;2|
+void srb_free(srb_t **b, ...)
+*/
+#ifdef S_USE_VA_ARGS
+#define srb_free(...) srb_free_aux(__VA_ARGS__, S_INVALID_PTR_VARG_TAIL)
+#else
+#define srb_free(...)
+#endif
+void srb_free_aux(srb_t **b, ...);
+
+/*
+ * Accessors
+ */
+
+/* #API: |Number of elements set to 1|compressed bitmap|Map number of elements set to 1|O(1)|1;2| */
+S_INLINE size_t srb_popcount(const srb_t *b)
+{
+	/* srb_void (failed allocation) has no counter */
+	return b && (const sd_t *)b != sd_void ? (size_t)b->vx.cnt : 0;
+}
+
+/* #API: |Memory used, including containers|compressed bitmap|bytes|O(n)|1;2| */
+size_t srb_mem_size(const srb_t *b);
+
+/* #API: |Access to nth element|compressed bitmap; element|0 or 1|O(1) (bitmap chunks), O(log n) (array and run chunks)|1;2| */
+int srb_test(const srb_t *b, const uint32_t nth);
+
+/*
+ * Modification
+ */
+
+/* #API: |Set nth element|compressed bitmap; element|-|O(log n) (bitmap chunks: O(1)), O(n) when creating a chunk or inserting into an array chunk|1;2| */
+void srb_set(srb_t **b, const uint32_t nth);
+
+/* #API: |Clear nth element|compressed bitmap; element|-|O(log n) (bitmap chunks: O(1)), O(n) when removing from an array chunk|1;2| */
+void srb_reset(srb_t **b, const uint32_t nth);
+
+/* #API: |Convert chunks to run containers where it saves space (and back, where it does not)|compressed bitmap|-|O(n)|1;2| */
+void srb_optimize(srb_t *b);
+
+/*
+ * Set operations
+ */
+
+/* #API: |Intersection|output compressed bitmap (allocated if NULL, otherwise replaced; it can be one of the inputs); input; input|output compressed bitmap reference|O(n)|1;2| */
+srb_t *srb_and(srb_t **out, const srb_t *a, const srb_t *b);
+
+/* #API: |Union|output compressed bitmap (allocated if NULL, otherwise replaced; it can be one of the inputs); input; input|output compressed bitmap reference|O(n)|1;2| */
+srb_t *srb_or(srb_t **out, const srb_t *a, const srb_t *b);
+
+/* #API: |Symmetric difference|output compressed bitmap (allocated if NULL, otherwise replaced; it can be one of the inputs); input; input|output compressed bitmap reference|O(n)|1;2| */
+srb_t *srb_xor(srb_t **out, const srb_t *a, const srb_t *b);
+
+/* #API: |Difference (a AND NOT b)|output compressed bitmap (allocated if NULL, otherwise replaced; it can be one of the inputs); input; input|output compressed bitmap reference|O(n)|1;2| */
+srb_t *srb_andnot(srb_t **out, const srb_t *a, const srb_t *b);
+
+/*
+ * Export and serialization
+ */
+
+/* #API: |Elements set to 1, in ascending order|output vector (allocated as SV_U32 if NULL, otherwise overwritten; it must be a 32 or 64-bit integer vector); compressed bitmap|output vector reference|O(n)|1;2| */
+sv_t *srb_to_vector(sv_t **out, const srb_t *b);
+
+/* #API: |Serialize compressed bitmap|output vector (allocated if NULL, otherwise overwritten; it must be a SV_U8 vector); compressed bitmap|output vector reference|O(n)|1;2| */
+sv_t *srb_serialize(sv_t **out, const srb_t *b);
+
+/* #API: |Load serialized compressed bitmap (empty bitmap if the input is not valid)|output compressed bitmap (allocated if NULL, otherwise replaced); serialized input (SV_U8 vector)|output compressed bitmap reference|O(n)|1;2| */
+srb_t *srb_deserialize(srb_t **out, const sv_t *in);
+
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+#endif /* #ifndef SRBITMAP_H */
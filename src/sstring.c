@@ -481,7 +481,10 @@ static ss_t *aux_toenc(ss_t **s, const sbool_t cat, const ss_t *src,
 			 * copy for the input
 			 */
 			if (f == senc_lzw || f == sdec_lzw ||
-			    f == senc_rle || f == sdec_rle) {
+			    f == senc_rle || f == sdec_rle ||
+			    f == senc_huf || f == sdec_huf ||
+			    f == senc_rle_huf || f == sdec_rle_huf ||
+			    f == senc_lzw_huf || f == sdec_lzw_huf) {
 				ss_cpy(&src_aux, *s);
 				src1 = src_aux;
 			} else
@@ -947,6 +950,9 @@ MK_SS_DUP_CPY_CAT(enc_hex, senc_hex, NULL)
 MK_SS_DUP_CPY_CAT(enc_HEX, senc_HEX, NULL)
 MK_SS_DUP_CPY_CAT(enc_lzw, senc_lzw, NULL)
 MK_SS_DUP_CPY_CAT(enc_rle, senc_rle, NULL)
+MK_SS_DUP_CPY_CAT(enc_huf, senc_huf, NULL)
+MK_SS_DUP_CPY_CAT(enc_rle_huf, senc_rle_huf, NULL)
+MK_SS_DUP_CPY_CAT(enc_lzw_huf, senc_lzw_huf, NULL)
 MK_SS_DUP_CPY_CAT(enc_esc_xml, NULL, senc_esc_xml)
 MK_SS_DUP_CPY_CAT(enc_esc_json, NULL, senc_esc_json)
 MK_SS_DUP_CPY_CAT(enc_esc_url, NULL, senc_esc_url)
@@ -957,12 +963,167 @@ MK_SS_DUP_CPY_CAT(dec_b64, sdec_b64, NULL)
 MK_SS_DUP_CPY_CAT(dec_hex, sdec_hex, NULL)
 MK_SS_DUP_CPY_CAT(dec_lzw, sdec_lzw, NULL)
 MK_SS_DUP_CPY_CAT(dec_rle, sdec_rle, NULL)
+MK_SS_DUP_CPY_CAT(dec_huf, sdec_huf, NULL)
+MK_SS_DUP_CPY_CAT(dec_rle_huf, sdec_rle_huf, NULL)
+MK_SS_DUP_CPY_CAT(dec_lzw_huf, sdec_lzw_huf, NULL)
 MK_SS_DUP_CPY_CAT(dec_esc_xml, sdec_esc_xml, NULL)
 MK_SS_DUP_CPY_CAT(dec_esc_json, sdec_esc_json, NULL)
 MK_SS_DUP_CPY_CAT(dec_esc_url, sdec_esc_url, NULL)
 MK_SS_DUP_CPY_CAT(dec_esc_dquote, sdec_esc_dquote, NULL)
 MK_SS_DUP_CPY_CAT(dec_esc_squote, sdec_esc_squote, NULL)
 
+/*
+ * LZW with preset dictionary
+ */
+
+static ss_t *aux_lzw_dict(ss_t **s, const ss_t *src, const ss_t *dict,
+			  const sbool_t enc)
+{
+	ASSERT_RETURN_IF(!s, ss_void);
+	if (!src)
+		src = ss_void;
+	if (!dict)
+		dict = ss_void;
+	ss_t *src_aux = NULL;
+	if (*s == src || *s == dict) { /* BEHAVIOR: aliasing: use a copy */
+		ss_cpy(&src_aux, *s);
+		if (*s == src)
+			src = src_aux;
+		if (*s == dict)
+			dict = src_aux;
+	}
+	const unsigned char *b = (const unsigned char *)ss_get_buffer_r(src),
+			    *d = (const unsigned char *)ss_get_buffer_r(dict);
+	size_t in_size = ss_size(src), ds = ss_size(dict),
+	       out_size = enc ? senc_lzw_dict(b, in_size, NULL, d, ds) :
+				sdec_lzw_dict(b, in_size, NULL, d, ds);
+	if (ss_reserve(s, out_size) >= out_size) {
+		unsigned char *o = (unsigned char *)ss_get_buffer(*s);
+		out_size = enc ? senc_lzw_dict(b, in_size, o, d, ds) :
+				 sdec_lzw_dict(b, in_size, o, d, ds);
+		ss_set_size(*s, out_size);
+		set_unicode_size_cached(*s, S_FALSE);
+	}
+	if (src_aux)
+		ss_free(&src_aux);
+	return ss_check(s);
+}
+
+ss_t *ss_enc_lzw_dict(ss_t **s, const ss_t *src, const ss_t *dict)
+{
+	return aux_lzw_dict(s, src, dict, S_TRUE);
+}
+
+ss_t *ss_dec_lzw_dict(ss_t **s, const ss_t *src, const ss_t *dict)
+{
+	return aux_lzw_dict(s, src, dict, S_FALSE);
+}
+
+ss_t *ss_build_lzw_dict(ss_t **dict, const ss_t **samples,
+			const size_t nsamples, const size_t max_size)
+{
+	ASSERT_RETURN_IF(!dict, ss_void);
+	size_t i, out_size = 0;
+	const unsigned char **b = NULL;
+	size_t *bs = NULL;
+	if (samples && nsamples > 0 && max_size > 0 &&
+	    ss_reserve(dict, max_size) >= max_size) {
+		b = (const unsigned char **)s_malloc(nsamples * sizeof(*b));
+		bs = (size_t *)s_malloc(nsamples * sizeof(*bs));
+	}
+	if (b && bs) {
+		for (i = 0; i < nsamples; i++) {
+			b[i] = samples[i] && samples[i] != *dict ?
+				(const unsigned char *)
+					ss_get_buffer_r(samples[i]) : NULL;
+			bs[i] = b[i] ? ss_size(samples[i]) : 0;
+		}
+		out_size = senc_dict_build(b, bs, nsamples,
+					   (unsigned char *)ss_get_buffer(*dict),
+					   max_size);
+	}
+	s_free(b);
+	s_free(bs);
+	if (*dict) {
+		ss_set_size(*dict, out_size);
+		set_unicode_size_cached(*dict, S_FALSE);
+	}
+	return ss_check(dict);
+}
+
+/*
+ * Block framing (parallel encoding/decoding)
+ */
+
+#define SS_FR_ENC	0
+#define SS_FR_DEC	1
+#define SS_FR_DEC_BLOCK	2
+
+static ss_t *aux_frame(ss_t **s, const ss_t *src, const int mode,
+		       const size_t block_size, const int codec,
+		       const size_t nthreads, const size_t block_index)
+{
+	ASSERT_RETURN_IF(!s, ss_void);
+	if (!src)
+		src = ss_void;
+	ss_t *src_aux = NULL;
+	if (*s == src) { /* BEHAVIOR: aliasing: use a copy for the input */
+		ss_cpy(&src_aux, src);
+		src = src_aux;
+	}
+	const unsigned char *b = (const unsigned char *)ss_get_buffer_r(src);
+	unsigned char *o = NULL;
+	size_t in_size = ss_size(src), out_size = 0;
+	for (;;) {
+		switch (mode) {
+		case SS_FR_ENC:
+			out_size = senc_frame(b, in_size, o, block_size, codec,
+					      nthreads);
+			break;
+		case SS_FR_DEC:
+			out_size = sdec_frame(b, in_size, o, nthreads);
+			break;
+		default:
+			out_size = sdec_frame_block(b, in_size, block_index,
+						    o);
+		}
+		if (o || !out_size || ss_reserve(s, out_size) < out_size)
+			break;
+		o = (unsigned char *)ss_get_buffer(*s);
+	}
+	if (*s && (o || !out_size)) {
+		ss_set_size(*s, o ? out_size : 0);
+		set_unicode_size_cached(*s, S_FALSE);
+	}
+	if (src_aux)
+		ss_free(&src_aux);
+	return ss_check(s);
+}
+
+ss_t *ss_enc_frame(ss_t **s, const ss_t *src, const size_t block_size,
+		   const enum eSFrameCodec codec, const size_t nthreads)
+{
+	return aux_frame(s, src, SS_FR_ENC, block_size, (int)codec, nthreads,
+			 0);
+}
+
+ss_t *ss_dec_frame(ss_t **s, const ss_t *src, const size_t nthreads)
+{
+	return aux_frame(s, src, SS_FR_DEC, 0, 0, nthreads, 0);
+}
+
+ss_t *ss_dec_frame_block(ss_t **s, const ss_t *src, const size_t block_index)
+{
+	return aux_frame(s, src, SS_FR_DEC_BLOCK, 0, 0, 1, block_index);
+}
+
+size_t ss_frame_nblocks(const ss_t *src)
+{
+	RETURN_IF(!src, 0);
+	return sdec_frame_nblocks((const unsigned char *)ss_get_buffer_r(src),
+				  ss_size(src));
+}
+
 /*
  * Allocation
  */
@@ -26,6 +26,7 @@ extern "C" {
 #include "svector.h"
 #include "saux/scommon.h"
 #include "saux/sdata.h"
+#include "saux/senc.h"
 
 /*
  * String base structure
@@ -262,6 +263,15 @@ ss_t *ss_dup_enc_lzw(const ss_t *src);
 /* #API: |Duplicate string with RLE encoding|string|output result|O(n)|1;2| */
 ss_t *ss_dup_enc_rle(const ss_t *src);
 
+/* #API: |Duplicate string with Huffman encoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_enc_huf(const ss_t *src);
+
+/* #API: |Duplicate string with RLE + Huffman encoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_enc_rle_huf(const ss_t *src);
+
+/* #API: |Duplicate string with LZW + Huffman encoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_enc_lzw_huf(const ss_t *src);
+
 /* #API: |Duplicate string with JSON escape encoding|string|output result|O(n)|1;2| */
 ss_t *ss_dup_enc_esc_json(const ss_t *src);
 
@@ -289,6 +299,15 @@ ss_t *ss_dup_dec_lzw(const ss_t *src);
 /* #API: |Duplicate string with RLE decoding|string|output result|O(n)|1;2| */
 ss_t *ss_dup_dec_rle(const ss_t *src);
 
+/* #API: |Duplicate string with Huffman decoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_dec_huf(const ss_t *src);
+
+/* #API: |Duplicate string with RLE + Huffman decoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_dec_rle_huf(const ss_t *src);
+
+/* #API: |Duplicate string with LZW + Huffman decoding|string|output result|O(n)|1;2| */
+ss_t *ss_dup_dec_lzw_huf(const ss_t *src);
+
 /* #API: |Duplicate string with JSON escape decoding|string|output result|O(n)|1;2| */
 ss_t *ss_dup_dec_esc_json(const ss_t *src);
 
@@ -389,6 +408,15 @@ ss_t *ss_cpy_enc_lzw(ss_t **s, const ss_t *src);
 /* #API: |Overwrite string with input string RLE encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cpy_enc_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Overwrite string with input string Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_enc_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Overwrite string with input string RLE + Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_enc_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Overwrite string with input string LZW + Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_enc_lzw_huf(ss_t **s, const ss_t *src);
+
 /* #API: |Overwrite string with input string JSON escape encoding copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cpy_enc_esc_json(ss_t **s, const ss_t *src);
 
@@ -416,6 +444,15 @@ ss_t *ss_cpy_dec_lzw(ss_t **s, const ss_t *src);
 /* #API: |Overwrite string with input string RLE decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cpy_dec_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Overwrite string with input string Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_dec_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Overwrite string with input string RLE + Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_dec_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Overwrite string with input string LZW + Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cpy_dec_lzw_huf(ss_t **s, const ss_t *src);
+
 /* #API: |Overwrite string with input string JSON escape decoding copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cpy_dec_esc_json(ss_t **s, const ss_t *src);
 
@@ -531,6 +568,15 @@ ss_t *ss_cat_enc_lzw(ss_t **s, const ss_t *src);
 /* #API: |Concatenate string with input string RLE encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cat_enc_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Concatenate string with input string Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_enc_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Concatenate string with input string RLE + Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_enc_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Concatenate string with input string LZW + Huffman encoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_enc_lzw_huf(ss_t **s, const ss_t *src);
+
 /* #API: |Concatenate string with input string JSON escape encoding copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cat_enc_esc_json(ss_t **s, const ss_t *src);
 
@@ -558,6 +604,15 @@ ss_t *ss_cat_dec_lzw(ss_t **s, const ss_t *src);
 /* #API: |Concatenate string with input string RLE decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cat_dec_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Concatenate string with input string Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_dec_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Concatenate string with input string RLE + Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_dec_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Concatenate string with input string LZW + Huffman decoded copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_cat_dec_lzw_huf(ss_t **s, const ss_t *src);
+
 /* #API: |Concatenate string with input string JSON escape decoding copy|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_cat_dec_esc_json(ss_t **s, const ss_t *src);
 
@@ -634,6 +689,15 @@ ss_t *ss_enc_lzw(ss_t **s, const ss_t *src);
 /* #API: |Convert to RLE|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_enc_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Convert to Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_enc_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Convert to RLE + Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_enc_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Convert to LZW + Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_enc_lzw_huf(ss_t **s, const ss_t *src);
+
 /* #API: |Convert/escape for JSON encoding|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_enc_esc_json(ss_t **s, const ss_t *src);
 
@@ -661,6 +725,36 @@ ss_t *ss_dec_lzw(ss_t **s, const ss_t *src);
 /* #API: |Decode from RLE|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_dec_rle(ss_t **s, const ss_t *src);
 
+/* #API: |Decode from Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Decode from RLE + Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_rle_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Decode from LZW + Huffman|output string; input string|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_lzw_huf(ss_t **s, const ss_t *src);
+
+/* #API: |Convert to LZW, using a preset dictionary (see ss_build_lzw_dict())|output string; input string; dictionary|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_enc_lzw_dict(ss_t **s, const ss_t *src, const ss_t *dict);
+
+/* #API: |Decode from LZW, using a preset dictionary (the same used for encoding)|output string; input string; dictionary|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_lzw_dict(ss_t **s, const ss_t *src, const ss_t *dict);
+
+/* #API: |Build LZW preset dictionary from sample data (useful for compressing small strings, e.g. < 4KB, having common content). Recommended dictionary size: 1024 to 4096 bytes|output dictionary; sample string array; number of samples; maximum dictionary size|output dictionary reference (optional usage)|O(n * max_size)|1;2| */
+ss_t *ss_build_lzw_dict(ss_t **dict, const ss_t **samples, const size_t nsamples, const size_t max_size);
+
+/* #API: |Convert to block frame (independent blocks encoded in parallel, with CRC-32 and block index)|output string; input string; block size (0: default, 1MB); block codec (SFR_LZW, SFR_RLE, SFR_HUF, SFR_LZW_HUF, SFR_RLE_HUF); number of threads (0: one per CPU)|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_enc_frame(ss_t **s, const ss_t *src, const size_t block_size, const enum eSFrameCodec codec, const size_t nthreads);
+
+/* #API: |Decode from block frame (blocks decoded in parallel, CRC-32 checked). On error, output string is empty|output string; input string; number of threads (0: one per CPU)|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_frame(ss_t **s, const ss_t *src, const size_t nthreads);
+
+/* #API: |Decode one block from block frame (random access). On error, output string is empty|output string; input string; block index (0 to ss_frame_nblocks() - 1)|output string reference (optional usage)|O(n)|1;2| */
+ss_t *ss_dec_frame_block(ss_t **s, const ss_t *src, const size_t block_index);
+
+/* #API: |Number of blocks in block frame|input string|number of blocks (0: invalid frame)|O(n)|1;2| */
+size_t ss_frame_nblocks(const ss_t *src);
+
 /* #API: |Unescape from JSON encoding|output string; input string|output string reference (optional usage)|O(n)|1;2| */
 ss_t *ss_dec_esc_json(ss_t **s, const ss_t *src);
 
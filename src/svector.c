@@ -9,7 +9,6 @@
 
 #include "svector.h"
 #include "saux/scommon.h"
-#include "saux/ssort.h"
 
 #ifndef SV_DEFAULT_SIGNED_VAL
 #define SV_DEFAULT_SIGNED_VAL 0
@@ -91,8 +90,8 @@ static T_SVLDX svldx_f[SV_LAST_INT + 1] = { svldi8, (T_SVLDX)svldu8,
 
 #define BUILD_CMP_I(FN, T)					\
 	static int FN(const void *a, const void *b) {		\
-		int64_t r = *((const T *)a) - *((const T *)b);	\
-		return r < 0 ? -1 : r > 0 ? 1 : 0;		\
+		T a2 = *((const T *)a), b2 = *((const T *)b);	\
+		return a2 < b2 ? -1 : a2 == b2 ? 0 : 1;		\
 	}
 
 #define BUILD_CMP_U(FN, T)					\
@@ -110,19 +109,36 @@ BUILD_CMP_U(__sv_cmp_u16, unsigned short)
 BUILD_CMP_U(__sv_cmp_u32, unsigned int)
 BUILD_CMP_U(__sv_cmp_u64, uint64_t)
 
-static uint8_t svt_sizes[SV_LAST_INT + 1] = {	sizeof(char),
-						sizeof(unsigned char),
-						sizeof(short),
-						sizeof(unsigned short),
-						sizeof(int),
-						sizeof(unsigned int),
-						sizeof(int64_t),
-						sizeof(uint64_t) };
+/* Floating point: IEEE 754 total order (same as the radix sort) */
+#define BUILD_CMP_F(FN, UT, KEY)				\
+	static int FN(const void *a, const void *b) {		\
+		UT a2, b2;					\
+		memcpy(&a2, a, sizeof(a2));			\
+		memcpy(&b2, b, sizeof(b2));			\
+		a2 = KEY(a2);					\
+		b2 = KEY(b2);					\
+		return a2 < b2 ? -1 : a2 == b2 ? 0 : 1;		\
+	}
 
-static sv_cmp_t svt_cmpf[SV_LAST_INT + 1] = {	__sv_cmp_i8, __sv_cmp_u8,
-						__sv_cmp_i16, __sv_cmp_u16,
-						__sv_cmp_i32, __sv_cmp_u32,
-						__sv_cmp_i64, __sv_cmp_u64 };
+BUILD_CMP_F(__sv_cmp_f32, uint32_t, ssort_f32_key)
+BUILD_CMP_F(__sv_cmp_f64, uint64_t, ssort_f64_key)
+
+static uint8_t svt_sizes[SV_GEN] = {	sizeof(char),
+					sizeof(unsigned char),
+					sizeof(short),
+					sizeof(unsigned short),
+					sizeof(int),
+					sizeof(unsigned int),
+					sizeof(int64_t),
+					sizeof(uint64_t),
+					sizeof(float),
+					sizeof(double) };
+
+static sv_cmp_t svt_cmpf[SV_GEN] = {	__sv_cmp_i8, __sv_cmp_u8,
+					__sv_cmp_i16, __sv_cmp_u16,
+					__sv_cmp_i32, __sv_cmp_u32,
+					__sv_cmp_i64, __sv_cmp_u64,
+					__sv_cmp_f32, __sv_cmp_f64 };
 
 static sv_t *sv_alloc_base(const enum eSV_Type t, const size_t elem_size,
 			   const size_t init_size,
@@ -306,9 +322,24 @@ static const char *ptr_to_elem_r(const sv_t *v, const size_t i)
 	return (const char *)sv_get_buffer_r(v) + i * v->d.elem_size;
 }
 
+#define SV_IS_FLOAT(v) ((v)->d.sub_type == SV_F32 || (v)->d.sub_type == SV_F64)
+
+static double sv_ld_f(const void *p, const int t)
+{
+	return t == SV_F32 ? *(const float *)p : *(const double *)p;
+}
+
+static void sv_st_f(void *p, const int t, const double x)
+{
+	if (t == SV_F32)
+		*(float *)p = (float)x;
+	else
+		*(double *)p = x;
+}
+
 uint8_t sv_elem_size(const enum eSV_Type t)
 {
-	return t > SV_LAST_INT ? 0 : svt_sizes[t];
+	return t >= SV_GEN ? 0 : svt_sizes[t];
 }
 
 /*
@@ -324,7 +355,7 @@ sv_t *sv_alloc_raw(const enum eSV_Type t, const sbool_t ext_buf, void *buffer,
 	sd_reset((sd_t *)v, sizeof(sv_t), elem_size, max_size, ext_buf,
 		 S_FALSE);
 	v->d.sub_type = t;
-	v->vx.cmpf = t <= SV_LAST_INT ? svt_cmpf[t] : f;
+	v->vx.cmpf = t < SV_GEN ? svt_cmpf[t] : f;
 	return v;
 }
 
@@ -446,64 +477,1545 @@ sv_t *sv_sort(sv_t *v)
 	case SV_U32: ssort_u32((uint32_t *)buf, buf_size); break;
 	case SV_I64: ssort_i64((int64_t *)buf, buf_size); break;
 	case SV_U64: ssort_u64((uint64_t *)buf, buf_size); break;
-	default:     qsort(buf, buf_size, elem_size, v->vx.cmpf);
+	case SV_F32: ssort_f32((float *)buf, buf_size); break;
+	case SV_F64: ssort_f64((double *)buf, buf_size); break;
+	default:     ssort_gen(buf, buf_size, elem_size, v->vx.cmpf);
 	}
 #else
-	qsort(buf, buf_size, elem_size, v->vx.cmpf);
+	ssort_gen(buf, buf_size, elem_size, v->vx.cmpf);
 #endif
 	return v;
 }
 
+sbool_t sv_sort_with_chk(const sv_t *v, const size_t elem_size)
+{
+	return v && elem_size && v->d.elem_size == elem_size ? S_TRUE :
+								 S_FALSE;
+}
+
 /*
- * Search
+ * Argsort: integer keys are mapped to unsigned order (sign bit flipped,
+ * floating point keys with the total order transform) and sorted with
+ * their index as payload (stable LSD radix sort). If there is not enough
+ * memory for that, and key and index fit together in 64 bits, they are
+ * packed and sorted in-place (MSD radix sort, stable too, as the index is
+ * part of the key). Generic vectors: indexes are sorted with the
+ * vector compare function, ties resolved by index.
  */
 
-size_t sv_find(const sv_t *v, const size_t off, const void *target)
+struct SVArgCtx
 {
-	RETURN_IF(!v || v->d.sub_type > SV_GEN, S_NPOS);
-	size_t pos = S_NPOS;
-	const size_t size = sv_size(v);
+	const char *b;
+	size_t es;
+	sv_cmp_t f;
+};
+
+S_INLINE sbool_t sv_arg_lt(const uint64_t *x, const uint64_t *y,
+			   const struct SVArgCtx *c)
+{
+	int r = c->f(c->b + (size_t)*x * c->es, c->b + (size_t)*y * c->es);
+	return r < 0 || (!r && *x < *y) ? S_TRUE : S_FALSE;
+}
+
+SSORT_BUILD_PDQ_CTX(sv_argsort_gen, uint64_t, const struct SVArgCtx *,
+		    sv_arg_lt)
+
+/* Elements as unsigned sort keys (integer and floating point vectors) */
+static void sv_ord_keys(uint64_t *k, const sv_t *v, const size_t n)
+{
+	size_t i;
+	const enum eSV_Type t = (enum eSV_Type)v->d.sub_type;
 	const void *p = sv_get_buffer_r(v);
-	const size_t elem_size = v->d.elem_size;
-	RETURN_IF(!elem_size, S_NPOS);
-	const size_t off_max = size * v->d.elem_size;
+	if (t == SV_F32) {
+		for (i = 0; i < n; i++)
+			k[i] = ssort_f32_key(((const uint32_t *)p)[i]);
+	} else if (t == SV_F64) {
+		for (i = 0; i < n; i++)
+			k[i] = ssort_f64_key(((const uint64_t *)p)[i]);
+	} else {
+		const size_t kb = v->d.elem_size * 8;
+		const uint64_t sb = (t & 1) ? 0 : (uint64_t)1 << (kb - 1),
+			       km = kb == 64 ? SUINT64_MAX :
+					       ((uint64_t)1 << kb) - 1;
+		const T_SVLDX ld = svldx_f[t];
+		for (i = 0; i < n; i++)
+			k[i] = ((uint64_t)ld(p, i) ^ sb) & km;
+	}
+}
+
+static sbool_t sv_argsort_aux(uint64_t *o, const sv_t *v, const size_t n)
+{
+	size_t i, ib;
+	sbool_t r = S_FALSE;
+	if (v->d.sub_type == SV_GEN) {
+		struct SVArgCtx c;
+		c.b = sv_get_buffer_r(v);
+		c.es = v->d.elem_size;
+		c.f = v->vx.cmpf;
+		for (i = 0; i < n; i++)
+			o[i] = i;
+		sv_argsort_gen(o, n, &c);
+		return S_TRUE;
+	}
+	uint64_t *k = (uint64_t *)s_malloc(n * sizeof(uint64_t));
+	if (k) {
+		sv_ord_keys(k, v, n);
+		for (i = 0; i < n; i++)
+			o[i] = i;
+		r = ssort_kv_u64(k, o, n);
+		s_free(k);
+	}
+#ifndef S_MINIMAL
+	for (ib = 1; ib < 64 && ((uint64_t)(n - 1) >> ib) != 0; ib++);
+	if (!r && v->d.elem_size * 8 + ib <= 64) {
+		const uint64_t im = ((uint64_t)1 << ib) - 1;
+		sv_ord_keys(o, v, n);
+		for (i = 0; i < n; i++)
+			o[i] = o[i] << ib | i;
+		ssort_u64(o, n);
+		for (i = 0; i < n; i++)
+			o[i] &= im;
+		r = S_TRUE;
+	}
+#else
+	(void)ib;
+#endif
+	return r;
+}
+
+sv_t *sv_argsort(sv_t **perm, const sv_t *v)
+{
+	ASSERT_RETURN_IF(!perm, sv_void);
+	const size_t n = v ? sv_size(v) : 0;
+	if (!*perm)
+		*perm = sv_alloc_t(SV_U64, n);
+	RETURN_IF((*perm)->d.sub_type != SV_U64 || *perm == v ||
+		  sv_reserve(perm, n) < n,
+		  sv_check(perm)); /* BEHAVIOR: only SV_U64 output is allowed */
+	sv_set_size(*perm, 0);
+	RETURN_IF(!n || (v->d.sub_type == SV_GEN && !v->vx.cmpf), *perm);
+	if (sv_argsort_aux((uint64_t *)sv_get_buffer(*perm), v, n))
+		sv_set_size(*perm, n);
+	else
+		sd_set_alloc_errors((sd_t *)*perm);
+	return *perm;
+}
+
+#define SV_GATHER(T)						\
+	for (i = 0; i < n; i++)					\
+		((T *)tmp)[i] = ((const T *)b)[perm[i]]
+
+static void sv_permute(sv_t *v, const uint64_t *perm, void *tmp)
+{
+	size_t i;
+	const size_t n = sv_size(v), es = v->d.elem_size;
+	char *b = sv_get_buffer(v);
+	switch (es) {
+	case 1: SV_GATHER(uint8_t); break;
+	case 2: SV_GATHER(uint16_t); break;
+	case 4: SV_GATHER(uint32_t); break;
+	case 8: SV_GATHER(uint64_t); break;
+	default:
+		for (i = 0; i < n; i++)
+			memcpy((char *)tmp + i * es, b + (size_t)perm[i] * es,
+			       es);
+	}
+	memcpy(b, tmp, n * es);
+}
+
+sbool_t sv_sort_pairs(sv_t *keys, sv_t *values)
+{
+	RETURN_IF(!keys || !values || keys == values ||
+		  sv_size(keys) != sv_size(values), S_FALSE);
+	const size_t n = sv_size(keys),
+		     es = S_MAX(keys->d.elem_size, values->d.elem_size);
+	RETURN_IF(n <= 1, S_TRUE);
+	sv_t *perm = NULL;
+	void *tmp = s_malloc(n * es);
+	const sbool_t ok = tmp && sv_size(sv_argsort(&perm, keys)) == n ?
+			   S_TRUE : S_FALSE;
+	if (ok) {
+		sv_permute(keys, (const uint64_t *)sv_get_buffer_r(perm), tmp);
+		sv_permute(values, (const uint64_t *)sv_get_buffer_r(perm),
+			   tmp);
+	}
+	sv_free(&perm);
+	s_free(tmp);
+	return ok;
+}
+
+/*
+ * Selection: nth element, partial sort and top-k. Integer and floating
+ * point vectors use type-specialized templates (floating point elements are
+ * compared as total order keys, as in sv_sort). Generic vectors use their
+ * compare function.
+ */
+
+#define SV_TOPK_HEAP_RATIO	8	/* heap if k * ratio <= n */
+
+#define SV_SEL_LT(a, b) (*(a) < *(b))
+#define SV_SEL_F32_LT(a, b) (ssort_f32_key(*(a)) < ssort_f32_key(*(b)))
+#define SV_SEL_F64_LT(a, b) (ssort_f64_key(*(a)) < ssort_f64_key(*(b)))
+
+#define BUILD_SV_SELECT(SUF, T, LT)					\
+	SSORT_BUILD_PDQ(sv_pdq_##SUF, T, LT)				\
+	SSORT_BUILD_SELECT(sv_pdq_##SUF, T, LT)				\
+	SSORT_BUILD_TOPK(sv_pdq_##SUF, T, LT)
+
+BUILD_SV_SELECT(i8, int8_t, SV_SEL_LT)
+BUILD_SV_SELECT(u8, uint8_t, SV_SEL_LT)
+BUILD_SV_SELECT(i16, int16_t, SV_SEL_LT)
+BUILD_SV_SELECT(u16, uint16_t, SV_SEL_LT)
+BUILD_SV_SELECT(i32, int32_t, SV_SEL_LT)
+BUILD_SV_SELECT(u32, uint32_t, SV_SEL_LT)
+BUILD_SV_SELECT(i64, int64_t, SV_SEL_LT)
+BUILD_SV_SELECT(u64, uint64_t, SV_SEL_LT)
+BUILD_SV_SELECT(f32, uint32_t, SV_SEL_F32_LT)
+BUILD_SV_SELECT(f64, uint64_t, SV_SEL_F64_LT)
+
+#undef BUILD_SV_SELECT
+
+#define SV_SELECT_CASE(ST, SUF, T)					\
+	case ST:							\
+		sv_pdq_##SUF##_select((T *)b, n, nth);			\
+		if (sort_head)						\
+			sv_pdq_##SUF((T *)b, nth);			\
+		break
+
+#define SV_SELECT_SWITCH(CASE)						\
+	switch (v->d.sub_type) {					\
+	CASE(SV_I8, i8, int8_t);					\
+	CASE(SV_U8, u8, uint8_t);					\
+	CASE(SV_I16, i16, int16_t);					\
+	CASE(SV_U16, u16, uint16_t);					\
+	CASE(SV_I32, i32, int32_t);					\
+	CASE(SV_U32, u32, uint32_t);					\
+	CASE(SV_I64, i64, int64_t);					\
+	CASE(SV_U64, u64, uint64_t);					\
+	CASE(SV_F32, f32, uint32_t);					\
+	CASE(SV_F64, f64, uint64_t);					\
+	default:							\
+		break;							\
+	}
+
+/* nth element, optionally sorting the elements before it (nth < size) */
+static void sv_select_x(sv_t *v, const size_t nth, const sbool_t sort_head)
+{
+	char *b = sv_get_buffer(v);
+	const size_t n = sv_size(v);
+	if (v->d.sub_type == SV_GEN) {
+		ssort_gen_select(b, n, v->d.elem_size, nth, v->vx.cmpf);
+		if (sort_head)
+			ssort_gen(b, nth, v->d.elem_size, v->vx.cmpf);
+		return;
+	}
+	SV_SELECT_SWITCH(SV_SELECT_CASE);
+}
+
+#define SV_LARGEST_CASE(ST, SUF, T)					\
+	case ST:							\
+		sv_pdq_##SUF##_largest((T *)o, (const T *)b, n, k);	\
+		break
+
+/* k greatest elements, descending (typed vectors, k <= size) */
+static void sv_largest_x(void *o, const sv_t *v, const size_t k)
+{
+	const char *b = sv_get_buffer_r(v);
+	const size_t n = sv_size(v);
+	SV_SELECT_SWITCH(SV_LARGEST_CASE);
+}
+
+#undef SV_LARGEST_CASE
+#undef SV_SELECT_SWITCH
+#undef SV_SELECT_CASE
+
+static void sv_reverse_elems(sv_t *v)
+{
+	const size_t n = sv_size(v), es = v->d.elem_size;
+	size_t i, j, k;
+	char *b = sv_get_buffer(v), c;
+	for (i = 0, j = n ? n - 1 : 0; i < j; i++, j--)
+		for (k = 0; k < es; k++) {
+			c = b[i * es + k];
+			b[i * es + k] = b[j * es + k];
+			b[j * es + k] = c;
+		}
+}
+
+sv_t *sv_nth_element(sv_t *v, const size_t nth)
+{
+	RETURN_IF(!v || nth >= sv_size(v) ||
+		  (v->d.sub_type == SV_GEN && !v->vx.cmpf), sv_check(&v));
+	sv_select_x(v, nth, S_FALSE);
+	return v;
+}
+
+sv_t *sv_partial_sort(sv_t *v, const size_t k)
+{
+	RETURN_IF(!v || (v->d.sub_type == SV_GEN && !v->vx.cmpf),
+		  sv_check(&v));
+	if (k >= sv_size(v))
+		return sv_sort(v);
+	if (k > 0)
+		sv_select_x(v, k, S_TRUE);
+	return v;
+}
+
+sv_t *sv_top_k(sv_t **out, const sv_t *v, const size_t k)
+{
+	ASSERT_RETURN_IF(!out, sv_void);
+	const size_t n = v ? sv_size(v) : 0, m = S_MIN(k, n);
+	sv_t *tmp = NULL, **r = *out == v ? &tmp : out;
+	if (!v || (v->d.sub_type == SV_GEN && !v->vx.cmpf)) {
+		sv_clear(*out); /* BEHAVIOR: empty output */
+		return sv_check(out);
+	}
+	if (v->d.sub_type != SV_GEN && m * SV_TOPK_HEAP_RATIO <= n) {
+		if (*r)
+			aux_cat(r, S_FALSE, v, 0); /* input type, empty */
+		if (aux_reserve(r, v, m) >= m &&
+		    (*r)->d.sub_type == v->d.sub_type) {
+			sv_largest_x(sv_get_buffer(*r), v, m);
+			sv_set_size(*r, m);
+		}
+	} else if (sv_size(sv_cpy(r, v)) == n) {
+		if (m < n) {
+			sv_select_x(*r, n - m, S_FALSE);
+			sv_erase(r, 0, n - m);
+		}
+		sv_sort(*r);
+		sv_reverse_elems(*r);
+	}
+	if (sv_size(*r) != m) /* BEHAVIOR: not enough memory */
+		sv_clear(*r);
+	if (tmp) { /* aliasing: output is the input */
+		sv_cpy(out, tmp);
+		sv_free(&tmp);
+	}
+	return sv_check(out);
+}
+
+/*
+ * Search
+ */
+
+/*
+ * Search kernels: equality is sign-agnostic, so one kernel per element size
+ * covers both signed and unsigned types. SSE2: 64 bytes per step (4 x
+ * broadcast compare, OR-ed for the early exit, then movemask + ctz).
+ */
+
+#ifdef S_SIMD_SSE2
+
+S_INLINE __m128i sv_cmpeq64(__m128i a, __m128i b)
+{
+	__m128i e = _mm_cmpeq_epi32(a, b);
+	return _mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+#define SV_SET1_8(t) _mm_set1_epi8((char)(t))
+#define SV_SET1_16(t) _mm_set1_epi16((short)(t))
+#define SV_SET1_32(t) _mm_set1_epi32((int)(t))
+#define SV_SET1_64(t) _mm_set1_epi64x((long long)(t))
+#define SV_LD128(p) _mm_loadu_si128((const __m128i *)(p))
+#define SV_MMASK(a) ((uint64_t)(uint32_t)_mm_movemask_epi8(a))
+
+#define BUILD_SV_FIND(FN, T, SET1, CMPEQ)				\
+	static size_t FN(const void *p0, size_t i, const size_t n,	\
+			 const T t)					\
+	{								\
+		const T *p = (const T *)p0;				\
+		const size_t ne = 16 / sizeof(T);			\
+		const __m128i x = SET1(t);				\
+		for (; i + 4 * ne <= n; i += 4 * ne) {			\
+			__m128i a = CMPEQ(SV_LD128(p + i), x),		\
+				b = CMPEQ(SV_LD128(p + i + ne), x),	\
+				c = CMPEQ(SV_LD128(p + i + 2 * ne), x),	\
+				d = CMPEQ(SV_LD128(p + i + 3 * ne), x);	\
+			if (!_mm_movemask_epi8(_mm_or_si128(		\
+					_mm_or_si128(a, b),		\
+					_mm_or_si128(c, d))))		\
+				continue;				\
+			return i + s_ctz64(SV_MMASK(a) |		\
+					   SV_MMASK(b) << 16 |		\
+					   SV_MMASK(c) << 32 |		\
+					   SV_MMASK(d) << 48) / sizeof(T);\
+		}							\
+		for (; i < n; i++)					\
+			if (p[i] == t)					\
+				return i;				\
+		return S_NPOS;						\
+	}
+
+BUILD_SV_FIND(sv_find8, uint8_t, SV_SET1_8, _mm_cmpeq_epi8)
+BUILD_SV_FIND(sv_find16, uint16_t, SV_SET1_16, _mm_cmpeq_epi16)
+BUILD_SV_FIND(sv_find32, uint32_t, SV_SET1_32, _mm_cmpeq_epi32)
+BUILD_SV_FIND(sv_find64, uint64_t, SV_SET1_64, sv_cmpeq64)
+
+#else
+
+#define BUILD_SV_FIND(FN, T)						\
+	static size_t FN(const void *p0, size_t i, const size_t n,	\
+			 const T t)					\
+	{								\
+		const T *p = (const T *)p0;				\
+		for (; i + 4 <= n; i += 4)				\
+			if (p[i] == t || p[i + 1] == t ||		\
+			    p[i + 2] == t || p[i + 3] == t)		\
+				break;					\
+		for (; i < n; i++)					\
+			if (p[i] == t)					\
+				return i;				\
+		return S_NPOS;						\
+	}
+
+BUILD_SV_FIND(sv_find8, uint8_t)
+BUILD_SV_FIND(sv_find16, uint16_t)
+BUILD_SV_FIND(sv_find32, uint32_t)
+BUILD_SV_FIND(sv_find64, uint64_t)
+
+#endif
+
+#undef BUILD_SV_FIND
+
+static size_t sv_find_gen(const sv_t *v, const size_t off, const void *target)
+{
+	const size_t size = sv_size(v), elem_size = v->d.elem_size;
+	const unsigned char *p = (const unsigned char *)sv_get_buffer_r(v),
+			    t0 = *(const unsigned char *)target;
 	size_t i = off * elem_size;
+	const size_t off_max = size * elem_size;
 	for (; i < off_max; i += elem_size)
-		if (!memcmp((const char *)p + i, target, elem_size))
+		if (p[i] == t0 && !memcmp(p + i, target, elem_size))
 			return i / elem_size;	/* found */
-	return pos;
+	return S_NPOS;
 }
 
-#define SV_FIND_iu(v, off, target)					\
-	RETURN_IF(!v || v->d.sub_type > SV_U64, S_NPOS);		\
-	char i8; unsigned char u8; short i16; unsigned short u16;	\
-	int i32; unsigned u32; int64_t i64; uint64_t u64;		\
-	void *src;							\
-	switch (v->d.sub_type) {					\
-	case SV_I8: i8 = (char)target; src = &i8; break;		\
-	case SV_U8: u8 = (unsigned char)target; src = &u8; break;	\
-	case SV_I16: i16 = (short)target; src = &i16; break;		\
-	case SV_U16: u16 = (unsigned short)target; src = &u16; break;	\
-	case SV_I32: i32 = (int)target; src = &i32; break;		\
-	case SV_U32: u32 = (unsigned)target; src = &u32; break;		\
-	case SV_I64: i64 = (int64_t)target; src = &i64; break;		\
-	case SV_U64: u64 = (uint64_t)target; src = &u64; break;		\
-	default: src = NULL;						\
+/* Target value already converted to the vector element type */
+static size_t sv_find_x(const sv_t *v, const size_t off, const uint64_t t)
+{
+	const void *p = sv_get_buffer_r(v);
+	const size_t size = sv_size(v);
+	switch (v->d.sub_type) {
+	case SV_I8: case SV_U8:
+		return sv_find8(p, off, size, (uint8_t)t);
+	case SV_I16: case SV_U16:
+		return sv_find16(p, off, size, (uint16_t)t);
+	case SV_I32: case SV_U32: case SV_F32:
+		return sv_find32(p, off, size, (uint32_t)t);
+	case SV_I64: case SV_U64: case SV_F64:
+		return sv_find64(p, off, size, t);
+	default:
+		break;
 	}
+	return S_NPOS;
+}
+
+/* Element (pointed by "target") to the same bits as from sv_find_i/u */
+static uint64_t sv_ld_target(const sv_t *v, const void *target)
+{
+	uint8_t u8;
+	uint16_t u16;
+	uint32_t u32;
+	uint64_t u64 = 0;
+	switch (v->d.elem_size) {
+	case 1: memcpy(&u8, target, 1); u64 = u8; break;
+	case 2: memcpy(&u16, target, 2); u64 = u16; break;
+	case 4: memcpy(&u32, target, 4); u64 = u32; break;
+	case 8: memcpy(&u64, target, 8); break;
+	}
+	return u64;
+}
+
+size_t sv_find(const sv_t *v, const size_t off, const void *target)
+{
+	RETURN_IF(!v || v->d.sub_type > SV_GEN || !target, S_NPOS);
+	RETURN_IF(!v->d.elem_size || off >= sv_size(v), S_NPOS);
+	if (v->d.sub_type == SV_GEN)
+		return sv_find_gen(v, off, target);
+	return sv_find_x(v, off, sv_ld_target(v, target));
+}
 
 size_t sv_find_i(const sv_t *v, const size_t off, const int64_t target)
 {
-	SV_FIND_iu(v, off, target);
-	return sv_find(v, off, src);
+	RETURN_IF(!v || v->d.sub_type > SV_LAST_INT, S_NPOS);
+	return sv_find_x(v, off, (uint64_t)target);
 }
 
 size_t sv_find_u(const sv_t *v, const size_t off, const uint64_t target)
 {
-	SV_FIND_iu(v, off, target);
-	return sv_find(v, off, src);
+	RETURN_IF(!v || v->d.sub_type > SV_LAST_INT, S_NPOS);
+	return sv_find_x(v, off, target);
+}
+
+sv_t *sv_find_all(sv_t **out, const sv_t *v, const size_t off,
+		  const void *target)
+{
+	ASSERT_RETURN_IF(!out, sv_void);
+	sv_t *tmp = NULL, **r = *out && *out == v ? &tmp : out;
+	if (!*r)
+		*r = sv_alloc_t(SV_U64, 0);
+	else
+		sv_clear(*r);
+	/* BEHAVIOR: 8/16-bit outputs would truncate the offsets */
+	if (v && target && *r && (*r)->d.sub_type <= SV_LAST_INT &&
+	    (*r)->d.elem_size >= 4) {
+		size_t i = off;
+		const sbool_t gen = v->d.sub_type == SV_GEN;
+		const uint64_t t = gen ? 0 : sv_ld_target(v, target);
+		for (;; i++) {
+			i = gen ? sv_find_gen(v, i, target) :
+				  sv_find_x(v, i, t);
+			if (i == S_NPOS || !sv_push_u(r, i))
+				break;
+		}
+	}
+	if (tmp) { /* aliasing: output is the input */
+		sv_cpy(out, tmp);
+		sv_free(&tmp);
+	}
+	return sv_check(out);
+}
+
+/*
+ * Binary search (sorted vectors): branchless, with the two possible next
+ * probes prefetched. Eytzinger index: breadth-first layout of the sorted
+ * elements (slot k has its children at 2k and 2k + 1), so the first tree
+ * levels share cache lines.
+ */
+
+#define SV_EYT_PF	16	/* prefetch 4 levels ahead */
+
+#define BUILD_SV_SEARCH(SUF, T)						\
+	static size_t sv_lb_##SUF(const T *p, size_t n, const T t)	\
+	{								\
+		const T *b = p;						\
+		RETURN_IF(!n, 0);					\
+		for (; n > 1; n -= n / 2) {				\
+			S_PREFETCH_R(b + n / 4);			\
+			S_PREFETCH_R(b + n / 2 + n / 4);		\
+			b = b[n / 2] < t ? b + n / 2 : b;		\
+		}							\
+		return (size_t)(b - p) + (*b < t);			\
+	}								\
+	static size_t sv_ub_##SUF(const T *p, size_t n, const T t)	\
+	{								\
+		const T *b = p;						\
+		RETURN_IF(!n, 0);					\
+		for (; n > 1; n -= n / 2) {				\
+			S_PREFETCH_R(b + n / 4);			\
+			S_PREFETCH_R(b + n / 2 + n / 4);		\
+			b = b[n / 2] <= t ? b + n / 2 : b;		\
+		}							\
+		return (size_t)(b - p) + (*b <= t);			\
+	}								\
+	static size_t sv_eyt_##SUF(const T *p, size_t n, const T t)	\
+	{								\
+		size_t k = 1;						\
+		for (; k <= n; k = 2 * k + (p[k] < t))			\
+			S_PREFETCH_R(p + k * SV_EYT_PF);		\
+		k >>= s_ctz64(~(uint64_t)k) + 1;			\
+		return k ? k : S_NPOS;					\
+	}
+
+BUILD_SV_SEARCH(i8, int8_t)
+BUILD_SV_SEARCH(u8, uint8_t)
+BUILD_SV_SEARCH(i16, int16_t)
+BUILD_SV_SEARCH(u16, uint16_t)
+BUILD_SV_SEARCH(i32, int32_t)
+BUILD_SV_SEARCH(u32, uint32_t)
+BUILD_SV_SEARCH(i64, int64_t)
+BUILD_SV_SEARCH(u64, uint64_t)
+
+#undef BUILD_SV_SEARCH
+
+static size_t sv_bound_gen(const char *p, size_t n, const size_t es,
+			   const sv_cmp_t f, const void *t, const int upper)
+{
+	const char *b = p;
+	RETURN_IF(!n, 0);
+	for (; n > 1; n -= n / 2) {
+		S_PREFETCH_R(b + (n / 4) * es);
+		S_PREFETCH_R(b + (n / 2 + n / 4) * es);
+		b = f(b + (n / 2) * es, t) < upper ? b + (n / 2) * es : b;
+	}
+	return (size_t)(b - p) / es + (f(b, t) < upper);
+}
+
+static size_t sv_eyt_gen(const char *p, size_t n, const size_t es,
+			 const sv_cmp_t f, const void *t)
+{
+	size_t k = 1;
+	for (; k <= n; k = 2 * k + (f(p + k * es, t) < 0))
+		S_PREFETCH_R(p + k * SV_EYT_PF * es);
+	k >>= s_ctz64(~(uint64_t)k) + 1;
+	return k ? k : S_NPOS;
+}
+
+#define SV_SEARCH_CASE(ST, SUF, T, FN, p, n, target)			\
+	case ST: {							\
+		T t;							\
+		memcpy(&t, target, sizeof(t));				\
+		return FN##SUF((const T *)(p), n, t);			\
+	}
+
+#define SV_SEARCH_SWITCH(v, FN, p, n, target)				\
+	switch (v->d.sub_type) {					\
+	SV_SEARCH_CASE(SV_I8, i8, int8_t, FN, p, n, target)		\
+	SV_SEARCH_CASE(SV_U8, u8, uint8_t, FN, p, n, target)		\
+	SV_SEARCH_CASE(SV_I16, i16, int16_t, FN, p, n, target)		\
+	SV_SEARCH_CASE(SV_U16, u16, uint16_t, FN, p, n, target)	\
+	SV_SEARCH_CASE(SV_I32, i32, int32_t, FN, p, n, target)		\
+	SV_SEARCH_CASE(SV_U32, u32, uint32_t, FN, p, n, target)	\
+	SV_SEARCH_CASE(SV_I64, i64, int64_t, FN, p, n, target)		\
+	SV_SEARCH_CASE(SV_U64, u64, uint64_t, FN, p, n, target)	\
+	default:							\
+		break;							\
+	}
+
+static size_t sv_bound(const sv_t *v, const void *target, const int upper)
+{
+	RETURN_IF(!v || !target || v->d.sub_type > SV_GEN, 0);
+	const char *p = sv_get_buffer_r(v);
+	const size_t n = sv_size(v);
+	if (upper) {
+		SV_SEARCH_SWITCH(v, sv_ub_, p, n, target);
+	} else {
+		SV_SEARCH_SWITCH(v, sv_lb_, p, n, target);
+	}
+	RETURN_IF(!v->vx.cmpf, 0); /* BEHAVIOR: generic without cmp. f. */
+	return sv_bound_gen(p, n, v->d.elem_size, v->vx.cmpf, target, upper);
+}
+
+size_t sv_lower_bound(const sv_t *v, const void *target)
+{
+	return sv_bound(v, target, 0);
+}
+
+size_t sv_upper_bound(const sv_t *v, const void *target)
+{
+	return sv_bound(v, target, 1);
+}
+
+size_t sv_bsearch(const sv_t *v, const void *target)
+{
+	size_t i = sv_lower_bound(v, target);
+	RETURN_IF(!target || i >= sv_size(v) ||
+		  (v->d.sub_type == SV_GEN && !v->vx.cmpf), S_NPOS);
+	return !(v->d.sub_type == SV_GEN ?
+		 v->vx.cmpf(ptr_to_elem_r(v, i), target) :
+		 memcmp(ptr_to_elem_r(v, i), target, v->d.elem_size)) ?
+	       i : S_NPOS;
+}
+
+static size_t sv_eyt_fill(sv_t *idx, const sv_t *v, size_t i, const size_t k,
+			  const size_t n)
+{
+	if (k <= n) {
+		i = sv_eyt_fill(idx, v, i, 2 * k, n);
+		memcpy(ptr_to_elem(idx, k), ptr_to_elem_r(v, i++),
+		       v->d.elem_size);
+		i = sv_eyt_fill(idx, v, i, 2 * k + 1, n);
+	}
+	return i;
+}
+
+sv_t *sv_build_search_index(sv_t **idx, const sv_t *v)
+{
+	ASSERT_RETURN_IF(!idx, sv_void);
+	RETURN_IF(!v || *idx == v, sv_check(idx));
+	const size_t n = sv_size(v);
+	if (*idx)
+		aux_cat(idx, S_FALSE, v, 0); /* source type, empty */
+	if (aux_reserve(idx, v, n + 1) >= n + 1 &&
+	    (*idx)->d.sub_type == v->d.sub_type &&
+	    (*idx)->d.elem_size == v->d.elem_size) {
+		(*idx)->vx.cmpf = v->vx.cmpf;
+		sv_set_size(*idx, n ? n + 1 : 0);
+		if (n) {	/* slot 0: unused (copy of the first element) */
+			sv_copy_elems(*idx, 0, v, 0, 1);
+			sv_eyt_fill(*idx, v, 0, 1, n);
+		}
+	}
+	return sv_check(idx);
+}
+
+size_t sv_search_index(const sv_t *idx, const void *target)
+{
+	RETURN_IF(!idx || !target || idx->d.sub_type > SV_GEN, S_NPOS);
+	const char *p = sv_get_buffer_r(idx);
+	const size_t n = sv_size(idx);
+	RETURN_IF(n < 2, S_NPOS);
+	SV_SEARCH_SWITCH(idx, sv_eyt_, p, n - 1, target);
+	RETURN_IF(!idx->vx.cmpf, S_NPOS);
+	return sv_eyt_gen(p, n - 1, idx->d.elem_size, idx->vx.cmpf, target);
 }
 
-#undef SV_FIND_iu
+#undef SV_SEARCH_SWITCH
+#undef SV_SEARCH_CASE
+
+/*
+ * Set algebra (sorted vectors): linear merge loops, switching to galloping
+ * (exponential + binary search) over the larger input when the sizes differ
+ * by more than SV_GALLOP_RATIO. Union, intersection and difference output
+ * sets (repeated input elements are emitted once), so the 32-bit SSE2
+ * intersection can compare 4x4 element blocks without tracking counts:
+ * matches are emitted in order, being duplicates the ones equal to the
+ * previous output element.
+ */
+
+#define SV_GALLOP_RATIO	32
+
+enum eSVSetOp { SV_OP_MERGE, SV_OP_UNION, SV_OP_ISECT, SV_OP_DIFF };
+
+#define SV_SET_EMIT(o, no, x)						\
+	((no) && (o)[(no) - 1] == (x) ? (void)0 : (void)((o)[(no)++] = (x)))
+
+static void sv_isect32(const uint32_t *a, const size_t na, const uint32_t *b,
+		       const size_t nb, uint32_t *o, size_t *ia, size_t *ib,
+		       size_t *ino, const int sgn)
+{
+#ifdef S_SIMD_SSE2
+	size_t i = 0, j = 0, no = 0;
+	const uint32_t bias = sgn ? 0x80000000 : 0;
+	uint32_t amax, bmax, x;
+	__m128i va, vb, m;
+	int mm;
+	while (i + 4 <= na && j + 4 <= nb) {
+		va = _mm_loadu_si128((const __m128i *)(a + i));
+		vb = _mm_loadu_si128((const __m128i *)(b + j));
+		m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(va, vb),
+			_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+			_mm_or_si128(
+			_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)),
+			_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+		mm = _mm_movemask_ps(_mm_castsi128_ps(m));
+		for (; mm; mm &= mm - 1) {
+			x = a[i + s_ctz32((uint32_t)mm)];
+			SV_SET_EMIT(o, no, x);
+		}
+		amax = a[i + 3] ^ bias;
+		bmax = b[j + 3] ^ bias;
+		i += amax <= bmax ? 4 : 0;
+		j += bmax <= amax ? 4 : 0;
+	}
+	*ia = i;
+	*ib = j;
+	*ino = no;
+#else
+	(void)a; (void)na; (void)b; (void)nb; (void)o; (void)ia; (void)ib;
+	(void)ino; (void)sgn;
+#endif
+}
+
+#define BUILD_SV_SETOP(SUF, T, SGN)					\
+	static size_t sv_uniq_##SUF(T *p, const size_t n)		\
+	{								\
+		size_t i, j;						\
+		RETURN_IF(n < 2, n);					\
+		for (i = 1; i < n && p[i] != p[i - 1]; i++);		\
+		for (j = i; i < n; i++)					\
+			if (p[i] != p[j - 1])				\
+				p[j++] = p[i];				\
+		return j;						\
+	}								\
+	static size_t sv_gallop_##SUF(const T *p, const size_t n,	\
+				      const T t)			\
+	{	/* lower bound, probing 1, 2, 4, ... elements ahead */	\
+		size_t lo = 0, hi, mid, step = 1;			\
+		RETURN_IF(!n || !(p[0] < t), 0);			\
+		for (; lo + step < n && p[lo + step] < t; step *= 2)	\
+			lo += step;					\
+		hi = S_MIN(lo + step, n);				\
+		while (hi - lo > 1) {					\
+			mid = lo + (hi - lo) / 2;			\
+			if (p[mid] < t)					\
+				lo = mid;				\
+			else						\
+				hi = mid;				\
+		}							\
+		return hi;						\
+	}								\
+	static size_t sv_setg_##SUF(const T *a, const size_t na,	\
+				    const T *b, const size_t nb, T *o,	\
+				    const enum eSVSetOp op)		\
+	{	/* galloping: "a" is the small one, except for diff. */	\
+		size_t i, j = 0, k, no = 0;				\
+		if (op == SV_OP_DIFF && na > nb) { /* skip b elements */ \
+			for (k = i = 0; k < nb; k++) {			\
+				j = i + sv_gallop_##SUF(a + i, na - i,	\
+							b[k]);		\
+				for (; i < j; i++)			\
+					SV_SET_EMIT(o, no, a[i]);	\
+				for (; i < na && a[i] == b[k]; i++);	\
+			}						\
+			for (; i < na; i++)				\
+				SV_SET_EMIT(o, no, a[i]);		\
+			return no;					\
+		}							\
+		for (i = 0; i < na; i++) {				\
+			k = j + sv_gallop_##SUF(b + j, nb - j, a[i]);	\
+			switch (op) {					\
+			case SV_OP_MERGE:				\
+				for (; j < k; j++)			\
+					o[no++] = b[j];			\
+				o[no++] = a[i];				\
+				break;					\
+			case SV_OP_UNION:				\
+				for (; j < k; j++)			\
+					SV_SET_EMIT(o, no, b[j]);	\
+				SV_SET_EMIT(o, no, a[i]);		\
+				break;					\
+			case SV_OP_ISECT:				\
+				if (k < nb && b[k] == a[i])		\
+					SV_SET_EMIT(o, no, a[i]);	\
+				j = k;					\
+				break;					\
+			case SV_OP_DIFF:				\
+				if (k == nb || b[k] != a[i])		\
+					SV_SET_EMIT(o, no, a[i]);	\
+				j = k;					\
+				break;					\
+			}						\
+		}							\
+		for (; op == SV_OP_MERGE && j < nb; j++)		\
+			o[no++] = b[j];					\
+		for (; op == SV_OP_UNION && j < nb; j++)		\
+			SV_SET_EMIT(o, no, b[j]);			\
+		return no;						\
+	}								\
+	static size_t sv_setop_##SUF(const T *a, const size_t na,	\
+				     const T *b, const size_t nb, T *o,	\
+				     const enum eSVSetOp op)		\
+	{								\
+		size_t i = 0, j = 0, no = 0;				\
+		T x;							\
+		if (nb / SV_GALLOP_RATIO > na)				\
+			return sv_setg_##SUF(a, na, b, nb, o, op);	\
+		if (na / SV_GALLOP_RATIO > nb)				\
+			return op == SV_OP_DIFF ?			\
+			       sv_setg_##SUF(a, na, b, nb, o, op) :	\
+			       sv_setg_##SUF(b, nb, a, na, o, op);	\
+		if (sizeof(T) == 4 && op == SV_OP_ISECT)		\
+			sv_isect32((const uint32_t *)a, na,		\
+				   (const uint32_t *)b, nb,		\
+				   (uint32_t *)o, &i, &j, &no, SGN);	\
+		switch (op) {						\
+		case SV_OP_MERGE:					\
+			while (i < na && j < nb)			\
+				o[no++] = b[j] < a[i] ? b[j++] : a[i++]; \
+			break;						\
+		case SV_OP_UNION:					\
+			while (i < na && j < nb) {			\
+				if (a[i] < b[j]) {			\
+					x = a[i++];			\
+				} else if (b[j] < a[i]) {		\
+					x = b[j++];			\
+				} else {				\
+					x = a[i++];			\
+					j++;				\
+				}					\
+				SV_SET_EMIT(o, no, x);			\
+			}						\
+			break;						\
+		case SV_OP_ISECT:					\
+			while (i < na && j < nb) {			\
+				if (a[i] < b[j]) {			\
+					i++;				\
+				} else if (b[j] < a[i]) {		\
+					j++;				\
+				} else {				\
+					SV_SET_EMIT(o, no, a[i]);	\
+					i++;				\
+					j++;				\
+				}					\
+			}						\
+			return no;					\
+		case SV_OP_DIFF:					\
+			while (i < na && j < nb) {			\
+				if (a[i] < b[j]) {			\
+					SV_SET_EMIT(o, no, a[i]);	\
+					i++;				\
+				} else if (b[j] < a[i]) {		\
+					j++;				\
+				} else {				\
+					i++;				\
+				}					\
+			}						\
+			for (; i < na; i++)				\
+				SV_SET_EMIT(o, no, a[i]);		\
+			return no;					\
+		}							\
+		for (; op == SV_OP_MERGE && i < na; i++)		\
+			o[no++] = a[i];					\
+		for (; op == SV_OP_MERGE && j < nb; j++)		\
+			o[no++] = b[j];					\
+		for (; op == SV_OP_UNION && i < na; i++)		\
+			SV_SET_EMIT(o, no, a[i]);			\
+		for (; op == SV_OP_UNION && j < nb; j++)		\
+			SV_SET_EMIT(o, no, b[j]);			\
+		return no;						\
+	}
+
+BUILD_SV_SETOP(i8, int8_t, S_TRUE)
+BUILD_SV_SETOP(u8, uint8_t, S_FALSE)
+BUILD_SV_SETOP(i16, int16_t, S_TRUE)
+BUILD_SV_SETOP(u16, uint16_t, S_FALSE)
+BUILD_SV_SETOP(i32, int32_t, S_TRUE)
+BUILD_SV_SETOP(u32, uint32_t, S_FALSE)
+BUILD_SV_SETOP(i64, int64_t, S_TRUE)
+BUILD_SV_SETOP(u64, uint64_t, S_FALSE)
+
+#undef BUILD_SV_SETOP
+
+#define SV_SETOP_CASE(ST, SUF, T)					\
+	case ST:							\
+		return sv_setop_##SUF((const T *)a, na, (const T *)b,	\
+				      nb, (T *)o, op)
+
+static size_t sv_setop_x(const enum eSV_Type t, const void *a,
+			 const size_t na, const void *b, const size_t nb,
+			 void *o, const enum eSVSetOp op)
+{
+	switch (t) {
+	SV_SETOP_CASE(SV_I8, i8, int8_t);
+	SV_SETOP_CASE(SV_U8, u8, uint8_t);
+	SV_SETOP_CASE(SV_I16, i16, int16_t);
+	SV_SETOP_CASE(SV_U16, u16, uint16_t);
+	SV_SETOP_CASE(SV_I32, i32, int32_t);
+	SV_SETOP_CASE(SV_U32, u32, uint32_t);
+	SV_SETOP_CASE(SV_I64, i64, int64_t);
+	SV_SETOP_CASE(SV_U64, u64, uint64_t);
+	default:
+		break;
+	}
+	return 0;
+}
+
+#undef SV_SETOP_CASE
+
+static sv_t *sv_setop(sv_t **out, const sv_t *a, const sv_t *b,
+		      const enum eSVSetOp op)
+{
+	ASSERT_RETURN_IF(!out, sv_void);
+	if (!a || !b || a->d.sub_type > SV_LAST_INT ||
+	    a->d.sub_type != b->d.sub_type) { /* BEHAVIOR: empty output */
+		sv_clear(*out);
+		return sv_check(out);
+	}
+	const size_t na = sv_size(a), nb = sv_size(b);
+	size_t no = op == SV_OP_ISECT ? S_MIN(na, nb) :
+		    op == SV_OP_DIFF ? na : na + nb;
+	sv_t *tmp = NULL, **r = *out == a || *out == b ? &tmp : out;
+	if (*r)
+		aux_cat(r, S_FALSE, a, 0); /* input type, empty */
+	if (aux_reserve(r, a, no) < no || (*r)->d.sub_type != a->d.sub_type) {
+		sv_free(&tmp);
+		sv_clear(*out);
+		return sv_check(out);
+	}
+	no = sv_setop_x((enum eSV_Type)a->d.sub_type, sv_get_buffer_r(a), na,
+			sv_get_buffer_r(b), nb, sv_get_buffer(*r), op);
+	sv_set_size(*r, no);
+	if (tmp) { /* aliasing: output is one of the inputs */
+		sv_cpy(out, tmp);
+		sv_free(&tmp);
+	}
+	return sv_check(out);
+}
+
+#define SV_UNIQ_CASE(ST, SUF, T)					\
+	case ST:							\
+		n = sv_uniq_##SUF((T *)p, n);				\
+		break
+
+sv_t *sv_unique(sv_t *v)
+{
+	RETURN_IF(!v, sv_void);
+	size_t i, n = sv_size(v);
+	const size_t es = v->d.elem_size;
+	char *p = sv_get_buffer(v);
+	switch (v->d.sub_type) {
+	SV_UNIQ_CASE(SV_I8, i8, int8_t);
+	SV_UNIQ_CASE(SV_U8, u8, uint8_t);
+	SV_UNIQ_CASE(SV_I16, i16, int16_t);
+	SV_UNIQ_CASE(SV_U16, u16, uint16_t);
+	SV_UNIQ_CASE(SV_I32, i32, int32_t);
+	SV_UNIQ_CASE(SV_U32, u32, uint32_t);
+	SV_UNIQ_CASE(SV_I64, i64, int64_t);
+	SV_UNIQ_CASE(SV_U64, u64, uint64_t);
+	default:
+		if (n < 2)
+			break;
+		for (i = 1, n = 1; i < sv_size(v); i++)
+			if (v->vx.cmpf ? v->vx.cmpf(p + (n - 1) * es,
+						    p + i * es) != 0 :
+					 memcmp(p + (n - 1) * es, p + i * es,
+						es) != 0) {
+				if (n != i)
+					memcpy(p + n * es, p + i * es, es);
+				n++;
+			}
+	}
+	sv_set_size(v, n);
+	return v;
+}
+
+#undef SV_UNIQ_CASE
+
+sv_t *sv_merge(sv_t **out, const sv_t *a, const sv_t *b)
+{
+	return sv_setop(out, a, b, SV_OP_MERGE);
+}
+
+sv_t *sv_union(sv_t **out, const sv_t *a, const sv_t *b)
+{
+	return sv_setop(out, a, b, SV_OP_UNION);
+}
+
+sv_t *sv_intersect(sv_t **out, const sv_t *a, const sv_t *b)
+{
+	return sv_setop(out, a, b, SV_OP_ISECT);
+}
+
+sv_t *sv_difference(sv_t **out, const sv_t *a, const sv_t *b)
+{
+	return sv_setop(out, a, b, SV_OP_DIFF);
+}
+
+/*
+ * Reductions: sum (exact, 128-bit accumulation), min/max, histogram
+ */
+
+#define SV_SUM_BLK	((size_t)1 << 20) /* elements: int64_t-safe block */
+
+struct SV128 {
+	uint64_t lo, hi; /* two's complement */
+};
+
+S_INLINE void sv128_add(struct SV128 *a, const int64_t x)
+{
+	const uint64_t lo = a->lo + (uint64_t)x;
+	a->hi += (x < 0 ? SUINT64_MAX : 0) + (lo < a->lo);
+	a->lo = lo;
+}
+
+#ifdef S_SIMD_SSE2
+
+static int64_t sv_m128_sum64(__m128i a)
+{
+	int64_t r[2];
+	_mm_storeu_si128((__m128i *)r, a);
+	return r[0] + r[1];
+}
+
+/* 8-bit: SAD against zero, signed values biased to unsigned */
+static int64_t sv_sumb8(const void *p0, const size_t n, const int sgn)
+{
+	const unsigned char *p = (const unsigned char *)p0;
+	const __m128i z = _mm_setzero_si128(),
+		      b = _mm_set1_epi8(sgn ? (char)0x80 : 0);
+	__m128i acc = z;
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_xor_si128(
+					SV_LD128(p + i), b), z));
+	int64_t r = sv_m128_sum64(acc) - (sgn ? 128 * (int64_t)i : 0);
+	for (; i < n; i++)
+		r += sgn ? (signed char)p[i] : p[i];
+	return r;
+}
+
+/* 16-bit: pair sums (unsigned values biased to signed), widened to 64 */
+static int64_t sv_sumb16(const void *p0, const size_t n, const int sgn)
+{
+	const uint16_t *p = (const uint16_t *)p0;
+	const __m128i one = _mm_set1_epi16(1),
+		      b = _mm_set1_epi16(sgn ? 0 : (short)0x8000);
+	__m128i acc = _mm_setzero_si128(), s, sg;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		s = _mm_madd_epi16(_mm_xor_si128(SV_LD128(p + i), b), one);
+		sg = _mm_srai_epi32(s, 31);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(s, sg));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(s, sg));
+	}
+	int64_t r = sv_m128_sum64(acc) + (sgn ? 0 : 32768 * (int64_t)i);
+	for (; i < n; i++)
+		r += sgn ? (int16_t)p[i] : p[i];
+	return r;
+}
+
+/* 32-bit: widened to 64 (sign or zero extension) */
+static int64_t sv_sumb32(const void *p0, const size_t n, const int sgn)
+{
+	const uint32_t *p = (const uint32_t *)p0;
+	const __m128i z = _mm_setzero_si128();
+	__m128i acc = z, x, sg;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		x = SV_LD128(p + i);
+		sg = sgn ? _mm_srai_epi32(x, 31) : z;
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(x, sg));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(x, sg));
+	}
+	int64_t r = sv_m128_sum64(acc);
+	for (; i < n; i++)
+		r += sgn ? (int32_t)p[i] : (int64_t)p[i];
+	return r;
+}
+
+#else
+
+#define BUILD_SV_SUMB(FN, TS, TU)					\
+	static int64_t FN(const void *p, const size_t n, const int sgn)	\
+	{								\
+		int64_t r0 = 0, r1 = 0;					\
+		size_t i = 0;						\
+		if (sgn) {						\
+			for (; i + 2 <= n; i += 2) {			\
+				r0 += ((const TS *)p)[i];		\
+				r1 += ((const TS *)p)[i + 1];		\
+			}						\
+			for (; i < n; i++)				\
+				r0 += ((const TS *)p)[i];		\
+		} else {						\
+			for (; i + 2 <= n; i += 2) {			\
+				r0 += ((const TU *)p)[i];		\
+				r1 += ((const TU *)p)[i + 1];		\
+			}						\
+			for (; i < n; i++)				\
+				r0 += ((const TU *)p)[i];		\
+		}							\
+		return r0 + r1;						\
+	}
+
+BUILD_SV_SUMB(sv_sumb8, int8_t, uint8_t)
+BUILD_SV_SUMB(sv_sumb16, int16_t, uint16_t)
+BUILD_SV_SUMB(sv_sumb32, int32_t, uint32_t)
+
+#undef BUILD_SV_SUMB
+
+#endif
+
+static sbool_t sv_sum128(const sv_t *v, struct SV128 *a)
+{
+	a->lo = a->hi = 0;
+	RETURN_IF(!v || v->d.sub_type > SV_LAST_INT, S_FALSE);
+	const char *p = sv_get_buffer_r(v);
+	const size_t n = sv_size(v), es = v->d.elem_size;
+	const int sgn = !(v->d.sub_type & 1); /* SV_I8, SV_I16, ... */
+	size_t i, bs;
+	if (es == 8) {
+		const uint64_t *p64 = (const uint64_t *)p;
+		uint64_t lo = 0, hi = 0;
+		for (i = 0; i < n; i++) { /* carry, minus sign extension */
+			lo += p64[i];
+			hi += (uint64_t)(lo < p64[i]) -
+			      (uint64_t)(sgn && (int64_t)p64[i] < 0);
+		}
+		a->lo = lo;
+		a->hi = hi;
+		return S_TRUE;
+	}
+	for (i = 0; i < n; i += bs) {
+		bs = S_MIN(n - i, SV_SUM_BLK);
+		sv128_add(a, es == 1 ? sv_sumb8(p + i, bs, sgn) :
+			     es == 2 ? sv_sumb16(p + i * 2, bs, sgn) :
+				       sv_sumb32(p + i * 4, bs, sgn));
+	}
+	return S_TRUE;
+}
+
+int64_t sv_sum_i(const sv_t *v, sbool_t *overflow)
+{
+	struct SV128 a;
+	sbool_t ovf = !sv_sum128(v, &a);
+	int64_t r = (int64_t)a.lo;
+	if (!ovf && a.hi != (r < 0 ? SUINT64_MAX : 0)) {
+		ovf = S_TRUE;
+		r = (int64_t)a.hi < 0 ? SINT64_MIN : SINT64_MAX;
+	}
+	if (overflow)
+		*overflow = ovf;
+	return r;
+}
+
+uint64_t sv_sum_u(const sv_t *v, sbool_t *overflow)
+{
+	struct SV128 a;
+	sbool_t ovf = !sv_sum128(v, &a);
+	uint64_t r = a.lo;
+	if (!ovf && a.hi) {
+		ovf = S_TRUE;
+		r = (int64_t)a.hi < 0 ? 0 : SUINT64_MAX;
+	}
+	if (overflow)
+		*overflow = ovf;
+	return r;
+}
+
+/*
+ * Floating point sum: double precision, 4 partial sums (element i goes to
+ * sum i % 4, for both the SSE2 and the scalar loops, so the result does not
+ * depend on the build). Single precision elements are converted to double
+ * before being added.
+ */
+
+double sv_sum_f(const sv_t *v)
+{
+	RETURN_IF(!v || !SV_IS_FLOAT(v), 0);
+	const size_t n = sv_size(v);
+	const void *p = sv_get_buffer_r(v);
+	size_t i = 0;
+	double s[4] = { 0, 0, 0, 0 };
+	if (v->d.sub_type == SV_F32) {
+		const float *f = (const float *)p;
+#ifdef S_SIMD_SSE2
+		__m128d a0 = _mm_setzero_pd(), a1 = a0;
+		__m128 x;
+		for (; i + 4 <= n; i += 4) {
+			x = _mm_loadu_ps(f + i);
+			a0 = _mm_add_pd(a0, _mm_cvtps_pd(x));
+			a1 = _mm_add_pd(a1, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+		}
+		_mm_storeu_pd(s, a0);
+		_mm_storeu_pd(s + 2, a1);
+#endif
+		for (; i + 4 <= n; i += 4) {
+			s[0] += f[i];
+			s[1] += f[i + 1];
+			s[2] += f[i + 2];
+			s[3] += f[i + 3];
+		}
+		for (; i < n; i++)
+			s[i % 4] += f[i];
+	} else {
+		const double *d = (const double *)p;
+#ifdef S_SIMD_SSE2
+		__m128d a0 = _mm_setzero_pd(), a1 = a0;
+		for (; i + 4 <= n; i += 4) {
+			a0 = _mm_add_pd(a0, _mm_loadu_pd(d + i));
+			a1 = _mm_add_pd(a1, _mm_loadu_pd(d + i + 2));
+		}
+		_mm_storeu_pd(s, a0);
+		_mm_storeu_pd(s + 2, a1);
+#endif
+		for (; i + 4 <= n; i += 4) {
+			s[0] += d[i];
+			s[1] += d[i + 1];
+			s[2] += d[i + 2];
+			s[3] += d[i + 3];
+		}
+		for (; i < n; i++)
+			s[i % 4] += d[i];
+	}
+	return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+/*
+ * Min/max: values first (SIMD), then the offset of the first occurrence
+ * (sv_find kernels)
+ */
+
+#ifdef S_SIMD_SSE2
+
+S_INLINE __m128i sv_sel128(const __m128i m, const __m128i a, const __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/* Unsigned types are biased (XOR of the sign bit) for signed compares */
+#define BUILD_SV_MINMAX(FN, T, SET1, CMPGT, BIAS)			\
+	static void FN(const T *p, const size_t n, T *mn, T *mx)	\
+	{								\
+		const size_t ne = 16 / sizeof(T);			\
+		size_t i = 0, j;					\
+		T a = p[0], b = p[0], ta[16 / sizeof(T)],		\
+		  tb[16 / sizeof(T)];					\
+		if (n >= ne) {						\
+			const __m128i bias = SET1(BIAS);		\
+			__m128i x, vmn, vmx;				\
+			vmn = vmx = _mm_xor_si128(SV_LD128(p), bias);	\
+			for (i = ne; i + ne <= n; i += ne) {		\
+				x = _mm_xor_si128(SV_LD128(p + i),	\
+						  bias);		\
+				vmn = sv_sel128(CMPGT(vmn, x), x, vmn);	\
+				vmx = sv_sel128(CMPGT(x, vmx), x, vmx);	\
+			}						\
+			_mm_storeu_si128((__m128i *)ta,			\
+					 _mm_xor_si128(vmn, bias));	\
+			_mm_storeu_si128((__m128i *)tb,			\
+					 _mm_xor_si128(vmx, bias));	\
+			for (j = 0; j < ne; j++) {			\
+				a = ta[j] < a ? ta[j] : a;		\
+				b = tb[j] > b ? tb[j] : b;		\
+			}						\
+		}							\
+		for (; i < n; i++) {					\
+			a = p[i] < a ? p[i] : a;			\
+			b = p[i] > b ? p[i] : b;			\
+		}							\
+		*mn = a;						\
+		*mx = b;						\
+	}
+
+BUILD_SV_MINMAX(sv_mm_i8, int8_t, SV_SET1_8, _mm_cmpgt_epi8, 0)
+BUILD_SV_MINMAX(sv_mm_u8, uint8_t, SV_SET1_8, _mm_cmpgt_epi8, 0x80)
+BUILD_SV_MINMAX(sv_mm_i16, int16_t, SV_SET1_16, _mm_cmpgt_epi16, 0)
+BUILD_SV_MINMAX(sv_mm_u16, uint16_t, SV_SET1_16, _mm_cmpgt_epi16, 0x8000)
+BUILD_SV_MINMAX(sv_mm_i32, int32_t, SV_SET1_32, _mm_cmpgt_epi32, 0)
+BUILD_SV_MINMAX(sv_mm_u32, uint32_t, SV_SET1_32, _mm_cmpgt_epi32,
+		0x80000000)
+
+#undef BUILD_SV_MINMAX
+
+#endif
+
+#define BUILD_SV_MINMAX(FN, T)						\
+	static void FN(const T *p, const size_t n, T *mn, T *mx)	\
+	{								\
+		size_t i = 1;						\
+		T a0 = p[0], b0 = p[0], a1 = p[0], b1 = p[0];		\
+		for (; i + 2 <= n; i += 2) {				\
+			a0 = p[i] < a0 ? p[i] : a0;			\
+			b0 = p[i] > b0 ? p[i] : b0;			\
+			a1 = p[i + 1] < a1 ? p[i + 1] : a1;		\
+			b1 = p[i + 1] > b1 ? p[i + 1] : b1;		\
+		}							\
+		for (; i < n; i++) {					\
+			a0 = p[i] < a0 ? p[i] : a0;			\
+			b0 = p[i] > b0 ? p[i] : b0;			\
+		}							\
+		*mn = a1 < a0 ? a1 : a0;				\
+		*mx = b1 > b0 ? b1 : b0;				\
+	}
+
+#ifndef S_SIMD_SSE2
+BUILD_SV_MINMAX(sv_mm_i8, int8_t)
+BUILD_SV_MINMAX(sv_mm_u8, uint8_t)
+BUILD_SV_MINMAX(sv_mm_i16, int16_t)
+BUILD_SV_MINMAX(sv_mm_u16, uint16_t)
+BUILD_SV_MINMAX(sv_mm_i32, int32_t)
+BUILD_SV_MINMAX(sv_mm_u32, uint32_t)
+#endif
+BUILD_SV_MINMAX(sv_mm_i64, int64_t)
+BUILD_SV_MINMAX(sv_mm_u64, uint64_t)
+
+#undef BUILD_SV_MINMAX
+
+/*
+ * Floating point min/max (total order), returned as element bits. SSE2:
+ * signed 32-bit compare of the elements with the non-sign bits of the
+ * negative ones inverted (that key XOR the sign bit is ssort_f32_key).
+ */
+static void sv_mm_f32(const uint32_t *p, const size_t n, uint32_t *mn,
+		      uint32_t *mx)
+{
+	size_t i = 0, j;
+	uint32_t a = ssort_f32_key(p[0]), b = a, k;
+#ifdef S_SIMD_SSE2
+	if (n >= 4) {
+		uint32_t ta[4], tb[4];
+		__m128i x = SV_LD128(p), vmn, vmx;
+		vmn = vmx = _mm_xor_si128(x, _mm_srli_epi32(
+						_mm_srai_epi32(x, 31), 1));
+		for (i = 4; i + 4 <= n; i += 4) {
+			x = SV_LD128(p + i);
+			x = _mm_xor_si128(x, _mm_srli_epi32(
+						_mm_srai_epi32(x, 31), 1));
+			vmn = sv_sel128(_mm_cmpgt_epi32(vmn, x), x, vmn);
+			vmx = sv_sel128(_mm_cmpgt_epi32(x, vmx), x, vmx);
+		}
+		_mm_storeu_si128((__m128i *)ta, vmn);
+		_mm_storeu_si128((__m128i *)tb, vmx);
+		for (j = 0; j < 4; j++) {
+			k = ta[j] ^ 0x80000000;
+			a = k < a ? k : a;
+			k = tb[j] ^ 0x80000000;
+			b = k > b ? k : b;
+		}
+	}
+#else
+	(void)j;
+#endif
+	for (; i < n; i++) {
+		k = ssort_f32_key(p[i]);
+		a = k < a ? k : a;
+		b = k > b ? k : b;
+	}
+	*mn = ssort_f32_unkey(a);
+	*mx = ssort_f32_unkey(b);
+}
+
+static void sv_mm_f64(const uint64_t *p, const size_t n, uint64_t *mn,
+		      uint64_t *mx)
+{
+	size_t i = 1;
+	uint64_t a0 = ssort_f64_key(p[0]), b0 = a0, a1 = a0, b1 = a0, k0, k1;
+	for (; i + 2 <= n; i += 2) {
+		k0 = ssort_f64_key(p[i]);
+		k1 = ssort_f64_key(p[i + 1]);
+		a0 = k0 < a0 ? k0 : a0;
+		b0 = k0 > b0 ? k0 : b0;
+		a1 = k1 < a1 ? k1 : a1;
+		b1 = k1 > b1 ? k1 : b1;
+	}
+	if (i < n) {
+		k0 = ssort_f64_key(p[i]);
+		a0 = k0 < a0 ? k0 : a0;
+		b0 = k0 > b0 ? k0 : b0;
+	}
+	*mn = ssort_f64_unkey(a1 < a0 ? a1 : a0);
+	*mx = ssort_f64_unkey(b1 > b0 ? b1 : b0);
+}
+
+#define SV_MM_CASE(ST, SUF, T)						\
+	case ST: {							\
+		T a, b;							\
+		sv_mm_##SUF((const T *)p, n, &a, &b);			\
+		*mn = (uint64_t)a;					\
+		*mx = (uint64_t)b;					\
+		break;							\
+	}
+
+/* Min/max values, as sv_find_x() targets (n > 0) */
+static void sv_mm_x(const sv_t *v, uint64_t *mn, uint64_t *mx)
+{
+	const void *p = sv_get_buffer_r(v);
+	const size_t n = sv_size(v);
+	switch (v->d.sub_type) {
+	SV_MM_CASE(SV_I8, i8, int8_t)
+	SV_MM_CASE(SV_U8, u8, uint8_t)
+	SV_MM_CASE(SV_I16, i16, int16_t)
+	SV_MM_CASE(SV_U16, u16, uint16_t)
+	SV_MM_CASE(SV_I32, i32, int32_t)
+	SV_MM_CASE(SV_U32, u32, uint32_t)
+	SV_MM_CASE(SV_I64, i64, int64_t)
+	SV_MM_CASE(SV_U64, u64, uint64_t)
+	case SV_F32: {
+		uint32_t a, b;
+		sv_mm_f32((const uint32_t *)p, n, &a, &b);
+		*mn = a;
+		*mx = b;
+		break;
+	}
+	case SV_F64:
+		sv_mm_f64((const uint64_t *)p, n, mn, mx);
+		break;
+	default:
+		*mn = *mx = 0;
+	}
+}
+
+#undef SV_MM_CASE
+
+static void sv_mm_gen(const sv_t *v, size_t *mn, size_t *mx)
+{
+	size_t i, n = sv_size(v);
+	*mn = *mx = 0;
+	for (i = 1; i < n; i++) {
+		if (v->vx.cmpf(ptr_to_elem_r(v, i), ptr_to_elem_r(v, *mn)) < 0)
+			*mn = i;
+		if (v->vx.cmpf(ptr_to_elem_r(v, i), ptr_to_elem_r(v, *mx)) > 0)
+			*mx = i;
+	}
+}
+
+sbool_t sv_minmax(const sv_t *v, size_t *min_off, size_t *max_off)
+{
+	size_t mn = S_NPOS, mx = S_NPOS;
+	uint64_t a, b;
+	sbool_t r = v && sv_size(v) > 0 && v->d.sub_type <= SV_GEN &&
+		    (v->d.sub_type != SV_GEN || v->vx.cmpf);
+	if (r) {
+		if (v->d.sub_type == SV_GEN) {
+			sv_mm_gen(v, &mn, &mx);
+		} else {
+			sv_mm_x(v, &a, &b);
+			if (min_off)
+				mn = sv_find_x(v, 0, a);
+			if (max_off)
+				mx = sv_find_x(v, 0, b);
+		}
+	}
+	if (min_off)
+		*min_off = mn;
+	if (max_off)
+		*max_off = mx;
+	return r;
+}
+
+size_t sv_min(const sv_t *v)
+{
+	size_t r;
+	sv_minmax(v, &r, NULL);
+	return r;
+}
+
+size_t sv_max(const sv_t *v)
+{
+	size_t r;
+	sv_minmax(v, NULL, &r);
+	return r;
+}
+
+/*
+ * Histogram
+ */
+
+sv_t *sv_histogram(sv_t **h, const sv_t *v, const int64_t lo,
+		   const uint64_t bin_size, const size_t nbins)
+{
+	ASSERT_RETURN_IF(!h, sv_void);
+	if (!*h)
+		*h = sv_alloc_t(SV_U64, nbins);
+	RETURN_IF((*h)->d.sub_type != SV_U64 || sv_reserve(h, nbins) < nbins,
+		  sv_check(h)); /* BEHAVIOR: only SV_U64 output is allowed */
+	uint64_t *o = (uint64_t *)sv_get_buffer(*h), d, c[4][256];
+	const uint64_t range = bin_size * nbins;
+	const size_t n = v ? sv_size(v) : 0;
+	const int sgn = v ? !(v->d.sub_type & 1) : 0;
+	size_t i, j;
+	memset(o, 0, nbins * sizeof(o[0]));
+	sv_set_size(*h, nbins);
+	RETURN_IF(!n || !bin_size || !nbins || v->d.sub_type > SV_LAST_INT ||
+		  range / bin_size != nbins, *h);
+	const void *p = sv_get_buffer_r(v);
+	if (v->d.elem_size == 1) { /* 8-bit: count all values first */
+		memset(c, 0, sizeof(c));
+		const unsigned char *p8 = (const unsigned char *)p;
+		for (i = 0; i + 4 <= n; i += 4) {
+			c[0][p8[i]]++;
+			c[1][p8[i + 1]]++;
+			c[2][p8[i + 2]]++;
+			c[3][p8[i + 3]]++;
+		}
+		for (; i < n; i++)
+			c[0][p8[i]]++;
+		for (j = 0; j < 256; j++) {
+			int64_t x = sgn ? (signed char)j : (int64_t)j;
+			d = (uint64_t)x - (uint64_t)lo;
+			if (x >= lo && d < range)
+				o[d / bin_size] += c[0][j] + c[1][j] + c[2][j] +
+						   c[3][j];
+		}
+		return *h;
+	}
+	for (i = 0; i < n; i++) {
+		int64_t x = svldx_f[(int)v->d.sub_type](p, i);
+		if (sgn || x >= 0) { /* signed compare is valid */
+			if (x < lo)
+				continue;
+		} else if (lo < 0 && (uint64_t)x - (uint64_t)lo < (uint64_t)x) {
+			continue; /* x - lo >= 2^64 */
+		}
+		d = (uint64_t)x - (uint64_t)lo;
+		if (d < range)
+			o[d / bin_size]++;
+	}
+	return *h;
+}
 
 /*
  * Compare
@@ -569,6 +2081,12 @@ uint64_t sv_at_u(const sv_t *v, const size_t index)
 
 #undef SV_IU_AT
 
+double sv_at_f(const sv_t *v, const size_t index)
+{
+	RETURN_IF(!v || !SV_IS_FLOAT(v) || index >= sv_size(v), 0);
+	return sv_ld_f(ptr_to_elem_r(v, index), v->d.sub_type);
+}
+
 /*
  * Vector "set": set element value at given position
  */
@@ -611,6 +2129,15 @@ sbool_t sv_set_u(sv_t **v, const size_t index, uint64_t value)
 }
 
 #undef SV_IU_SET
+
+sbool_t sv_set_f(sv_t **v, const size_t index, double value)
+{
+	RETURN_IF(!v || !*v || !SV_IS_FLOAT(*v), S_FALSE);
+	SV_SET_CHECK(v, index);
+	sv_st_f(ptr_to_elem(*v, index), (*v)->d.sub_type, value);
+	return S_TRUE;
+}
+
 #undef SV_SET_CHECK
 #undef SV_SET_INT_CHECK
 
@@ -676,6 +2203,16 @@ sbool_t sv_push_u(sv_t **v, const uint64_t c)
 	return S_TRUE;
 }
 
+sbool_t sv_push_f(sv_t **v, const double c)
+{
+	RETURN_IF(!v || !*v || !SV_IS_FLOAT(*v), S_FALSE);
+	SV_PUSH_GROW(v, 1);
+	SV_PUSH_START(v);
+	SV_PUSH_END(v, 1);
+	sv_st_f(p, (*v)->d.sub_type, c);
+	return S_TRUE;
+}
+
 #undef SV_PUSH_START
 #undef SV_PUSH_END
 #undef SV_PUSH_IU
@@ -718,3 +2255,11 @@ uint64_t sv_pop_u(sv_t *v)
 	SV_POP_IU(uint64_t);
 }
 
+double sv_pop_f(sv_t *v)
+{
+	RETURN_IF(!v || !SV_IS_FLOAT(v), 0);
+	SV_POP_START(0);
+	SV_POP_END;
+	return sv_ld_f(p, v->d.sub_type);
+}
+
@@ -9,14 +9,18 @@ extern "C" {
  *
  * #SHORTDOC vector handling
  *
- * #DOC Vector handling functions for managing integer data and
- * #DOC generic data.
+ * #DOC Vector handling functions for managing integer data, floating
+ * #DOC point data (SV_F32/SV_F64, IEEE 754 single/double precision), and
+ * #DOC generic data. Floating point vectors are ordered by the IEEE 754
+ * #DOC total order (-NaN < -inf < ... < -0 < +0 < ... < +inf < +NaN), and
+ * #DOC element equality is bitwise (e.g. sv_find).
  *
  * Copyright (c) 2015-2016, F. Aragon. All rights reserved. Released under
  * the BSD 3-Clause License (see the doc/LICENSE file included).
  */ 
 
 #include "saux/sdata.h"
+#include "saux/ssort.h"
 
 /*
  * Structures
@@ -34,6 +38,8 @@ enum eSV_Type
 	SV_I64,
 	SV_U64,
 	SV_LAST_INT = SV_U64,
+	SV_F32,
+	SV_F64,
 	SV_GEN
 };
 
@@ -71,7 +77,7 @@ typedef struct SVector sv_t; /* "Hidden" structure (accessors are provided) */
  */
 
 /*
-#API: |Allocate typed vector (stack)|Vector type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64; space preallocated to store n elements|vector|O(1)|1;2|
+#API: |Allocate typed vector (stack)|Vector type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64/SV_F32/SV_F64; space preallocated to store n elements|vector|O(1)|1;2|
 sv_t *sv_alloca_t(const enum eSV_Type t, const size_t initial_num_elems_reserve)
 
 #API: |Allocate generic vector (stack)|element size; space preallocated to store n elements; compare function (used for sorting, pass NULL for none)|vector|O(1)|1;2|
@@ -93,7 +99,7 @@ sv_t *sv_alloc_raw(const enum eSV_Type t, const sbool_t ext_buf, void *buffer, c
 /* #API: |Allocate generic vector (heap)|element size; space preallocated to store n elements; compare function (used for sorting, pass NULL for none)|vector|O(1)|1;2| */
 sv_t *sv_alloc(const size_t elem_size, const size_t initial_num_elems_reserve, const sv_cmp_t f);
 
-/* #API: |Allocate typed vector (heap)|Vector type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64; space preallocated to store n elements|vector|O(1)|1;2| */
+/* #API: |Allocate typed vector (heap)|Vector type: SV_I8/SV_U8/SV_I16/SV_U16/SV_I32/SV_U32/SV_I64/SV_U64/SV_F32/SV_F64; space preallocated to store n elements|vector|O(1)|1;2| */
 sv_t *sv_alloc_t(const enum eSV_Type t, const size_t initial_num_elems_reserve);
 
 SD_BUILDFUNCS_FULL(sv, 0)
@@ -205,9 +211,54 @@ sv_t *sv_erase(sv_t **v, const size_t off, const size_t n);
 /* #API: |Resize vector|input/output vector; new size|output vector reference (optional usage)|O(n)|1;2| */
 sv_t *sv_resize(sv_t **v, const size_t n);
 
-/* #API: |Sort vector|input/output vector|output vector reference (optional usage)|relies on libc "qsort" implementation, e.g. glibc implements introsort (O(n log n)), musl does smoothsort (O(n log n)), etc.|1;2| */
+/* #API: |Sort vector|input/output vector|output vector reference (optional usage)|O(n) for 8-bit elements, O(n log n) for the rest: in-place MSD radix sort for integer and floating point vectors, pattern-defeating quicksort for generic vectors of 1/2/4/8/12/16/24/32 byte elements, libc "qsort" otherwise|1;2| */
 sv_t *sv_sort(sv_t *v);
 
+/*
+#API: |Sort vector using a sort function generated with SSORT_BUILD_PDQ (inlined comparator, e.g. for struct vectors)|input/output vector;element type;sort function|output vector reference (optional usage)|O(n log n)|1;2|
+sv_t *sv_sort_with(sv_t *v, T, sort_function)
+*/
+#define sv_sort_with(v, T, sort_f)					\
+	(sv_sort_with_chk(v, sizeof(T)) ?				\
+	 (sort_f((T *)sv_get_buffer(v), sv_size(v)), (v)) : (v))
+
+/* #notAPI: |Check if vector can be sorted with sv_sort_with|vector;element size|S_TRUE: vector elements have the given size|O(1)|1;2| */
+sbool_t sv_sort_with_chk(const sv_t *v, const size_t elem_size);
+
+/* #API: |Stable sort permutation: offsets of the vector elements in sorted order (integer and floating point vectors: radix sort; generic vectors: compare function)|output SV_U64 vector (allocated if NULL); vector|output vector reference|O(n) for integer and floating point vectors, O(n log n) for generic vectors|1;2| */
+sv_t *sv_argsort(sv_t **perm, const sv_t *v);
+
+/* #API: |Sort key vector, applying the same permutation to the value vector (stable, values of any element size)|key vector (integer or generic with compare function); value vector (same number of elements)|S_TRUE: OK, S_FALSE: invalid input or not enough memory|O(n) for integer keys, O(n log n) for generic keys|1;2| */
+sbool_t sv_sort_pairs(sv_t *keys, sv_t *values);
+
+/* #API: |Reorder vector so the element at the given offset is the one that would be there after sorting, with no greater elements before it and no smaller elements after it|input/output vector (integer, floating point, or generic with compare function); element offset|output vector reference (optional usage)|O(n) expected (introselect); O(n log n) for generic vectors with element sizes not covered by the sv_sort templates|1;2| */
+sv_t *sv_nth_element(sv_t *v, const size_t nth);
+
+/* #API: |Partial sort: the k smallest elements first, sorted, the rest in unspecified order|input/output vector; number of elements to sort|output vector reference (optional usage)|O(n + k log k) expected|1;2| */
+sv_t *sv_partial_sort(sv_t *v, const size_t k);
+
+/* #API: |Top-k: the k greatest elements, in descending order (input vector is not modified)|output vector (allocated if NULL, otherwise overwritten, getting the input vector type); input vector; number of elements|output vector reference|O(n log k) for integer/floating point vectors when k is small compared to n (heap), O(n + k log k) expected otherwise (copy, then selection)|1;2| */
+sv_t *sv_top_k(sv_t **out, const sv_t *v, const size_t k);
+
+/*
+ * Set algebra (sorted vectors)
+ */
+
+/* #API: |Remove repeated elements (sorted vector: unique elements)|input/output vector|output vector reference (optional usage)|O(n)|1;2| */
+sv_t *sv_unique(sv_t *v);
+
+/* #API: |Merge two sorted integer vectors (repeated elements are kept)|output vector (allocated if NULL, otherwise overwritten; it can be one of the inputs); sorted vector; sorted vector (same type)|output vector reference|O(n + m)|1;2| */
+sv_t *sv_merge(sv_t **out, const sv_t *a, const sv_t *b);
+
+/* #API: |Union of two sorted integer vectors (set: each element once)|output vector (allocated if NULL, otherwise overwritten; it can be one of the inputs); sorted vector; sorted vector (same type)|output vector reference|O(n + m)|1;2| */
+sv_t *sv_union(sv_t **out, const sv_t *a, const sv_t *b);
+
+/* #API: |Intersection of two sorted integer vectors (set: each element once)|output vector (allocated if NULL, otherwise overwritten; it can be one of the inputs); sorted vector; sorted vector (same type)|output vector reference|O(n + m); O(m log(n / m)) when n >> m (galloping search)|1;2| */
+sv_t *sv_intersect(sv_t **out, const sv_t *a, const sv_t *b);
+
+/* #API: |Difference of two sorted integer vectors, elements of a not in b (set: each element once)|output vector (allocated if NULL, otherwise overwritten; it can be one of the inputs); sorted vector; sorted vector (same type)|output vector reference|O(n + m); O(m log(n / m)) when n >> m (galloping search)|1;2| */
+sv_t *sv_difference(sv_t **out, const sv_t *a, const sv_t *b);
+
 /*
  * Search
  */
@@ -221,6 +272,53 @@ size_t sv_find_i(const sv_t *v, const size_t off, const int64_t target);
 /* #API: |Find value in vector (unsigned integer)|vector; search offset start; target to be located|offset: >=0 found; S_NPOS: not found|O(n)|1;2| */
 size_t sv_find_u(const sv_t *v, const size_t off, const uint64_t target);
 
+/* #API: |Find all occurrences of a value (integer or generic vector, same target as sv_find)|output vector with the matching offsets (if NULL, a SV_U64 vector is allocated; if it is the input vector, it gets SV_U64 type, after the search; otherwise it is cleared first, and it must be a 32 or 64-bit integer vector: nothing is written into other types); vector; search offset start; target to be located|output vector reference|O(n)|1;2| */
+sv_t *sv_find_all(sv_t **out, const sv_t *v, const size_t off, const void *target);
+
+/*
+ * Binary search (sorted vectors)
+ */
+
+/* #API: |Binary search: first element not less than target (sorted vector; for integer vectors, target points to a value of the vector element type; generic vectors use the compare function)|vector; target|offset (vector size if all elements are less than target)|O(log n)|1;2| */
+size_t sv_lower_bound(const sv_t *v, const void *target);
+
+/* #API: |Binary search: first element greater than target (sorted vector)|vector; target|offset (vector size if no element is greater than target)|O(log n)|1;2| */
+size_t sv_upper_bound(const sv_t *v, const void *target);
+
+/* #API: |Binary search: locate element (sorted vector)|vector; target|offset: >=0 found (first occurrence); S_NPOS: not found|O(log n)|1;2| */
+size_t sv_bsearch(const sv_t *v, const void *target);
+
+/* #API: |Build search index: copy of a sorted vector in Eytzinger (breadth-first) order, for faster searches on big read-only vectors. Index slot 0 is unused|output index; sorted vector|output index reference|O(n)|1;2| */
+sv_t *sv_build_search_index(sv_t **idx, const sv_t *v);
+
+/* #API: |Search index lookup: first element not less than target|index (from sv_build_search_index); target|index slot (use sv_at/sv_at_i/sv_at_u on the index for reading the element); S_NPOS: all elements are less than target|O(log n)|1;2| */
+size_t sv_search_index(const sv_t *idx, const void *target);
+
+/*
+ * Reductions
+ */
+
+/* #API: |Sum of all elements (integer vector), computed exactly (128-bit accumulation)|vector; overflow flag output (optional): S_TRUE if the result does not fit in the output type (or if the vector is not an integer vector)|sum (saturated on overflow)|O(n)|1;2| */
+int64_t sv_sum_i(const sv_t *v, sbool_t *overflow);
+
+/* #API: |Sum of all elements (integer vector, unsigned result)|vector; overflow flag output (optional)|sum (saturated on overflow, 0 if negative)|O(n)|1;2| */
+uint64_t sv_sum_u(const sv_t *v, sbool_t *overflow);
+
+/* #API: |Sum of all elements (floating point vector), using double precision accumulators|vector|sum (0 if not a SV_F32/SV_F64 vector)|O(n)|1;2| */
+double sv_sum_f(const sv_t *v);
+
+/* #API: |Minimum element (integer or floating point vector, or generic vector with compare function)|vector|offset of the first minimum element; S_NPOS: empty vector|O(n)|1;2| */
+size_t sv_min(const sv_t *v);
+
+/* #API: |Maximum element|vector|offset of the first maximum element; S_NPOS: empty vector|O(n)|1;2| */
+size_t sv_max(const sv_t *v);
+
+/* #API: |Minimum and maximum elements (single pass)|vector; minimum element offset output (optional); maximum element offset output (optional)|S_TRUE: OK; S_FALSE: empty or not comparable vector (offsets set to S_NPOS)|O(n)|1;2| */
+sbool_t sv_minmax(const sv_t *v, size_t *min_off, size_t *max_off);
+
+/* #API: |Histogram (integer vector): element x is counted in bin (x - lo) / bin_size, if lo <= x < lo + bin_size * nbins|output SV_U64 vector with nbins counters (allocated if NULL); vector; first bin lower value; bin size; number of bins|output vector reference|O(n)|1;2| */
+sv_t *sv_histogram(sv_t **h, const sv_t *v, const int64_t lo, const uint64_t bin_size, const size_t nbins);
+
 /*
  * Compare
  */
@@ -244,6 +342,9 @@ int64_t sv_at_i(const sv_t *v, const size_t index);
 /* #API: |Vector random access (unsigned integer)|vector; location|Element value|O(1)|1;2| */
 uint64_t sv_at_u(const sv_t *v, const size_t index);
 
+/* #API: |Vector random access (floating point)|vector; location|Element value (0 if out of range or not a SV_F32/SV_F64 vector)|O(1)|1;2| */
+double sv_at_f(const sv_t *v, const size_t index);
+
 /*
  * Vector "set": set element value at given position
  */
@@ -257,6 +358,9 @@ sbool_t sv_set_i(sv_t **v, const size_t index, int64_t value);
 /* #API: |Vector random access write (unsigned integer)|vector; location; value|S_TRUE: OK, S_FALSE: not enough memory|O(1)|1;2| */
 sbool_t sv_set_u(sv_t **v, const size_t index, uint64_t value);
 
+/* #API: |Vector random access write (floating point)|vector; location; value|S_TRUE: OK, S_FALSE: not enough memory or not a SV_F32/SV_F64 vector|O(1)|1;2| */
+sbool_t sv_set_f(sv_t **v, const size_t index, double value);
+
 /*
  * Vector "push": add element in the last position
  */
@@ -276,6 +380,9 @@ sbool_t sv_push_i(sv_t **v, const int64_t c);
 /* #API: |Push/add element (unsigned integer)|vector; data source|S_TRUE: added OK; S_FALSE: not enough memory|O(1)|1;2| */
 sbool_t sv_push_u(sv_t **v, const uint64_t c);
 
+/* #API: |Push/add element (floating point)|vector; data source|S_TRUE: added OK; S_FALSE: not enough memory or not a SV_F32/SV_F64 vector|O(1)|1;2| */
+sbool_t sv_push_f(sv_t **v, const double c);
+
 /*
  * Vector "pop": extract element from last position
  */
@@ -289,6 +396,9 @@ int64_t sv_pop_i(sv_t *v);
 /* #API: |Pop/extract element (unsigned integer)|vector|Integer element|O(1)|1;2| */
 uint64_t sv_pop_u(sv_t *v);
 
+/* #API: |Pop/extract element (floating point)|vector|Floating point element|O(1)|1;2| */
+double sv_pop_f(sv_t *v);
+
 /*
  * Functions intended for helping compiler optimization
  */